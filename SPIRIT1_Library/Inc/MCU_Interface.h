@@ -49,6 +49,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "SPIRIT_Types.h"
+#include "SPIRIT_Context.h"
 
 
 #ifdef __cplusplus
@@ -118,16 +119,62 @@ void RadioExitShutdown(void);
 SpiritFlagStatus RadioCheckShutdown(void);
 void RadioSpiSetBaudrate(uint32_t baudrate_prescaler);
 
-#define SpiritEnterShutdown                                  RadioEnterShutdown
+/* state waits on a GPIO edge, see SPIRIT_Wait.h: blocks until the MCU pin wired to the
+   SPIRIT GPIO given to SpiritWaitGpioInit() is high or lTimeoutUs has elapsed, returns its level */
+#ifdef SPIRIT_USE_WAIT_GPIO
+SpiritFlagStatus RadioWaitGpioHigh(uint32_t lTimeoutUs);
+#endif
+
+/* bus level: the write batch, when compiled in, sits right above the driver, see SPIRIT_Batch.h */
+#ifdef SPIRIT_USE_WRITE_BATCH
+
+#include "SPIRIT_Batch.h"
+
+#define SpiritBusEnterShutdown                                         SpiritBatchEnterShutdown
+#define SpiritBusWriteRegisters(cRegAddress, cNbBytes, pcBuffer)       SpiritBatchWriteRegisters(cRegAddress, cNbBytes, pcBuffer)
+#define SpiritBusReadRegisters(cRegAddress, cNbBytes, pcBuffer)        SpiritBatchReadRegisters(cRegAddress, cNbBytes, pcBuffer)
+#define SpiritBusCommandStrobes(cCommandCode)                          SpiritBatchCommandStrobes(cCommandCode)
+
+#else
+
+#define SpiritBusEnterShutdown                                         RadioEnterShutdown
+#define SpiritBusWriteRegisters(cRegAddress, cNbBytes, pcBuffer)       RadioSpiWriteRegisters(cRegAddress, cNbBytes, pcBuffer)
+#define SpiritBusReadRegisters(cRegAddress, cNbBytes, pcBuffer)        RadioSpiReadRegisters(cRegAddress, cNbBytes, pcBuffer)
+#define SpiritBusCommandStrobes(cCommandCode)                          RadioSpiCommandStrobes(cCommandCode)
+
+#endif
+
+/* library level: register accesses go through the write-through shadow, see SPIRIT_Shadow.h */
+#ifdef SPIRIT_USE_REGISTER_SHADOW
+
+#include "SPIRIT_Shadow.h"
+
+#define SpiritEnterShutdown                                  SpiritShadowEnterShutdown
 #define SpiritExitShutdown                                   RadioExitShutdown
 #define SpiritCheckShutdown                                  (SpiritFlagStatus)RadioCheckShutdown
 
 
 #define SpiritSpiDeinit                                                RadioSpiDeinit
 #define SpiritSpiInit                                                  RadioSpiInit
-#define SpiritSpiWriteRegisters(cRegAddress, cNbBytes, pcBuffer)       RadioSpiWriteRegisters(cRegAddress, cNbBytes, pcBuffer)
-#define SpiritSpiReadRegisters(cRegAddress, cNbBytes, pcBuffer)        RadioSpiReadRegisters(cRegAddress, cNbBytes, pcBuffer)
-#define SpiritSpiCommandStrobes(cCommandCode)                          RadioSpiCommandStrobes(cCommandCode)
+#define SpiritSpiWriteRegisters(cRegAddress, cNbBytes, pcBuffer)       SpiritShadowWriteRegisters(cRegAddress, cNbBytes, pcBuffer)
+#define SpiritSpiReadRegisters(cRegAddress, cNbBytes, pcBuffer)        SpiritShadowReadRegisters(cRegAddress, cNbBytes, pcBuffer)
+#define SpiritSpiCommandStrobes(cCommandCode)                          SpiritShadowCommandStrobes(cCommandCode)
+
+#else
+
+#define SpiritEnterShutdown                                  SpiritBusEnterShutdown
+#define SpiritExitShutdown                                   RadioExitShutdown
+#define SpiritCheckShutdown                                  (SpiritFlagStatus)RadioCheckShutdown
+
+
+#define SpiritSpiDeinit                                                RadioSpiDeinit
+#define SpiritSpiInit                                                  RadioSpiInit
+#define SpiritSpiWriteRegisters(cRegAddress, cNbBytes, pcBuffer)       SpiritBusWriteRegisters(cRegAddress, cNbBytes, pcBuffer)
+#define SpiritSpiReadRegisters(cRegAddress, cNbBytes, pcBuffer)        SpiritBusReadRegisters(cRegAddress, cNbBytes, pcBuffer)
+#define SpiritSpiCommandStrobes(cCommandCode)                          SpiritBusCommandStrobes(cCommandCode)
+
+#endif
+
 #define SpiritSpiWriteLinearFifo(cNbBytes, pcBuffer)                   RadioSpiWriteFifo(cNbBytes, pcBuffer)
 #define SpiritSpiReadLinearFifo(cNbBytes, pcBuffer)                    RadioSpiReadFifo(cNbBytes, pcBuffer)
 
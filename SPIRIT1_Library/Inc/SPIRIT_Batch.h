@@ -0,0 +1,150 @@
+/**
+  ******************************************************************************
+  * @file    SPIRIT_Batch.h
+  * @brief   Coalescing of SPIRIT register writes into bursts.
+  * @details
+  *
+  * Every call to the SPI driver costs a chip select cycle and two header bytes,
+  * and a full configuration is made of dozens of small writes. Between
+  * @ref SpiritBatchBegin() and @ref SpiritBatchFlush() register writes are not
+  * sent to SPIRIT but kept pending. The flush sends them sorted by address,
+  * one burst per range of contiguous registers.
+  *
+  * While a batch is open:
+  * <ul>
+  * <li>a register read returns the pending values, the registers without a
+  *     pending value are read from SPIRIT</li>
+  * <li>a command strobe, a read of the status registers (0xC0 and above) and
+  *     a write to a register whose write order matters (the test registers
+  *     0xA8 and 0xB2 used by the extra current workaround) flush the pending
+  *     writes first, so they keep their order with respect to them</li>
+  * <li>the linear FIFO is not part of the batch: flush before accessing it</li>
+  * </ul>
+  *
+  * The module is compiled in by defining SPIRIT_USE_WRITE_BATCH and can be
+  * disabled at run time with @ref SpiritBatchEnable(). It sits right
+  * above the SPI driver functions of <i>@ref MCU_Interface.h</i>, below the
+  * register shadow (see <i>@ref SPIRIT_Shadow.h</i>).
+  *
+  * <b>Example:</b>
+  * @code
+  *
+  * SpiritBatchBegin();
+  *
+  * SpiritRadioSetDatarate(38400);
+  * SpiritRadioSetFrequencyDev(20000);
+  * SpiritPktBasicInit(&xBasicInit);
+  *
+  * SpiritBatchFlush();
+  *
+  * @endcode
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SPIRIT_BATCH_H
+#define __SPIRIT_BATCH_H
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "SPIRIT_Types.h"
+
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+
+/**
+ * @addtogroup SPIRIT_Libraries
+ * @{
+ */
+
+
+/**
+ * @defgroup SPIRIT_Batch       Write Batch
+ * @brief Coalescing of SPIRIT register writes into bursts.
+ * @details See the file <i>@ref SPIRIT_Batch.h</i> for more details.
+ * @{
+ */
+
+/**
+ * @defgroup Batch_Exported_Types       Batch Exported Types
+ * @{
+ */
+
+/**
+ * @brief  Counters of the write batch.
+ */
+typedef struct
+{
+  uint32_t lWritesQueued;       /*!< register write calls kept pending */
+  uint32_t lBursts;             /*!< SPI transactions issued by the flushes */
+  uint32_t lReadsPatched;       /*!< register reads that returned pending values */
+  uint32_t lEarlyFlushes;       /*!< flushes forced by a strobe, a status read or an ordered write */
+} SpiritBatchCounters;
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Batch_Exported_Constants          Batch Exported Constants
+ * @{
+ */
+
+/**
+ * @brief  Registers that can be kept pending (0x00 to 0xBF).
+ */
+#define BATCH_SIZE                      0xC0
+
+/**
+ * @brief  Registers that are never kept pending: status registers and test
+ *         registers that must be written in program order.
+ */
+#define IS_BATCH_ORDERED(ADDR)          ((ADDR) >= BATCH_SIZE || (ADDR) == 0xA8 || (ADDR) == 0xB2)
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Batch_Exported_Functions           Batch Exported Functions
+ * @{
+ */
+
+void SpiritBatchEnable(SpiritFunctionalState xNewState);
+SpiritFunctionalState SpiritBatchGetState(void);
+void SpiritBatchBegin(void);
+SpiritStatus SpiritBatchFlush(void);
+SpiritBool SpiritBatchIsOpen(void);
+void SpiritBatchGetCounters(SpiritBatchCounters* pxCounters);
+void SpiritBatchResetCounters(void);
+
+SpiritStatus SpiritBatchWriteRegisters(uint8_t cRegAddress, uint8_t cNbBytes, uint8_t* pcBuffer);
+SpiritStatus SpiritBatchReadRegisters(uint8_t cRegAddress, uint8_t cNbBytes, uint8_t* pcBuffer);
+SpiritStatus SpiritBatchCommandStrobes(uint8_t cCommandCode);
+void SpiritBatchEnterShutdown(void);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -65,6 +65,13 @@
 
 #include "SPIRIT_Qi.h"
 #include "SPIRIT_Radio.h"
+#include "SPIRIT_Shadow.h"
+#include "SPIRIT_Batch.h"
+#include "SPIRIT_Wait.h"
+#include "SPIRIT_SpiClock.h"
+#include "SPIRIT_Stream.h"
+#include "SPIRIT_Fixed.h"
+#include "SPIRIT_Context.h"
 #include "MCU_Interface.h"
 #include "SPIRIT_Types.h"
 #include "SPIRIT_Management.h"
@@ -0,0 +1,212 @@
+/**
+  ******************************************************************************
+  * @file    SPIRIT_Context.h
+  * @brief   Per radio state of the SPIRIT library, for several SPIRIT on one MCU.
+  * @details
+  *
+  * Everything the library remembers about a SPIRIT lives in a @ref SpiritContext:
+  * the status of the last transaction (g_xStatus), the XTAL frequency, the
+  * VCO calibration workaround flag, the TX/RX workaround state, the register
+  * shadow, the write batch, the state waits, the SPI clock and the stream.
+  * The library works on the context bound with @ref SpiritContextBind(); all
+  * the functions of the API keep their signature and act on the SPIRIT of the
+  * bound context.
+  *
+  * A default context is bound at start-up, so that a single radio application
+  * does not have to know about contexts at all. To drive several SPIRIT,
+  * give each one a context and bind it before calling the library for it.
+  *
+  * The context also carries the index of the bus of the radio. The driver
+  * functions of <i>@ref MCU_Interface.h</i> route each transaction to the bus
+  * of the bound context, see @ref SpiritContextGetBus().
+  *
+  * The binding is process wide: use the library from one thread at a time,
+  * e.g. from a radio thread that serves all the radios in turn.
+  *
+  * <b>Example:</b>
+  * @code
+  *
+  * SpiritContext xRadioA, xRadioB;
+  *
+  * SpiritContextInit(&xRadioA, 0);
+  * SpiritContextInit(&xRadioB, 1);
+  *
+  * SpiritContextBind(&xRadioA);
+  * SpiritRadioSetXtalFrequency(50000000);
+  * SpiritRadioInit(&xRadioInitA);
+  *
+  * SpiritContextBind(&xRadioB);
+  * SpiritRadioSetXtalFrequency(52000000);
+  * SpiritRadioInit(&xRadioInitB);
+  *
+  * @endcode
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SPIRIT_CONTEXT_H
+#define __SPIRIT_CONTEXT_H
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "SPIRIT_Types.h"
+#include "SPIRIT_Shadow.h"
+#include "SPIRIT_Batch.h"
+#include "SPIRIT_Wait.h"
+#include "SPIRIT_SpiClock.h"
+#include "SPIRIT_Stream.h"
+
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+
+/**
+ * @addtogroup SPIRIT_Libraries
+ * @{
+ */
+
+
+/**
+ * @defgroup SPIRIT_Context     Radio Context
+ * @brief Per radio state of the SPIRIT library.
+ * @details See the file <i>@ref SPIRIT_Context.h</i> for more details.
+ * @{
+ */
+
+/**
+ * @defgroup Context_Exported_Types     Context Exported Types
+ * @{
+ */
+
+/**
+ * @brief  State of the register shadow, see SPIRIT_Shadow.c.
+ */
+typedef struct
+{
+  SpiritFunctionalState xState;
+  uint8_t vectcValue[SHADOW_SIZE];
+  uint8_t vectcValid[(SHADOW_SIZE+7)/8];
+  SpiritStatus xStatus;
+  SpiritShadowCounters xCounters;
+} SpiritShadowContext;
+
+/**
+ * @brief  State of the write batch, see SPIRIT_Batch.c.
+ */
+typedef struct
+{
+  SpiritFunctionalState xState;
+  SpiritBool xOpen;
+  uint8_t vectcValue[BATCH_SIZE];
+  uint8_t vectcPending[BATCH_SIZE/8];
+  uint8_t cCount;
+  SpiritStatus xStatus;
+  SpiritBatchCounters xCounters;
+} SpiritBatchContext;
+
+/**
+ * @brief  State of the state waits, see SPIRIT_Wait.c.
+ */
+typedef struct
+{
+  uint8_t cGpio;
+  SpiritWaitCounters xCounters;
+} SpiritWaitContext;
+
+/**
+ * @brief  State of the SPI clock discovery, see SPIRIT_SpiClock.c.
+ */
+typedef struct
+{
+  uint32_t lHz;
+  uint32_t lMinHz;
+  uint32_t lStepHz;
+  SpiritSpiClockCounters xCounters;
+} SpiritSpiClockContext;
+
+/**
+ * @brief  State of the stream, see SPIRIT_Stream.c.
+ */
+typedef struct
+{
+  uint8_t cMode;
+  uint8_t cTxChunk;
+  uint8_t* pcBuffer;
+  uint16_t nLength;
+  uint16_t nPosition;
+  SpiritStreamCounters xCounters;
+} SpiritStreamContext;
+
+/**
+ * @brief  Everything the library keeps about one SPIRIT.
+ */
+struct SpiritContextS
+{
+  volatile SpiritStatus xStatus;        /*!< g_xStatus */
+  uint8_t cBus;                         /*!< bus of the radio, for the driver functions */
+  uint32_t lXtalFrequency;              /*!< see SpiritRadioSetXtalFrequency() */
+  SpiritFunctionalState xDoVcoCalibrationWA;
+  volatile uint8_t cCommunicationState; /*!< TX/RX workaround state, see SPIRIT_Management.c */
+  uint32_t nDesiredFrequency;
+  SpiritShadowContext xShadow;
+  SpiritBatchContext xBatch;
+  SpiritWaitContext xWait;
+  SpiritSpiClockContext xSpiClock;
+  SpiritStreamContext xStream;
+};
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Context_Exported_Constants         Context Exported Constants
+ * @{
+ */
+
+/**
+ * @brief  Values of cCommunicationState: the TX or RX settings of the
+ *         SpiritManagementWaCmdStrobeTx()/Rx() workarounds are in place.
+ */
+#define COMMUNICATION_STATE_TX          0
+#define COMMUNICATION_STATE_RX          1
+#define COMMUNICATION_STATE_NONE        2
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Context_Exported_Functions         Context Exported Functions
+ * @{
+ */
+
+void SpiritContextInit(SpiritContext* pxContext, uint8_t cBus);
+void SpiritContextBind(SpiritContext* pxContext);
+SpiritContext* SpiritContextGet(void);
+uint8_t SpiritContextGetBus(void);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
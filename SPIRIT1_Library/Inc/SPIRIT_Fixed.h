@@ -0,0 +1,97 @@
+/**
+  ******************************************************************************
+  * @file    SPIRIT_Fixed.h
+  * @brief   Integer forms of the float and double formulas of the radio configuration.
+  * @details
+  *
+  * The radio configuration (@ref SpiritRadioInit(), @ref SpiritRadioSetFrequencyBase(),
+  * @ref SpiritRadioSearchFreqDevME(), the FC offset setters and the VCO calibration
+  * workaround of <i>@ref SPIRIT_Management.h</i>) was written with float and
+  * double expressions, like <tt>(3.0*480140)/(F_Xo>>12)-64</tt> for the IF offset.
+  * On a Cortex-M4F the double ones run in software, on a Cortex-M0 all of them.
+  *
+  * The functions of this module give the same results as these expressions,
+  * bit for bit, with integer operations only:
+  * <ul>
+  * <li>the IEEE 754 rounding to nearest even of every float (24 bits) or double
+  *     (53 bits) operation is reproduced on the exact integer or rational value</li>
+  * <li>the double products and quotients are computed exactly on 64 bits; the
+  *     rounding is modelled bit by bit only when the exact value is within the
+  *     error bound of the double computation from an integer (or a half integer
+  *     for round()), which is rare</li>
+  * </ul>
+  *
+  * The datarate and channel filter searches were already in integers.
+  *
+  * <b>Example:</b>
+  * @code
+  *
+  * // (uint32_t)(lFBase*3*(((double)(FBASE_DIVIDER*1))/50000000))
+  * uint32_t lSynthWord = SpiritFixedScale(lFBase*3, FBASE_DIVIDER*1, 50000000);
+  *
+  * @endcode
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SPIRIT_FIXED_H
+#define __SPIRIT_FIXED_H
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "SPIRIT_Types.h"
+
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+
+/**
+ * @addtogroup SPIRIT_Libraries
+ * @{
+ */
+
+
+/**
+ * @defgroup SPIRIT_Fixed       Fixed Point
+ * @brief Integer forms of the float and double formulas of the radio configuration.
+ * @details See the file <i>@ref SPIRIT_Fixed.h</i> for more details.
+ * @{
+ */
+
+/**
+ * @defgroup Fixed_Exported_Functions           Fixed Point Exported Functions
+ * @{
+ */
+
+uint64_t SpiritFixedFloat(uint64_t llValue);
+uint64_t SpiritFixedFloatDiv(uint64_t llNum, uint32_t lDen);
+uint32_t SpiritFixedScale(uint32_t lValue, uint32_t lNum, uint32_t lDen);
+uint32_t SpiritFixedScaleRound(uint32_t lValue, uint32_t lNum, uint32_t lDen);
+
+uint32_t SpiritFixedFdev(uint32_t lXtalFrequency, uint32_t lFactor);
+uint8_t SpiritFixedIfOffset(uint32_t lXtalDivided);
+int32_t SpiritFixedPpmOffset(int16_t nXtalPpm, uint32_t lFBase);
+int16_t SpiritFixedOffsetFactor(int32_t lFOffset, uint32_t lXtalFrequency);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
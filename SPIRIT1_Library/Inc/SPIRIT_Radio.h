@@ -440,6 +440,26 @@ typedef struct
 #define IS_PAPOWER(PATABLE)          ((PATABLE)<=90)
 #define IS_PA_STEP_WIDTH(WIDTH)      ((WIDTH)>=1 && (WIDTH)<=4)
 
+/**
+ * @brief  Initializer of the factors of the power curves of @ref SpiritRadioGetdBm2Reg() and
+ *         @ref SpiritRadioGetReg2dBm(), shared with the tables of src/spirit1PaCurve.h.
+ *         Interpolation curves are linear in the following 3 regions:
+ *       - reg value: 1 to 13    (up region)
+ *       - reg value: 13 to 40   (mid region)
+ *       - reg value: 41 to 90   (low region)
+ *       power_reg = m*power_dBm + q
+ *       For each band the order is: {m-up, q-up, m-mid, q-mid, m-low, q-low}.
+ * @note The power interpolation curves have been extracted
+ *       by measurements done on the divisional evaluation boards.
+ */
+#define PA_POWER_FACTORS  { \
+  {-2.11,25.66,-2.11,25.66,-2.00,31.28},   /* 915 */ \
+  {-2.04,23.45,-2.04,23.45,-1.95,27.66},   /* 868 */ \
+  {-3.48,38.45,-1.89,27.66,-1.92,30.23},   /* 433 */ \
+  {-3.27,35.43,-1.80,26.31,-1.89,29.61},   /* 315 */ \
+  {-4.18,50.66,-1.80,30.04,-1.86,32.22},   /* 169 */ \
+}
+
 /**
  * @}
  */
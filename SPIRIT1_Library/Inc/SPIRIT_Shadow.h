@@ -0,0 +1,144 @@
+/**
+  ******************************************************************************
+  * @file    SPIRIT_Shadow.h
+  * @brief   Write-through shadow of the SPIRIT configuration registers.
+  * @details
+  *
+  * Most setters of this library read a register, modify some bits and write
+  * it back. The shadow keeps a copy of the configuration space 0x00-0xF2 so
+  * that the read half of these sequences is served without an SPI transaction.
+  *
+  * The shadow sits between the library and the SPI driver functions of
+  * <i>@ref MCU_Interface.h</i> (or the write batch, see <i>@ref SPIRIT_Batch.h</i>)
+  * and is compiled in by defining SPIRIT_USE_REGISTER_SHADOW. Then:
+  * <ul>
+  * <li>every register write goes to the bus and updates the shadow (write-through)</li>
+  * <li>a register read is served locally when all the requested registers are
+  *     known and none of them is volatile</li>
+  * <li>status registers (0xC0 and above), the linear FIFO and registers whose
+  *     read has a side effect are always read from the bus</li>
+  * <li>the shadow is invalidated by the @ref COMMAND_SRES strobe and on shutdown</li>
+  * </ul>
+  *
+  * <b>Example:</b>
+  * @code
+  *
+  * SpiritShadowCounters xCounters;
+  *
+  * SpiritShadowResetCounters();
+  * SpiritCsmaInit(&xCsmaInit);
+  * SpiritShadowGetCounters(&xCounters);
+  *
+  * printf("saved %d SPI transactions\r\n", xCounters.lTransactionsSaved);
+  *
+  * @endcode
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SPIRIT_SHADOW_H
+#define __SPIRIT_SHADOW_H
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "SPIRIT_Types.h"
+
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+
+/**
+ * @addtogroup SPIRIT_Libraries
+ * @{
+ */
+
+
+/**
+ * @defgroup SPIRIT_Shadow      Register Shadow
+ * @brief Write-through cache of the SPIRIT configuration registers.
+ * @details See the file <i>@ref SPIRIT_Shadow.h</i> for more details.
+ * @{
+ */
+
+/**
+ * @defgroup Shadow_Exported_Types      Shadow Exported Types
+ * @{
+ */
+
+/**
+ * @brief  SPI traffic counters of the register shadow.
+ */
+typedef struct
+{
+  uint32_t lTransactions;       /*!< SPI transactions issued through the shadow */
+  uint32_t lTransactionsSaved;  /*!< register reads served without an SPI transaction */
+  uint32_t lBytesSaved;         /*!< SPI bytes (header included) not sent thanks to the shadow */
+  uint32_t lInvalidations;      /*!< number of times the shadow has been invalidated */
+} SpiritShadowCounters;
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Shadow_Exported_Constants         Shadow Exported Constants
+ * @{
+ */
+
+/**
+ * @brief  Size of the shadowed configuration space (registers 0x00 to 0xF2).
+ */
+#define SHADOW_SIZE                     0xF3
+
+/**
+ * @brief  Registers that are never served from the shadow: the status area, plus
+ *         the test registers written by the extra current workaround whose read
+ *         is used as a delay.
+ */
+#define IS_SHADOW_VOLATILE(ADDR)        ((ADDR) >= 0xC0 || (ADDR) == 0xA8 || (ADDR) == 0xB2)
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Shadow_Exported_Functions          Shadow Exported Functions
+ * @{
+ */
+
+void SpiritShadowEnable(SpiritFunctionalState xNewState);
+SpiritFunctionalState SpiritShadowGetState(void);
+void SpiritShadowInvalidate(void);
+void SpiritShadowGetCounters(SpiritShadowCounters* pxCounters);
+void SpiritShadowResetCounters(void);
+SpiritBool SpiritShadowPeek(uint8_t cRegAddress, uint8_t* pcValue);
+
+SpiritStatus SpiritShadowWriteRegisters(uint8_t cRegAddress, uint8_t cNbBytes, uint8_t* pcBuffer);
+SpiritStatus SpiritShadowReadRegisters(uint8_t cRegAddress, uint8_t cNbBytes, uint8_t* pcBuffer);
+SpiritStatus SpiritShadowCommandStrobes(uint8_t cCommandCode);
+void SpiritShadowEnterShutdown(void);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
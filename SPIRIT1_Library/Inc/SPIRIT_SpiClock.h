@@ -0,0 +1,163 @@
+/**
+  ******************************************************************************
+  * @file    SPIRIT_SpiClock.h
+  * @brief   Discovery of the highest reliable SPI clock of a SPIRIT.
+  * @details
+  *
+  * The SPIRIT SPI runs up to 10 MHz, but what a board sustains depends on the
+  * traces, the level shifters and the MCU pads. @ref SpiritSpiClockCalibrate()
+  * finds it at run time:
+  * <ul>
+  * <li>the SPI clock is stepped up from a rate known to work, through
+  *     RadioSpiSetBaudrate() of <i>@ref MCU_Interface.h</i></li>
+  * <li>at each step, write/readback patterns (all zeros, all ones, alternate
+  *     bits, address dependent values) on the sync word and the AES key input,
+  *     which the radio does not use outside packet TX/RX and AES operations; the
+  *     scan stops at the first corrupted readback</li>
+  * <li>the clock is set a margin of steps below the highest clean rate and the
+  *     registers under test get their content back</li>
+  * </ul>
+  *
+  * The patterns go straight to the driver, around the register shadow and the
+  * write batch. Do not calibrate while the radio is transmitting or receiving.
+  *
+  * The result is kept in the radio context (see <i>@ref SPIRIT_Context.h</i>)
+  * and can be saved by the application: @ref SpiritSpiClockRestore() applies a
+  * saved rate after a quick check instead of a new scan. @ref SpiritSpiClockCheck()
+  * repeats the quick check, e.g. periodically or when the status bytes look
+  * wrong, and drops the clock one step at a time until the patterns read back.
+  *
+  * <b>Example:</b>
+  * @code
+  *
+  * SpiClockInit xSpiClockInit = {
+  *   1000000,     // lMinHz
+  *   10000000,    // lMaxHz
+  *   1000000,     // lStepHz
+  *   1,           // cMarginSteps
+  *   8            // cRounds
+  * };
+  *
+  * if(SpiritSpiClockRestore(lSavedHz, &xSpiClockInit) == S_FALSE)
+  * {
+  *   lSavedHz = SpiritSpiClockCalibrate(&xSpiClockInit);
+  * }
+  *
+  * @endcode
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SPIRIT_SPI_CLOCK_H
+#define __SPIRIT_SPI_CLOCK_H
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "SPIRIT_Types.h"
+
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+
+/**
+ * @addtogroup SPIRIT_Libraries
+ * @{
+ */
+
+
+/**
+ * @defgroup SPIRIT_SpiClock    SPI Clock
+ * @brief Discovery of the highest reliable SPI clock.
+ * @details See the file <i>@ref SPIRIT_SpiClock.h</i> for more details.
+ * @{
+ */
+
+/**
+ * @defgroup SpiClock_Exported_Types    SPI Clock Exported Types
+ * @{
+ */
+
+/**
+ * @brief  SPI clock scan structure definition.
+ */
+typedef struct
+{
+  uint32_t lMinHz;              /*!< first rate of the scan, must be reliable */
+  uint32_t lMaxHz;              /*!< last rate of the scan, at most @ref SPIRIT_SPI_CLOCK_MAX_HZ */
+  uint32_t lStepHz;             /*!< increment of the scan and of the degradation */
+  uint8_t cMarginSteps;         /*!< steps between the highest clean rate and the selected one */
+  uint8_t cRounds;              /*!< pattern rounds at each step */
+} SpiClockInit;
+
+/**
+ * @brief  Counters of the SPI clock discovery.
+ */
+typedef struct
+{
+  uint32_t lRounds;             /*!< write/readback pattern rounds */
+  uint32_t lErrors;             /*!< rounds with a corrupted readback */
+  uint32_t lDegrades;           /*!< clock steps down after an error */
+} SpiritSpiClockCounters;
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup SpiClock_Exported_Constants       SPI Clock Exported Constants
+ * @{
+ */
+
+/**
+ * @brief  Highest SPI clock of the SPIRIT.
+ */
+#define SPIRIT_SPI_CLOCK_MAX_HZ         10000000
+
+/**
+ * @brief  Pattern rounds of @ref SpiritSpiClockCheck() and @ref SpiritSpiClockRestore().
+ */
+#define SPIRIT_SPI_CLOCK_CHECK_ROUNDS   4
+
+#define IS_SPI_CLOCK_INIT(MIN, MAX, STEP)  ((MIN)>0 && (MIN)<=(MAX) && (MAX)<=SPIRIT_SPI_CLOCK_MAX_HZ && (STEP)>0)
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup SpiClock_Exported_Functions       SPI Clock Exported Functions
+ * @{
+ */
+
+uint32_t SpiritSpiClockCalibrate(const SpiClockInit* pxSpiClockInit);
+SpiritBool SpiritSpiClockRestore(uint32_t lHz, const SpiClockInit* pxSpiClockInit);
+SpiritBool SpiritSpiClockCheck(void);
+uint32_t SpiritSpiClockDegrade(void);
+uint32_t SpiritSpiClockGet(void);
+void SpiritSpiClockGetCounters(SpiritSpiClockCounters* pxCounters);
+void SpiritSpiClockResetCounters(void);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
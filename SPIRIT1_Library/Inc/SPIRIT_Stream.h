@@ -0,0 +1,184 @@
+/**
+  ******************************************************************************
+  * @file    SPIRIT_Stream.h
+  * @brief   Streaming TX and RX of packets larger than the linear FIFO.
+  * @details
+  *
+  * The packet handlers take payloads up to 65535 bytes, the linear FIFOs hold
+  * 96. A stream moves a larger payload through the FIFO while the packet is
+  * on the air:
+  * <ul>
+  * <li>TX: the first 96 bytes are written before the TX command; every time
+  *     the TX FIFO drains to the refill level (TX_FIFO_ALMOST_EMPTY) the next
+  *     96 - refill level bytes are written, which always fit</li>
+  * <li>RX: every time the RX FIFO fills up to the drain level
+  *     (RX_FIFO_ALMOST_FULL) and at RX_DATA_READY, the content of the FIFO is
+  *     read into the buffer</li>
+  * <li>a TX FIFO underflow (the refill came too late) aborts the transmission,
+  *     an RX FIFO overflow (the drain came too late) or a payload longer than
+  *     the buffer aborts the reception; the FIFO is flushed in both cases</li>
+  * </ul>
+  *
+  * The refill and drain levels set the latency the IRQ handler can afford: a
+  * refill level of 32 bytes leaves 1 ms at 250 kbps, 512 us at 500 kbps.
+  *
+  * The stream arms the FIFO IRQs it needs when it starts and disarms the
+  * almost empty/almost full ones when it ends. The application keeps reading
+  * the IRQ status in its handler and hands it to @ref SpiritStreamHandleIrqs().
+  * The payload length and the length field width (cPktLengthWidth) of the
+  * packet format are set by the application, as for a single FIFO packet.
+  *
+  * <b>Example:</b>
+  * @code
+  *
+  * StreamInit xStreamInit = {
+  *   SPIRIT_STREAM_TX_REFILL_LEVEL,   // cTxRefillLevel
+  *   SPIRIT_STREAM_RX_DRAIN_LEVEL     // cRxDrainLevel
+  * };
+  *
+  * SpiritStreamInit(&xStreamInit);
+  * SpiritPktBasicSetPayloadLength(2048);
+  * SpiritStreamTxStart(vectcUpload, 2048);
+  *
+  * // IRQ handler
+  * SpiritIrqGetStatus(&xIrqStatus);
+  * if(SpiritStreamHandleIrqs(&xIrqStatus) == SPIRIT_STREAM_DONE)
+  * {
+  *   // sent
+  * }
+  *
+  * @endcode
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SPIRIT_STREAM_H
+#define __SPIRIT_STREAM_H
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "SPIRIT_Types.h"
+#include "SPIRIT_Irq.h"
+
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+
+/**
+ * @addtogroup SPIRIT_Libraries
+ * @{
+ */
+
+
+/**
+ * @defgroup SPIRIT_Stream      Stream
+ * @brief Streaming TX and RX of packets larger than the linear FIFO.
+ * @details See the file <i>@ref SPIRIT_Stream.h</i> for more details.
+ * @{
+ */
+
+/**
+ * @defgroup Stream_Exported_Types      Stream Exported Types
+ * @{
+ */
+
+/**
+ * @brief  Stream FIFO levels structure definition.
+ */
+typedef struct
+{
+  uint8_t cTxRefillLevel;       /*!< TX FIFO level that triggers a refill (almost empty threshold) */
+  uint8_t cRxDrainLevel;        /*!< RX FIFO level that triggers a drain */
+} StreamInit;
+
+/**
+ * @brief  State of the stream after an IRQ.
+ */
+typedef enum
+{
+  SPIRIT_STREAM_IDLE = 0,       /*!< no stream running */
+  SPIRIT_STREAM_BUSY,           /*!< the packet is still on the air */
+  SPIRIT_STREAM_DONE,           /*!< the packet has been sent or received */
+  SPIRIT_STREAM_UNDERFLOW,      /*!< TX FIFO underflow, the transmission has been aborted */
+  SPIRIT_STREAM_OVERFLOW,       /*!< RX FIFO overflow or payload longer than the buffer, the reception has been aborted */
+  SPIRIT_STREAM_DISCARDED       /*!< the packet handler discarded the packet (CRC, filtering) */
+} SpiritStreamResult;
+
+/**
+ * @brief  Counters of the streams.
+ */
+typedef struct
+{
+  uint32_t lTxStreams;          /*!< transmissions started */
+  uint32_t lRxStreams;          /*!< receptions started */
+  uint32_t lRefills;            /*!< TX FIFO writes after the TX command */
+  uint32_t lDrains;             /*!< RX FIFO reads */
+  uint32_t lUnderflows;
+  uint32_t lOverflows;
+  uint32_t lDiscarded;
+} SpiritStreamCounters;
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Stream_Exported_Constants        Stream Exported Constants
+ * @{
+ */
+
+/**
+ * @brief  Size of each linear FIFO.
+ */
+#define SPIRIT_STREAM_FIFO_SIZE         96
+
+/**
+ * @brief  Default levels: 32 bytes of margin on both FIFOs.
+ */
+#define SPIRIT_STREAM_TX_REFILL_LEVEL   32
+#define SPIRIT_STREAM_RX_DRAIN_LEVEL    64
+
+#define IS_STREAM_LEVEL(LEVEL)          ((LEVEL)>0 && (LEVEL)<SPIRIT_STREAM_FIFO_SIZE)
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Stream_Exported_Functions         Stream Exported Functions
+ * @{
+ */
+
+void SpiritStreamInit(const StreamInit* pxStreamInit);
+SpiritBool SpiritStreamTxStart(uint8_t* pcBuffer, uint16_t nLength);
+SpiritBool SpiritStreamRxStart(uint8_t* pcBuffer, uint16_t nMaxLength);
+SpiritStreamResult SpiritStreamHandleIrqs(const SpiritIrqs* pxIrqStatus);
+void SpiritStreamAbort(void);
+uint16_t SpiritStreamGetLength(void);
+void SpiritStreamGetCounters(SpiritStreamCounters* pxCounters);
+void SpiritStreamResetCounters(void);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
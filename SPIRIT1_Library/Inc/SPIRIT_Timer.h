@@ -9,7 +9,10 @@
   *
   * This module provides API to configure the Spirit timing mechanisms.
   * They allow the user to set the timer registers using raw values or
-  * compute them since the desired timer value is expressed in ms.
+  * compute them since the desired timer value is expressed in ms or us.
+  * The counter and prescaler pair is the one of least error over all the
+  * register values, found with integer operations only, and tables of
+  * timeouts can be computed once, at startup.
   * Moreover the management of the Spirit LDCR mode can be done using
   * these API.
   *
@@ -131,6 +134,16 @@ typedef enum{
                                                 COND == ANY_ABOVE_THRESHOLD )
 
 
+/**
+ * @brief  Counter and prescaler values of a timer, in the order of the registers.
+ */
+typedef struct
+{
+  uint8_t cPrescaler;      /*!< Value of the prescaler register */
+  uint8_t cCounter;        /*!< Value of the counter register */
+} TimerValues;
+
+
 
 /**
  * @}
@@ -212,6 +225,12 @@ void SpiritTimerSetWakeUpTimerReloadPrescaler(uint8_t cPrescaler);
 void SpiritTimerGetWakeUpTimerReload(float* pfWakeUpReloadMsec, uint8_t* pcCounter , uint8_t* pcPrescaler);
 void SpiritTimerComputeWakeUpValues(float fDesiredMsec , uint8_t* pcCounter , uint8_t* pcPrescaler);
 void SpiritTimerComputeRxTimeoutValues(float fDesiredMsec , uint8_t* pcCounter , uint8_t* pcPrescaler);
+void SpiritTimerSearchValues(uint64_t llTicksNum, uint32_t lTicksDen, TimerValues* pxValues);
+void SpiritTimerComputeWakeUpValuesUs(uint32_t lDesiredUsec, uint8_t* pcCounter, uint8_t* pcPrescaler);
+void SpiritTimerComputeRxTimeoutValuesUs(uint32_t lDesiredUsec, uint8_t* pcCounter, uint8_t* pcPrescaler);
+void SpiritTimerComputeWakeUpTable(const uint32_t* plDesiredUsec, uint8_t cCount, TimerValues* pxValues);
+void SpiritTimerComputeRxTimeoutTable(const uint32_t* plDesiredUsec, uint8_t cCount, TimerValues* pxValues);
+void SpiritTimerSetRxTimeoutUs(uint32_t lDesiredUsec);
 void SpiritTimerSetRxTimeoutStopCondition(RxTimeoutStopCondition xStopCondition);
 void SpiritTimerReloadStrobe(void);
 uint16_t SpiritTimerGetRcoFrequency(void);
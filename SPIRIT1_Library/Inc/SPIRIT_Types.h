@@ -169,6 +169,12 @@ typedef struct
 }SpiritStatus;
 
 
+/**
+ * @brief  Per radio state of the library, defined in <i>@ref SPIRIT_Context.h</i>.
+ */
+typedef struct SpiritContextS SpiritContext;
+
+
 
 /**
  * @}
@@ -190,7 +196,13 @@ typedef struct
  * @{
  */
 
-extern volatile SpiritStatus g_xStatus;
+extern SpiritContext* g_pxSpiritContext;
+
+/**
+ * @brief  Spirit Status of the bound radio (see <i>@ref SPIRIT_Context.h</i>),
+ *         updated on every SPI transaction.
+ */
+#define g_xStatus       (g_pxSpiritContext->xStatus)
 
 /**
  * @}
@@ -0,0 +1,174 @@
+/**
+  ******************************************************************************
+  * @file    SPIRIT_Wait.h
+  * @brief   Bounded waits for a SPIRIT main controller state.
+  * @details
+  *
+  * After a command strobe the library has to wait for the main controller to
+  * reach the new state (READY after the XO start-up, LOCK after the synthesizer
+  * settling). @ref SpiritWaitState() replaces the open ended loops of delay
+  * and @ref SpiritRefreshStatus() calls:
+  * <ul>
+  * <li>each poll is a one register read of MC_STATE0 and the state is taken
+  *     from the status bytes the transaction returns, the register value only
+  *     confirms it was not read in the middle of a transition</li>
+  * <li>the wait is bounded: it gives up after a timeout and returns an error
+  *     code instead of spinning forever on a chip that does not answer</li>
+  * <li>waiting for LOCK fails early when the synthesizer keeps reporting
+  *     LOCKWON (lock window, no lock)</li>
+  * </ul>
+  *
+  * The library has no time base, so without a platform hook the timeout is a
+  * budget of polls: one per @ref SPIRIT_WAIT_POLL_US microseconds, a lower
+  * bound of the duration of a transaction, so that the wait lasts at least
+  * the timeout.
+  *
+  * When SPIRIT_USE_WAIT_GPIO is defined and a SPIRIT GPIO wired to the MCU
+  * has been given to @ref SpiritWaitGpioInit(), the waits for READY, LOCK,
+  * RX, TX, STANDBY and SLEEP map that GPIO to the matching digital output
+  * (SPIRIT_GPIO_DIG_OUT_READY, _LOCK, _RX_STATE, _TX_STATE, _SLEEP_OR_STANDBY)
+  * and block in RadioWaitGpioHigh() of <i>@ref MCU_Interface.h</i> until it
+  * rises: no poll at all, the calling thread sleeps until the edge. The GPIO
+  * is remapped only when needed (checked in the register shadow when it is in
+  * use) and not while a write batch is open, then the wait polls.
+  *
+  * <b>Example:</b>
+  * @code
+  *
+  * SpiritCmdStrobeLockTx();
+  *
+  * if(SpiritWaitState(MC_STATE_LOCK, SPIRIT_WAIT_LOCK_TIMEOUT_US) != SPIRIT_WAIT_OK)
+  * {
+  *   // no lock: recalibrate or report
+  * }
+  *
+  * @endcode
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SPIRIT_WAIT_H
+#define __SPIRIT_WAIT_H
+
+
+/* Includes ------------------------------------------------------------------*/
+#include "SPIRIT_Types.h"
+#include "SPIRIT_Gpio.h"
+
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+
+/**
+ * @addtogroup SPIRIT_Libraries
+ * @{
+ */
+
+
+/**
+ * @defgroup SPIRIT_Wait        State Wait
+ * @brief Bounded waits for a SPIRIT main controller state.
+ * @details See the file <i>@ref SPIRIT_Wait.h</i> for more details.
+ * @{
+ */
+
+/**
+ * @defgroup Wait_Exported_Types        Wait Exported Types
+ * @{
+ */
+
+/**
+ * @brief  Outcome of a wait.
+ */
+typedef enum
+{
+  SPIRIT_WAIT_OK = 0,           /*!< the state has been reached */
+  SPIRIT_WAIT_TIMEOUT,          /*!< the state has not been reached in time */
+  SPIRIT_WAIT_LOCK_ERROR        /*!< waiting for LOCK, the synthesizer stayed in LOCKWON */
+} SpiritWaitResult;
+
+/**
+ * @brief  Counters of the waits.
+ */
+typedef struct
+{
+  uint32_t lWaits;              /*!< calls to SpiritWaitState() */
+  uint32_t lPolls;              /*!< MC_STATE reads issued by the waits */
+  uint32_t lGpioWaits;          /*!< waits that blocked on the state GPIO */
+  uint32_t lGpioRemaps;         /*!< writes of the state GPIO configuration */
+  uint32_t lFailures;           /*!< waits that returned an error */
+} SpiritWaitCounters;
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Wait_Exported_Constants          Wait Exported Constants
+ * @{
+ */
+
+/**
+ * @brief  Lower bound of the duration of a poll, in us: the poll budget of a
+ *         timeout when the waits have no time base.
+ */
+#ifndef SPIRIT_WAIT_POLL_US
+#define SPIRIT_WAIT_POLL_US             1
+#endif
+
+/**
+ * @brief  Timeouts of the waits of the library, in us: XO start-up (STANDBY or
+ *         SLEEP to READY), synthesizer lock with VCO calibration and immediate
+ *         transitions (LOCK to READY, READY to STANDBY).
+ */
+#define SPIRIT_WAIT_XO_TIMEOUT_US       2000
+#define SPIRIT_WAIT_LOCK_TIMEOUT_US     1000
+#define SPIRIT_WAIT_STATE_TIMEOUT_US    100
+
+/**
+ * @brief  LOCKWON reads tolerated before a wait for LOCK fails.
+ */
+#define SPIRIT_WAIT_LOCKWON_MAX         5
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Wait_Exported_Functions           Wait Exported Functions
+ * @{
+ */
+
+SpiritWaitResult SpiritWaitState(SpiritState xState, uint32_t lTimeoutUs);
+void SpiritWaitGetCounters(SpiritWaitCounters* pxCounters);
+void SpiritWaitResetCounters(void);
+
+#ifdef SPIRIT_USE_WAIT_GPIO
+void SpiritWaitGpioInit(SpiritGpioPin xGpio);
+void SpiritWaitGpioDeInit(void);
+#endif
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
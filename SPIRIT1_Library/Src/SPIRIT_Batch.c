@@ -0,0 +1,364 @@
+/**
+  ******************************************************************************
+  * @file    SPIRIT_Batch.c
+  * @brief   Coalescing of SPIRIT register writes into bursts.
+  * @details See the file <i>@ref SPIRIT_Batch.h</i> for more details.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "SPIRIT_Batch.h"
+#include "MCU_Interface.h"
+#include <string.h>
+
+
+/**
+ * @addtogroup SPIRIT_Libraries
+ * @{
+ */
+
+
+/**
+ * @addtogroup SPIRIT_Batch
+ * @{
+ */
+
+
+/**
+ * @defgroup Batch_Private_Variables           Batch Private Variables
+ * @{
+ */
+
+/* the batch of the bound radio, see SPIRIT_Context.h */
+
+/**
+ * @brief  Batch state. It is enabled by default when the module is compiled in.
+ */
+#define s_xBatchState           (g_pxSpiritContext->xBatch.xState)
+
+#define s_xBatchOpen            (g_pxSpiritContext->xBatch.xOpen)
+
+/**
+ * @brief  Pending register values and pending bitmap (one bit per register).
+ */
+#define s_vectcBatchValue       (g_pxSpiritContext->xBatch.vectcValue)
+#define s_vectcBatchPending     (g_pxSpiritContext->xBatch.vectcPending)
+#define s_cBatchCount           (g_pxSpiritContext->xBatch.cCount)
+
+/**
+ * @brief  Last status received from SPIRIT, returned by the writes kept pending.
+ */
+#define s_xBatchStatus          (g_pxSpiritContext->xBatch.xStatus)
+
+#define s_xBatchCounters        (g_pxSpiritContext->xBatch.xCounters)
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Batch_Private_Macros               Batch Private Macros
+ * @{
+ */
+
+#define BATCH_IS_PENDING(ADDR)          (s_vectcBatchPending[(ADDR)>>3] & (1<<((ADDR)&0x07)))
+#define BATCH_SET_PENDING(ADDR)         (s_vectcBatchPending[(ADDR)>>3] |= (1<<((ADDR)&0x07)))
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Batch_Private_Functions             Batch Private Functions
+ * @{
+ */
+
+/**
+ * @brief  Returns S_TRUE if one of the registers of the range can not be kept pending.
+ * @param  cRegAddress base register address.
+ * @param  cNbBytes number of registers.
+ * @retval SpiritBool.
+ */
+static SpiritBool SpiritBatchIsOrdered(uint8_t cRegAddress, uint8_t cNbBytes)
+{
+  uint16_t nAddress;
+
+  for(nAddress=cRegAddress; nAddress<(uint16_t)cRegAddress+cNbBytes; nAddress++)
+  {
+    if(IS_BATCH_ORDERED(nAddress))
+    {
+      return S_TRUE;
+    }
+  }
+
+  return S_FALSE;
+}
+
+/**
+ * @brief  Sends the pending writes, one burst per range of contiguous registers.
+ * @param  None.
+ * @retval None.
+ */
+static void SpiritBatchSend(void)
+{
+  uint8_t cStart, cEnd;
+
+  for(cStart=0; s_cBatchCount!=0 && cStart<BATCH_SIZE; cStart=cEnd)
+  {
+    if(!BATCH_IS_PENDING(cStart))
+    {
+      cEnd = cStart+1;
+      continue;
+    }
+
+    for(cEnd=cStart+1; cEnd<BATCH_SIZE && BATCH_IS_PENDING(cEnd); cEnd++);
+
+    s_xBatchStatus = RadioSpiWriteRegisters(cStart, cEnd-cStart, &s_vectcBatchValue[cStart]);
+    s_xBatchCounters.lBursts++;
+    s_cBatchCount -= cEnd-cStart;
+  }
+
+  memset(s_vectcBatchPending, 0, sizeof(s_vectcBatchPending));
+  s_cBatchCount = 0;
+}
+
+/**
+ * @brief  Sends the pending writes before an access that must keep its order.
+ * @param  None.
+ * @retval None.
+ */
+static void SpiritBatchEarlyFlush(void)
+{
+  if(s_cBatchCount!=0)
+  {
+    SpiritBatchSend();
+    s_xBatchCounters.lEarlyFlushes++;
+  }
+}
+
+/**
+ * @brief  Enables or disables the write batch. When disabled, @ref SpiritBatchBegin()
+ *         has no effect and every write goes to SPIRIT immediately. Disabling
+ *         flushes the open batch, if any.
+ * @param  xNewState new state of the batch.
+ *         This parameter can be: S_ENABLE or S_DISABLE.
+ * @retval None.
+ */
+void SpiritBatchEnable(SpiritFunctionalState xNewState)
+{
+  s_assert_param(IS_SPIRIT_FUNCTIONAL_STATE(xNewState));
+
+  if(xNewState==S_DISABLE && s_xBatchOpen)
+  {
+    SpiritBatchFlush();
+  }
+  s_xBatchState = xNewState;
+}
+
+/**
+ * @brief  Returns the state of the write batch.
+ * @param  None.
+ * @retval SpiritFunctionalState S_ENABLE if the batch is in use.
+ */
+SpiritFunctionalState SpiritBatchGetState(void)
+{
+  return s_xBatchState;
+}
+
+/**
+ * @brief  Opens a batch: the following register writes are kept pending until
+ *         @ref SpiritBatchFlush() is called. Calling it while a batch is open
+ *         or while the batch is disabled has no effect.
+ * @param  None.
+ * @retval None.
+ */
+void SpiritBatchBegin(void)
+{
+  if(s_xBatchState==S_ENABLE)
+  {
+    s_xBatchOpen = S_TRUE;
+  }
+}
+
+/**
+ * @brief  Sends the pending writes and closes the batch.
+ * @param  None.
+ * @retval SpiritStatus status returned by the last transaction.
+ */
+SpiritStatus SpiritBatchFlush(void)
+{
+  SpiritBatchSend();
+  s_xBatchOpen = S_FALSE;
+
+  return s_xBatchStatus;
+}
+
+/**
+ * @brief  Returns S_TRUE if a batch is open.
+ * @param  None.
+ * @retval SpiritBool.
+ */
+SpiritBool SpiritBatchIsOpen(void)
+{
+  return s_xBatchOpen;
+}
+
+/**
+ * @brief  Returns the counters of the write batch.
+ * @param  pxCounters pointer to the counters to fill.
+ * @retval None.
+ */
+void SpiritBatchGetCounters(SpiritBatchCounters* pxCounters)
+{
+  *pxCounters = s_xBatchCounters;
+}
+
+/**
+ * @brief  Clears the counters of the write batch.
+ * @param  None.
+ * @retval None.
+ */
+void SpiritBatchResetCounters(void)
+{
+  memset(&s_xBatchCounters, 0, sizeof(s_xBatchCounters));
+}
+
+/**
+ * @brief  Writes registers, or keeps the values pending if a batch is open.
+ * @param  cRegAddress base register address.
+ * @param  cNbBytes number of registers to write.
+ * @param  pcBuffer register values.
+ * @retval SpiritStatus status returned by the transaction, or the last known
+ *         status when the write has been kept pending.
+ */
+SpiritStatus SpiritBatchWriteRegisters(uint8_t cRegAddress, uint8_t cNbBytes, uint8_t* pcBuffer)
+{
+  uint8_t i;
+
+  if(!s_xBatchOpen)
+  {
+    return RadioSpiWriteRegisters(cRegAddress, cNbBytes, pcBuffer);
+  }
+
+  if(SpiritBatchIsOrdered(cRegAddress, cNbBytes))
+  {
+    SpiritBatchEarlyFlush();
+    s_xBatchStatus = RadioSpiWriteRegisters(cRegAddress, cNbBytes, pcBuffer);
+    return s_xBatchStatus;
+  }
+
+  for(i=0; i<cNbBytes; i++)
+  {
+    if(!BATCH_IS_PENDING(cRegAddress+i))
+    {
+      BATCH_SET_PENDING(cRegAddress+i);
+      s_cBatchCount++;
+    }
+    s_vectcBatchValue[cRegAddress+i] = pcBuffer[i];
+  }
+  s_xBatchCounters.lWritesQueued++;
+
+  return s_xBatchStatus;
+}
+
+/**
+ * @brief  Reads registers. Inside a batch the pending values are returned in
+ *         place of the ones read from SPIRIT.
+ * @param  cRegAddress base register address.
+ * @param  cNbBytes number of registers to read.
+ * @param  pcBuffer buffer for the register values.
+ * @retval SpiritStatus status returned by the transaction, or the last known
+ *         status when the read has been served by the pending values.
+ */
+SpiritStatus SpiritBatchReadRegisters(uint8_t cRegAddress, uint8_t cNbBytes, uint8_t* pcBuffer)
+{
+  uint8_t i, cPending = 0;
+
+  if(!s_xBatchOpen)
+  {
+    return RadioSpiReadRegisters(cRegAddress, cNbBytes, pcBuffer);
+  }
+
+  if(SpiritBatchIsOrdered(cRegAddress, cNbBytes))
+  {
+    SpiritBatchEarlyFlush();
+    s_xBatchStatus = RadioSpiReadRegisters(cRegAddress, cNbBytes, pcBuffer);
+    return s_xBatchStatus;
+  }
+
+  for(i=0; i<cNbBytes; i++)
+  {
+    if(BATCH_IS_PENDING(cRegAddress+i))
+    {
+      cPending++;
+    }
+  }
+
+  if(cPending!=cNbBytes)
+  {
+    s_xBatchStatus = RadioSpiReadRegisters(cRegAddress, cNbBytes, pcBuffer);
+  }
+
+  if(cPending!=0)
+  {
+    for(i=0; i<cNbBytes; i++)
+    {
+      if(BATCH_IS_PENDING(cRegAddress+i))
+      {
+        pcBuffer[i] = s_vectcBatchValue[cRegAddress+i];
+      }
+    }
+    s_xBatchCounters.lReadsPatched++;
+  }
+
+  return s_xBatchStatus;
+}
+
+/**
+ * @brief  Sends a command strobe, after the pending writes.
+ * @param  cCommandCode command code.
+ * @retval SpiritStatus status returned by the transaction.
+ */
+SpiritStatus SpiritBatchCommandStrobes(uint8_t cCommandCode)
+{
+  if(!s_xBatchOpen)
+  {
+    return RadioSpiCommandStrobes(cCommandCode);
+  }
+
+  SpiritBatchEarlyFlush();
+  s_xBatchStatus = RadioSpiCommandStrobes(cCommandCode);
+
+  return s_xBatchStatus;
+}
+
+/**
+ * @brief  Puts SPIRIT in shutdown. The pending writes are dropped and the batch
+ *         is closed, since the register content is lost anyway.
+ * @param  None.
+ * @retval None.
+ */
+void SpiritBatchEnterShutdown(void)
+{
+  memset(s_vectcBatchPending, 0, sizeof(s_vectcBatchPending));
+  s_cBatchCount = 0;
+  s_xBatchOpen = S_FALSE;
+
+  RadioEnterShutdown();
+}
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
@@ -0,0 +1,121 @@
+/**
+  ******************************************************************************
+  * @file    SPIRIT_Context.c
+  * @brief   Per radio state of the SPIRIT library, for several SPIRIT on one MCU.
+  * @details See the file <i>@ref SPIRIT_Context.h</i> for more details.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "SPIRIT_Context.h"
+#include <string.h>
+
+
+/**
+ * @addtogroup SPIRIT_Libraries
+ * @{
+ */
+
+
+/**
+ * @addtogroup SPIRIT_Context
+ * @{
+ */
+
+
+/**
+ * @defgroup Context_Private_Variables         Context Private Variables
+ * @{
+ */
+
+/**
+ * @brief  Context of the single radio applications, bus 0, bound at start-up.
+ *         Its initial values are the ones of @ref SpiritContextInit().
+ */
+static SpiritContext s_xDefaultContext =
+{
+  .cBus = 0,
+  .xDoVcoCalibrationWA = S_ENABLE,
+  .cCommunicationState = COMMUNICATION_STATE_NONE,
+  .xShadow = { .xState = S_ENABLE },
+  .xBatch = { .xState = S_ENABLE, .xOpen = S_FALSE },
+};
+
+/**
+ * @brief  The context the library works on.
+ */
+SpiritContext* g_pxSpiritContext = &s_xDefaultContext;
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Context_Public_Functions          Context Public Functions
+ * @{
+ */
+
+/**
+ * @brief  Initializes a radio context: nothing known about the radio, shadow and
+ *         batch enabled, VCO calibration workaround enabled, no wait GPIO.
+ *         Do not initialize the bound context.
+ * @param  pxContext pointer to the context.
+ * @param  cBus index of the bus of the radio, see @ref SpiritContextGetBus().
+ * @retval None.
+ */
+void SpiritContextInit(SpiritContext* pxContext, uint8_t cBus)
+{
+  memset(pxContext, 0, sizeof(SpiritContext));
+  pxContext->cBus = cBus;
+  pxContext->xDoVcoCalibrationWA = S_ENABLE;
+  pxContext->cCommunicationState = COMMUNICATION_STATE_NONE;
+  pxContext->xShadow.xState = S_ENABLE;
+  pxContext->xBatch.xState = S_ENABLE;
+  pxContext->xBatch.xOpen = S_FALSE;
+}
+
+/**
+ * @brief  Makes the library work on a radio context until the next call.
+ * @param  pxContext pointer to the context, NULL for the default context.
+ * @retval None.
+ */
+void SpiritContextBind(SpiritContext* pxContext)
+{
+  g_pxSpiritContext = pxContext!=NULL ? pxContext : &s_xDefaultContext;
+}
+
+/**
+ * @brief  Returns the bound context.
+ * @param  None.
+ * @retval SpiritContext* pointer to the bound context.
+ */
+SpiritContext* SpiritContextGet(void)
+{
+  return g_pxSpiritContext;
+}
+
+/**
+ * @brief  Returns the bus of the bound context: the driver functions of
+ *         <i>@ref MCU_Interface.h</i> of a platform with several SPIRIT use it to
+ *         address the right one.
+ * @param  None.
+ * @retval uint8_t index of the bus.
+ */
+uint8_t SpiritContextGetBus(void)
+{
+  return g_pxSpiritContext->cBus;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
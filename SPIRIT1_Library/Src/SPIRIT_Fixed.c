@@ -0,0 +1,411 @@
+/**
+  ******************************************************************************
+  * @file    SPIRIT_Fixed.c
+  * @brief   Integer forms of the float and double formulas of the radio configuration.
+  * @details See the file <i>@ref SPIRIT_Fixed.h</i> for more details.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "SPIRIT_Fixed.h"
+#include "SPIRIT_Radio.h"
+
+
+/**
+ * @addtogroup SPIRIT_Libraries
+ * @{
+ */
+
+
+/**
+ * @addtogroup SPIRIT_Fixed
+ * @{
+ */
+
+
+/**
+ * @defgroup Fixed_Private_Defines             Fixed Point Private Defines
+ * @{
+ */
+
+/**
+ * @brief  Significant bits of the float and double formats.
+ */
+#define FIXED_FLOAT_BITS        24
+#define FIXED_DOUBLE_BITS       53
+
+/**
+ * @brief  (3.0*480140), the numerator of the IF offset formula.
+ */
+#define FIXED_IF_OFFSET_NUM     1440420
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Fixed_Private_Functions           Fixed Point Private Functions
+ * @{
+ */
+
+/**
+ * @brief  Returns the number of significant bits of a value.
+ * @param  llValue the value.
+ * @retval uint8_t 0 for 0, else the position of the highest bit set plus one.
+ */
+static uint8_t SpiritFixedBits(uint64_t llValue)
+{
+#ifdef __GNUC__
+  /* CLZ on the Cortex-M3 and above */
+  return llValue ? (uint8_t)(64-__builtin_clzll(llValue)) : 0;
+#else
+  uint8_t cBits = 0;
+
+  if(llValue>>32) { cBits += 32; llValue >>= 32; }
+  if(llValue>>16) { cBits += 16; llValue >>= 16; }
+  if(llValue>>8)  { cBits += 8;  llValue >>= 8; }
+  if(llValue>>4)  { cBits += 4;  llValue >>= 4; }
+  if(llValue>>2)  { cBits += 2;  llValue >>= 2; }
+  if(llValue>>1)  { cBits += 1;  llValue >>= 1; }
+
+  return cBits + (uint8_t)llValue;
+#endif
+}
+
+/**
+ * @brief  Returns lNum/lDen as a double: a mantissa of @ref FIXED_DOUBLE_BITS bits,
+ *         rounded to nearest even, and its exponent.
+ * @param  lNum numerator, not 0.
+ * @param  lDen denominator, not 0.
+ * @param  pnExp the returned exponent: the quotient is mantissa*2^(*pnExp).
+ * @retval uint64_t the mantissa.
+ */
+static uint64_t SpiritFixedDoubleDiv(uint32_t lNum, uint32_t lDen, int16_t* pnExp)
+{
+  uint64_t llQuotient = lNum/lDen, llRest = lNum%lDen;
+  uint8_t cRound;
+
+  /* long division, one bit per step, up to the mantissa and the rounding bit */
+  *pnExp = 0;
+  while(llQuotient < ((uint64_t)1<<FIXED_DOUBLE_BITS))
+  {
+    llRest <<= 1;
+    llQuotient <<= 1;
+    if(llRest >= lDen)
+    {
+      llRest -= lDen;
+      llQuotient |= 1;
+    }
+    (*pnExp)--;
+  }
+
+  cRound = (uint8_t)(llQuotient&1);
+  llQuotient >>= 1;
+  (*pnExp)++;
+  if(cRound && (llRest || (llQuotient&1)))
+  {
+    llQuotient++;
+  }
+  if(llQuotient == ((uint64_t)1<<FIXED_DOUBLE_BITS))
+  {
+    llQuotient >>= 1;
+    (*pnExp)++;
+  }
+
+  return llQuotient;
+}
+
+/**
+ * @brief  Returns lValue*llMantissa*2^(*pnExp) as a double, rounded to nearest even.
+ * @param  lValue an integer, exact as a double.
+ * @param  llMantissa a mantissa of @ref FIXED_DOUBLE_BITS bits at most.
+ * @param  pnExp the exponent of llMantissa, updated to the one of the result.
+ * @retval uint64_t the mantissa of the product.
+ */
+static uint64_t SpiritFixedDoubleMul(uint32_t lValue, uint64_t llMantissa, int16_t* pnExp)
+{
+  /* the exact product on 96 bits: llHigh*2^32 + lLow */
+  uint64_t llLow = (uint64_t)lValue*(uint32_t)llMantissa;
+  uint64_t llHigh = (uint64_t)lValue*(uint32_t)(llMantissa>>32) + (llLow>>32);
+  uint32_t lLow = (uint32_t)llLow;
+  uint64_t llProduct, llRest, llHalf;
+  uint8_t cShift;
+
+  if(SpiritFixedBits(llHigh)+32 <= FIXED_DOUBLE_BITS)
+  {
+    return (llHigh<<32) | lLow;
+  }
+
+  /* 53 bits of 85 at most: the shift is in [1, 32] */
+  cShift = SpiritFixedBits(llHigh)+32-FIXED_DOUBLE_BITS;
+  if(cShift < 32)
+  {
+    llProduct = (llHigh<<(32-cShift)) | (lLow>>cShift);
+    llRest = lLow & (((uint32_t)1<<cShift)-1);
+  }
+  else
+  {
+    llProduct = llHigh;
+    llRest = lLow;
+  }
+
+  llHalf = (uint64_t)1<<(cShift-1);
+  if(llRest>llHalf || (llRest==llHalf && (llProduct&1)))
+  {
+    llProduct++;
+  }
+  *pnExp += cShift;
+
+  return llProduct;
+}
+
+/**
+ * @brief  Computes lValue*((double)lNum/lDen) exactly as a double, then truncates or rounds it.
+ * @param  lValue an integer, exact as a double.
+ * @param  lNum numerator.
+ * @param  lDen denominator, not 0.
+ * @param  xRound S_TRUE for round(), half away from zero; S_FALSE for the truncation.
+ * @retval uint32_t the result.
+ */
+static uint32_t SpiritFixedScaleModel(uint32_t lValue, uint32_t lNum, uint32_t lDen, SpiritBool xRound)
+{
+  uint64_t llMantissa;
+  int16_t nExp;
+
+  if(lValue==0 || lNum==0)
+  {
+    return 0;
+  }
+
+  llMantissa = SpiritFixedDoubleMul(lValue, SpiritFixedDoubleDiv(lNum, lDen, &nExp), &nExp);
+
+  if(nExp >= 0)
+  {
+    return (uint32_t)(llMantissa<<nExp);
+  }
+  if(nExp <= -64)
+  {
+    return 0;
+  }
+  if(xRound)
+  {
+    llMantissa += (uint64_t)1<<(-nExp-1);
+  }
+  return (uint32_t)(llMantissa>>(-nExp));
+}
+
+/**
+ * @brief  Returns lValue*((double)lNum/lDen), truncated or rounded, from the exact
+ *         quotient when the double error cannot change it, else from the model.
+ * @param  lValue an integer, exact as a double.
+ * @param  lNum numerator.
+ * @param  lDen denominator, not 0.
+ * @param  xRound S_TRUE for round(), half away from zero; S_FALSE for the truncation.
+ * @retval uint32_t the result, which must fit on 32 bits.
+ */
+static uint32_t SpiritFixedScaleExact(uint32_t lValue, uint32_t lNum, uint32_t lDen, SpiritBool xRound)
+{
+  uint64_t llProduct = (uint64_t)lValue*lNum;
+  uint64_t llQuotient = llProduct/lDen;
+  uint64_t llRest = llProduct%lDen;
+  uint64_t llMargin;
+
+  /* two roundings of 2^-53: the double is within (quotient+1)*2^-51 of the exact
+  value, that is below llMargin in units of 1/lDen */
+  llMargin = (((llQuotient+1)*lDen)>>51) + 1;
+
+  if(xRound)
+  {
+    if(2*llRest > lDen+2*llMargin)
+    {
+      return (uint32_t)(llQuotient+1);
+    }
+    if(2*llRest+2*llMargin < lDen)
+    {
+      return (uint32_t)llQuotient;
+    }
+  }
+  else if(llRest >= llMargin && llRest+llMargin < lDen)
+  {
+    return (uint32_t)llQuotient;
+  }
+
+  /* close to an integer, or a half integer: the double rounding decides */
+  return SpiritFixedScaleModel(lValue, lNum, lDen, xRound);
+}
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Fixed_Public_Functions            Fixed Point Public Functions
+ * @{
+ */
+
+/**
+ * @brief  Returns (float)llValue.
+ * @param  llValue the value.
+ * @retval uint64_t the value rounded to nearest even on @ref FIXED_FLOAT_BITS significant bits.
+ */
+uint64_t SpiritFixedFloat(uint64_t llValue)
+{
+  uint8_t cBits = SpiritFixedBits(llValue), cShift;
+  uint64_t llRest, llHalf;
+
+  if(cBits <= FIXED_FLOAT_BITS)
+  {
+    return llValue;
+  }
+
+  cShift = cBits-FIXED_FLOAT_BITS;
+  llHalf = (uint64_t)1<<(cShift-1);
+  llRest = llValue & ((llHalf<<1)-1);
+  llValue >>= cShift;
+  if(llRest>llHalf || (llRest==llHalf && (llValue&1)))
+  {
+    llValue++;
+  }
+
+  return llValue<<cShift;
+}
+
+/**
+ * @brief  Returns (uint32_t)(fNum/fDen) of two floats.
+ * @param  llNum the numerator, a value of @ref SpiritFixedFloat().
+ * @param  lDen the denominator, a value of @ref SpiritFixedFloat(), not 0.
+ * @retval uint64_t the float quotient, truncated.
+ */
+uint64_t SpiritFixedFloatDiv(uint64_t llNum, uint32_t lDen)
+{
+  uint64_t llQuotient = llNum/lDen, llRest = llNum%lDen, llHalf, llLow;
+  uint8_t cBits = SpiritFixedBits(llQuotient), cShift;
+
+  if(cBits < FIXED_FLOAT_BITS)
+  {
+    /* fractional bits left: up to the next integer within half a unit, ties included */
+    if(llRest && ((lDen-llRest)<<(FIXED_FLOAT_BITS+1-cBits)) <= lDen)
+    {
+      llQuotient++;
+    }
+    return llQuotient;
+  }
+
+  if(cBits == FIXED_FLOAT_BITS)
+  {
+    /* the unit is 1 */
+    if(2*llRest>lDen || (2*llRest==lDen && (llQuotient&1)))
+    {
+      llQuotient++;
+    }
+    return llQuotient;
+  }
+
+  /* the unit is above 1: the fraction only breaks the ties */
+  cShift = cBits-FIXED_FLOAT_BITS;
+  llHalf = (uint64_t)1<<(cShift-1);
+  llLow = llQuotient & ((llHalf<<1)-1);
+  llQuotient >>= cShift;
+  if(llLow>llHalf || (llLow==llHalf && (llRest || (llQuotient&1))))
+  {
+    llQuotient++;
+  }
+
+  return llQuotient<<cShift;
+}
+
+/**
+ * @brief  Returns (uint32_t)(lValue*((double)lNum/lDen)).
+ * @param  lValue an integer.
+ * @param  lNum numerator.
+ * @param  lDen denominator, not 0.
+ * @retval uint32_t the result, which must fit on 32 bits.
+ */
+uint32_t SpiritFixedScale(uint32_t lValue, uint32_t lNum, uint32_t lDen)
+{
+  return SpiritFixedScaleExact(lValue, lNum, lDen, S_FALSE);
+}
+
+/**
+ * @brief  Returns (uint32_t)round(lValue*((double)lNum/lDen)).
+ * @param  lValue an integer.
+ * @param  lNum numerator.
+ * @param  lDen denominator, not 0.
+ * @retval uint32_t the result, which must fit on 32 bits.
+ */
+uint32_t SpiritFixedScaleRound(uint32_t lValue, uint32_t lNum, uint32_t lDen)
+{
+  return SpiritFixedScaleExact(lValue, lNum, lDen, S_TRUE);
+}
+
+/**
+ * @brief  Returns the frequency deviation formula (uint32_t)((float)F_Xo/2^18*lFactor).
+ * @param  lXtalFrequency F_Xo in Hz.
+ * @param  lFactor (uint32_t)((8.0+M)/2*2^E) or a threshold of the search, below 2^24.
+ * @retval uint32_t the frequency deviation in Hz.
+ */
+uint32_t SpiritFixedFdev(uint32_t lXtalFrequency, uint32_t lFactor)
+{
+  /* the division by 2^18 is exact */
+  return (uint32_t)(SpiritFixedFloat(SpiritFixedFloat(lXtalFrequency)*lFactor)>>18);
+}
+
+/**
+ * @brief  Returns ROUND((3.0*480140)/lXtalDivided-64), the IF offset register value.
+ * @param  lXtalDivided F_Xo>>12, or F_Xo>>13 for the digital IF offset of a doubled xtal.
+ * @retval uint8_t the IF offset.
+ * @note   The fraction is r/lXtalDivided with r the remainder: its distance from 1/2,
+ *         when not 0, is above the float error, so that only a fraction above 1/2
+ *         rounds up, like in ROUND().
+ */
+uint8_t SpiritFixedIfOffset(uint32_t lXtalDivided)
+{
+  uint32_t lQuotient = FIXED_IF_OFFSET_NUM/lXtalDivided, lRest = FIXED_IF_OFFSET_NUM%lXtalDivided;
+
+  return (uint8_t)(lQuotient-64+(2*lRest>lXtalDivided ? 1 : 0));
+}
+
+/**
+ * @brief  Returns (int32_t)(((float)nXtalPpm*lFBase)/PPM_FACTOR), the offset of an xtal error.
+ * @param  nXtalPpm the xtal offset in ppm.
+ * @param  lFBase the base frequency in Hz.
+ * @retval int32_t the frequency offset in Hz.
+ */
+int32_t SpiritFixedPpmOffset(int16_t nXtalPpm, uint32_t lFBase)
+{
+  uint32_t lPpm = nXtalPpm<0 ? (uint32_t)(-(int32_t)nXtalPpm) : (uint32_t)nXtalPpm;
+  uint64_t llOffset = SpiritFixedFloatDiv(SpiritFixedFloat(lPpm*SpiritFixedFloat(lFBase)), PPM_FACTOR);
+
+  return nXtalPpm<0 ? -(int32_t)llOffset : (int32_t)llOffset;
+}
+
+/**
+ * @brief  Returns (int16_t)(((float)lFOffset*FBASE_DIVIDER)/lXtalFrequency), the FC_OFFSET value.
+ * @param  lFOffset the frequency offset in Hz.
+ * @param  lXtalFrequency F_Xo in Hz.
+ * @retval int16_t the FC_OFFSET value.
+ */
+int16_t SpiritFixedOffsetFactor(int32_t lFOffset, uint32_t lXtalFrequency)
+{
+  uint32_t lOffset = lFOffset<0 ? (uint32_t)0-(uint32_t)lFOffset : (uint32_t)lFOffset;
+  uint64_t llFactor = SpiritFixedFloatDiv(SpiritFixedFloat(lOffset)*FBASE_DIVIDER,
+                                          (uint32_t)SpiritFixedFloat(lXtalFrequency));
+
+  return (int16_t)(lFOffset<0 ? -(int32_t)llFactor : (int32_t)llFactor);
+}
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
@@ -38,6 +38,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "SPIRIT_Management.h"
+#include "SPIRIT_Fixed.h"
 
 /**
 * @addtogroup SPIRIT_Libraries
@@ -55,13 +56,10 @@
 */
 static const uint8_t s_vectcBandRegValue[4]={SYNT0_BS_6, SYNT0_BS_12, SYNT0_BS_16, SYNT0_BS_32};
 
-#define COMMUNICATION_STATE_TX          0
-#define COMMUNICATION_STATE_RX          1
-#define COMMUNICATION_STATE_NONE        2
+/* TX/RX workaround state of the bound radio, see SPIRIT_Context.h */
+#define s_nDesiredFrequency             (g_pxSpiritContext->nDesiredFrequency)
 
-static uint32_t s_nDesiredFrequency;
-
-volatile static uint8_t s_cCommunicationState = COMMUNICATION_STATE_NONE;
+#define s_cCommunicationState           (g_pxSpiritContext->cCommunicationState)
 
 
 /**
@@ -171,7 +169,7 @@ void SpiritManagementSetFrequencyBase(uint32_t lFBase)
   /* Search the VCO charge pump word and set the corresponding register */
   wcp = SpiritRadioSearchWCP(Fc);
   
-  synthWord = (uint32_t)(lFBase*(((double)(FBASE_DIVIDER*cRefDiv*s_vectcBHalfFactor[band]))/SpiritRadioGetXtalFrequency()));
+  synthWord = SpiritFixedScale(lFBase, FBASE_DIVIDER*cRefDiv*s_vectcBHalfFactor[band], SpiritRadioGetXtalFrequency());
   
   /* Build the array of registers values for the analog part */
   anaRadioRegArray[0] = (uint8_t)(((synthWord>>21)&(0x0000001F))|(wcp<<5));
@@ -191,7 +189,6 @@ uint8_t SpiritManagementWaVcoCalibration(void)
   uint8_t cRestore = 0;
   uint8_t cStandby = 0;
   uint32_t xtal_frequency = SpiritRadioGetXtalFrequency();
-  uint8_t nLockwon=0;
   
   /* Enable the reference divider if the XTAL is between 48 and 52 MHz */
   if(xtal_frequency>DOUBLE_XTAL_THR)
@@ -216,51 +213,30 @@ uint8_t SpiritManagementWaVcoCalibration(void)
   {
     cStandby = 1;
     SpiritCmdStrobeReady();
-    do{
-      SpiritRefreshStatus();
-      
-    }while(g_xStatus.MC_STATE != MC_STATE_READY); 
+    if(SpiritWaitState(MC_STATE_READY, SPIRIT_WAIT_XO_TIMEOUT_US)!=SPIRIT_WAIT_OK) return 1;
   }
   
   SpiritCmdStrobeLockTx();
   
-  nLockwon=0;
-  do{
-    SpiritRefreshStatus();
-    if(g_xStatus.MC_STATE == MC_STATE_LOCKWON)
-    {
-      if(nLockwon++==5) return 1;
-    }
-  }while(g_xStatus.MC_STATE != MC_STATE_LOCK);
+  /* fails after a few LOCKWON reads */
+  if(SpiritWaitState(MC_STATE_LOCK, SPIRIT_WAIT_LOCK_TIMEOUT_US)!=SPIRIT_WAIT_OK) return 1;
     
   s_cVcoWordTx = SpiritCalibrationGetVcoCalData();
   
   SpiritCmdStrobeReady();
   
-  do{
-    SpiritRefreshStatus();
-  }while(g_xStatus.MC_STATE != MC_STATE_READY); 
+  if(SpiritWaitState(MC_STATE_READY, SPIRIT_WAIT_STATE_TIMEOUT_US)!=SPIRIT_WAIT_OK) return 1;
   
     
   SpiritCmdStrobeLockRx();
   
-  nLockwon=0;
-  do{
-    SpiritRefreshStatus();
-    if(g_xStatus.MC_STATE == MC_STATE_LOCKWON)
-    {
-      if(nLockwon++==5) return 1;
-    }
-  }while(g_xStatus.MC_STATE != MC_STATE_LOCK);
+  if(SpiritWaitState(MC_STATE_LOCK, SPIRIT_WAIT_LOCK_TIMEOUT_US)!=SPIRIT_WAIT_OK) return 1;
   
   s_cVcoWordRx = SpiritCalibrationGetVcoCalData();
   
   SpiritCmdStrobeReady();
   
-  do{
-    SpiritRefreshStatus();
-   
-  }while(g_xStatus.MC_STATE != MC_STATE_READY);
+  if(SpiritWaitState(MC_STATE_READY, SPIRIT_WAIT_STATE_TIMEOUT_US)!=SPIRIT_WAIT_OK) return 1;
   
   if(cStandby == 1)
   {
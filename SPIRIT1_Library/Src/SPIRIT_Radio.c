@@ -39,6 +39,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "SPIRIT_Radio.h"
+#include "SPIRIT_Fixed.h"
 #include "MCU_Interface.h"
 #include <math.h>
 
@@ -77,9 +78,8 @@
 /** @defgroup Radio_Private_Macros                      Radio Private Macros
 * @{
 */
-#define XTAL_FLAG(xtalFrequency)               (xtalFrequency>=25e6) ? XTAL_FLAG_26_MHz:XTAL_FLAG_24_MHz
+#define XTAL_FLAG(xtalFrequency)               (xtalFrequency>=25000000) ? XTAL_FLAG_26_MHz:XTAL_FLAG_24_MHz
 
-#define ROUND(A)                                  (((A-(uint32_t)A)> 0.5)? (uint32_t)A+1:(uint32_t)A)
 /**
 * @}
 */
@@ -89,9 +89,9 @@
 * @{
 */
 /**
-* @brief  The Xtal frequency. To be set by the user (see SetXtalFreq() function)
+* @brief  The Xtal frequency of the bound radio. To be set by the user (see SetXtalFreq() function)
 */
-static uint32_t s_lXtalFrequency;
+#define s_lXtalFrequency        (g_pxSpiritContext->lXtalFrequency)
 
 /**
 * @brief  Factor is: B/2 used in the formula for SYNTH word calculation
@@ -133,31 +133,17 @@ static const uint16_t s_vectnVCOFreq[16]=
 };
 
 /**
-* @brief  This variable is used to enable or disable
+* @brief  This variable of the bound radio is used to enable or disable
 *  the VCO calibration WA called at the end of the SpiritRadioSetFrequencyBase fcn.
 *  Default is enabled.
 */
-static SpiritFunctionalState xDoVcoCalibrationWA=S_ENABLE;
+#define xDoVcoCalibrationWA     (g_pxSpiritContext->xDoVcoCalibrationWA)
 
 
 /**
-* @brief  These values are used to interpolate the power curves.
-*         Interpolation curves are linear in the following 3 regions:
-*       - reg value: 1 to 13    (up region)
-*       - reg value: 13 to 40   (mid region)
-*       - reg value: 41 to 90   (low region)
-*       power_reg = m*power_dBm + q
-*       For each band the order is: {m-up, q-up, m-mid, q-mid, m-low, q-low}.
-* @note The power interpolation curves have been extracted
-*       by measurements done on the divisional evaluation boards.
+* @brief  These values are used to interpolate the power curves, see @ref PA_POWER_FACTORS.
 */
-static const float fPowerFactors[5][6]={ 
-  {-2.11,25.66,-2.11,25.66,-2.00,31.28},   /* 915 */
-  {-2.04,23.45,-2.04,23.45,-1.95,27.66},   /* 868 */
-  {-3.48,38.45,-1.89,27.66,-1.92,30.23},   /* 433 */
-  {-3.27,35.43,-1.80,26.31,-1.89,29.61},   /* 315 */
-  {-4.18,50.66,-1.80,30.04,-1.86,32.22},   /* 169 */
-};
+static const float fPowerFactors[5][6]=PA_POWER_FACTORS;
 
 /**
 * @}
@@ -183,7 +169,8 @@ static const float fPowerFactors[5][6]={
 *         parameters in the pxSRadioInitStruct.
 * @param  pxSRadioInitStruct pointer to a SRadioInit structure that
 *         contains the configuration information for the analog radio part of SPIRIT.
-* @retval Error code: 0=no error, 1=error during calibration of VCO.
+* @retval Error code: 0=no error, 1=error during calibration of VCO or
+*         SPIRIT did not reach STANDBY or READY (see @ref SpiritWaitState()).
 */
 uint8_t SpiritRadioInit(SRadioInit* pxSRadioInitStruct)
 {
@@ -196,7 +183,7 @@ uint8_t SpiritRadioInit(SRadioInit* pxSRadioInitStruct)
   uint8_t value = 0xA0; SpiritSpiWriteRegisters(0x9F, 1, &value);
   
   /* Calculates the offset respect to RF frequency and according to xtal_ppm parameter: (xtal_ppm*FBase)/10^6 */
-  FOffsetTmp = (int32_t)(((float)pxSRadioInitStruct->nXtalOffsetPpm*pxSRadioInitStruct->lFrequencyBase)/PPM_FACTOR);
+  FOffsetTmp = SpiritFixedPpmOffset(pxSRadioInitStruct->nXtalOffsetPpm, pxSRadioInitStruct->lFrequencyBase);
   
   /* Check the parameters */
   s_assert_param(IS_FREQUENCY_BAND(pxSRadioInitStruct->lFrequencyBase));
@@ -208,13 +195,10 @@ uint8_t SpiritRadioInit(SRadioInit* pxSRadioInitStruct)
   
   /* Disable the digital, ADC, SMPS reference clock divider if fXO>24MHz or fXO<26MHz */
   SpiritSpiCommandStrobes(COMMAND_STANDBY);    
-  do{
-    /* Delay for state transition */
-    for(volatile uint8_t i=0; i!=0xFF; i++);
-    
-    /* Reads the MC_STATUS register */
-    SpiritRefreshStatus();
-  }while(g_xStatus.MC_STATE!=MC_STATE_STANDBY);
+  if(SpiritWaitState(MC_STATE_STANDBY, SPIRIT_WAIT_STATE_TIMEOUT_US)!=SPIRIT_WAIT_OK)
+  {
+    return 1;
+  }
   
   if(s_lXtalFrequency<DOUBLE_XTAL_THR)
   {
@@ -229,16 +213,13 @@ uint8_t SpiritRadioInit(SRadioInit* pxSRadioInitStruct)
   
   /* Goes in READY state */
   SpiritSpiCommandStrobes(COMMAND_READY);
-  do{
-    /* Delay for state transition */
-    for(volatile uint8_t i=0; i!=0xFF; i++);
-    
-    /* Reads the MC_STATUS register */
-    SpiritRefreshStatus();
-  }while(g_xStatus.MC_STATE!=MC_STATE_READY);
+  if(SpiritWaitState(MC_STATE_READY, SPIRIT_WAIT_XO_TIMEOUT_US)!=SPIRIT_WAIT_OK)
+  {
+    return 1;
+  }
   
   /* Calculates the FC_OFFSET parameter and cast as signed int: FOffsetTmp = (Fxtal/2^18)*FC_OFFSET */
-  xtalOffsetFactor = (int16_t)(((float)FOffsetTmp*FBASE_DIVIDER)/s_lXtalFrequency);
+  xtalOffsetFactor = SpiritFixedOffsetFactor(FOffsetTmp, s_lXtalFrequency);
   anaRadioRegArray[2] = (uint8_t)((((uint16_t)xtalOffsetFactor)>>8)&0x0F);
   anaRadioRegArray[3] = (uint8_t)(xtalOffsetFactor);
   
@@ -271,9 +252,8 @@ uint8_t SpiritRadioInit(SRadioInit* pxSRadioInitStruct)
   
   digRadioRegArray[3] = (uint8_t)((bwM<<4) | bwE);
  
-  float if_off=(3.0*480140)/(s_lXtalFrequency>>12)-64;
-  
-  uint8_t ifOffsetAna = ROUND(if_off);
+  /* IF offset: (3.0*480140)/(Fxtal>>12)-64, rounded */
+  uint8_t ifOffsetAna = SpiritFixedIfOffset(s_lXtalFrequency>>12);
   
   if(s_lXtalFrequency<DOUBLE_XTAL_THR)
   {
@@ -282,10 +262,8 @@ uint8_t SpiritRadioInit(SRadioInit* pxSRadioInitStruct)
   }
   else
   {
-    if_off=(3.0*480140)/(s_lXtalFrequency>>13)-64;
-    
     /* ... otherwise recompute it */
-    anaRadioRegArray[1] = ROUND(if_off);
+    anaRadioRegArray[1] = SpiritFixedIfOffset(s_lXtalFrequency>>13);
   }
   
   g_xStatus = SpiritSpiWriteRegisters(IF_OFFSET_ANA_BASE, 1, &ifOffsetAna);
@@ -375,7 +353,7 @@ void SpiritRadioGetInfo(SRadioInit* pxSRadioInitStruct)
   
   /* Calculates the frequency base */
   uint8_t cRefDiv = (uint8_t)SpiritRadioGetRefDiv()+1;
-  pxSRadioInitStruct->lFrequencyBase = (uint32_t)round(synthWord*(((double)s_lXtalFrequency)/(FBASE_DIVIDER*cRefDiv*s_vectcBHalfFactor[band])));
+  pxSRadioInitStruct->lFrequencyBase = SpiritFixedScaleRound(synthWord, s_lXtalFrequency, FBASE_DIVIDER*cRefDiv*s_vectcBHalfFactor[band]);
   
   /* Calculates the Offset Factor */
   uint16_t xtalOffTemp = ((((uint16_t)anaRadioRegArray[6])<<8)+((uint16_t)anaRadioRegArray[7]));
@@ -419,10 +397,10 @@ void SpiritRadioGetInfo(SRadioInit* pxSRadioInitStruct)
   pxSRadioInitStruct->lDatarate = ((s_lXtalFrequency>>(5+cDivider))*(256+digRadioRegArray[0]))>>(23-(digRadioRegArray[1]&0x0F));
   
   /* Calculates the frequency deviation */
-  pxSRadioInitStruct->lFreqDev =(uint32_t)((float)s_lXtalFrequency/(((uint32_t)1)<<18)*(uint32_t)((8.0+FDevM)/2*(1<<FDevE)));
+  pxSRadioInitStruct->lFreqDev = SpiritFixedFdev(s_lXtalFrequency, ((8+FDevM)<<FDevE)>>1);
   
   /* Reads the channel filter bandwidth from the look-up table and return it */
-  pxSRadioInitStruct->lBandwidth = (uint32_t)(100.0*s_vectnBandwidth26M[bwM+(bwE*9)]*((s_lXtalFrequency>>cDivider)/26e6));
+  pxSRadioInitStruct->lBandwidth = SpiritFixedScale(100*s_vectnBandwidth26M[bwM+(bwE*9)], s_lXtalFrequency>>cDivider, 26000000);
   
 }
 
@@ -740,13 +718,13 @@ void SpiritRadioSetFrequencyOffsetPpm(int16_t nXtalPpm)
   fBase = synthWord*(s_lXtalFrequency/(s_vectcBHalfFactor[band]*cRefDiv)/FBASE_DIVIDER);
   
   /* Calculates the offset respect to RF frequency and according to xtal_ppm parameter */
-  FOffsetTmp = (int32_t)(((float)nXtalPpm*fBase)/PPM_FACTOR);
+  FOffsetTmp = SpiritFixedPpmOffset(nXtalPpm, fBase);
   
   /* Check the Offset is in the correct range */
   s_assert_param(IS_FREQUENCY_OFFSET(FOffsetTmp,s_lXtalFrequency));
   
   /* Calculates the FC_OFFSET value to write in the corresponding register */  
-  xtalOffsetFactor = (int16_t)(((float)FOffsetTmp*FBASE_DIVIDER)/s_lXtalFrequency);
+  xtalOffsetFactor = SpiritFixedOffsetFactor(FOffsetTmp, s_lXtalFrequency);
   
   /* Build the array related to the FC_OFFSET_1 and FC_OFFSET_0 register */
   tempArray[0]=(uint8_t)((((uint16_t)xtalOffsetFactor)>>8)&0x0F);
@@ -772,7 +750,7 @@ void SpiritRadioSetFrequencyOffset(int32_t lFOffset)
   s_assert_param(IS_FREQUENCY_OFFSET(lFOffset,s_lXtalFrequency));
   
   /* Calculates the offset value to write in the FC_OFFSET register */
-  offset = (int16_t)(((float)lFOffset*FBASE_DIVIDER)/s_lXtalFrequency);
+  offset = SpiritFixedOffsetFactor(lFOffset, s_lXtalFrequency);
   
   /* Build the array related to the FC_OFFSET_1 and FC_OFFSET_0 register */
   tempArray[0]=(uint8_t)((((uint16_t)offset)>>8)&0x0F);
@@ -911,7 +889,7 @@ uint8_t SpiritRadioSetFrequencyBase(uint32_t lFBase)
   /* Search the VCO charge pump word and set the corresponding register */
   wcp = SpiritRadioSearchWCP(Fc);
   
-  synthWord = (uint32_t)(lFBase*s_vectcBHalfFactor[band]*(((double)(FBASE_DIVIDER*cRefDiv))/s_lXtalFrequency));
+  synthWord = SpiritFixedScale(lFBase*s_vectcBHalfFactor[band], FBASE_DIVIDER*cRefDiv, s_lXtalFrequency);
   
   /* Build the array of registers values for the analog part */
   anaRadioRegArray[0] = (uint8_t)(((synthWord>>21)&(0x0000001F))|(wcp<<5));
@@ -957,7 +935,7 @@ uint32_t SpiritRadioGetFrequencyBase(void)
   uint8_t cRefDiv = (uint8_t)SpiritRadioGetRefDiv() + 1;
   
   /* Calculates the frequency base and return it */
-  return (uint32_t)round(synthWord*(((double)s_lXtalFrequency)/(FBASE_DIVIDER*cRefDiv*s_vectcBHalfFactor[band])));
+  return SpiritFixedScaleRound(synthWord, s_lXtalFrequency, FBASE_DIVIDER*cRefDiv*s_vectcBHalfFactor[band]);
 }
 
 
@@ -1131,14 +1109,16 @@ void SpiritRadioSearchFreqDevME(uint32_t lFDev, uint8_t* pcM, uint8_t* pcE)
 {
   uint8_t i;
   uint32_t a,bp,b=0;
-  float xtalDivtmp=(float)s_lXtalFrequency/(((uint32_t)1)<<18);
   
   /* Check the parameters */
   s_assert_param(IS_F_DEV(lFDev,s_lXtalFrequency));
   
+  /* the xtal as a float once: the formula leaves it as it is */
+  uint32_t lXtalFloat = (uint32_t)SpiritFixedFloat(s_lXtalFrequency);
+  
   for(i=0;i<10;i++)
   {
-    a=(uint32_t)(xtalDivtmp*(uint32_t)(7.5*(1<<i)));
+    a=SpiritFixedFdev(lXtalFloat, (15<<i)>>1);
     if(lFDev<a)
       break;
   }
@@ -1147,7 +1127,7 @@ void SpiritRadioSearchFreqDevME(uint32_t lFDev, uint8_t* pcM, uint8_t* pcE)
   for(i=0;i<8;i++)
   {
     bp=b;
-    b=(uint32_t)(xtalDivtmp*(uint32_t)((8.0+i)/2*(1<<(*pcE))));
+    b=SpiritFixedFdev(lXtalFloat, ((8+i)<<(*pcE))>>1);
     if(lFDev<b)
       break;
   }
@@ -1254,7 +1234,7 @@ uint32_t SpiritRadioGetFrequencyDev(void)
   FDevE = (tempRegValue&0xF0)>>4;
   
   /* Calculates the frequency deviation and return it */  
-  return (uint32_t)((float)s_lXtalFrequency/(((uint32_t)1)<<18)*(uint32_t)((8.0+FDevM)/2*(1<<FDevE)));
+  return SpiritFixedFdev(s_lXtalFrequency, ((8+FDevM)<<FDevE)>>1);
    
 }
 
@@ -1306,7 +1286,7 @@ uint32_t SpiritRadioGetChannelBW(void)
   bwE = tempRegValue&0x0F;
   
   /* Reads the channel filter bandwidth from the look-up table and return it */
-  return (uint32_t)(100.0*s_vectnBandwidth26M[bwM+(bwE*9)]*s_lXtalFrequency/26e6);
+  return (uint32_t)(((uint64_t)100*s_vectnBandwidth26M[bwM+(bwE*9)]*s_lXtalFrequency)/26000000);
   
 }
 
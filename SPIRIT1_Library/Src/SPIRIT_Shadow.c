@@ -0,0 +1,292 @@
+/**
+  ******************************************************************************
+  * @file    SPIRIT_Shadow.c
+  * @brief   Write-through shadow of the SPIRIT configuration registers.
+  * @details See the file <i>@ref SPIRIT_Shadow.h</i> for more details.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "SPIRIT_Shadow.h"
+#include "SPIRIT_Regs.h"
+#include "MCU_Interface.h"
+#include <string.h>
+
+
+/**
+ * @addtogroup SPIRIT_Libraries
+ * @{
+ */
+
+
+/**
+ * @addtogroup SPIRIT_Shadow
+ * @{
+ */
+
+
+/**
+ * @defgroup Shadow_Private_Variables          Shadow Private Variables
+ * @{
+ */
+
+/* the shadow of the bound radio, see SPIRIT_Context.h */
+
+/**
+ * @brief  Shadow state. It is enabled by default when the module is compiled in.
+ */
+#define s_xShadowState          (g_pxSpiritContext->xShadow.xState)
+
+/**
+ * @brief  Copy of the configuration registers and validity bitmap (one bit per register).
+ */
+#define s_vectcShadow           (g_pxSpiritContext->xShadow.vectcValue)
+#define s_vectcShadowValid      (g_pxSpiritContext->xShadow.vectcValid)
+
+/**
+ * @brief  Last status received from SPIRIT, returned by the reads served locally.
+ */
+#define s_xShadowStatus         (g_pxSpiritContext->xShadow.xStatus)
+
+#define s_xShadowCounters       (g_pxSpiritContext->xShadow.xCounters)
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Shadow_Private_Macros              Shadow Private Macros
+ * @{
+ */
+
+#define SHADOW_IS_VALID(ADDR)           (s_vectcShadowValid[(ADDR)>>3] & (1<<((ADDR)&0x07)))
+#define SHADOW_SET_VALID(ADDR)          (s_vectcShadowValid[(ADDR)>>3] |= (1<<((ADDR)&0x07)))
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Shadow_Private_Functions            Shadow Private Functions
+ * @{
+ */
+
+/**
+ * @brief  Returns S_TRUE if all the registers of the range can be served by the shadow.
+ * @param  cRegAddress base register address.
+ * @param  cNbBytes number of registers.
+ * @retval SpiritBool.
+ */
+static SpiritBool SpiritShadowHit(uint8_t cRegAddress, uint8_t cNbBytes)
+{
+  uint16_t nAddress;
+
+  if(cNbBytes==0 || (uint16_t)cRegAddress+cNbBytes>SHADOW_SIZE)
+  {
+    return S_FALSE;
+  }
+
+  for(nAddress=cRegAddress; nAddress<(uint16_t)cRegAddress+cNbBytes; nAddress++)
+  {
+    if(IS_SHADOW_VOLATILE(nAddress) || !SHADOW_IS_VALID(nAddress))
+    {
+      return S_FALSE;
+    }
+  }
+
+  return S_TRUE;
+}
+
+/**
+ * @brief  Stores the values of a register range in the shadow, skipping the volatile registers.
+ * @param  cRegAddress base register address.
+ * @param  cNbBytes number of registers.
+ * @param  pcBuffer register values.
+ * @retval None.
+ */
+static void SpiritShadowStore(uint8_t cRegAddress, uint8_t cNbBytes, uint8_t* pcBuffer)
+{
+  uint16_t nAddress;
+
+  for(nAddress=cRegAddress; nAddress<(uint16_t)cRegAddress+cNbBytes && nAddress<SHADOW_SIZE; nAddress++)
+  {
+    if(!IS_SHADOW_VOLATILE(nAddress))
+    {
+      s_vectcShadow[nAddress] = pcBuffer[nAddress-cRegAddress];
+      SHADOW_SET_VALID(nAddress);
+    }
+  }
+}
+
+/**
+ * @brief  Enables or disables the register shadow. Disabling also invalidates it.
+ * @param  xNewState new state of the shadow.
+ *         This parameter can be: S_ENABLE or S_DISABLE.
+ * @retval None.
+ */
+void SpiritShadowEnable(SpiritFunctionalState xNewState)
+{
+  s_assert_param(IS_SPIRIT_FUNCTIONAL_STATE(xNewState));
+
+  if(xNewState==S_DISABLE)
+  {
+    SpiritShadowInvalidate();
+  }
+  s_xShadowState = xNewState;
+}
+
+/**
+ * @brief  Returns the state of the register shadow.
+ * @param  None.
+ * @retval SpiritFunctionalState S_ENABLE if the shadow is in use.
+ */
+SpiritFunctionalState SpiritShadowGetState(void)
+{
+  return s_xShadowState;
+}
+
+/**
+ * @brief  Forgets all the shadowed values. The following reads go to the bus.
+ *         To be called whenever SPIRIT loses its configuration outside the
+ *         control of this library (power cycle, external reset).
+ * @param  None.
+ * @retval None.
+ */
+void SpiritShadowInvalidate(void)
+{
+  memset(s_vectcShadowValid, 0, sizeof(s_vectcShadowValid));
+  s_xShadowCounters.lInvalidations++;
+}
+
+/**
+ * @brief  Returns the SPI traffic counters of the shadow.
+ * @param  pxCounters pointer to the counters to fill.
+ * @retval None.
+ */
+void SpiritShadowGetCounters(SpiritShadowCounters* pxCounters)
+{
+  *pxCounters = s_xShadowCounters;
+}
+
+/**
+ * @brief  Clears the SPI traffic counters of the shadow.
+ * @param  None.
+ * @retval None.
+ */
+void SpiritShadowResetCounters(void)
+{
+  memset(&s_xShadowCounters, 0, sizeof(s_xShadowCounters));
+}
+
+/**
+ * @brief  Returns the shadowed value of a register, without an SPI transaction.
+ * @param  cRegAddress register address.
+ * @param  pcValue pointer to the value, filled when the shadow knows the register.
+ * @retval SpiritBool S_TRUE if the register is in the shadow.
+ */
+SpiritBool SpiritShadowPeek(uint8_t cRegAddress, uint8_t* pcValue)
+{
+  if(s_xShadowState!=S_ENABLE || !SpiritShadowHit(cRegAddress, 1))
+  {
+    return S_FALSE;
+  }
+
+  *pcValue = s_vectcShadow[cRegAddress];
+  return S_TRUE;
+}
+
+/**
+ * @brief  Writes the registers through to SPIRIT and updates the shadow.
+ * @param  cRegAddress base register address.
+ * @param  cNbBytes number of registers to write.
+ * @param  pcBuffer register values.
+ * @retval SpiritStatus status returned by the transaction.
+ */
+SpiritStatus SpiritShadowWriteRegisters(uint8_t cRegAddress, uint8_t cNbBytes, uint8_t* pcBuffer)
+{
+  s_xShadowStatus = SpiritBusWriteRegisters(cRegAddress, cNbBytes, pcBuffer);
+  s_xShadowCounters.lTransactions++;
+
+  if(s_xShadowState==S_ENABLE)
+  {
+    SpiritShadowStore(cRegAddress, cNbBytes, pcBuffer);
+  }
+
+  return s_xShadowStatus;
+}
+
+/**
+ * @brief  Reads registers, from the shadow when possible and from SPIRIT otherwise.
+ * @param  cRegAddress base register address.
+ * @param  cNbBytes number of registers to read.
+ * @param  pcBuffer buffer for the register values.
+ * @retval SpiritStatus status returned by the transaction, or the last known
+ *         status when the read has been served by the shadow.
+ */
+SpiritStatus SpiritShadowReadRegisters(uint8_t cRegAddress, uint8_t cNbBytes, uint8_t* pcBuffer)
+{
+  if(s_xShadowState==S_ENABLE && SpiritShadowHit(cRegAddress, cNbBytes))
+  {
+    memcpy(pcBuffer, &s_vectcShadow[cRegAddress], cNbBytes);
+    s_xShadowCounters.lTransactionsSaved++;
+    s_xShadowCounters.lBytesSaved += 2+cNbBytes;
+    return s_xShadowStatus;
+  }
+
+  s_xShadowStatus = SpiritBusReadRegisters(cRegAddress, cNbBytes, pcBuffer);
+  s_xShadowCounters.lTransactions++;
+
+  if(s_xShadowState==S_ENABLE)
+  {
+    SpiritShadowStore(cRegAddress, cNbBytes, pcBuffer);
+  }
+
+  return s_xShadowStatus;
+}
+
+/**
+ * @brief  Sends a command strobe. The SRES command invalidates the shadow
+ *         since it brings all the registers back to their reset values.
+ * @param  cCommandCode command code.
+ * @retval SpiritStatus status returned by the transaction.
+ */
+SpiritStatus SpiritShadowCommandStrobes(uint8_t cCommandCode)
+{
+  s_xShadowStatus = SpiritBusCommandStrobes(cCommandCode);
+  s_xShadowCounters.lTransactions++;
+
+  if(cCommandCode==COMMAND_SRES)
+  {
+    SpiritShadowInvalidate();
+  }
+
+  return s_xShadowStatus;
+}
+
+/**
+ * @brief  Puts SPIRIT in shutdown and invalidates the shadow, since the
+ *         register content is lost.
+ * @param  None.
+ * @retval None.
+ */
+void SpiritShadowEnterShutdown(void)
+{
+  SpiritBusEnterShutdown();
+  SpiritShadowInvalidate();
+}
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
@@ -0,0 +1,401 @@
+/**
+  ******************************************************************************
+  * @file    SPIRIT_SpiClock.c
+  * @brief   Discovery of the highest reliable SPI clock of a SPIRIT.
+  * @details See the file <i>@ref SPIRIT_SpiClock.h</i> for more details.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "SPIRIT_SpiClock.h"
+#include "MCU_Interface.h"
+#include <string.h>
+
+
+/**
+ * @addtogroup SPIRIT_Libraries
+ * @{
+ */
+
+
+/**
+ * @addtogroup SPIRIT_SpiClock
+ * @{
+ */
+
+
+/**
+ * @defgroup SpiClock_Private_Defines          SPI Clock Private Defines
+ * @{
+ */
+
+/**
+ * @brief  Registers under test: AES_KEY_IN_15..0 and SYNC4..1.
+ */
+#define SPI_CLOCK_KEY_SIZE      16
+#define SPI_CLOCK_SYNC_SIZE     4
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup SpiClock_Private_Variables        SPI Clock Private Variables
+ * @{
+ */
+
+/* the SPI clock of the bound radio, see SPIRIT_Context.h */
+
+#define s_lSpiClockHz           (g_pxSpiritContext->xSpiClock.lHz)
+#define s_lSpiClockMinHz        (g_pxSpiritContext->xSpiClock.lMinHz)
+#define s_lSpiClockStepHz       (g_pxSpiritContext->xSpiClock.lStepHz)
+#define s_xSpiClockCounters     (g_pxSpiritContext->xSpiClock.xCounters)
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup SpiClock_Private_Functions        SPI Clock Private Functions
+ * @{
+ */
+
+/**
+ * @brief  Sets the SPI clock.
+ * @param  lHz the clock in Hz.
+ * @retval None.
+ */
+static void SpiritSpiClockSet(uint32_t lHz)
+{
+  RadioSpiSetBaudrate(lHz);
+  s_lSpiClockHz = lHz;
+}
+
+/**
+ * @brief  Tells if the clock can be stepped down.
+ * @param  None.
+ * @retval SpiritBool S_TRUE if a scan range is known and the clock is above its lowest rate.
+ */
+static SpiritBool SpiritSpiClockCanDegrade(void)
+{
+  return (SpiritBool)(s_lSpiClockStepHz!=0 && s_lSpiClockHz>s_lSpiClockMinHz);
+}
+
+/**
+ * @brief  Returns a byte of a test pattern: all zeros, all ones, the two
+ *         alternate bit patterns, then values that change with the address.
+ * @param  cRound round of the pattern.
+ * @param  cIndex position of the byte in the registers under test.
+ * @retval uint8_t the byte.
+ */
+static uint8_t SpiritSpiClockPattern(uint8_t cRound, uint8_t cIndex)
+{
+  switch(cRound%5)
+  {
+  case 0:
+    return 0x00;
+  case 1:
+    return 0xFF;
+  case 2:
+    return 0x55;
+  case 3:
+    return 0xAA;
+  default:
+    return (uint8_t)(0xA5 + 0x3B*cIndex + cRound);
+  }
+}
+
+/**
+ * @brief  Writes the registers under test.
+ * @param  pcKey AES key input, @ref SPI_CLOCK_KEY_SIZE bytes.
+ * @param  pcSync sync word, @ref SPI_CLOCK_SYNC_SIZE bytes.
+ * @retval None.
+ */
+static void SpiritSpiClockWrite(uint8_t* pcKey, uint8_t* pcSync)
+{
+  RadioSpiWriteRegisters(AES_KEY_IN_15_BASE, SPI_CLOCK_KEY_SIZE, pcKey);
+  g_xStatus = RadioSpiWriteRegisters(SYNC4_BASE, SPI_CLOCK_SYNC_SIZE, pcSync);
+}
+
+/**
+ * @brief  Reads the registers under test.
+ * @param  pcKey AES key input, @ref SPI_CLOCK_KEY_SIZE bytes.
+ * @param  pcSync sync word, @ref SPI_CLOCK_SYNC_SIZE bytes.
+ * @retval None.
+ */
+static void SpiritSpiClockRead(uint8_t* pcKey, uint8_t* pcSync)
+{
+  RadioSpiReadRegisters(AES_KEY_IN_15_BASE, SPI_CLOCK_KEY_SIZE, pcKey);
+  g_xStatus = RadioSpiReadRegisters(SYNC4_BASE, SPI_CLOCK_SYNC_SIZE, pcSync);
+}
+
+/**
+ * @brief  Writes the registers under test and reads them back.
+ * @param  pcKey AES key input, @ref SPI_CLOCK_KEY_SIZE bytes.
+ * @param  pcSync sync word, @ref SPI_CLOCK_SYNC_SIZE bytes.
+ * @retval SpiritBool S_TRUE if the readback matches.
+ */
+static SpiritBool SpiritSpiClockWriteCheck(uint8_t* pcKey, uint8_t* pcSync)
+{
+  uint8_t vectcKey[SPI_CLOCK_KEY_SIZE], vectcSync[SPI_CLOCK_SYNC_SIZE];
+
+  SpiritSpiClockWrite(pcKey, pcSync);
+  SpiritSpiClockRead(vectcKey, vectcSync);
+
+  return (SpiritBool)(memcmp(vectcKey, pcKey, SPI_CLOCK_KEY_SIZE)==0 &&
+                      memcmp(vectcSync, pcSync, SPI_CLOCK_SYNC_SIZE)==0);
+}
+
+/**
+ * @brief  Runs pattern rounds at the current clock.
+ * @param  cRounds number of rounds.
+ * @retval SpiritBool S_TRUE if every readback matched.
+ */
+static SpiritBool SpiritSpiClockRounds(uint8_t cRounds)
+{
+  uint8_t vectcKey[SPI_CLOCK_KEY_SIZE], vectcSync[SPI_CLOCK_SYNC_SIZE];
+  uint8_t cRound, i;
+
+  for(cRound=0; cRound<cRounds; cRound++)
+  {
+    for(i=0; i<SPI_CLOCK_KEY_SIZE; i++)
+    {
+      vectcKey[i] = SpiritSpiClockPattern(cRound, i);
+    }
+    for(i=0; i<SPI_CLOCK_SYNC_SIZE; i++)
+    {
+      vectcSync[i] = SpiritSpiClockPattern(cRound, SPI_CLOCK_KEY_SIZE+i);
+    }
+
+    s_xSpiClockCounters.lRounds++;
+    if(!SpiritSpiClockWriteCheck(vectcKey, vectcSync))
+    {
+      s_xSpiClockCounters.lErrors++;
+      return S_FALSE;
+    }
+  }
+
+  return S_TRUE;
+}
+
+/**
+ * @brief  Checks the current clock with pattern rounds and steps it down until
+ *         the rounds pass or the lowest rate is reached. The registers under
+ *         test are read at the lowest rate before and get their content back
+ *         at the final one.
+ * @param  cRounds number of rounds at each rate.
+ * @retval SpiritBool S_TRUE if the current clock passed at once.
+ */
+static SpiritBool SpiritSpiClockVerify(uint8_t cRounds)
+{
+  uint8_t vectcKey[SPI_CLOCK_KEY_SIZE], vectcSync[SPI_CLOCK_SYNC_SIZE];
+  uint32_t lHz = s_lSpiClockHz;
+  SpiritBool xClean;
+
+  /* the content to give back, read at a rate that works */
+  if(s_lSpiClockMinHz!=0 && lHz!=s_lSpiClockMinHz)
+  {
+    SpiritSpiClockSet(s_lSpiClockMinHz);
+    SpiritSpiClockRead(vectcKey, vectcSync);
+    SpiritSpiClockSet(lHz);
+  }
+  else
+  {
+    SpiritSpiClockRead(vectcKey, vectcSync);
+  }
+
+  xClean = SpiritSpiClockRounds(cRounds);
+  if(!xClean)
+  {
+    while(SpiritSpiClockCanDegrade())
+    {
+      SpiritSpiClockDegrade();
+      if(SpiritSpiClockRounds(cRounds))
+      {
+        break;
+      }
+    }
+  }
+
+  while(!SpiritSpiClockWriteCheck(vectcKey, vectcSync) && SpiritSpiClockCanDegrade())
+  {
+    SpiritSpiClockDegrade();
+  }
+
+  return xClean;
+}
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup SpiClock_Public_Functions         SPI Clock Public Functions
+ * @{
+ */
+
+/**
+ * @brief  Scans the SPI clock from lMinHz up to lMaxHz and selects the highest
+ *         rate that passed the patterns, cMarginSteps steps down. The scan stops
+ *         at the first rate that fails.
+ * @param  pxSpiClockInit pointer to the scan parameters.
+ * @retval uint32_t the selected clock in Hz, 0 if even lMinHz failed: the clock
+ *         is then left at lMinHz.
+ */
+uint32_t SpiritSpiClockCalibrate(const SpiClockInit* pxSpiClockInit)
+{
+  uint8_t vectcKey[SPI_CLOCK_KEY_SIZE], vectcSync[SPI_CLOCK_SYNC_SIZE];
+  uint32_t lHz, lCleanHz = 0, lMarginHz;
+
+  s_assert_param(IS_SPI_CLOCK_INIT(pxSpiClockInit->lMinHz, pxSpiClockInit->lMaxHz, pxSpiClockInit->lStepHz));
+
+  s_lSpiClockMinHz = pxSpiClockInit->lMinHz;
+  s_lSpiClockStepHz = pxSpiClockInit->lStepHz;
+
+  SpiritSpiClockSet(pxSpiClockInit->lMinHz);
+  SpiritSpiClockRead(vectcKey, vectcSync);
+
+  for(lHz=pxSpiClockInit->lMinHz; lHz<=pxSpiClockInit->lMaxHz; lHz+=pxSpiClockInit->lStepHz)
+  {
+    SpiritSpiClockSet(lHz);
+    if(!SpiritSpiClockRounds(pxSpiClockInit->cRounds))
+    {
+      break;
+    }
+    lCleanHz = lHz;
+  }
+
+  if(lCleanHz==0)
+  {
+    SpiritSpiClockSet(pxSpiClockInit->lMinHz);
+    SpiritSpiClockWriteCheck(vectcKey, vectcSync);
+    return 0;
+  }
+
+  lMarginHz = (uint32_t)pxSpiClockInit->cMarginSteps*pxSpiClockInit->lStepHz;
+  if(lMarginHz>lCleanHz-pxSpiClockInit->lMinHz)
+  {
+    lMarginHz = lCleanHz-pxSpiClockInit->lMinHz;
+  }
+  SpiritSpiClockSet(lCleanHz-lMarginHz);
+
+  while(!SpiritSpiClockWriteCheck(vectcKey, vectcSync) && SpiritSpiClockCanDegrade())
+  {
+    SpiritSpiClockDegrade();
+  }
+
+  return s_lSpiClockHz;
+}
+
+/**
+ * @brief  Applies a clock selected by an earlier @ref SpiritSpiClockCalibrate(),
+ *         e.g. saved in non volatile memory, after a check with
+ *         @ref SPIRIT_SPI_CLOCK_CHECK_ROUNDS pattern rounds. If the check
+ *         fails the clock is stepped down like in @ref SpiritSpiClockCheck().
+ * @param  lHz the saved clock in Hz.
+ * @param  pxSpiClockInit pointer to the scan parameters, for the lowest rate
+ *         and the step.
+ * @retval SpiritBool S_TRUE if the saved clock passed the check, S_FALSE if it
+ *         is out of the scan range or had to be stepped down: calibrate again.
+ */
+SpiritBool SpiritSpiClockRestore(uint32_t lHz, const SpiClockInit* pxSpiClockInit)
+{
+  s_assert_param(IS_SPI_CLOCK_INIT(pxSpiClockInit->lMinHz, pxSpiClockInit->lMaxHz, pxSpiClockInit->lStepHz));
+
+  s_lSpiClockMinHz = pxSpiClockInit->lMinHz;
+  s_lSpiClockStepHz = pxSpiClockInit->lStepHz;
+
+  if(lHz<pxSpiClockInit->lMinHz || lHz>pxSpiClockInit->lMaxHz)
+  {
+    SpiritSpiClockSet(pxSpiClockInit->lMinHz);
+    return S_FALSE;
+  }
+
+  SpiritSpiClockSet(lHz);
+  return SpiritSpiClockVerify(SPIRIT_SPI_CLOCK_CHECK_ROUNDS);
+}
+
+/**
+ * @brief  Checks the current clock with @ref SPIRIT_SPI_CLOCK_CHECK_ROUNDS
+ *         pattern rounds and, on a corrupted readback, steps it down until
+ *         the rounds pass or the lowest rate of the scan is reached.
+ *         Without an earlier calibration or restore the clock is only checked.
+ * @param  None.
+ * @retval SpiritBool S_TRUE if the current clock passed at once.
+ */
+SpiritBool SpiritSpiClockCheck(void)
+{
+  return SpiritSpiClockVerify(SPIRIT_SPI_CLOCK_CHECK_ROUNDS);
+}
+
+/**
+ * @brief  Steps the SPI clock down by one step of the scan, not below its
+ *         lowest rate. Does nothing without an earlier calibration or restore.
+ * @param  None.
+ * @retval uint32_t the new clock in Hz.
+ */
+uint32_t SpiritSpiClockDegrade(void)
+{
+  if(!SpiritSpiClockCanDegrade())
+  {
+    return s_lSpiClockHz;
+  }
+
+  s_xSpiClockCounters.lDegrades++;
+  if(s_lSpiClockHz-s_lSpiClockMinHz>s_lSpiClockStepHz)
+  {
+    SpiritSpiClockSet(s_lSpiClockHz-s_lSpiClockStepHz);
+  }
+  else
+  {
+    SpiritSpiClockSet(s_lSpiClockMinHz);
+  }
+
+  return s_lSpiClockHz;
+}
+
+/**
+ * @brief  Returns the SPI clock set by this module.
+ * @param  None.
+ * @retval uint32_t the clock in Hz, 0 if it has not been set: the driver default.
+ */
+uint32_t SpiritSpiClockGet(void)
+{
+  return s_lSpiClockHz;
+}
+
+/**
+ * @brief  Returns the counters of the SPI clock discovery.
+ * @param  pxCounters pointer to the counters to fill.
+ * @retval None.
+ */
+void SpiritSpiClockGetCounters(SpiritSpiClockCounters* pxCounters)
+{
+  *pxCounters = s_xSpiClockCounters;
+}
+
+/**
+ * @brief  Clears the counters of the SPI clock discovery.
+ * @param  None.
+ * @retval None.
+ */
+void SpiritSpiClockResetCounters(void)
+{
+  memset(&s_xSpiClockCounters, 0, sizeof(s_xSpiClockCounters));
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
@@ -0,0 +1,390 @@
+/**
+  ******************************************************************************
+  * @file    SPIRIT_Stream.c
+  * @brief   Streaming TX and RX of packets larger than the linear FIFO.
+  * @details See the file <i>@ref SPIRIT_Stream.h</i> for more details.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "SPIRIT_Stream.h"
+#include "SPIRIT_Commands.h"
+#include "SPIRIT_LinearFifo.h"
+#include "SPIRIT_Management.h"
+#include "MCU_Interface.h"
+#include <string.h>
+
+
+/**
+ * @addtogroup SPIRIT_Libraries
+ * @{
+ */
+
+
+/**
+ * @addtogroup SPIRIT_Stream
+ * @{
+ */
+
+
+/**
+ * @defgroup Stream_Private_Defines            Stream Private Defines
+ * @{
+ */
+
+/**
+ * @brief  Values of cMode.
+ */
+#define STREAM_MODE_NONE        0
+#define STREAM_MODE_TX          1
+#define STREAM_MODE_RX          2
+
+/**
+ * @brief  IRQs of a transmission and of a reception.
+ */
+#define STREAM_TX_IRQS          (TX_FIFO_ALMOST_EMPTY | TX_FIFO_ERROR | TX_DATA_SENT)
+#define STREAM_RX_IRQS          (RX_FIFO_ALMOST_FULL | RX_FIFO_ERROR | RX_DATA_READY | RX_DATA_DISC)
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Stream_Private_Variables          Stream Private Variables
+ * @{
+ */
+
+/* the stream of the bound radio, see SPIRIT_Context.h */
+
+#define s_cStreamMode           (g_pxSpiritContext->xStream.cMode)
+#define s_cStreamTxChunk        (g_pxSpiritContext->xStream.cTxChunk)
+#define s_pcStreamBuffer        (g_pxSpiritContext->xStream.pcBuffer)
+#define s_nStreamLength         (g_pxSpiritContext->xStream.nLength)
+#define s_nStreamPosition       (g_pxSpiritContext->xStream.nPosition)
+#define s_xStreamCounters       (g_pxSpiritContext->xStream.xCounters)
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Stream_Private_Functions          Stream Private Functions
+ * @{
+ */
+
+/**
+ * @brief  Enables or disables a set of IRQs with one write of the IRQ_MASK registers.
+ * @param  lIrqs the IRQs, a combination of @ref IrqList values.
+ * @param  xNewState new state of the IRQs.
+ * @retval None.
+ */
+static void SpiritStreamArm(uint32_t lIrqs, SpiritFunctionalState xNewState)
+{
+  uint8_t tempRegValue[4];
+  uint32_t tempValue = 0;
+  uint8_t i;
+
+  g_xStatus = SpiritSpiReadRegisters(IRQ_MASK3_BASE, 4, tempRegValue);
+  for(i=0; i<4; i++)
+  {
+    tempValue |= ((uint32_t)tempRegValue[i])<<(8*(3-i));
+  }
+
+  if(xNewState == S_DISABLE)
+  {
+    tempValue &= ~lIrqs;
+  }
+  else
+  {
+    tempValue |= lIrqs;
+  }
+
+  for(i=0; i<4; i++)
+  {
+    tempRegValue[i] = (uint8_t)(tempValue>>(8*(3-i)));
+  }
+  g_xStatus = SpiritSpiWriteRegisters(IRQ_MASK3_BASE, 4, tempRegValue);
+}
+
+/**
+ * @brief  Writes the next bytes of the payload into the TX FIFO.
+ * @param  cMaxBytes room in the TX FIFO.
+ * @retval None.
+ */
+static void SpiritStreamFill(uint8_t cMaxBytes)
+{
+  uint16_t nBytes = s_nStreamLength-s_nStreamPosition;
+
+  if(nBytes>cMaxBytes)
+  {
+    nBytes = cMaxBytes;
+  }
+  if(nBytes!=0)
+  {
+    g_xStatus = SpiritSpiWriteLinearFifo((uint8_t)nBytes, &s_pcStreamBuffer[s_nStreamPosition]);
+    s_nStreamPosition += nBytes;
+  }
+}
+
+/**
+ * @brief  Reads the content of the RX FIFO into the buffer.
+ * @param  None.
+ * @retval SpiritBool S_FALSE if the buffer is too short for it.
+ */
+static SpiritBool SpiritStreamDrain(void)
+{
+  uint8_t cBytes = SpiritLinearFifoReadNumElementsRxFifo();
+
+  if(cBytes>s_nStreamLength-s_nStreamPosition)
+  {
+    return S_FALSE;
+  }
+  if(cBytes!=0)
+  {
+    g_xStatus = SpiritSpiReadLinearFifo(cBytes, &s_pcStreamBuffer[s_nStreamPosition]);
+    s_nStreamPosition += cBytes;
+    s_xStreamCounters.lDrains++;
+  }
+
+  return S_TRUE;
+}
+
+/**
+ * @brief  Ends the stream: disarms the almost empty/almost full IRQs and, if
+ *         the packet did not complete, stops the radio and flushes the FIFO.
+ * @param  xResult outcome of the stream.
+ * @retval SpiritStreamResult xResult.
+ */
+static SpiritStreamResult SpiritStreamEnd(SpiritStreamResult xResult)
+{
+  uint8_t cMode = s_cStreamMode;
+
+  s_cStreamMode = STREAM_MODE_NONE;
+  SpiritStreamArm(cMode==STREAM_MODE_TX ? TX_FIFO_ALMOST_EMPTY : RX_FIFO_ALMOST_FULL, S_DISABLE);
+
+  if(xResult!=SPIRIT_STREAM_DONE)
+  {
+    if(xResult!=SPIRIT_STREAM_DISCARDED)
+    {
+      SpiritCmdStrobeSabort();
+    }
+    if(cMode==STREAM_MODE_TX)
+    {
+      SpiritCmdStrobeFlushTxFifo();
+    }
+    else
+    {
+      SpiritCmdStrobeFlushRxFifo();
+    }
+  }
+
+  return xResult;
+}
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Stream_Public_Functions           Stream Public Functions
+ * @{
+ */
+
+/**
+ * @brief  Sets the refill and drain levels: the TX FIFO almost empty threshold
+ *         and the RX FIFO almost full threshold.
+ * @param  pxStreamInit pointer to the levels.
+ * @retval None.
+ */
+void SpiritStreamInit(const StreamInit* pxStreamInit)
+{
+  s_assert_param(IS_STREAM_LEVEL(pxStreamInit->cTxRefillLevel));
+  s_assert_param(IS_STREAM_LEVEL(pxStreamInit->cRxDrainLevel));
+
+  SpiritLinearFifoSetAlmostEmptyThresholdTx(pxStreamInit->cTxRefillLevel);
+  /* the almost full threshold counts from the top of the FIFO */
+  SpiritLinearFifoSetAlmostFullThresholdRx(SPIRIT_STREAM_FIFO_SIZE-pxStreamInit->cRxDrainLevel);
+
+  s_cStreamTxChunk = SPIRIT_STREAM_FIFO_SIZE-pxStreamInit->cTxRefillLevel;
+}
+
+/**
+ * @brief  Fills the TX FIFO with the start of the payload, arms the TX IRQs and
+ *         sends the TX command. The rest of the payload is written by
+ *         @ref SpiritStreamHandleIrqs(). The buffer must stay valid until the
+ *         stream ends.
+ * @param  pcBuffer the payload.
+ * @param  nLength length of the payload, as set in the packet length.
+ * @retval SpiritBool S_FALSE if a stream is running or the levels have not
+ *         been set with @ref SpiritStreamInit().
+ */
+SpiritBool SpiritStreamTxStart(uint8_t* pcBuffer, uint16_t nLength)
+{
+  if(s_cStreamMode!=STREAM_MODE_NONE || s_cStreamTxChunk==0)
+  {
+    return S_FALSE;
+  }
+
+  s_cStreamMode = STREAM_MODE_TX;
+  s_pcStreamBuffer = pcBuffer;
+  s_nStreamLength = nLength;
+  s_nStreamPosition = 0;
+  s_xStreamCounters.lTxStreams++;
+
+  SpiritCmdStrobeFlushTxFifo();
+  SpiritStreamFill(SPIRIT_STREAM_FIFO_SIZE);
+  SpiritStreamArm(STREAM_TX_IRQS, S_ENABLE);
+  SpiritCmdStrobeTx();
+
+  return S_TRUE;
+}
+
+/**
+ * @brief  Arms the RX IRQs and sends the RX command. The payload is read into
+ *         the buffer by @ref SpiritStreamHandleIrqs(), which must stay valid
+ *         until the stream ends.
+ * @param  pcBuffer buffer for the payload.
+ * @param  nMaxLength size of the buffer: a longer payload aborts the reception.
+ * @retval SpiritBool S_FALSE if a stream is running.
+ */
+SpiritBool SpiritStreamRxStart(uint8_t* pcBuffer, uint16_t nMaxLength)
+{
+  if(s_cStreamMode!=STREAM_MODE_NONE)
+  {
+    return S_FALSE;
+  }
+
+  s_cStreamMode = STREAM_MODE_RX;
+  s_pcStreamBuffer = pcBuffer;
+  s_nStreamLength = nMaxLength;
+  s_nStreamPosition = 0;
+  s_xStreamCounters.lRxStreams++;
+
+  SpiritCmdStrobeFlushRxFifo();
+  SpiritStreamArm(STREAM_RX_IRQS, S_ENABLE);
+  SpiritCmdStrobeRx();
+
+  return S_TRUE;
+}
+
+/**
+ * @brief  Serves the FIFO IRQs of the running stream, to be called with the
+ *         IRQ status read by the IRQ handler: refills the TX FIFO, drains the
+ *         RX FIFO, ends the stream on completion or error.
+ * @param  pxIrqStatus the IRQ status.
+ * @retval SpiritStreamResult state of the stream: SPIRIT_STREAM_BUSY while the
+ *         packet is on the air, the outcome when the stream ends with this
+ *         call, SPIRIT_STREAM_IDLE if no stream is running.
+ */
+SpiritStreamResult SpiritStreamHandleIrqs(const SpiritIrqs* pxIrqStatus)
+{
+  if(s_cStreamMode==STREAM_MODE_TX)
+  {
+    if(pxIrqStatus->IRQ_TX_FIFO_ERROR)
+    {
+      s_xStreamCounters.lUnderflows++;
+      return SpiritStreamEnd(SPIRIT_STREAM_UNDERFLOW);
+    }
+    if(pxIrqStatus->IRQ_TX_DATA_SENT)
+    {
+      return SpiritStreamEnd(SPIRIT_STREAM_DONE);
+    }
+    if(pxIrqStatus->IRQ_TX_FIFO_ALMOST_EMPTY && s_nStreamPosition<s_nStreamLength)
+    {
+      /* the FIFO holds at most the refill level: the chunk always fits */
+      SpiritStreamFill(s_cStreamTxChunk);
+      s_xStreamCounters.lRefills++;
+    }
+    return SPIRIT_STREAM_BUSY;
+  }
+
+  if(s_cStreamMode==STREAM_MODE_RX)
+  {
+    if(pxIrqStatus->IRQ_RX_FIFO_ERROR)
+    {
+      s_xStreamCounters.lOverflows++;
+      return SpiritStreamEnd(SPIRIT_STREAM_OVERFLOW);
+    }
+    if(pxIrqStatus->IRQ_RX_DATA_DISC)
+    {
+      s_xStreamCounters.lDiscarded++;
+      return SpiritStreamEnd(SPIRIT_STREAM_DISCARDED);
+    }
+    if(pxIrqStatus->IRQ_RX_FIFO_ALMOST_FULL || pxIrqStatus->IRQ_RX_DATA_READY)
+    {
+      if(!SpiritStreamDrain())
+      {
+        s_xStreamCounters.lOverflows++;
+        return SpiritStreamEnd(SPIRIT_STREAM_OVERFLOW);
+      }
+    }
+    if(pxIrqStatus->IRQ_RX_DATA_READY)
+    {
+      return SpiritStreamEnd(SPIRIT_STREAM_DONE);
+    }
+    return SPIRIT_STREAM_BUSY;
+  }
+
+  return SPIRIT_STREAM_IDLE;
+}
+
+/**
+ * @brief  Stops the running stream, e.g. after a timeout of the application:
+ *         aborts the transmission or the reception and flushes the FIFO.
+ * @param  None.
+ * @retval None.
+ */
+void SpiritStreamAbort(void)
+{
+  if(s_cStreamMode!=STREAM_MODE_NONE)
+  {
+    SpiritStreamEnd(SPIRIT_STREAM_IDLE);
+  }
+}
+
+/**
+ * @brief  Returns the progress of the last stream.
+ * @param  None.
+ * @retval uint16_t bytes written to the TX FIFO or read from the RX FIFO: the
+ *         received payload length once a reception is done.
+ */
+uint16_t SpiritStreamGetLength(void)
+{
+  return s_nStreamPosition;
+}
+
+/**
+ * @brief  Returns the counters of the streams.
+ * @param  pxCounters pointer to the counters to fill.
+ * @retval None.
+ */
+void SpiritStreamGetCounters(SpiritStreamCounters* pxCounters)
+{
+  *pxCounters = s_xStreamCounters;
+}
+
+/**
+ * @brief  Clears the counters of the streams.
+ * @param  None.
+ * @retval None.
+ */
+void SpiritStreamResetCounters(void)
+{
+  memset(&s_xStreamCounters, 0, sizeof(s_xStreamCounters));
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
@@ -71,6 +71,11 @@
  * @{
  */
 
+#define TIMER_FACTOR_MIN        2              /*!< Smallest register value + 1: a register at 0 is the infinite RX timeout */
+#define TIMER_FACTOR_MAX        256            /*!< Largest register value + 1 */
+#define RX_TIMEOUT_TICK_DEN     1210000000     /*!< 1210 clock cycles per tick, times 10^6 us per s */
+#define WAKEUP_TICK_DEN         1000000        /*!< One RCO cycle per tick, times 10^6 us per s */
+
 /**
  *@}
  */
@@ -81,6 +86,13 @@
  * @{
  */
 
+#define TIMER_MIN(a, b)         ((a)<(b) ? (a) : (b))
+#define TIMER_MAX(a, b)         ((a)<(b) ? (b) : (a))
+
+/* A candidate period of the search: its distance to the ticks in whole ticks, then its smaller and its
+   larger factor, so that the least key is the closest period and, on a tie, the one of smallest prescaler */
+#define TIMER_KEY(lDist, lMin, lMax)   (((uint32_t)(lDist)<<18) | ((uint32_t)(lMin)<<9) | (uint32_t)(lMax))
+
 
 /**
  *@}
@@ -102,6 +114,10 @@
  * @{
  */
 
+static uint32_t SpiritTimerMsToUs(float fDesiredMsec);
+static void SpiritTimerSearchCandidates(uint32_t lTicks, uint32_t p, uint32_t* plBelow, uint32_t* plAbove);
+static uint32_t SpiritTimerRxTimeoutClock(void);
+
 /**
  *@}
  */
@@ -112,6 +128,71 @@
  * @{
  */
 
+/**
+ * @brief  Converts a time in ms to us, rounded, saturated to the range of uint32_t.
+ * @param  fDesiredMsec time in ms.
+ * @retval Time in us.
+ */
+static uint32_t SpiritTimerMsToUs(float fDesiredMsec)
+{
+  if(fDesiredMsec<=0)
+    return 0;
+  if(fDesiredMsec>=4294967.0f)
+    return 0xFFFFFFFF;
+  return (uint32_t)(fDesiredMsec*1000+0.5f);
+}
+
+
+/**
+ * @brief  Returns the clock of the rx_timeout timer before its division by 1210: the xtal frequency,
+ *         halved for a doubled xtal.
+ * @retval Clock frequency in Hz.
+ */
+static uint32_t SpiritTimerRxTimeoutClock(void)
+{
+  uint32_t nXtalFrequency = SpiritRadioGetXtalFrequency();
+
+  /* if xtal is doubled divide it by 2 */
+  if(nXtalFrequency>DOUBLE_XTAL_THR) {
+    nXtalFrequency >>= 1;
+  }
+
+  return nXtalFrequency;
+}
+
+
+/**
+ * @brief  Ranks the periods of prescaler factor p closest to lTicks, below (or at) and above it, among
+ *         the candidates of @ref SpiritTimerSearchValues(). The counter factors around lTicks/p are
+ *         saturated to the range.
+ * @param  lTicks whole ticks of the period searched.
+ * @param  p prescaler factor.
+ * @param  plBelow pointer to the best key, see @ref TIMER_KEY, of a period up to lTicks.
+ * @param  plAbove pointer to the best key of a period above lTicks.
+ * @retval None
+ */
+static void SpiritTimerSearchCandidates(uint32_t lTicks, uint32_t p, uint32_t* plBelow, uint32_t* plAbove)
+{
+  uint32_t c, lPeriod, lKey, lQuot = lTicks/p;
+
+  for(uint8_t i=0; i<2; i++, lQuot++)
+  {
+    c = lQuot<TIMER_FACTOR_MIN ? TIMER_FACTOR_MIN : (lQuot>TIMER_FACTOR_MAX ? TIMER_FACTOR_MAX : lQuot);
+    lPeriod = p*c;
+    if(lPeriod>lTicks)
+    {
+      lKey = TIMER_KEY(lPeriod-lTicks, TIMER_MIN(p, c), TIMER_MAX(p, c));
+      *plAbove = TIMER_MIN(*plAbove, lKey);
+    }
+    else
+    {
+      lKey = TIMER_KEY(lTicks-lPeriod, TIMER_MIN(p, c), TIMER_MAX(p, c));
+      *plBelow = TIMER_MIN(*plBelow, lKey);
+    }
+  }
+}
+
+
 /**
  * @brief  Enables or Disables the LDCR mode.
  * @param  xNewState new state for LDCR mode.
@@ -226,6 +307,25 @@ void SpiritTimerSetRxTimeoutMs(float fDesiredMsec)
 }
 
 
+/**
+ * @brief  Sets the RX timeout timer counter and prescaler from the desired value in us, without float.
+ * @param  lDesiredUsec desired timer value.
+ *         This parameter must be an uint32_t.
+ * @retval None
+ */
+void SpiritTimerSetRxTimeoutUs(uint32_t lDesiredUsec)
+{
+  uint8_t tempRegValue[2];
+
+  /* Computes the counter and prescaler value */
+  SpiritTimerComputeRxTimeoutValuesUs(lDesiredUsec , &tempRegValue[1] , &tempRegValue[0]);
+
+  /* Writes the prescaler and counter value for RX timeout in the corresponding register */
+  g_xStatus = SpiritSpiWriteRegisters(TIMERS5_RX_TIMEOUT_PRESCALER_BASE, 2, tempRegValue);
+
+}
+
+
 /**
  * @brief  Sets the RX timeout timer counter. If it is equal to 0 the timeout is infinite.
  * @param  cCounter value for the timer counter.
@@ -525,8 +625,8 @@ uint16_t SpiritTimerGetRcoFrequency(void)
 
 /**
  * @brief  Computes the values of the wakeup timer counter and prescaler from the user time expressed in millisecond.
- *         The prescaler and the counter values are computed maintaining the prescaler value as
- *         small as possible in order to obtain the best resolution, and in the meantime minimizing the error.
+ *         The time is rounded to us and the values are the ones of least error, see
+ *         @ref SpiritTimerComputeWakeUpValuesUs().
  * @param  fDesiredMsec desired wakeup timeout in millisecs.
  *         This parameter must be a float. Since the counter and prescaler are 8 bit registers the maximum
  *         reachable value is maxTime = fTclk x 256 x 256.
@@ -538,52 +638,14 @@ uint16_t SpiritTimerGetRcoFrequency(void)
  */
 void SpiritTimerComputeWakeUpValues(float fDesiredMsec , uint8_t* pcCounter , uint8_t* pcPrescaler)
 {
-  float rco_freq,err;
-  uint32_t n;
-  
-  rco_freq=((float)SpiritTimerGetRcoFrequency())/1000;
-  
-  /* N cycles in the time base of the timer: 
-     - clock of the timer is RCO frequency
-     - divide times 1000 more because we have an input in ms (variable rco_freq is already this frequency divided by 1000)
-  */
-  n=(uint32_t)(fDesiredMsec*rco_freq);
-    
-  /* check if it is possible to reach that target with prescaler and counter of spirit1 */
-  if(n/0xFF>0xFD)
-  {
-    /* if not return the maximum possible value */
-    (*pcCounter) = 0xFF;
-    (*pcPrescaler) = 0xFF;
-    return;
-  }
-  
-  /* prescaler is really 2 as min value */
-  (*pcPrescaler)=(n/0xFF)+2;
-  (*pcCounter) = n / (*pcPrescaler);
-  
-  /* check if the error is minimum */
-  err=S_ABS((float)(*pcCounter)*(*pcPrescaler)/rco_freq-fDesiredMsec);
-  
-  if((*pcCounter)<=254)
-  {
-    if(S_ABS((float)((*pcCounter)+1)*(*pcPrescaler)/rco_freq-fDesiredMsec)<err)
-      (*pcCounter)=(*pcCounter)+1;
-  }
-    
-  /* decrement prescaler and counter according to the logic of this timer in spirit1 */
-  (*pcPrescaler)--;
-  if((*pcCounter)>1)
-    (*pcCounter)--;
-  else
-    (*pcCounter)=1;
+  SpiritTimerComputeWakeUpValuesUs(SpiritTimerMsToUs(fDesiredMsec), pcCounter, pcPrescaler);
 }
 
 
 /**
  * @brief  Computes the values of the rx_timeout timer counter and prescaler from the user time expressed in millisecond.
- *         The prescaler and the counter values are computed maintaining the prescaler value as
- *         small as possible in order to obtain the best resolution, and in the meantime minimizing the error.
+ *         The time is rounded to us and the values are the ones of least error, see
+ *         @ref SpiritTimerComputeRxTimeoutValuesUs().
  * @param  fDesiredMsec desired rx_timeout in millisecs.
  *         This parameter must be a float. Since the counter and prescaler are 8 bit registers the maximum
  *         reachable value is maxTime = fTclk x 255 x 255.
@@ -595,49 +657,151 @@ void SpiritTimerComputeWakeUpValues(float fDesiredMsec , uint8_t* pcCounter , ui
  */
 void SpiritTimerComputeRxTimeoutValues(float fDesiredMsec , uint8_t* pcCounter , uint8_t* pcPrescaler)
 {
-  uint32_t nXtalFrequency = SpiritRadioGetXtalFrequency();
-  uint32_t n;
-  float err;
-  
-  /* if xtal is doubled divide it by 2 */
-  if(nXtalFrequency>DOUBLE_XTAL_THR) {
-    nXtalFrequency >>= 1;
-  }
-  
-  /* N cycles in the time base of the timer: 
-     - clock of the timer is xtal/1210
-     - divide times 1000 more because we have an input in ms
-  */
-  n=(uint32_t)(fDesiredMsec*nXtalFrequency/1210000);
-  
-  /* check if it is possible to reach that target with prescaler and counter of spirit1 */
-  if(n/0xFF>0xFD)
+  SpiritTimerComputeRxTimeoutValuesUs(SpiritTimerMsToUs(fDesiredMsec), pcCounter, pcPrescaler);
+}
+
+
+/**
+ * @brief  Searches the counter and prescaler values of the timer period closest to a number of ticks of
+ *         the timer clock, given as the fraction llTicksNum/lTicksDen. The period is
+ *         (PRESCALER+1)*(COUNTER+1) ticks, with both registers in the range [1:255]: the pair is the one
+ *         of least error among all of them and, on a tie, the one of smallest prescaler.
+ *         For each prescaler factor p only the two counter factors around ticks/p can be the closest,
+ *         and the search runs over p from ticks/256, below which the counter is saturated, to the square
+ *         root of the ticks, above which the factors swap roles: at most 66 steps of one 32 bit division,
+ *         ended early by a period of the least possible error. The candidates are ranked by their distance
+ *         in whole ticks, the remainder weighs in once at the end. A timeout set over and over is
+ *         best computed once, with @ref SpiritTimerComputeRxTimeoutTable() or
+ *         @ref SpiritTimerComputeWakeUpTable(), and set from its values.
+ * @param  llTicksNum numerator of the number of ticks.
+ * @param  lTicksDen denominator of the number of ticks, not 0.
+ * @param  pxValues pointer to the values found.
+ * @retval None
+ */
+void SpiritTimerSearchValues(uint64_t llTicksNum, uint32_t lTicksDen, TimerValues* pxValues)
+{
+  uint32_t lTicks, lRem, p, lQuot, lRest, lStopBelow, lStopAbove, lBelow = 0xFFFFFFFF, lAbove = 0xFFFFFFFF;
+  uint64_t llErrBelow, llErrAbove;
+
+  /* beyond the longest period: the maximum possible value */
+  if(llTicksNum/lTicksDen>=(uint64_t)TIMER_FACTOR_MAX*TIMER_FACTOR_MAX)
   {
-    /* if not return the maximum possible value */
-    (*pcCounter) = 0xFF;
-    (*pcPrescaler) = 0xFF;
+    pxValues->cPrescaler = TIMER_FACTOR_MAX-1;
+    pxValues->cCounter = TIMER_FACTOR_MAX-1;
     return;
   }
-  
-  /* prescaler is really 2 as min value */
-  (*pcPrescaler)=(n/0xFF)+2;
-  (*pcCounter) = n / (*pcPrescaler);
-  
-  /* check if the error is minimum */
-  err=S_ABS((float)(*pcCounter)*(*pcPrescaler)*1210000/nXtalFrequency-fDesiredMsec);
-  
-  if((*pcCounter)<=254)
+
+  /* whole ticks and remainder: a period lTicks-d is off by d*lTicksDen+lRem, lTicks+d by d*lTicksDen-lRem */
+  lTicks = (uint32_t)(llTicksNum/lTicksDen);
+  lRem = (uint32_t)(llTicksNum-(uint64_t)lTicks*lTicksDen);
+
+  /* the least possible error, on which the search ends: a period of lTicks, or of lTicks+1 past half a tick */
+  lStopBelow = 2*(uint64_t)lRem<=lTicksDen ? TIMER_KEY(1, 0, 0) : 0;
+  lStopAbove = 2*(uint64_t)lRem>=lTicksDen ? TIMER_KEY(2, 0, 0) : 0;
+
+  /* first the greedy guess of the float search, the prescaler factor below which the counter is saturated */
+  p = lTicks/TIMER_FACTOR_MAX;
+  if(p<TIMER_FACTOR_MIN)
+    p = TIMER_FACTOR_MIN;
+  SpiritTimerSearchCandidates(lTicks, p, &lBelow, &lAbove);
+
+  /* p*p reached llTicksNum/lTicksDen: the factors swap roles */
+  while(lBelow>=lStopBelow && lAbove>=lStopAbove && p*p<lTicks+(lRem!=0))
   {
-    if(S_ABS((float)((*pcCounter)+1)*(*pcPrescaler)*1210000/nXtalFrequency-fDesiredMsec)<err)
-      (*pcCounter)=(*pcCounter)+1;
+    p++;
+    lQuot = lTicks/p;
+    if(lQuot<TIMER_FACTOR_MIN)
+    {
+      SpiritTimerSearchCandidates(lTicks, p, &lBelow, &lAbove);
+      continue;
+    }
+
+    /* past the first factor lQuot+1 is in range too: lQuot*p is below by lRest ticks, (lQuot+1)*p above */
+    lRest = lTicks-lQuot*p;
+    lBelow = TIMER_MIN(lBelow, TIMER_KEY(lRest, TIMER_MIN(p, lQuot), TIMER_MAX(p, lQuot)));
+    lAbove = TIMER_MIN(lAbove, TIMER_KEY(p-lRest, TIMER_MIN(p, lQuot+1), TIMER_MAX(p, lQuot+1)));
+  }
+
+  /* the closest of the two, the smaller prescaler on a tie */
+  llErrBelow = lBelow==0xFFFFFFFF ? (uint64_t)-1 : (uint64_t)(lBelow>>18)*lTicksDen+lRem;
+  llErrAbove = lAbove==0xFFFFFFFF ? (uint64_t)-1 : (uint64_t)(lAbove>>18)*lTicksDen-lRem;
+  if(llErrAbove<llErrBelow || (llErrAbove==llErrBelow && (lAbove&0x3FFFF)<(lBelow&0x3FFFF)))
+    lBelow = lAbove;
+
+  pxValues->cPrescaler = (uint8_t)(((lBelow>>9)&0x1FF)-1);
+  pxValues->cCounter = (uint8_t)((lBelow&0x1FF)-1);
+}
+
+
+/**
+ * @brief  Computes the values of the wakeup timer counter and prescaler from the time expressed in us,
+ *         with @ref SpiritTimerSearchValues(): the period (PRESCALER+1)*(COUNTER+1)/fRCO closest to it.
+ * @param  lDesiredUsec desired wakeup timeout in us.
+ * @param  pcCounter pointer to the variable in which the value for the wakeup timer counter has to be stored.
+ * @param  pcPrescaler pointer to the variable in which the value for the wakeup timer prescaler has to be stored.
+ * @retval None
+ */
+void SpiritTimerComputeWakeUpValuesUs(uint32_t lDesiredUsec, uint8_t* pcCounter, uint8_t* pcPrescaler)
+{
+  TimerValues xValues;
+
+  SpiritTimerComputeWakeUpTable(&lDesiredUsec, 1, &xValues);
+  (*pcCounter) = xValues.cCounter;
+  (*pcPrescaler) = xValues.cPrescaler;
+}
+
+
+/**
+ * @brief  Computes the values of the rx_timeout timer counter and prescaler from the time expressed in us,
+ *         with @ref SpiritTimerSearchValues(): the period (PRESCALER+1)*(COUNTER+1)*1210/fclk closest to it.
+ * @param  lDesiredUsec desired rx_timeout in us.
+ * @param  pcCounter pointer to the variable in which the value for the rx_timeout counter has to be stored.
+ * @param  pcPrescaler pointer to the variable in which the value for the rx_timeout prescaler has to be stored.
+ * @retval None
+ */
+void SpiritTimerComputeRxTimeoutValuesUs(uint32_t lDesiredUsec, uint8_t* pcCounter, uint8_t* pcPrescaler)
+{
+  TimerValues xValues;
+
+  SpiritTimerComputeRxTimeoutTable(&lDesiredUsec, 1, &xValues);
+  (*pcCounter) = xValues.cCounter;
+  (*pcPrescaler) = xValues.cPrescaler;
+}
+
+
+/**
+ * @brief  Computes the wakeup timer values of a table of times, for the RCO frequency read once.
+ * @param  plDesiredUsec pointer to the times in us.
+ * @param  cCount number of times.
+ * @param  pxValues pointer to the cCount values computed, to be set with @ref SpiritTimerSetWakeUpTimer().
+ * @retval None
+ */
+void SpiritTimerComputeWakeUpTable(const uint32_t* plDesiredUsec, uint8_t cCount, TimerValues* pxValues)
+{
+  uint32_t lRcoFrequency = SpiritTimerGetRcoFrequency();
+
+  for(uint8_t i=0; i<cCount; i++)
+  {
+    SpiritTimerSearchValues((uint64_t)plDesiredUsec[i]*lRcoFrequency, WAKEUP_TICK_DEN, &pxValues[i]);
+  }
+}
+
+
+/**
+ * @brief  Computes the rx_timeout timer values of a table of times, for the xtal frequency read once.
+ * @param  plDesiredUsec pointer to the times in us.
+ * @param  cCount number of times.
+ * @param  pxValues pointer to the cCount values computed, to be set with @ref SpiritTimerSetRxTimeout().
+ * @retval None
+ */
+void SpiritTimerComputeRxTimeoutTable(const uint32_t* plDesiredUsec, uint8_t cCount, TimerValues* pxValues)
+{
+  uint32_t lClock = SpiritTimerRxTimeoutClock();
+
+  for(uint8_t i=0; i<cCount; i++)
+  {
+    SpiritTimerSearchValues((uint64_t)plDesiredUsec[i]*lClock, RX_TIMEOUT_TICK_DEN, &pxValues[i]);
   }
-    
-  /* decrement prescaler and counter according to the logic of this timer in spirit1 */
-  (*pcPrescaler)--;
-  if((*pcCounter)>1)
-    (*pcCounter)--;
-  else
-    (*pcCounter)=1;
 }
 
 
@@ -89,13 +89,10 @@
  */
 
 /**
- * @brief  Spirit Status global variable.
- *         This global variable of @ref SpiritStatus type is updated on every SPI transaction
- *         to maintain memory of Spirit Status.
+ * @brief  The Spirit Status (g_xStatus), updated on every SPI transaction to maintain
+ *         memory of Spirit Status, is part of the bound radio context, see SPIRIT_Context.c.
  */
 
-volatile SpiritStatus g_xStatus;
-
 /**
  * @}
  */
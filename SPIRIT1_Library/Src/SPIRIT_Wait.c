@@ -0,0 +1,276 @@
+/**
+  ******************************************************************************
+  * @file    SPIRIT_Wait.c
+  * @brief   Bounded waits for a SPIRIT main controller state.
+  * @details See the file <i>@ref SPIRIT_Wait.h</i> for more details.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "SPIRIT_Wait.h"
+#include "MCU_Interface.h"
+#include <string.h>
+
+
+/**
+ * @addtogroup SPIRIT_Libraries
+ * @{
+ */
+
+
+/**
+ * @addtogroup SPIRIT_Wait
+ * @{
+ */
+
+
+/**
+ * @defgroup Wait_Private_Variables            Wait Private Variables
+ * @{
+ */
+
+/* the waits of the bound radio, see SPIRIT_Context.h */
+
+#define s_xWaitCounters         (g_pxSpiritContext->xWait.xCounters)
+
+/**
+ * @brief  SPIRIT GPIO wired to the MCU for the waits, 0 if none.
+ */
+#define s_cWaitGpio             (g_pxSpiritContext->xWait.cGpio)
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Wait_Private_Functions            Wait Private Functions
+ * @{
+ */
+
+/**
+ * @brief  Reads MC_STATE0 and updates g_xStatus with the status bytes of the
+ *         transaction. The read is repeated while the status bytes and the
+ *         register disagree, i.e. while the state is changing.
+ * @param  plPolls budget of polls, decremented for each read.
+ * @retval SpiritBool S_TRUE if g_xStatus holds a stable state.
+ */
+static SpiritBool SpiritWaitPoll(uint32_t* plPolls)
+{
+  uint8_t cMcState0;
+
+  while(*plPolls!=0)
+  {
+    (*plPolls)--;
+    g_xStatus = SpiritSpiReadRegisters(MC_STATE0_BASE, 1, &cMcState0);
+    s_xWaitCounters.lPolls++;
+
+    if(((uint8_t*)&g_xStatus)[0]==cMcState0)
+    {
+      return S_TRUE;
+    }
+  }
+
+  return S_FALSE;
+}
+
+#ifdef SPIRIT_USE_WAIT_GPIO
+/**
+ * @brief  Returns the digital output of the GPIO that is high in a state.
+ * @param  xState state to wait for.
+ * @retval uint8_t the SpiritGpioIO value, 0 if the state has none.
+ */
+static uint8_t SpiritWaitGpioSignal(SpiritState xState)
+{
+  switch(xState)
+  {
+  case MC_STATE_READY:
+    return SPIRIT_GPIO_DIG_OUT_READY;
+  case MC_STATE_LOCK:
+    return SPIRIT_GPIO_DIG_OUT_LOCK;
+  case MC_STATE_RX:
+    return SPIRIT_GPIO_DIG_OUT_RX_STATE;
+  case MC_STATE_TX:
+    return SPIRIT_GPIO_DIG_OUT_TX_STATE;
+  case MC_STATE_STANDBY:
+  case MC_STATE_SLEEP:
+    return SPIRIT_GPIO_DIG_OUT_SLEEP_OR_STANDBY;
+  default:
+    return 0;
+  }
+}
+
+/**
+ * @brief  Maps the wait GPIO to the output of a state and blocks until it is high.
+ * @param  xState state to wait for.
+ * @param  lTimeoutUs timeout in us.
+ * @param  plPolls budget of polls of the wait, cut to one poll if the GPIO
+ *         times out: it only tells why.
+ * @retval SpiritBool S_TRUE if the state has been reached.
+ */
+static SpiritBool SpiritWaitGpio(SpiritState xState, uint32_t lTimeoutUs, uint32_t* plPolls)
+{
+  uint8_t cSignal = SpiritWaitGpioSignal(xState);
+  uint8_t cConf, cCurrent;
+
+  if(s_cWaitGpio==0 || cSignal==0)
+  {
+    return S_FALSE;
+  }
+
+#ifdef SPIRIT_USE_WRITE_BATCH
+  /* the configuration would be kept pending */
+  if(SpiritBatchIsOpen())
+  {
+    return S_FALSE;
+  }
+#endif
+
+  cConf = SPIRIT_GPIO_MODE_DIGITAL_OUTPUT_LP | cSignal;
+
+#ifdef SPIRIT_USE_REGISTER_SHADOW
+  /* free when the register is in the shadow, otherwise not worth a read */
+  if(SpiritShadowGetState()==S_ENABLE)
+  {
+    SpiritSpiReadRegisters(s_cWaitGpio, 1, &cCurrent);
+  }
+  else
+  {
+    cCurrent = (uint8_t)~cConf;
+  }
+#else
+  cCurrent = (uint8_t)~cConf;
+#endif
+
+  if(cCurrent!=cConf)
+  {
+    g_xStatus = SpiritSpiWriteRegisters(s_cWaitGpio, 1, &cConf);
+    s_xWaitCounters.lGpioRemaps++;
+  }
+
+  s_xWaitCounters.lGpioWaits++;
+  if(RadioWaitGpioHigh(lTimeoutUs)==S_RESET)
+  {
+    *plPolls = 1;
+    return S_FALSE;
+  }
+
+  /* no transaction to take the status bytes from */
+  g_xStatus.MC_STATE = xState;
+  return S_TRUE;
+}
+#endif
+
+/**
+ * @}
+ */
+
+
+/**
+ * @defgroup Wait_Public_Functions             Wait Public Functions
+ * @{
+ */
+
+/**
+ * @brief  Waits until the SPIRIT main controller is in a given state, or for at
+ *         most lTimeoutUs. On return g_xStatus holds the last state read.
+ * @param  xState state to wait for.
+ * @param  lTimeoutUs timeout in us, see @ref SPIRIT_WAIT_POLL_US when the wait polls.
+ * @retval SpiritWaitResult SPIRIT_WAIT_OK if the state has been reached,
+ *         SPIRIT_WAIT_LOCK_ERROR if xState is MC_STATE_LOCK and the synthesizer
+ *         has reported LOCKWON more than @ref SPIRIT_WAIT_LOCKWON_MAX times,
+ *         SPIRIT_WAIT_TIMEOUT otherwise.
+ */
+SpiritWaitResult SpiritWaitState(SpiritState xState, uint32_t lTimeoutUs)
+{
+  uint32_t lPolls = lTimeoutUs/SPIRIT_WAIT_POLL_US + 1;
+  uint8_t cLockwon = 0;
+
+  s_xWaitCounters.lWaits++;
+
+#ifdef SPIRIT_USE_WAIT_GPIO
+  if(SpiritWaitGpio(xState, lTimeoutUs, &lPolls))
+  {
+    return SPIRIT_WAIT_OK;
+  }
+#endif
+
+  while(SpiritWaitPoll(&lPolls))
+  {
+    if(g_xStatus.MC_STATE==xState)
+    {
+      return SPIRIT_WAIT_OK;
+    }
+    if(xState==MC_STATE_LOCK && g_xStatus.MC_STATE==MC_STATE_LOCKWON && ++cLockwon>SPIRIT_WAIT_LOCKWON_MAX)
+    {
+      s_xWaitCounters.lFailures++;
+      return SPIRIT_WAIT_LOCK_ERROR;
+    }
+  }
+
+  s_xWaitCounters.lFailures++;
+  if(xState==MC_STATE_LOCK && g_xStatus.MC_STATE==MC_STATE_LOCKWON)
+  {
+    return SPIRIT_WAIT_LOCK_ERROR;
+  }
+  return SPIRIT_WAIT_TIMEOUT;
+}
+
+/**
+ * @brief  Returns the counters of the waits.
+ * @param  pxCounters pointer to the counters to fill.
+ * @retval None.
+ */
+void SpiritWaitGetCounters(SpiritWaitCounters* pxCounters)
+{
+  *pxCounters = s_xWaitCounters;
+}
+
+/**
+ * @brief  Clears the counters of the waits.
+ * @param  None.
+ * @retval None.
+ */
+void SpiritWaitResetCounters(void)
+{
+  memset(&s_xWaitCounters, 0, sizeof(s_xWaitCounters));
+}
+
+#ifdef SPIRIT_USE_WAIT_GPIO
+/**
+ * @brief  Selects the SPIRIT GPIO the waits block on. The board must route it
+ *         to the pin RadioWaitGpioHigh() watches. The GPIO is reconfigured by
+ *         the waits and should not be used for anything else.
+ * @param  xGpio the GPIO.
+ *         This parameter can be any value of @ref SpiritGpioPin.
+ * @retval None.
+ */
+void SpiritWaitGpioInit(SpiritGpioPin xGpio)
+{
+  s_assert_param(IS_SPIRIT_GPIO(xGpio));
+  s_cWaitGpio = (uint8_t)xGpio;
+}
+
+/**
+ * @brief  Goes back to polling for all the waits.
+ * @param  None.
+ * @retval None.
+ */
+void SpiritWaitGpioDeInit(void)
+{
+  s_cWaitGpio = 0;
+}
+#endif
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
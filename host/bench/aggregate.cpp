@@ -0,0 +1,208 @@
+/**
+ * Small records packed into frames by spirit1Aggregate.h against one frame
+ * per record, over the simulated medium (spirit1Medium.h) between two
+ * simulated SPIRIT1.
+ *
+ *   spirit1-bench-aggregate [records] [datarate] [records/s offered]
+ *
+ * The records are 6 to 20 bytes. The sender sends a frame as soon as the
+ * aggregator has one due and the previous frame is out (TX_DATA_SENT), the
+ * receiver unpacks every frame on RX_DATA_READY. "1 per frame" is the
+ * aggregator with maxBytes 1: one record per frame, behind its length byte.
+ *
+ * saturated: every record is there from the start, rec/s is what the link
+ * carries at most, air/rec the airtime per record, rec/frame the records per
+ * frame. offered: records come at a steady rate, ms mean and max: latency
+ * from the arrival of a record to its reception.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SPIRIT_Config.h"
+#include "spirit1Aggregate.h"
+#include "spirit1Medium.h"
+#include "standInTransport.h"
+
+static const uint8_t FRAME = 96;
+
+struct Node {
+    explicit Node(Spirit1SimClock &clock) : sim(&clock), sending(false) { SpiritContextInit(&context, 0); }
+
+    Spirit1Sim sim;
+    SpiritContext context;
+    uint8_t address;
+    bool sending;
+};
+
+static uint32_t records, datarate, rate;
+
+static void use(Node &node) {
+    standInBus().use(&node.sim);
+    SpiritContextBind(&node.context);
+}
+
+static void nodeInit(Node &node) {
+    SRadioInit radio = {0, 868000000, 20000, 0, FSK, datarate, datarate / 2,
+                        3 * datarate < 800000 ? 3 * datarate : 800000};
+    PktStackInit stack = {PKT_PREAMBLE_LENGTH_04BYTES, PKT_SYNC_LENGTH_4BYTES, 0x1A2635A8, PKT_LENGTH_VAR, 7,
+                          PKT_CRC_MODE_16BITS_1, PKT_CONTROL_LENGTH_0BYTES, S_DISABLE, S_ENABLE};
+    PktStackAddressesInit addresses = {S_ENABLE, node.address, S_DISABLE, 0xEE, S_DISABLE, 0xFF};
+    SGpioInit gpioIrq = {SPIRIT_GPIO_3, SPIRIT_GPIO_MODE_DIGITAL_OUTPUT_LP, SPIRIT_GPIO_DIG_OUT_IRQ};
+
+    use(node);
+    SpiritCmdStrobeSres();
+    SpiritRadioSetXtalFrequency(50000000);
+    SpiritRadioInit(&radio);
+    SpiritPktStackInit(&stack);
+    SpiritPktStackSetVarLengthWidth(FRAME, PKT_CONTROL_LENGTH_0BYTES);
+    SpiritPktStackAddressesInit(&addresses);
+    SpiritGpioInit(&gpioIrq);
+    SpiritIrqDeInit(NULL);
+    SpiritIrq(TX_DATA_SENT, S_ENABLE);
+    SpiritIrq(RX_DATA_READY, S_ENABLE);
+    SpiritIrq(RX_DATA_DISC, S_ENABLE);
+    SpiritIrqClearStatus();
+}
+
+/* record k: 6 to 20 bytes, k (LE) then a filler that depends on k */
+static uint8_t fill(uint8_t *record, uint32_t k) {
+    uint8_t length = (uint8_t) (6 + (k * 7) % 15);
+    for (uint8_t i = 0; i < length; i++) record[i] = (uint8_t) (k * 13 + i);
+    memcpy(record, &k, sizeof(k));
+    return length;
+}
+
+typedef struct {
+    uint32_t delivered;
+    uint32_t frames;
+    uint64_t airtimeNs;
+    uint64_t elapsedNs;
+    uint64_t latencyNs;
+    uint64_t maxLatencyNs;
+} Result;
+
+/* interval 0: saturated */
+static Result run(uint8_t maxBytes, uint32_t maxDelayUs, uint64_t intervalNs) {
+    Spirit1SimClock clock;
+    Spirit1Medium medium;
+    Node sender(clock), receiver(clock);
+    Spirit1Aggregator<FRAME> aggregator(maxBytes, maxDelayUs);
+    uint8_t record[FRAME], frame[FRAME];
+    Result result = Result();
+    uint32_t added = 0;
+
+    sender.address = 0x10;
+    receiver.address = 0x20;
+    medium.attach(sender.sim);
+    medium.attach(receiver.sim);
+    nodeInit(sender);
+    nodeInit(receiver);
+    use(receiver);
+    SpiritCmdStrobeRx();
+
+    uint64_t start = clock.now();
+    while (result.delivered < records) {
+        uint64_t now = clock.now() - start;
+        uint32_t nowUs = (uint32_t) (now / 1000);
+        uint32_t arrived = intervalNs ? (uint32_t) (now / intervalNs) + 1 : records;
+        if (arrived > records) arrived = records;
+
+        if (sender.sim.irqPending()) {
+            SpiritIrqs irqs;
+            use(sender);
+            SpiritIrqGetStatus(&irqs);
+            if (irqs.IRQ_TX_DATA_SENT) sender.sending = false;
+        }
+        if (receiver.sim.irqPending()) {
+            SpiritIrqs irqs;
+            use(receiver);
+            SpiritIrqGetStatus(&irqs);
+            if (irqs.IRQ_RX_DATA_READY) {
+                uint8_t length = SpiritLinearFifoReadNumElementsRxFifo();
+                SpiritSpiReadLinearFifo(length, frame);
+                Spirit1RecordReader reader(frame, length);
+                const uint8_t *received;
+                while ((received = reader.next(&length)) != NULL) {
+                    uint32_t k;
+                    memcpy(&k, received, sizeof(k));
+                    if (k != result.delivered || fill(record, k) != length || memcmp(record, received, length)) continue;
+                    uint64_t latency = now - (intervalNs ? k * intervalNs : 0);
+                    result.latencyNs += latency;
+                    if (latency > result.maxLatencyNs) result.maxLatencyNs = latency;
+                    result.delivered++;
+                }
+            }
+            if (irqs.IRQ_RX_DATA_READY || irqs.IRQ_RX_DATA_DISC) SpiritCmdStrobeRx();
+        }
+
+        /* records wait in the application until the frame being built has room */
+        while (added < arrived) {
+            uint8_t length = fill(record, added);
+            if (!aggregator.add(record, length, nowUs)) break;
+            added++;
+        }
+        if (!sender.sending && (aggregator.due(nowUs) || (added == records && !aggregator.empty()))) {
+            uint8_t length = aggregator.take(frame);
+            use(sender);
+            SpiritPktStackSetPayloadLength(length);
+            SpiritPktCommonSetDestinationAddress(receiver.address);
+            SpiritSpiWriteLinearFifo(length, frame);
+            SpiritCmdStrobeTx();
+            sender.sending = true;
+            result.frames++;
+            result.airtimeNs += sender.sim.airtimeNs(length);
+            continue;
+        }
+
+        if (!sender.sim.irqPending() && !receiver.sim.irqPending()) {
+            uint64_t next = clock.nextEventNs();
+            if (added < records && intervalNs) {
+                uint64_t arrival = start + (uint64_t) arrived * intervalNs;
+                if (arrival < next) next = arrival;
+            }
+            if (!aggregator.empty() && !sender.sending) {
+                uint64_t deadline = start + (uint64_t) aggregator.deadlineUs() * 1000;
+                if (deadline < next) next = deadline;
+            }
+            clock.advance(next > clock.now() ? next - clock.now() : 1000);
+        }
+    }
+    result.elapsedNs = clock.now() - start;
+
+    standInBus().use(NULL);
+    SpiritContextBind(NULL);
+    return result;
+}
+
+int main(int argc, char **argv) {
+    static const struct {
+        const char *name;
+        uint8_t maxBytes;
+        uint32_t maxDelayUs;
+    } configs[] = {
+        {"1 per frame", 1, 0},
+        {"32 B  5 ms", 32, 5000},
+        {"64 B  5 ms", 64, 5000},
+        {"96 B  5 ms", 96, 5000},
+        {"96 B 20 ms", 96, 20000},
+        {"96 B 50 ms", 96, 50000},
+    };
+    records = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 2000;
+    datarate = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 0) : 38400;
+    rate = argc > 3 ? (uint32_t) strtoul(argv[3], NULL, 0) : 150;
+
+    printf("SPIRIT1 aggregation, %u records of 6 to 20 bytes, %u bps, %u records/s offered\r\n", records, datarate,
+           rate);
+    printf("%-12s %28s   %21s\r\n", "", "saturated", "offered");
+    printf("%-12s %9s %9s %9s %10s %10s %10s\r\n", "", "rec/s", "air/rec", "rec/frame", "rec/s", "ms mean", "ms max");
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        Result saturated = run(configs[c].maxBytes, configs[c].maxDelayUs, 0);
+        Result offered = run(configs[c].maxBytes, configs[c].maxDelayUs, 1000000000ULL / rate);
+        printf("%-12s %9.1f %7.0fus %9.2f %10.1f %10.2f %10.2f\r\n", configs[c].name,
+               saturated.delivered / (saturated.elapsedNs / 1e9), (double) saturated.airtimeNs / saturated.delivered / 1000,
+               (double) saturated.delivered / saturated.frames, offered.delivered / (offered.elapsedNs / 1e9),
+               (double) offered.latencyNs / offered.delivered / 1e6, offered.maxLatencyNs / 1e6);
+    }
+    return 0;
+}
@@ -0,0 +1,272 @@
+/**
+ * Goodput of the selective repeat ARQ of spirit1Arq.h against LLP style stop
+ * and wait, over the simulated medium (spirit1Medium.h) at several loss
+ * rates. The loss rate applies to every frame, data and ACK alike.
+ *
+ *   spirit1-bench-arq [frames] [datarate] [payload bytes]
+ *
+ * The simulated chip does not do the LLP auto-ack, so stop and wait is run
+ * by the MCUs the way the LLP runs it: a 2 bit sequence number, the receiver
+ * answers every frame at once with a 1 byte ACK, the sender listens for it
+ * for the ACK airtime plus 1 ms and retransmits up to 15 times (NMaxReTx)
+ * before it gives the frame up.
+ *
+ * recv: frames delivered in order and intact; lost: given up; retx:
+ * retransmissions; t/o: ACKs waited for in vain; kbps: payload bits
+ * delivered per second of virtual time.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SPIRIT_Config.h"
+#include "spirit1Arq.h"
+#include "spirit1Medium.h"
+#include "standInTransport.h"
+
+static const uint8_t FRAME = 96;
+static const uint32_t LLP_MAX_RETX = 15;
+static const uint64_t LIMIT_NS = 600000000000ULL;
+
+struct Node {
+    explicit Node(Spirit1SimClock &clock) : sim(&clock), sending(false) { SpiritContextInit(&context, 0); }
+
+    Spirit1Sim sim;
+    SpiritContext context;
+    uint8_t address;
+    bool sending;
+};
+
+static uint32_t frames, datarate;
+static uint8_t payloadLength;
+
+static void use(Node &node) {
+    standInBus().use(&node.sim);
+    SpiritContextBind(&node.context);
+}
+
+static void nodeInit(Node &node) {
+    SRadioInit radio = {0, 868000000, 20000, 0, FSK, datarate, datarate / 2,
+                        3 * datarate < 800000 ? 3 * datarate : 800000};
+    PktStackInit stack = {PKT_PREAMBLE_LENGTH_04BYTES, PKT_SYNC_LENGTH_4BYTES, 0x1A2635A8, PKT_LENGTH_VAR, 7,
+                          PKT_CRC_MODE_16BITS_1, PKT_CONTROL_LENGTH_0BYTES, S_DISABLE, S_ENABLE};
+    PktStackAddressesInit addresses = {S_ENABLE, node.address, S_DISABLE, 0xEE, S_DISABLE, 0xFF};
+    SGpioInit gpioIrq = {SPIRIT_GPIO_3, SPIRIT_GPIO_MODE_DIGITAL_OUTPUT_LP, SPIRIT_GPIO_DIG_OUT_IRQ};
+
+    use(node);
+    SpiritCmdStrobeSres();
+    SpiritRadioSetXtalFrequency(50000000);
+    SpiritRadioInit(&radio);
+    SpiritPktStackInit(&stack);
+    SpiritPktStackSetVarLengthWidth(FRAME, PKT_CONTROL_LENGTH_0BYTES);
+    SpiritPktStackAddressesInit(&addresses);
+    SpiritGpioInit(&gpioIrq);
+    spirit1ArqTakeOver();
+    SpiritIrqDeInit(NULL);
+    SpiritIrq(TX_DATA_SENT, S_ENABLE);
+    SpiritIrq(RX_DATA_READY, S_ENABLE);
+    SpiritIrq(RX_DATA_DISC, S_ENABLE);
+    SpiritIrqClearStatus();
+    SpiritCmdStrobeRx();
+}
+
+static void transmit(Node &node, uint8_t destination, uint8_t *frame, uint8_t length) {
+    use(node);
+    SpiritCmdStrobeSabort();
+    SpiritCmdStrobeFlushTxFifo();
+    SpiritPktStackSetPayloadLength(length);
+    SpiritPktCommonSetDestinationAddress(destination);
+    SpiritSpiWriteLinearFifo(length, frame);
+    SpiritCmdStrobeTx();
+    node.sending = true;
+}
+
+/* bottom half: back to RX after every frame, returns the length of a received frame or 0 */
+static uint8_t service(Node &node, uint8_t *frame) {
+    SpiritIrqs irqs;
+    uint8_t length = 0;
+
+    use(node);
+    SpiritIrqGetStatus(&irqs);
+    if (irqs.IRQ_TX_DATA_SENT) node.sending = false;
+    if (irqs.IRQ_RX_DATA_READY) {
+        length = SpiritLinearFifoReadNumElementsRxFifo();
+        SpiritSpiReadLinearFifo(length, frame);
+    }
+    if (irqs.IRQ_TX_DATA_SENT || irqs.IRQ_RX_DATA_READY || irqs.IRQ_RX_DATA_DISC) SpiritCmdStrobeRx();
+    return length;
+}
+
+/* payload k: k (LE) then a filler that depends on k */
+static void fill(uint8_t *payload, uint32_t k) {
+    for (uint8_t i = 0; i < payloadLength; i++) payload[i] = (uint8_t) (k * 31 + i);
+    memcpy(payload, &k, sizeof(k));
+}
+
+static bool intact(const uint8_t *payload, uint8_t length, uint32_t k) {
+    uint8_t expected[FRAME];
+    fill(expected, k);
+    return length == payloadLength && memcmp(payload, expected, length) == 0;
+}
+
+/* to the next model event, or to deadlineUs */
+static void idle(Spirit1SimClock &clock, uint64_t deadlineUs) {
+    uint64_t next = clock.nextEventNs();
+    if (deadlineUs * 1000 < next) next = deadlineUs * 1000;
+    clock.advance(next > clock.now() ? next - clock.now() : 1000);
+}
+
+typedef struct {
+    uint32_t delivered;
+    uint32_t lost;
+    uint32_t retransmissions;
+    uint32_t timeouts;
+    uint64_t elapsedNs;
+} Result;
+
+static Result stopAndWait(Spirit1SimClock &clock, Node &sender, Node &receiver) {
+    Result result = Result();
+    uint8_t frame[FRAME], received[FRAME];
+    uint64_t ackTimeoutUs = sender.sim.airtimeNs(1) / 1000 + 1000;
+    uint32_t k = 0, tries = 0;
+    uint64_t deadlineUs = ~(uint64_t) 0;
+    bool waiting = false;
+    int lastSeq = -1;
+
+    uint64_t start = clock.now();
+    while (k < frames && clock.now() - start < LIMIT_NS) {
+        uint64_t nowUs = clock.now() / 1000;
+        if (sender.sim.irqPending()) {
+            bool wasSending = sender.sending;
+            uint8_t length = service(sender, received);
+            if (wasSending && !sender.sending) {
+                waiting = true;
+                deadlineUs = nowUs + ackTimeoutUs;
+            }
+            if (waiting && length == 1 && received[0] == (SPIRIT1_ARQ_ACK | ((k & 3) << 2))) {
+                k++;
+                tries = 0;
+                waiting = false;
+            }
+        }
+        if (receiver.sim.irqPending()) {
+            uint8_t length = service(receiver, received);
+            if (length > 1 && !receiver.sending) {
+                int seq = received[0] >> 2;
+                uint8_t ack = (uint8_t) (SPIRIT1_ARQ_ACK | (seq << 2));
+                transmit(receiver, sender.address, &ack, 1);
+                if (seq != lastSeq) {
+                    uint32_t value;
+                    memcpy(&value, received + 1, sizeof(value));
+                    if (intact(received + 1, (uint8_t) (length - 1), value)) result.delivered++;
+                    lastSeq = seq;
+                }
+            }
+        }
+        if (waiting && nowUs >= deadlineUs) {
+            waiting = false;
+            result.timeouts++;
+            if (tries > LLP_MAX_RETX) {
+                result.lost++;
+                k++;
+                tries = 0;
+            }
+        }
+        if (!sender.sending && !waiting && k < frames) {
+            if (tries) result.retransmissions++;
+            tries++;
+            frame[0] = (uint8_t) (SPIRIT1_ARQ_DATA | ((k & 3) << 2));
+            fill(frame + 1, k);
+            transmit(sender, receiver.address, frame, (uint8_t) (payloadLength + 1));
+        }
+        if (!sender.sim.irqPending() && !receiver.sim.irqPending()) idle(clock, waiting ? deadlineUs : ~0ULL / 1000);
+    }
+    result.elapsedNs = clock.now() - start;
+    return result;
+}
+
+template<uint8_t Window>
+static Result selectiveRepeat(Spirit1SimClock &clock, Node &sender, Node &receiver) {
+    Result result = Result();
+    uint8_t frame[FRAME], received[FRAME];
+    Spirit1ArqSender<Window, FRAME> arq(4 * (uint32_t) (sender.sim.airtimeNs(FRAME) / 1000), 1000, 1000000);
+    Spirit1ArqReceiver<Window, FRAME> peer;
+    uint32_t pushed = 0;
+
+    uint64_t start = clock.now();
+    while (result.delivered < frames && clock.now() - start < LIMIT_NS) {
+        uint32_t nowUs = (uint32_t) (clock.now() / 1000);
+        if (sender.sim.irqPending()) {
+            uint8_t length = service(sender, received);
+            if (length) arq.onAck(received, length, nowUs);
+        }
+        if (receiver.sim.irqPending()) {
+            uint8_t length = service(receiver, received);
+            if (length && peer.onData(received, length) && !receiver.sending) {
+                uint8_t ack[SPIRIT1_ARQ_ACK_LENGTH];
+                transmit(receiver, sender.address, ack, peer.ack(ack));
+            }
+            const uint8_t *payload;
+            while ((payload = peer.front(&length)) != NULL) {
+                if (intact(payload, length, result.delivered)) result.delivered++;
+                else result.lost++;
+                peer.release();
+            }
+        }
+        if (!sender.sending) {
+            while (pushed < frames) {
+                fill(frame, pushed);
+                if (!arq.push(frame, payloadLength)) break;
+                pushed++;
+            }
+            uint8_t length = arq.poll(nowUs, frame);
+            if (length) transmit(sender, receiver.address, frame, length);
+        }
+        if (!sender.sim.irqPending() && !receiver.sim.irqPending()) {
+            bool ready = !sender.sending && !arq.awaitingAck() && !arq.idle();
+            if (!ready) idle(clock, arq.awaitingAck() ? arq.timeoutUs() : ~0ULL / 1000);
+        }
+    }
+    result.retransmissions = arq.stats().retransmissions;
+    result.timeouts = arq.stats().timeouts;
+    result.elapsedNs = clock.now() - start;
+    return result;
+}
+
+static void run(const char *name, Result (*protocol)(Spirit1SimClock &, Node &, Node &), double lossRate) {
+    Spirit1SimClock clock;
+    Spirit1Medium medium;
+    Node sender(clock), receiver(clock);
+
+    sender.address = 0x10;
+    receiver.address = 0x20;
+    medium.setLossRate(lossRate);
+    medium.attach(sender.sim);
+    medium.attach(receiver.sim);
+    nodeInit(sender);
+    nodeInit(receiver);
+
+    Result result = protocol(clock, sender, receiver);
+    printf("%-10s %5.2f %7u %6u %6u %6u %9.1f\r\n", name, lossRate, result.delivered, result.lost,
+           result.retransmissions, result.timeouts, (double) result.delivered * payloadLength * 8 / (result.elapsedNs / 1e9) / 1000);
+
+    standInBus().use(NULL);
+    SpiritContextBind(NULL);
+}
+
+int main(int argc, char **argv) {
+    static const double lossRates[] = {0, 0.01, 0.05, 0.1, 0.2};
+    frames = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 500;
+    datarate = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 0) : 38400;
+    uint32_t bytes = argc > 3 ? (uint32_t) strtoul(argv[3], NULL, 0) : 64;
+    payloadLength = (uint8_t) (bytes < 4 ? 4 : bytes > FRAME - SPIRIT1_ARQ_HEADER ? FRAME - SPIRIT1_ARQ_HEADER : bytes);
+
+    printf("SPIRIT1 ARQ, %u frames of %u bytes, %u bps\r\n", frames, payloadLength, datarate);
+    printf("%-10s %5s %7s %6s %6s %6s %9s\r\n", "", "loss", "recv", "lost", "retx", "t/o", "kbps");
+    for (size_t l = 0; l < sizeof(lossRates) / sizeof(lossRates[0]); l++) {
+        run("stop/wait", stopAndWait, lossRates[l]);
+        run("SR w=8", selectiveRepeat<8>, lossRates[l]);
+        run("SR w=32", selectiveRepeat<32>, lossRates[l]);
+    }
+    return 0;
+}
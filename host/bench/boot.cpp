@@ -0,0 +1,85 @@
+/**
+ * Boot to RX: SRES, the radio and packet configuration, the VCO calibration
+ * and the RX strobe, until MC_STATE is RX. SpiritRadioInit() and
+ * SpiritPktBasicInit() of the library, with and without the register shadow,
+ * against the register image of spirit1RegisterImage.h built at compile time
+ * from the same parameters, on the timed stand-in bus.
+ *
+ *   spirit1-bench-boot [spi frequency in Hz] [select delay in ns] [iterations]
+ *
+ * trans., bytes, reads: SPI transactions, bus bytes and register reads per
+ * boot; chip us: virtual time of the boot on the model, the transition times
+ * included; us/boot: the bus time.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SPIRIT_Config.h"
+#include "spirit1RegisterImage.h"
+#include "standInTransport.h"
+
+static constexpr SRadioInit RADIO = {0, 868000000, 20000, 0, FSK, 38400, 20000, 100000};
+static constexpr PktBasicInit BASIC = {PKT_PREAMBLE_LENGTH_04BYTES, PKT_SYNC_LENGTH_4BYTES, 0x88888888,
+                                       PKT_LENGTH_VAR, 7, PKT_CRC_MODE_16BITS_1, PKT_CONTROL_LENGTH_0BYTES,
+                                       S_ENABLE, S_DISABLE, S_ENABLE};
+static constexpr Spirit1RegisterImage IMAGE = spirit1RegisterImage(50000000, RADIO, BASIC);
+
+static void libraryBoot() {
+    SRadioInit radio = RADIO;
+    PktBasicInit basic = BASIC;
+
+    SpiritCmdStrobeSres();
+    SpiritRadioSetXtalFrequency(50000000);
+    SpiritRadioInit(&radio);
+    SpiritPktBasicInit(&basic);
+}
+
+static void imageBoot() {
+    SpiritCmdStrobeSres();
+    spirit1ImageLoad(IMAGE);
+}
+
+static void run(const char *name, void (*boot)(), SpiritFunctionalState shadow, int iterations) {
+    Spirit1Sim &chip = standInBus().chip();
+    int failures = 0;
+
+    SpiritShadowEnable(shadow);
+    chip.resetStats();
+
+    uint64_t chipBegin = chip.now();
+    uint32_t begin = standInBus().nowUs();
+    for (int i = 0; i < iterations; i++) {
+        boot();
+        SpiritCmdStrobeRx();
+        if (SpiritWaitState(MC_STATE_RX, SPIRIT_WAIT_STATE_TIMEOUT_US) != SPIRIT_WAIT_OK) failures++;
+    }
+    uint32_t elapsed = standInBus().nowUs() - begin;
+
+    printf("%-15s %8.1f %8.1f %6.1f %6d %9.1f %9.1f\r\n", name,
+           (double) chip.stats().transactions / iterations,
+           (double) chip.stats().bytes / iterations,
+           (double) chip.stats().reads / iterations,
+           failures,
+           (double) (chip.now() - chipBegin) / 1000.0 / iterations,
+           (double) elapsed / iterations);
+}
+
+int main(int argc, char **argv) {
+    uint32_t frequency = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 5000000;
+    uint32_t selectNs = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 0) : 2000;
+    int iterations = argc > 3 ? atoi(argv[3]) : 200;
+
+    standInBus().setFrequency(frequency);
+    standInBus().setSelectDelayNs(selectNs);
+
+    printf("SPIRIT1 boot to RX, stand-in bus @ %lu Hz, %lu ns per transaction, %d iterations\r\n",
+           (unsigned long) frequency, (unsigned long) selectNs, iterations);
+    printf("%-15s %8s %8s %6s %6s %9s %9s\r\n",
+           "configuration", "trans.", "bytes", "reads", "errors", "chip us", "us/boot");
+
+    run("library", libraryBoot, S_DISABLE, iterations);
+    run("library+shadow", libraryBoot, S_ENABLE, iterations);
+    run("image", imageBoot, S_DISABLE, iterations);
+
+    return 0;
+}
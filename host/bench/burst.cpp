@@ -0,0 +1,59 @@
+/**
+ * Throughput and CPU load of the SPIRIT1 SPI engine, byte path vs. burst path,
+ * against the host stand-in bus.
+ *
+ *   spirit1-bench-burst [spi frequency in Hz] [iterations]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "spirit1Spi.h"
+#include "spiStandIn.h"
+
+static void run(Spirit1Spi<SpiStandInBus> &spi, SpiStandInBus &bus, const char *name,
+                uint8_t n, bool fifo, bool burst, int iterations) {
+    uint8_t buffer[256];
+    for (int i = 0; i < n; i++) buffer[i] = (uint8_t) i;
+
+    spi.setBurstThreshold(burst ? 1 : 256);
+    spi.resetStats();
+
+    uint32_t begin = bus.nowUs();
+    for (int i = 0; i < iterations; i++) {
+        if (fifo) {
+            spi.writeFifo(n, buffer);
+            spi.readFifo(n, buffer);
+        } else {
+            spi.writeRegisters(0x00, n, buffer);
+            spi.readRegisters(0x00, n, buffer);
+        }
+    }
+    uint32_t elapsed = bus.nowUs() - begin;
+
+    const Spirit1SpiStats &stats = spi.stats();
+    printf("%-10s %5d  %-5s %7lu %10.0f %6.1f\r\n", name, n, burst ? "burst" : "byte",
+           (unsigned long) stats.transactions,
+           elapsed ? stats.bytes * 1e6 / elapsed : 0.0,
+           elapsed ? 100.0 * stats.busyUs / elapsed : 0.0);
+}
+
+int main(int argc, char **argv) {
+    uint32_t frequency = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 5000000;
+    int iterations = argc > 2 ? atoi(argv[2]) : 200;
+
+    SpiStandInBus bus(frequency);
+    Spirit1Spi<SpiStandInBus> spi(bus);
+
+    printf("SPIRIT1 SPI engine, stand-in bus @ %lu Hz, %d iterations\r\n", (unsigned long) frequency, iterations);
+    printf("%-10s %5s  %-5s %7s %10s %6s\r\n", "transfer", "size", "path", "calls", "bytes/s", "cpu%");
+
+    static const uint8_t fifoSizes[] = {16, 32, 64, 96};
+    for (unsigned i = 0; i < sizeof(fifoSizes); i++) {
+        run(spi, bus, "fifo", fifoSizes[i], true, false, iterations);
+        run(spi, bus, "fifo", fifoSizes[i], true, true, iterations);
+    }
+    run(spi, bus, "registers", 0xF2, false, false, iterations);
+    run(spi, bus, "registers", 0xF2, false, true, iterations);
+
+    return 0;
+}
@@ -0,0 +1,177 @@
+/**
+ * Goodput of messages larger than a frame, split into STack frames by
+ * spirit1Fragment.h and put back together by the receiver, over the
+ * simulated medium (spirit1Medium.h) between two simulated SPIRIT1.
+ *
+ *   spirit1-bench-fragment [messages] [datarate]
+ *
+ * The sender sends the fragments back to back (TX command, TX_DATA_SENT,
+ * next one); the receiver reads every frame on RX_DATA_READY and hands it to
+ * the reassembler. There is no retransmission: a lost fragment loses its
+ * message, which the reassembler drops after its timeout.
+ *
+ * frags: fragments per message; overhead: bytes on the air per message byte,
+ * STack header and CRC included; recv: messages complete; kbps: message bits
+ * delivered per second of virtual time; eff.: kbps over the datarate.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SPIRIT_Config.h"
+#include "spirit1Fragment.h"
+#include "spirit1Medium.h"
+#include "spirit1RxRing.h"
+#include "standInTransport.h"
+
+static const uint8_t FRAME = 96;
+static const uint16_t CHUNK = Spirit1Fragmenter<FRAME>::CHUNK;
+
+struct Node {
+    explicit Node(Spirit1SimClock &clock) : sim(&clock) { SpiritContextInit(&context, 0); }
+
+    Spirit1Sim sim;
+    SpiritContext context;
+    uint8_t address;
+};
+
+static Spirit1Fragmenter<FRAME> fragmenter;
+static Spirit1Reassembler<Spirit1Fragmenter<FRAME>::MAX_MESSAGE, 2, FRAME> *reassembler;
+static uint8_t message[Spirit1Fragmenter<FRAME>::MAX_MESSAGE];
+static uint32_t datarate;
+
+static void use(Node &node) {
+    standInBus().use(&node.sim);
+    SpiritContextBind(&node.context);
+}
+
+static void nodeInit(Node &node) {
+    SRadioInit radio = {0, 868000000, 20000, 0, FSK, datarate, datarate / 2,
+                        3 * datarate < 800000 ? 3 * datarate : 800000};
+    PktStackInit stack = {PKT_PREAMBLE_LENGTH_04BYTES, PKT_SYNC_LENGTH_4BYTES, 0x1A2635A8, PKT_LENGTH_VAR, 7,
+                          PKT_CRC_MODE_16BITS_1, PKT_CONTROL_LENGTH_0BYTES, S_DISABLE, S_ENABLE};
+    PktStackAddressesInit addresses = {S_ENABLE, node.address, S_DISABLE, 0xEE, S_DISABLE, 0xFF};
+    SGpioInit gpioIrq = {SPIRIT_GPIO_3, SPIRIT_GPIO_MODE_DIGITAL_OUTPUT_LP, SPIRIT_GPIO_DIG_OUT_IRQ};
+
+    use(node);
+    SpiritCmdStrobeSres();
+    SpiritRadioSetXtalFrequency(50000000);
+    SpiritRadioInit(&radio);
+    SpiritPktStackInit(&stack);
+    SpiritPktStackSetVarLengthWidth(FRAME, PKT_CONTROL_LENGTH_0BYTES);
+    SpiritPktStackAddressesInit(&addresses);
+    SpiritGpioInit(&gpioIrq);
+    SpiritIrqDeInit(NULL);
+    SpiritIrq(TX_DATA_SENT, S_ENABLE);
+    SpiritIrq(RX_DATA_READY, S_ENABLE);
+    SpiritIrq(RX_DATA_DISC, S_ENABLE);
+    SpiritIrqClearStatus();
+}
+
+/* the next fragment from sender to receiver, false once the message is done */
+static bool sendFragment(Node &sender, uint8_t destination) {
+    uint8_t frame[FRAME];
+    uint8_t length = fragmenter.next(frame);
+    if (!length) return false;
+    use(sender);
+    SpiritPktStackSetPayloadLength(length);
+    SpiritPktCommonSetDestinationAddress(destination);
+    SpiritSpiWriteLinearFifo(length, frame);
+    SpiritCmdStrobeTx();
+    return true;
+}
+
+/* bottom half of the receiver: true if a message is complete and intact */
+static bool receiveFragment(Node &receiver, uint16_t expected) {
+    SpiritIrqs irqs;
+    uint8_t frame[FRAME];
+    Spirit1RxInfo info;
+    bool complete = false;
+
+    use(receiver);
+    SpiritIrqGetStatus(&irqs);
+    if (irqs.IRQ_RX_DATA_READY) {
+        spirit1RxReadInfo(&info, (uint32_t) (receiver.sim.now() / 1000));
+        uint8_t length = SpiritLinearFifoReadNumElementsRxFifo();
+        SpiritSpiReadLinearFifo(length, frame);
+        uint16_t messageLength;
+        const uint8_t *received = reassembler->receive(info.source, frame, length, info.timestampUs, &messageLength);
+        complete = received && messageLength == expected && memcmp(received, message, expected) == 0;
+    }
+    if (irqs.IRQ_RX_DATA_READY || irqs.IRQ_RX_DATA_DISC) SpiritCmdStrobeRx();
+    return complete;
+}
+
+static void run(uint16_t size, double lossRate, uint32_t messages) {
+    Spirit1SimClock clock;
+    Spirit1Medium medium;
+    Node sender(clock), receiver(clock);
+    uint32_t delivered = 0;
+
+    sender.address = 0x10;
+    receiver.address = 0x20;
+    medium.setLossRate(lossRate);
+    medium.attach(sender.sim);
+    medium.attach(receiver.sim);
+    nodeInit(sender);
+    nodeInit(receiver);
+    use(receiver);
+    SpiritCmdStrobeRx();
+    reassembler->resetStats();
+
+    uint64_t start = clock.now();
+    for (uint32_t m = 0; m < messages; m++) {
+        for (uint16_t i = 0; i < size; i++) message[i] = (uint8_t) (i * 7 + m);
+        fragmenter.begin(message, size);
+        while (sendFragment(sender, receiver.address)) {
+            /* until TX_DATA_SENT, serving the receiver meanwhile */
+            for (;;) {
+                if (receiver.sim.irqPending() && receiveFragment(receiver, size)) delivered++;
+                if (sender.sim.irqPending()) {
+                    use(sender);
+                    SpiritIrqs irqs;
+                    SpiritIrqGetStatus(&irqs);
+                    if (irqs.IRQ_TX_DATA_SENT) break;
+                }
+                uint64_t next = clock.nextEventNs();
+                clock.advance(next > clock.now() ? next - clock.now() : 1000);
+            }
+        }
+    }
+    /* the last fragment lands */
+    clock.advance(receiver.sim.airtimeNs(FRAME));
+    if (receiver.sim.irqPending() && receiveFragment(receiver, size)) delivered++;
+    uint64_t elapsed = clock.now() - start;
+
+    uint32_t fragments = fragmenter.fragments();
+    uint64_t airtime = 0;
+    for (uint16_t done = 0; done < size; done = (uint16_t) (done + CHUNK)) {
+        uint16_t chunk = size - done < CHUNK ? (uint16_t) (size - done) : CHUNK;
+        airtime += sender.sim.airtimeNs((uint16_t) (chunk + SPIRIT1_FRAGMENT_HEADER));
+    }
+    double onAir = (double) airtime * datarate / 8e9;
+    double kbps = (double) delivered * size * 8 / (elapsed / 1e9) / 1000;
+    printf("%6u %5.2f %5u %8.3f %6u %6u %8.1f %5.1f%% %5u\r\n", size, lossRate, fragments, onAir / size,
+           messages, delivered, kbps, kbps * 100000 / datarate, reassembler->stats().timeouts);
+
+    standInBus().use(NULL);
+    SpiritContextBind(NULL);
+}
+
+int main(int argc, char **argv) {
+    static const uint16_t sizes[] = {64, 256, 1024, 2048, 4096, 8192};
+    static const double lossRates[] = {0, 0.01, 0.05};
+    uint32_t messages = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 50;
+    datarate = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 0) : 250000;
+
+    reassembler = new Spirit1Reassembler<Spirit1Fragmenter<FRAME>::MAX_MESSAGE, 2, FRAME>(50000);
+    printf("SPIRIT1 fragmentation, %u messages per run, %u bps, %u byte frames, %u byte header\r\n", messages,
+           datarate, FRAME, SPIRIT1_FRAGMENT_HEADER);
+    printf("%6s %5s %5s %8s %6s %6s %8s %6s %5s\r\n", "bytes", "loss", "frags", "overhead", "sent", "recv", "kbps",
+           "eff.", "t/o");
+    for (size_t l = 0; l < sizeof(lossRates) / sizeof(lossRates[0]); l++) {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) run(sizes[s], lossRates[l], messages);
+    }
+    delete reassembler;
+    return 0;
+}
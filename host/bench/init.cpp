@@ -0,0 +1,75 @@
+/**
+ * SPI traffic and wall time of the full radio initialisation of the firmware
+ * (reset, base configuration, GPIO, PA, IRQ, QI and timer setup) against the
+ * timed stand-in bus, with the register shadow and the write batch on and off.
+ *
+ *   spirit1-bench-init [spi frequency in Hz] [select delay in ns] [iterations]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SPIRIT_Config.h"
+#include "standInTransport.h"
+
+extern "C" void SpiritBaseConfiguration(void);
+
+/* the sequence of main() up to the RX strobe */
+static void radioInit() {
+    SGpioInit gpioIrq = {SPIRIT_GPIO_3, SPIRIT_GPIO_MODE_DIGITAL_OUTPUT_LP, SPIRIT_GPIO_DIG_OUT_IRQ};
+
+    SpiritSpiCommandStrobes(COMMAND_SRES);
+    SpiritManagementWaExtraCurrent();
+    SpiritRadioSetXtalFrequency(52000000);
+    SpiritBaseConfiguration();
+
+    SpiritBatchBegin();
+    SpiritGpioInit(&gpioIrq);
+    SpiritRadioSetPALeveldBm(7, 11.6f);
+    SpiritRadioSetPALevelMaxIndex(7);
+    SpiritIrqDeInit(NULL);
+    SpiritIrq(TX_DATA_SENT, S_ENABLE);
+    SpiritIrq(RX_DATA_DISC, S_ENABLE);
+    SpiritIrq(RX_DATA_READY, S_ENABLE);
+    SpiritQiSetSqiThreshold(SQI_TH_0);
+    SpiritQiSqiCheck(S_ENABLE);
+    SpiritTimerSetRxTimeoutMs(1000.0);
+    SpiritTimerSetRxTimeoutStopCondition(SQI_ABOVE_THRESHOLD);
+    SpiritIrqClearStatus();
+    SpiritBatchFlush();
+}
+
+static void run(const char *name, SpiritFunctionalState shadow, SpiritFunctionalState batch, int iterations) {
+    SpiritShadowEnable(shadow);
+    SpiritBatchEnable(batch);
+    standInSpi().resetStats();
+
+    uint32_t begin = standInBus().nowUs();
+    for (int i = 0; i < iterations; i++) radioInit();
+    uint32_t elapsed = standInBus().nowUs() - begin;
+
+    const Spirit1SpiStats &stats = standInSpi().stats();
+    printf("%-14s %8.1f %8.1f %10.1f\r\n", name,
+           (double) stats.transactions / iterations,
+           (double) stats.bytes / iterations,
+           (double) elapsed / iterations);
+}
+
+int main(int argc, char **argv) {
+    uint32_t frequency = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 5000000;
+    uint32_t selectNs = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 0) : 2000;
+    int iterations = argc > 3 ? atoi(argv[3]) : 200;
+
+    standInBus().setFrequency(frequency);
+    standInBus().setSelectDelayNs(selectNs);
+
+    printf("SPIRIT1 radio init, stand-in bus @ %lu Hz, %lu ns per transaction, %d iterations\r\n",
+           (unsigned long) frequency, (unsigned long) selectNs, iterations);
+    printf("%-14s %8s %8s %10s\r\n", "mode", "trans.", "bytes", "us/init");
+
+    run("plain", S_DISABLE, S_DISABLE, iterations);
+    run("shadow", S_ENABLE, S_DISABLE, iterations);
+    run("batch", S_DISABLE, S_ENABLE, iterations);
+    run("shadow+batch", S_ENABLE, S_ENABLE, iterations);
+
+    return 0;
+}
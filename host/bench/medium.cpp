@@ -0,0 +1,305 @@
+/**
+ * End-to-end packet rate, goodput and latency of the radio driver over the
+ * simulated medium (spirit1Medium.h). Every node is a simulated SPIRIT1
+ * driven by the SPIRIT1 library through the stand-in transport, the way
+ * main.cpp drives the radio: IRQ driven, abort RX, fill the TX FIFO and
+ * strobe TX to send, read the RX FIFO and strobe RX again on RX_DATA_READY.
+ * All times are virtual, SPI traffic included (10 MHz, 1 us per transaction).
+ *
+ *   spirit1-bench-medium [frames] [payload bytes] [loss rate] [datarate]
+ *
+ * ping-pong: node 0 sends to node 1, which echoes; the latency is the round
+ *            trip from queueing the ping to reading the pong
+ * flood:     nodes 1..n-1 send back to back to node 0; the latency is from
+ *            queueing a frame to reading it from the RX FIFO of node 0
+ *
+ * The nodes' MCUs are served in turn, the SPI work of one node delays the
+ * driver of the others (not their radios). Each node has a library context
+ * of its own (SPIRIT_Context.h), for its register shadow and write batch.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "SPIRIT_Config.h"
+#include "spirit1Medium.h"
+#include "standInTransport.h"
+
+static const uint8_t BROADCAST = 0xFF;
+static const uint64_t NEVER = ~(uint64_t) 0;
+
+struct Node {
+    explicit Node(Spirit1SimClock &clock) : sim(&clock) { SpiritContextInit(&context, 0); }
+
+    Spirit1Sim sim;
+    SpiritContext context;
+    uint8_t address;
+    bool sending;             /*!< frame in the TX FIFO, until TX_DATA_SENT */
+    std::vector<uint8_t> frame;
+    uint8_t destination;
+    uint32_t seq;             /*!< next frame to queue */
+    uint64_t timeoutAt;       /*!< ping-pong: pong expected by */
+};
+
+static struct {
+    uint32_t payload;
+    double lossRate;
+    uint32_t datarate;
+} config;
+
+static std::vector<uint64_t> queuedAt;    /*!< per (sender, seq), see key() */
+static std::vector<uint64_t> latencies;
+static uint32_t delivered, lost;
+static uint64_t deliveredBytes;
+
+static size_t key(uint8_t sender, uint32_t seq) {
+    return (size_t) sender * 1000000 + seq;
+}
+
+static void use(Node &node) {
+    standInBus().use(&node.sim);
+    SpiritContextBind(&node.context);
+}
+
+static void nodeInit(Node &node, SpiritFunctionalState csma) {
+    uint32_t fdev = std::max<uint32_t>(config.datarate / 2, 5000);
+    uint32_t bandwidth = std::min<uint32_t>(2 * (config.datarate + fdev), 800000);
+    SRadioInit radio = {0, 868000000, 20000, 0, FSK, config.datarate, fdev, bandwidth};
+    PktBasicInit basic = {PKT_PREAMBLE_LENGTH_04BYTES, PKT_SYNC_LENGTH_4BYTES, 0x1A2635A8, PKT_LENGTH_VAR, 7,
+                          PKT_CRC_MODE_16BITS_1, PKT_CONTROL_LENGTH_0BYTES, S_ENABLE, S_DISABLE, S_ENABLE};
+    PktBasicAddressesInit addresses = {S_ENABLE, node.address, S_DISABLE, 0xEE, S_ENABLE, BROADCAST};
+    SGpioInit gpioIrq = {SPIRIT_GPIO_3, SPIRIT_GPIO_MODE_DIGITAL_OUTPUT_LP, SPIRIT_GPIO_DIG_OUT_IRQ};
+    CsmaInit csmaInit = {S_DISABLE, TBIT_TIME_64, TCCA_TIME_3, 5, 0xFA21, 1};
+
+    use(node);
+    SpiritCmdStrobeSres();
+    SpiritRadioSetXtalFrequency(50000000);
+    SpiritRadioInit(&radio);
+    SpiritPktBasicInit(&basic);
+    SpiritPktBasicSetVarLengthWidth(255, S_ENABLE, PKT_CONTROL_LENGTH_0BYTES);
+    SpiritPktBasicAddressesInit(&addresses);
+    SpiritGpioInit(&gpioIrq);
+    SpiritIrqDeInit(NULL);
+    SpiritIrq(TX_DATA_SENT, S_ENABLE);
+    SpiritIrq(RX_DATA_READY, S_ENABLE);
+    SpiritIrq(RX_DATA_DISC, S_ENABLE);
+    SpiritIrq(MAX_BO_CCA_REACH, S_ENABLE);
+    if (csma == S_ENABLE) {
+        /* seeded per node, or the back-offs are the same everywhere */
+        csmaInit.nBuCounterSeed = (uint16_t) (csmaInit.nBuCounterSeed + 7919 * node.address);
+        SpiritCsmaInit(&csmaInit);
+        SpiritQiSetRssiThresholddBm(-100);
+    }
+    SpiritCsma(csma);
+    SpiritIrqClearStatus();
+    SpiritCmdStrobeRx();
+
+    node.sending = false;
+    node.seq = 0;
+    node.timeoutAt = NEVER;
+}
+
+/* the frame in node.frame to node.destination */
+static void transmit(Node &node) {
+    use(node);
+    SpiritCmdStrobeSabort();
+    SpiritCmdStrobeFlushTxFifo();
+    SpiritPktBasicSetPayloadLength((uint16_t) node.frame.size());
+    SpiritPktCommonSetDestinationAddress(node.destination);
+    SpiritSpiWriteLinearFifo((uint8_t) node.frame.size(), &node.frame[0]);
+    SpiritCmdStrobeTx();
+    node.sending = true;
+}
+
+/* payload: sender, seq (LE), filler */
+static void queue(Node &node, uint8_t destination, uint64_t now) {
+    node.frame.assign(config.payload, 0x55);
+    node.frame[0] = node.address;
+    for (int i = 0; i < 4; i++) node.frame[1 + i] = (uint8_t) (node.seq >> (8 * i));
+    node.destination = destination;
+    size_t k = key(node.address, node.seq);
+    if (queuedAt.size() <= k) queuedAt.resize(k + 1, NEVER);
+    queuedAt[k] = now;
+    node.seq++;
+    transmit(node);
+}
+
+typedef void (*Receive)(Node &node, const uint8_t *payload, uint8_t length, uint64_t now);
+
+/* bottom half of the nIRQ of node */
+static void service(Node &node, Receive receive, uint64_t now) {
+    SpiritIrqs irqs;
+    uint8_t payload[96];
+
+    use(node);
+    SpiritIrqGetStatus(&irqs);
+    if (irqs.IRQ_MAX_BO_CCA_REACH) {
+        /* channel busy, try again */
+        transmit(node);
+        return;
+    }
+    if (irqs.IRQ_TX_DATA_SENT) {
+        node.sending = false;
+        SpiritCmdStrobeRx();
+    }
+    if (irqs.IRQ_RX_DATA_READY) {
+        uint8_t length = SpiritLinearFifoReadNumElementsRxFifo();
+        SpiritSpiReadLinearFifo(length, payload);
+        SpiritCmdStrobeRx();
+        receive(node, payload, length, now);
+    } else if (irqs.IRQ_RX_DATA_DISC) {
+        SpiritCmdStrobeRx();
+    }
+}
+
+static uint32_t seqOf(const uint8_t *payload) {
+    return (uint32_t) payload[1] | ((uint32_t) payload[2] << 8) | ((uint32_t) payload[3] << 16) |
+           ((uint32_t) payload[4] << 24);
+}
+
+static void delivered1(const uint8_t *payload, uint8_t length, uint64_t now, bool measure) {
+    delivered++;
+    deliveredBytes += length;
+    if (!measure) return;
+    size_t k = key(payload[0], seqOf(payload));
+    if (k < queuedAt.size() && queuedAt[k] != NEVER) {
+        latencies.push_back(now - queuedAt[k]);
+        queuedAt[k] = NEVER;
+    }
+}
+
+static std::vector<Node *> nodes;
+
+static void pingPongReceive(Node &node, const uint8_t *payload, uint8_t length, uint64_t now) {
+    if (node.address == nodes[1]->address) {
+        /* echo */
+        delivered1(payload, length, now, false);
+        node.frame.assign(payload, payload + length);
+        node.destination = payload[0];
+        transmit(node);
+        return;
+    }
+    if (payload[0] == node.address && seqOf(payload) == node.seq - 1 && node.timeoutAt != NEVER) {
+        delivered1(payload, length, now, true);
+        node.timeoutAt = NEVER;
+    }
+}
+
+static void floodReceive(Node &, const uint8_t *payload, uint8_t length, uint64_t now) {
+    delivered1(payload, length, now, true);
+}
+
+/* the main loop of all nodes: bottom halves, then the application, then the time until something happens */
+static uint64_t run(Spirit1SimClock &clock, Receive receive, bool pingPong, uint32_t frames) {
+    uint64_t start = clock.now();
+    uint32_t senders = (uint32_t) nodes.size() - 1;
+    uint64_t pingTimeoutNs = 4 * nodes[0]->sim.airtimeNs((uint16_t) config.payload) + 2000000;
+
+    for (;;) {
+        uint64_t now = clock.now();
+        bool done = true;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            Node &node = *nodes[i];
+            if (node.sim.irqPending()) service(node, receive, now);
+        }
+        if (pingPong) {
+            Node &pinger = *nodes[0];
+            if (pinger.timeoutAt != NEVER && now >= pinger.timeoutAt) {
+                lost++;
+                pinger.timeoutAt = NEVER;
+            }
+            if (pinger.timeoutAt == NEVER && !pinger.sending && pinger.seq < frames) {
+                queue(pinger, nodes[1]->address, now);
+                pinger.timeoutAt = now + pingTimeoutNs;
+            }
+            done = pinger.seq == frames && pinger.timeoutAt == NEVER;
+        } else {
+            for (size_t i = 1; i < nodes.size(); i++) {
+                Node &sender = *nodes[i];
+                if (!sender.sending && sender.seq < frames / senders) queue(sender, nodes[0]->address, now);
+                if (sender.sending || sender.seq < frames / senders) done = false;
+            }
+        }
+        if (done) break;
+
+        /* until the next model event or application timer */
+        uint64_t next = clock.nextEventNs();
+        if (pingPong && nodes[0]->timeoutAt < next) next = nodes[0]->timeoutAt;
+        bool pending = false;
+        for (size_t i = 0; i < nodes.size(); i++) pending = pending || nodes[i]->sim.irqPending();
+        if (pending) continue;
+        if (next == NEVER) break;
+        clock.advance(next > clock.now() ? next - clock.now() : 0);
+    }
+    /* let the last frames land */
+    clock.advance(2 * nodes[0]->sim.airtimeNs((uint16_t) config.payload));
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i]->sim.irqPending()) service(*nodes[i], receive, clock.now());
+    }
+    return clock.now() - start;
+}
+
+static uint64_t percentile(std::vector<uint64_t> &values, uint32_t p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t index = (values.size() * p + 99) / 100;
+    return values[index ? index - 1 : 0];
+}
+
+static void workload(const char *name, size_t count, bool pingPong, SpiritFunctionalState csma, uint32_t frames) {
+    Spirit1SimClock clock;
+    Spirit1Medium medium;
+    std::vector<Node *> created;
+
+    medium.setLossRate(config.lossRate);
+    for (size_t i = 0; i < count; i++) {
+        Node *node = new Node(clock);
+        node->address = (uint8_t) (0x10 + i);
+        medium.attach(node->sim);
+        created.push_back(node);
+    }
+    nodes = created;
+    for (size_t i = 0; i < count; i++) nodeInit(*nodes[i], csma);
+    medium.resetStats();
+    queuedAt.clear();
+    latencies.clear();
+    delivered = lost = 0;
+    deliveredBytes = 0;
+
+    uint64_t elapsed = run(clock, pingPong ? pingPongReceive : floodReceive, pingPong, frames);
+    double seconds = (double) elapsed / 1e9;
+    uint32_t sent = 0;
+    for (size_t i = 0; i < count; i++) sent += nodes[i]->sim.stats().framesSent;
+
+    printf("%-18s %5u %7u %7u %9.1f %9.1f %9.1f %9.1f %6u\r\n", name, (unsigned) count, sent, delivered,
+           delivered / seconds, (double) deliveredBytes * 8 / seconds / 1000,
+           percentile(latencies, 50) / 1000.0, percentile(latencies, 99) / 1000.0, medium.stats().collisions);
+
+    standInBus().use(NULL);
+    SpiritContextBind(NULL);
+    for (size_t i = 0; i < count; i++) delete created[i];
+    nodes.clear();
+}
+
+int main(int argc, char **argv) {
+    uint32_t frames = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 1000;
+    config.payload = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 0) : 20;
+    config.lossRate = argc > 3 ? atof(argv[3]) : 0.0;
+    config.datarate = argc > 4 ? (uint32_t) strtoul(argv[4], NULL, 0) : 38400;
+    if (config.payload < 5) config.payload = 5;
+    if (config.payload > 96) config.payload = 96;
+
+    printf("SPIRIT1 medium, %u frames, %u byte payload, %.3f loss, %u bps\r\n",
+           frames, config.payload, config.lossRate, config.datarate);
+    printf("%-18s %5s %7s %7s %9s %9s %9s %9s %6s\r\n", "workload", "nodes", "sent", "recv", "frames/s",
+           "kbps", "p50 us", "p99 us", "coll.");
+
+    workload("ping-pong", 2, true, S_DISABLE, frames);
+    workload("flood", 2, false, S_DISABLE, frames);
+    workload("flood", 4, false, S_DISABLE, frames);
+    workload("flood csma", 4, false, S_ENABLE, frames);
+
+    return 0;
+}
@@ -0,0 +1,178 @@
+/**
+ * Aggregate RX throughput of one MCU serving several SPIRIT1, each on its own
+ * SPI bus with its own library context (SPIRIT_Context.h): register shadow,
+ * write batch and workaround state per radio. The transports are routed by
+ * the bus of the bound context (SPIRIT1_TRANSPORTS in spirit1Transport.h).
+ *
+ *   spirit1-bench-multi [frames per radio] [payload bytes] [datarate] [gap in us]
+ *
+ * Every radio receives its own stream of back to back frames, one inter
+ * frame gap apart. The MCU serves the radios in turn as main.cpp serves one:
+ * IRQ status, read the RX FIFO, strobe RX again; while it talks to one radio
+ * the others wait, and a frame that starts before its radio is back in RX is
+ * missed. All times are virtual, SPI traffic included (10 MHz, 1 us per
+ * transaction), on the clock the models share.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "SPIRIT_Config.h"
+#include "spirit1Transport.h"
+#include "spiStandIn.h"
+
+static const size_t MAX_RADIOS = 4;
+static const uint64_t NEVER = ~(uint64_t) 0;
+
+static SpiStandInBus bus0(0), bus1(0), bus2(0), bus3(0);
+static SpiStandInBus *buses[MAX_RADIOS] = {&bus0, &bus1, &bus2, &bus3};
+static Spirit1Transport<SpiStandInBus> spis[MAX_RADIOS] = {
+        Spirit1Transport<SpiStandInBus>(bus0), Spirit1Transport<SpiStandInBus>(bus1),
+        Spirit1Transport<SpiStandInBus>(bus2), Spirit1Transport<SpiStandInBus>(bus3)};
+
+SPIRIT1_TRANSPORTS(spis)
+
+struct Radio {
+    explicit Radio(Spirit1SimClock &clock) : sim(&clock) {}
+
+    Spirit1Sim sim;
+    SpiritContext context;
+    uint32_t received;
+    uint64_t receivedBytes;
+};
+
+static struct {
+    uint32_t frames;
+    uint32_t payload;
+    uint32_t datarate;
+    uint64_t gapNs;
+} config;
+
+static void radioInit(Radio &radio, uint8_t bus) {
+    uint32_t fdev = config.datarate / 2 > 5000 ? config.datarate / 2 : 5000;
+    uint32_t bandwidth = 2 * (config.datarate + fdev) < 800000 ? 2 * (config.datarate + fdev) : 800000;
+    SRadioInit init = {0, 868000000, 20000, 0, FSK, config.datarate, fdev, bandwidth};
+    PktBasicInit basic = {PKT_PREAMBLE_LENGTH_04BYTES, PKT_SYNC_LENGTH_4BYTES, 0x1A2635A8, PKT_LENGTH_VAR, 7,
+                          PKT_CRC_MODE_16BITS_1, PKT_CONTROL_LENGTH_0BYTES, S_DISABLE, S_DISABLE, S_ENABLE};
+    SGpioInit gpioIrq = {SPIRIT_GPIO_3, SPIRIT_GPIO_MODE_DIGITAL_OUTPUT_LP, SPIRIT_GPIO_DIG_OUT_IRQ};
+
+    buses[bus]->use(&radio.sim);
+    SpiritContextInit(&radio.context, bus);
+    SpiritContextBind(&radio.context);
+    SpiritCmdStrobeSres();
+    SpiritRadioSetXtalFrequency(50000000);
+    SpiritRadioInit(&init);
+    SpiritPktBasicInit(&basic);
+    SpiritPktBasicSetVarLengthWidth(255, S_DISABLE, PKT_CONTROL_LENGTH_0BYTES);
+    SpiritGpioInit(&gpioIrq);
+    SpiritIrqDeInit(NULL);
+    SpiritIrq(RX_DATA_READY, S_ENABLE);
+    SpiritIrq(RX_DATA_DISC, S_ENABLE);
+    SpiritIrqClearStatus();
+    SpiritCmdStrobeRx();
+
+    radio.received = 0;
+    radio.receivedBytes = 0;
+}
+
+/* bottom half of the nIRQ of radio */
+static void service(Radio &radio) {
+    SpiritIrqs irqs;
+    uint8_t payload[96];
+
+    SpiritContextBind(&radio.context);
+    SpiritIrqGetStatus(&irqs);
+    if (irqs.IRQ_RX_DATA_READY) {
+        uint8_t length = SpiritLinearFifoReadNumElementsRxFifo();
+        SpiritSpiReadLinearFifo(length, payload);
+        SpiritCmdStrobeRx();
+        radio.received++;
+        radio.receivedBytes += length;
+    } else if (irqs.IRQ_RX_DATA_DISC) {
+        SpiritCmdStrobeRx();
+    }
+}
+
+static bool finished(const Radio &radio) {
+    const Spirit1SimStats &stats = radio.sim.stats();
+    return stats.framesReceived + stats.framesDiscarded + stats.framesMissed >= config.frames;
+}
+
+static uint32_t single;
+
+static void workload(size_t count) {
+    Spirit1SimClock clock;
+    std::vector<Radio *> radios;
+
+    for (size_t i = 0; i < count; i++) {
+        radios.push_back(new Radio(clock));
+        radioInit(*radios[i], (uint8_t) i);
+    }
+
+    /* the streams, starting together */
+    Spirit1SimFrame frame = Spirit1SimFrame();
+    frame.crcOk = true;
+    frame.payload.assign(config.payload, 0x55);
+    uint64_t period = radios[0]->sim.airtimeNs((uint16_t) config.payload) + config.gapNs;
+    for (size_t i = 0; i < count; i++) {
+        radios[i]->sim.resetStats();
+        for (uint32_t k = 0; k < config.frames; k++) radios[i]->sim.inject(frame, -60, config.gapNs + k * period);
+    }
+
+    uint64_t start = clock.now();
+    for (;;) {
+        bool done = true, pending = false;
+        for (size_t i = 0; i < count; i++) {
+            if (radios[i]->sim.irqPending()) service(*radios[i]);
+            done = done && finished(*radios[i]) && !radios[i]->sim.irqPending();
+            pending = pending || radios[i]->sim.irqPending();
+        }
+        if (done) break;
+        if (pending) continue;
+        uint64_t next = clock.nextEventNs();
+        if (next == NEVER) break;
+        clock.advance(next > clock.now() ? next - clock.now() : 0);
+    }
+    double seconds = (double) (clock.now() - start) / 1e9;
+
+    uint32_t received = 0, missed = 0, transactions = 0;
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        received += radios[i]->received;
+        bytes += radios[i]->receivedBytes;
+        missed += radios[i]->sim.stats().framesMissed;
+        transactions += radios[i]->sim.stats().transactions;
+    }
+    if (count == 1) single = received;
+
+    printf("%6u %7u %7u %9.1f %9.1f %8.2f %8.1f\r\n", (unsigned) count, received, missed, received / seconds,
+           (double) bytes * 8 / seconds / 1000, single ? (double) received / single : 0.0,
+           received ? (double) transactions / received : 0.0);
+
+    SpiritContextBind(NULL);
+    for (size_t i = 0; i < count; i++) {
+        buses[i]->use(NULL);
+        delete radios[i];
+    }
+}
+
+int main(int argc, char **argv) {
+    config.frames = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 500;
+    config.payload = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 0) : 20;
+    uint32_t datarate = argc > 3 ? (uint32_t) strtoul(argv[3], NULL, 0) : 0;
+    config.gapNs = (argc > 4 ? strtoul(argv[4], NULL, 0) : 300) * 1000ULL;
+    if (config.payload < 1) config.payload = 1;
+    if (config.payload > 96) config.payload = 96;
+
+    uint32_t datarates[] = {38400, 250000};
+    for (size_t d = 0; d < 2; d++) {
+        config.datarate = datarate ? datarate : datarates[d];
+        printf("SPIRIT1 multi-radio RX, %u frames per radio, %u byte payload, %u bps, %u us gap\r\n",
+               config.frames, config.payload, config.datarate, (unsigned) (config.gapNs / 1000));
+        printf("%6s %7s %7s %9s %9s %8s %8s\r\n", "radios", "recv", "missed", "frames/s", "kbps", "scaling",
+               "trans.");
+        for (size_t count = 1; count <= MAX_RADIOS; count++) workload(count);
+        if (datarate) break;
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+/**
+ * Packet buffers of spirit1BufferPool.h against the copying descriptors of
+ * spirit1RxRing.h and spirit1TxQueue.h.
+ *
+ *   spirit1-bench-pool [iterations] [payload bytes]
+ *
+ * alloc/free: ns per alloc() + free() pair with the pool empty, half and
+ * nearly full, which must not change. RX: a packet read from the simulated
+ * FIFO by the radio thread and handed to the application, which reads its
+ * payload and lets it go; TX: a frame built by the application and queued,
+ * without the radio thread.
+ * copied: bytes moved by the CPU per packet outside the SPI transfer; ns: host
+ * time per packet, SPI transfer included; RAM: bytes of static memory for 16
+ * packets in flight.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include "SPIRIT_Config.h"
+#include "spirit1RxRing.h"
+#include "spirit1BufferPool.h"
+#include "spirit1TxQueue.h"
+#include "standInTransport.h"
+
+static uint32_t iterations;
+static uint8_t length;
+static volatile uint32_t sink;
+
+static double nsSince(std::chrono::steady_clock::time_point start, uint32_t count) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+}
+
+/* a received packet waiting in the RX FIFO of the simulated chip */
+static void fillRxFifo() {
+    Spirit1SimFrame frame = Spirit1SimFrame();
+    frame.crcOk = true;
+    frame.payload.assign(length, 0x5A);
+    SpiritCmdStrobeRx();
+    standInBus().chip().inject(frame);
+    standInBus().chip().advance(standInBus().chip().airtimeNs(length) + 1000000);
+    SpiritIrqClearStatus();
+}
+
+static uint32_t consume(const uint8_t *payload, uint16_t size) {
+    uint32_t sum = 0;
+    for (uint16_t i = 0; i < size; i++) sum += payload[i];
+    return sum;
+}
+
+static double rxCopy() {
+    static Spirit1RxRing<16> ring;
+    Spirit1RxPacket packet;
+    double ns = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        fillRxFifo();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        spirit1RxReceive(ring, i);
+        ring.pop(packet);
+        sink = consume(packet.payload, packet.length);
+        ns += nsSince(start, 1);
+        SpiritCmdStrobeFlushRxFifo();
+    }
+    return ns / iterations;
+}
+
+static double rxPool() {
+    static Spirit1BufferPool<16, SPIRIT1_RX_PAYLOAD_MAX> pool;
+    static Spirit1RxRing<16, Spirit1Buffer *> ring;
+    Spirit1Buffer *packet;
+    double ns = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        fillRxFifo();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        spirit1RxReceive(ring, pool, i);
+        ring.pop(packet);
+        sink = consume(packet->data(), packet->length);
+        packet->release();
+        ns += nsSince(start, 1);
+        SpiritCmdStrobeFlushRxFifo();
+    }
+    return ns / iterations;
+}
+
+/* the application side only: build 16 frames and queue them, a new queue each time */
+template<bool Pooled>
+static double tx() {
+    static Spirit1BufferPool<16, SPIRIT1_TX_PAYLOAD_MAX> pool;
+    uint8_t frame[SPIRIT1_TX_PAYLOAD_MAX];
+    Spirit1Buffer *queued[16];
+    double ns = 0;
+    for (uint32_t i = 0; i < iterations; i += 16) {
+        Spirit1TxQueue<16> queue;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (uint32_t k = 0; k < 16; k++) {
+            if (Pooled) {
+                Spirit1Buffer *buffer = queued[k] = pool.alloc();
+                memset(buffer->data(), (int) k, length);
+                buffer->length = length;
+                queue.push(buffer);
+            } else {
+                memset(frame, (int) k, length);
+                queue.push(frame, length);
+            }
+        }
+        ns += nsSince(start, 16);
+        /* sent */
+        for (uint32_t k = 0; Pooled && k < 16; k++) queued[k]->release();
+    }
+    return ns / (iterations / 16);
+}
+
+int main(int argc, char **argv) {
+    iterations = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 20000;
+    uint32_t bytes = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 0) : 64;
+    length = (uint8_t) (bytes > SPIRIT1_RX_PAYLOAD_MAX ? SPIRIT1_RX_PAYLOAD_MAX : bytes ? bytes : 1);
+    iterations = (iterations + 15) & ~15u;
+
+    SRadioInit radio = {0, 868000000, 20000, 0, FSK, 500000, 250000, 800000};
+    PktBasicInit basic = {PKT_PREAMBLE_LENGTH_04BYTES, PKT_SYNC_LENGTH_4BYTES, 0x1A2635A8, PKT_LENGTH_VAR, 7,
+                          PKT_CRC_MODE_16BITS_1, PKT_CONTROL_LENGTH_0BYTES, S_DISABLE, S_DISABLE, S_ENABLE};
+    SpiritCmdStrobeSres();
+    SpiritRadioSetXtalFrequency(50000000);
+    SpiritRadioInit(&radio);
+    SpiritPktBasicInit(&basic);
+
+    printf("SPIRIT1 buffer pool, %u iterations, %u byte packets\r\n", iterations, length);
+
+    printf("%-10s %8s %8s %8s\r\n", "", "empty", "half", "full-1");
+    Spirit1BufferPool<32, SPIRIT1_RX_PAYLOAD_MAX> pool;
+    Spirit1Buffer *held[32];
+    printf("%-10s", "alloc/free");
+    for (uint32_t occupied = 0; occupied < 32; occupied += occupied ? 15 : 16) {
+        for (uint32_t k = 0; k < occupied; k++) held[k] = pool.alloc();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; i++) pool.free(pool.alloc());
+        printf(" %8.1f", nsSince(start, iterations));
+        for (uint32_t k = 0; k < occupied; k++) pool.free(held[k]);
+    }
+    printf("\r\n\r\n");
+
+    size_t copyRam = sizeof(Spirit1RxRing<16>);
+    size_t poolRam = sizeof(Spirit1RxRing<16, Spirit1Buffer *>) + sizeof(Spirit1BufferPool<16, SPIRIT1_RX_PAYLOAD_MAX>);
+    printf("%-3s %-11s %8s %8s %8s\r\n", "", "", "copied", "ns", "RAM");
+    printf("%-3s %-11s %8u %8.1f %8lu\r\n", "RX", "descriptor", (unsigned) sizeof(Spirit1RxPacket), rxCopy(),
+           (unsigned long) copyRam);
+    printf("%-3s %-11s %8u %8.1f %8lu\r\n", "RX", "pool", (unsigned) sizeof(Spirit1Buffer *), rxPool(),
+           (unsigned long) poolRam);
+    printf("%-3s %-11s %8u %8.1f %8lu\r\n", "TX", "descriptor", (unsigned) length, tx<false>(),
+           (unsigned long) sizeof(Spirit1TxQueue<16>));
+    printf("%-3s %-11s %8u %8.1f %8lu\r\n", "TX", "pool", 0u, tx<true>(),
+           (unsigned long) (sizeof(Spirit1TxQueue<16>) + sizeof(Spirit1BufferPool<16, SPIRIT1_TX_PAYLOAD_MAX>)));
+    return 0;
+}
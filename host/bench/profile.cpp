@@ -0,0 +1,105 @@
+/**
+ * SPI cost per SPIRIT1 library call (spirit1Profile.h) of the firmware's
+ * radio bring-up, a retune and a packet exchange, against the simulated chip
+ * on the timed stand-in bus.
+ *
+ *   spirit1-bench-profile [spi frequency in Hz] [select delay in ns] [dump file]
+ *
+ * With a dump file the table is also written there as the binary image the
+ * target produces, for host/tools/profdump.cpp.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SPIRIT_Config.h"
+#include "spirit1Profile.h"
+#include "standInTransport.h"
+
+static void radioInit() {
+    SRadioInit radio = {0, 868000000, 20000, 0, FSK, 38400, 20000, 100000};
+    PktBasicInit basic = {PKT_PREAMBLE_LENGTH_04BYTES, PKT_SYNC_LENGTH_4BYTES, 0x1A2635A8, PKT_LENGTH_VAR, 7,
+                          PKT_CRC_MODE_16BITS_1, PKT_CONTROL_LENGTH_0BYTES, S_ENABLE, S_DISABLE, S_ENABLE};
+    PktBasicAddressesInit addresses = {S_ENABLE, 0x44, S_DISABLE, 0xEE, S_ENABLE, 0xFF};
+    SGpioInit gpioIrq = {SPIRIT_GPIO_3, SPIRIT_GPIO_MODE_DIGITAL_OUTPUT_LP, SPIRIT_GPIO_DIG_OUT_IRQ};
+
+    SpiritCmdStrobeSres();
+    SpiritManagementWaExtraCurrent();
+    SpiritRadioSetXtalFrequency(50000000);
+    SpiritRadioInit(&radio);
+    SpiritPktBasicInit(&basic);
+    SpiritPktBasicAddressesInit(&addresses);
+    SpiritGpioInit(&gpioIrq);
+    SpiritRadioSetPALeveldBm(7, 11.6f);
+    SpiritRadioSetPALevelMaxIndex(7);
+    SpiritIrqDeInit(NULL);
+    SpiritIrq(TX_DATA_SENT, S_ENABLE);
+    SpiritIrq(RX_DATA_DISC, S_ENABLE);
+    SpiritIrq(RX_DATA_READY, S_ENABLE);
+    SpiritQiSetSqiThreshold(SQI_TH_0);
+    SpiritQiSqiCheck(S_ENABLE);
+    SpiritTimerSetRxTimeoutMs(1000.0);
+    SpiritTimerSetRxTimeoutStopCondition(SQI_ABOVE_THRESHOLD);
+    SpiritIrqClearStatus();
+}
+
+static void exchange() {
+    SpiritIrqs irqs;
+    uint8_t payload[20] = "profile";
+    Spirit1Sim &chip = standInBus().chip();
+
+    SpiritPktBasicSetPayloadLength(sizeof(payload));
+    SpiritCmdStrobeFlushTxFifo();
+    SpiritSpiWriteLinearFifo(sizeof(payload), payload);
+    SpiritCmdStrobeTx();
+    chip.advance(chip.airtimeNs(sizeof(payload)) + 200000);
+    SpiritIrqGetStatus(&irqs);
+
+    Spirit1SimFrame frame = Spirit1SimFrame();
+    frame.destination = 0x44;
+    frame.crcOk = true;
+    frame.payload.assign(payload, payload + sizeof(payload));
+    SpiritCmdStrobeRx();
+    chip.inject(frame, -70, 200000);
+    chip.advance(chip.airtimeNs(sizeof(payload)) + 400000);
+    SpiritIrqGetStatus(&irqs);
+    if (irqs.IRQ_RX_DATA_READY) {
+        uint8_t n = SpiritLinearFifoReadNumElementsRxFifo();
+        SpiritSpiReadLinearFifo(n, payload);
+        SpiritQiGetRssi();
+        SpiritPktBasicGetReceivedPktLength();
+    }
+    SpiritCmdStrobeFlushRxFifo();
+}
+
+static void writeFile(const uint8_t *data, size_t size, void *context) {
+    fwrite(data, 1, size, (FILE *) context);
+}
+
+int main(int argc, char **argv) {
+    uint32_t frequency = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 5000000;
+    uint32_t selectNs = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 0) : 2000;
+
+    standInBus().setFrequency(frequency);
+    standInBus().setSelectDelayNs(selectNs);
+    spirit1ProfileReset();
+
+    radioInit();
+    SpiritRadioSetFrequencyBase(915000000);
+    SpiritManagementWaVcoCalibration();
+    for (int i = 0; i < 10; i++) exchange();
+
+    printf("SPIRIT1 SPI cost per library call, stand-in bus @ %lu Hz, %lu ns per transaction\r\n",
+           (unsigned long) frequency, (unsigned long) selectNs);
+    spirit1ProfileReport();
+
+    if (argc > 3) {
+        FILE *file = fopen(argv[3], "wb");
+        if (!file) {
+            perror(argv[3]);
+            return 1;
+        }
+        spirit1ProfileDump(writeFile, file);
+        fclose(file);
+    }
+    return 0;
+}
@@ -0,0 +1,126 @@
+/**
+ * Packets delivered to a slow application by the RX ring of spirit1RxRing.h,
+ * at the highest SPIRIT1 datarate on the simulated chip: persistent RX and
+ * back to back frames, the radio bottom half queues every RX_DATA_READY and
+ * the application takes the queued packets every period. A ring of one slot
+ * is the former single RX buffer.
+ *
+ *   spirit1-bench-rxring [frames] [payload bytes] [application period in us] [datarate]
+ *
+ * missed: frames the radio did not receive; dropped: ring full; bad: out of
+ * order or damaged payloads seen by the application. All times are virtual.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SPIRIT_Config.h"
+#include "spirit1RxRing.h"
+#include "standInTransport.h"
+
+static const uint64_t NEVER = ~(uint64_t) 0;
+
+static struct {
+    uint32_t frames;
+    uint32_t payload;
+    uint64_t periodNs;
+    uint32_t datarate;
+} config;
+
+static void radioInit() {
+    uint32_t fdev = config.datarate / 2;
+    uint32_t bandwidth = 2 * (config.datarate + fdev) < 800000 ? 2 * (config.datarate + fdev) : 800000;
+    SRadioInit radio = {0, 868000000, 20000, 0, FSK, config.datarate, fdev, bandwidth};
+    PktBasicInit basic = {PKT_PREAMBLE_LENGTH_04BYTES, PKT_SYNC_LENGTH_4BYTES, 0x1A2635A8, PKT_LENGTH_VAR, 7,
+                          PKT_CRC_MODE_16BITS_1, PKT_CONTROL_LENGTH_0BYTES, S_DISABLE, S_DISABLE, S_ENABLE};
+
+    SpiritCmdStrobeSres();
+    SpiritRadioSetXtalFrequency(50000000);
+    SpiritRadioInit(&radio);
+    SpiritPktBasicInit(&basic);
+    SpiritRadioPersistenRx(S_ENABLE);
+    SpiritIrqDeInit(NULL);
+    SpiritIrq(RX_DATA_READY, S_ENABLE);
+    SpiritIrq(RX_DATA_DISC, S_ENABLE);
+    SpiritIrqClearStatus();
+    SpiritCmdStrobeRx();
+}
+
+template<uint32_t Size>
+static void run() {
+    Spirit1Sim &chip = standInBus().chip();
+    Spirit1RxRing<Size> ring;
+    Spirit1RxPacket packet;
+    uint32_t delivered = 0, bad = 0, next = 0;
+    uint64_t latencySum = 0;
+
+    radioInit();
+    chip.resetStats();
+
+    /* payload: frame number (LE), then its low byte */
+    Spirit1SimFrame frame = Spirit1SimFrame();
+    frame.crcOk = true;
+    uint64_t period = chip.airtimeNs((uint16_t) config.payload) + 20000;
+    uint64_t start = chip.now();
+    for (uint32_t k = 0; k < config.frames; k++) {
+        frame.payload.assign(config.payload, (uint8_t) k);
+        for (int i = 0; i < 4; i++) frame.payload[i] = (uint8_t) (k >> (8 * i));
+        chip.inject(frame, -60, 100000 + k * period);
+    }
+
+    uint64_t appAt = start + config.periodNs;
+    for (;;) {
+        if (chip.irqPending()) {
+            SpiritIrqs irqs;
+            uint32_t nowUs = (uint32_t) (chip.now() / 1000);
+            SpiritIrqGetStatus(&irqs);
+            if (irqs.IRQ_RX_DATA_READY && !spirit1RxReceive(ring, nowUs)) SpiritCmdStrobeFlushRxFifo();
+            continue;
+        }
+        if (chip.now() >= appAt) {
+            /* the application */
+            while (ring.pop(packet)) {
+                uint32_t k = (uint32_t) packet.payload[0] | ((uint32_t) packet.payload[1] << 8) |
+                             ((uint32_t) packet.payload[2] << 16) | ((uint32_t) packet.payload[3] << 24);
+                if (packet.length != config.payload || k < next || packet.payload[packet.length - 1] != (uint8_t) k) {
+                    bad++;
+                }
+                next = k + 1;
+                delivered++;
+                latencySum += chip.now() / 1000 - packet.timestampUs;
+            }
+            appAt += config.periodNs;
+        }
+        const Spirit1SimStats &stats = chip.stats();
+        if (stats.framesReceived + stats.framesDiscarded + stats.framesMissed >= config.frames &&
+            !chip.irqPending() && ring.count() == 0) {
+            break;
+        }
+        uint64_t event = chip.clock().nextEventNs();
+        if (event == NEVER || event > appAt) event = appAt;
+        chip.advance(event > chip.now() ? event - chip.now() : 0);
+    }
+    double seconds = (double) (chip.now() - start) / 1e9;
+
+    printf("%5u %7u %7u %7u %7u %5u %6u %9.1f %9.1f\r\n", (unsigned) Size, config.frames, delivered,
+           chip.stats().framesMissed, ring.stats().overflows, bad, ring.stats().highWater, delivered / seconds,
+           delivered ? (double) latencySum / delivered : 0.0);
+}
+
+int main(int argc, char **argv) {
+    config.frames = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 2000;
+    config.payload = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 0) : 20;
+    config.periodNs = (argc > 3 ? strtoul(argv[3], NULL, 0) : 5000) * 1000ULL;
+    config.datarate = argc > 4 ? (uint32_t) strtoul(argv[4], NULL, 0) : 500000;
+    if (config.payload < 5) config.payload = 5;
+    if (config.payload > SPIRIT1_RX_PAYLOAD_MAX) config.payload = SPIRIT1_RX_PAYLOAD_MAX;
+
+    printf("SPIRIT1 RX ring, %u frames, %u byte payload, %u bps, application every %u us\r\n", config.frames,
+           config.payload, config.datarate, (unsigned) (config.periodNs / 1000));
+    printf("%5s %7s %7s %7s %7s %5s %6s %9s %9s\r\n", "slots", "sent", "recv", "missed", "dropped", "bad",
+           "high", "frames/s", "lat. us");
+    run<1>();
+    run<4>();
+    run<16>();
+    run<32>();
+    return 0;
+}
@@ -0,0 +1,118 @@
+/**
+ * SPI transactions of common SPIRIT1 library calls with and without the
+ * register shadow, counted on the untimed stand-in bus.
+ *
+ *   spirit1-bench-shadow
+ *
+ * "cold" runs the call sequence right after an invalidation (as after a
+ * reset), "warm" runs it a second time, as when re-configuring the radio.
+ */
+#include <stdio.h>
+
+#include "SPIRIT_Config.h"
+#include "standInTransport.h"
+
+static void radioSetters() {
+    SpiritRadioSetXtalFrequency(50000000);
+    SpiritRadioSetDatarate(38400);
+    SpiritRadioSetFrequencyDev(20000);
+    SpiritRadioSetChannelBW(100000);
+    SpiritRadioSetModulation(FSK);
+}
+
+static void paSetters() {
+    SpiritRadioSetPALeveldBm(7, 11.6f);
+    SpiritRadioSetPALevelMaxIndex(7);
+}
+
+static void packetInit() {
+    PktBasicInit init = {
+            PKT_PREAMBLE_LENGTH_04BYTES, PKT_SYNC_LENGTH_4BYTES, 0x1A2635A8,
+            PKT_LENGTH_VAR, 7, PKT_CRC_MODE_16BITS_2, PKT_CONTROL_LENGTH_0BYTES,
+            S_ENABLE, S_DISABLE, S_ENABLE
+    };
+    SpiritPktBasicInit(&init);
+}
+
+static void addressesInit() {
+    PktBasicAddressesInit init = {S_ENABLE, 0x44, S_DISABLE, 0xEE, S_DISABLE, 0xFF};
+    SpiritPktBasicAddressesInit(&init);
+}
+
+static void irqSetup() {
+    SpiritIrqDeInit(NULL);
+    SpiritIrq(RX_DATA_READY, S_ENABLE);
+    SpiritIrq(RX_DATA_DISC, S_ENABLE);
+    SpiritIrq(TX_DATA_SENT, S_ENABLE);
+    SpiritIrqClearStatus();
+}
+
+static void csmaInit() {
+    CsmaInit init = {S_DISABLE, TBIT_TIME_64, TCCA_TIME_3, 5, 0xFA21, 32};
+    SpiritCsmaInit(&init);
+    SpiritCsma(S_ENABLE);
+}
+
+static void qiSetup() {
+    SpiritQiSetRssiThresholddBm(-120);
+    SpiritQiPqiCheck(S_ENABLE);
+    SpiritQiSqiCheck(S_ENABLE);
+}
+
+struct Call {
+    const char *name;
+    void (*run)();
+};
+
+static const Call calls[] = {
+        {"radio setters", radioSetters},
+        {"PA setters", paSetters},
+        {"SpiritPktBasicInit", packetInit},
+        {"SpiritPktBasicAddressesInit", addressesInit},
+        {"IRQ setup", irqSetup},
+        {"SpiritCsmaInit", csmaInit},
+        {"QI setup", qiSetup},
+};
+
+static const int nCalls = sizeof(calls) / sizeof(calls[0]);
+
+/* transactions issued on the bus by each call */
+static void pass(uint32_t *transactions) {
+    for (int i = 0; i < nCalls; i++) {
+        uint32_t before = standInSpi().stats().transactions;
+        calls[i].run();
+        transactions[i] = standInSpi().stats().transactions - before;
+    }
+}
+
+int main() {
+    uint32_t off[nCalls], cold[nCalls], warm[nCalls];
+    SpiritShadowCounters counters;
+
+    SpiritShadowEnable(S_DISABLE);
+    pass(off);
+
+    SpiritShadowEnable(S_ENABLE);
+    SpiritShadowInvalidate();
+    pass(cold);
+    SpiritShadowResetCounters();
+    pass(warm);
+    SpiritShadowGetCounters(&counters);
+
+    printf("SPIRIT1 register shadow, SPI transactions per call\r\n");
+    printf("%-28s %5s %5s %5s\r\n", "call", "off", "cold", "warm");
+    uint32_t totalOff = 0, totalCold = 0, totalWarm = 0;
+    for (int i = 0; i < nCalls; i++) {
+        printf("%-28s %5lu %5lu %5lu\r\n", calls[i].name,
+               (unsigned long) off[i], (unsigned long) cold[i], (unsigned long) warm[i]);
+        totalOff += off[i];
+        totalCold += cold[i];
+        totalWarm += warm[i];
+    }
+    printf("%-28s %5lu %5lu %5lu\r\n", "total",
+           (unsigned long) totalOff, (unsigned long) totalCold, (unsigned long) totalWarm);
+    printf("warm pass: %lu transactions and %lu bytes saved\r\n",
+           (unsigned long) counters.lTransactionsSaved, (unsigned long) counters.lBytesSaved);
+
+    return 0;
+}
@@ -0,0 +1,131 @@
+/**
+ * The integer radio formulas of SPIRIT_Fixed.h against the float and double
+ * expressions they replaced (radioFloatReference.h), per call on the host CPU.
+ *
+ *   spirit1-bench-solver [iterations]
+ *
+ * cycles: time stamp counter ticks per call (x86 only, 0 elsewhere); ns: host
+ * time per call. The host has hardware doubles: on a Cortex-M4F the double
+ * expressions are library calls (__aeabi_ddiv, __aeabi_dmul, __aeabi_ui2d,
+ * __aeabi_d2uiz and round()), on a Cortex-M0 the float ones as well, while the
+ * integer forms need the 64 bit division at most.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "SPIRIT_Config.h"
+#include "radioFloatReference.h"
+
+#define INPUTS 4096
+
+static uint32_t iterations;
+static volatile uint32_t sink;
+static uint32_t xtals[INPUTS], bases[INPUTS], words[INPUTS], fdevs[INPUTS];
+static int16_t ppms[INPUTS];
+static int32_t offsets[INPUTS];
+
+static uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static uint32_t nextRandom() {
+    static uint32_t state = 12345;
+    state = state * 1664525 + 1013904223;
+    return state >> 8;
+}
+
+/* xtals of both ranges, bases of the high band, offsets within the FC_OFFSET range */
+static void fillInputs() {
+    for (int i = 0; i < INPUTS; i++) {
+        xtals[i] = (i & 1 ? 48000000 : 24000000) + nextRandom() % (i & 1 ? 4000001 : 2000001);
+        bases[i] = HIGH_BAND_LOWER_LIMIT + nextRandom() % (HIGH_BAND_UPPER_LIMIT - HIGH_BAND_LOWER_LIMIT);
+        words[i] = referenceSynthWord(bases[i], HIGH_BAND_FACTOR / 2, 1, xtals[i]);
+        fdevs[i] = F_DEV_LOWER_LIMIT(xtals[i]) + nextRandom() % (F_DEV_UPPER_LIMIT(xtals[i]) - F_DEV_LOWER_LIMIT(xtals[i]));
+        ppms[i] = (int16_t) (nextRandom() % 201) - 100;
+        offsets[i] = (int32_t) (nextRandom() % 400001) - 200000;
+    }
+}
+
+static uint32_t ifOffset(int i, bool fixed) {
+    return fixed ? SpiritFixedIfOffset(xtals[i] >> 12) : referenceIfOffset(xtals[i], 12);
+}
+
+static uint32_t ppmOffset(int i, bool fixed) {
+    return (uint32_t) (fixed ? SpiritFixedPpmOffset(ppms[i], bases[i]) : referencePpmOffset(ppms[i], bases[i]));
+}
+
+static uint32_t offsetFactor(int i, bool fixed) {
+    return (uint32_t) (fixed ? SpiritFixedOffsetFactor(offsets[i], xtals[i])
+                             : referenceOffsetFactor(offsets[i], xtals[i]));
+}
+
+static uint32_t fdevSearch(int i, bool fixed) {
+    uint8_t m, e;
+    SpiritRadioSetXtalFrequency(xtals[i]);
+    if (fixed) SpiritRadioSearchFreqDevME(fdevs[i], &m, &e);
+    else referenceSearchFreqDevME(xtals[i], fdevs[i], &m, &e);
+    return (uint32_t) (m << 4 | e);
+}
+
+static uint32_t synthWord(int i, bool fixed) {
+    return fixed ? SpiritFixedScale(bases[i] * (HIGH_BAND_FACTOR / 2), FBASE_DIVIDER, xtals[i])
+                 : referenceSynthWord(bases[i], HIGH_BAND_FACTOR / 2, 1, xtals[i]);
+}
+
+static uint32_t frequencyBase(int i, bool fixed) {
+    return fixed ? SpiritFixedScaleRound(words[i], xtals[i], FBASE_DIVIDER * (HIGH_BAND_FACTOR / 2))
+                 : referenceFrequencyBase(words[i], HIGH_BAND_FACTOR / 2, 1, xtals[i]);
+}
+
+struct Formula {
+    const char *name;
+    uint32_t (*run)(int i, bool fixed);
+};
+
+static const Formula formulas[] = {
+    {"IF offset", ifOffset},
+    {"ppm offset", ppmOffset},
+    {"FC_OFFSET factor", offsetFactor},
+    {"fdev search", fdevSearch},
+    {"synth word", synthWord},
+    {"frequency base", frequencyBase},
+};
+
+static void run(const Formula &formula) {
+    double ns[2], cycles[2];
+    uint32_t differences = 0;
+
+    for (int i = 0; i < INPUTS; i++) differences += formula.run(i, true) != formula.run(i, false);
+    for (int fixed = 0; fixed < 2; fixed++) {
+        uint32_t sum = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        uint64_t begin = ticks();
+        for (uint32_t n = 0; n < iterations; n++) sum += formula.run((int) (n % INPUTS), fixed != 0);
+        cycles[fixed] = (double) (ticks() - begin) / iterations;
+        ns[fixed] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                    iterations;
+        sink = sum;
+    }
+
+    printf("%-17s %10.1f %10.1f %10.1f %10.1f %6lu\r\n", formula.name, cycles[0], ns[0], cycles[1], ns[1],
+           (unsigned long) differences);
+}
+
+int main(int argc, char **argv) {
+    iterations = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 1000000;
+
+    fillInputs();
+    printf("SPIRIT1 radio formulas, %lu calls each\r\n", (unsigned long) iterations);
+    printf("%-17s %21s %21s\r\n", "", "float/double", "integer");
+    printf("%-17s %10s %10s %10s %10s %6s\r\n", "formula", "cycles", "ns", "cycles", "ns", "diff.");
+    for (size_t f = 0; f < sizeof(formulas) / sizeof(formulas[0]); f++) run(formulas[f]);
+    return 0;
+}
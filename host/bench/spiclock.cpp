@@ -0,0 +1,100 @@
+/**
+ * RX FIFO drain time at the mbed default SPI clock (1 MHz) and at the clock
+ * found by the SPI clock discovery of SPIRIT_SpiClock.h, on the simulated
+ * chip with a bus that corrupts bytes above a given clock.
+ *
+ *   spirit1-bench-spiclock [bus limit in Hz] [step in Hz] [margin steps]
+ *
+ * drain us: virtual time to read the level and the 96 bytes of a full RX
+ * FIFO (two transactions); calibration: virtual time and pattern rounds of
+ * the scan.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SPIRIT_Config.h"
+#include "standInTransport.h"
+
+static const uint8_t FRAME_LENGTH = 96;
+
+static void radioInit() {
+    SRadioInit radio = {0, 868000000, 20000, 0, FSK, 250000, 125000, 600000};
+    PktBasicInit basic = {PKT_PREAMBLE_LENGTH_04BYTES, PKT_SYNC_LENGTH_4BYTES, 0x1A2635A8, PKT_LENGTH_VAR, 7,
+                          PKT_CRC_MODE_16BITS_1, PKT_CONTROL_LENGTH_0BYTES, S_DISABLE, S_DISABLE, S_ENABLE};
+
+    SpiritCmdStrobeSres();
+    SpiritRadioSetXtalFrequency(50000000);
+    SpiritRadioInit(&radio);
+    SpiritPktBasicInit(&basic);
+    SpiritIrqDeInit(NULL);
+    SpiritIrq(RX_DATA_READY, S_ENABLE);
+    SpiritIrqClearStatus();
+}
+
+/* receives a full FIFO frame and drains it, returns the virtual ns of the drain */
+static uint64_t drain() {
+    Spirit1Sim &chip = standInBus().chip();
+    Spirit1SimFrame frame = Spirit1SimFrame();
+    uint8_t payload[FRAME_LENGTH];
+
+    frame.crcOk = true;
+    frame.payload.assign(FRAME_LENGTH, 0x5A);
+    SpiritIrqClearStatus();
+    SpiritCmdStrobeRx();
+    chip.inject(frame, -60, 100000);
+    while (!chip.irqPending()) chip.advance(10000);
+
+    uint64_t start = chip.now();
+    uint8_t length = SpiritLinearFifoReadNumElementsRxFifo();
+    SpiritSpiReadLinearFifo(length, payload);
+    uint64_t elapsed = chip.now() - start;
+    if (length != FRAME_LENGTH) printf("short frame: %u bytes\r\n", length);
+    return elapsed;
+}
+
+static void report(const char *name, uint32_t hz) {
+    uint64_t ns = drain();
+    printf("%-14s %9.2f %9.1f %9.1f\r\n", name, hz / 1e6, ns / 1000.0,
+           (double) FRAME_LENGTH * 8 * 1e6 / (double) ns);
+}
+
+int main(int argc, char **argv) {
+    uint32_t limit = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 8500000;
+    uint32_t step = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 0) : 500000;
+    uint32_t margin = argc > 3 ? (uint32_t) strtoul(argv[3], NULL, 0) : 1;
+    SpiClockInit init = {1000000, SPIRIT_SPI_CLOCK_MAX_HZ, step, (uint8_t) margin, 8};
+    Spirit1Sim &chip = standInBus().chip();
+    SpiritSpiClockCounters counters;
+
+    chip.setSpiLimit(limit);
+    radioInit();
+
+    printf("SPIRIT1 SPI clock, bus limit %.2f MHz, %.2f MHz steps, %u step margin\r\n", limit / 1e6, step / 1e6,
+           margin);
+    printf("%-14s %9s %9s %9s\r\n", "clock", "MHz", "drain us", "kbps");
+
+    RadioSpiSetBaudrate(1000000);
+    report("mbed default", 1000000);
+
+    SpiritSpiClockResetCounters();
+    uint64_t start = chip.now();
+    uint32_t hz = SpiritSpiClockCalibrate(&init);
+    uint64_t calibration = chip.now() - start;
+    SpiritSpiClockGetCounters(&counters);
+    report("calibrated", hz);
+
+    /* the bus degrades, e.g. with the temperature */
+    chip.setSpiLimit(limit * 3 / 4);
+    start = chip.now();
+    SpiritSpiClockCheck();
+    uint64_t check = chip.now() - start;
+    report("after check", SpiritSpiClockGet());
+
+    printf("calibration: %.1f us, %lu rounds, %lu errors\r\n", calibration / 1000.0,
+           (unsigned long) counters.lRounds, (unsigned long) counters.lErrors);
+    SpiritSpiClockGetCounters(&counters);
+    printf("check after the degradation: %.1f us, %lu steps down\r\n", check / 1000.0,
+           (unsigned long) counters.lDegrades);
+    printf("bytes corrupted on the bus: %lu\r\n", (unsigned long) chip.stats().spiErrors);
+    return 0;
+}
@@ -0,0 +1,148 @@
+/**
+ * Sustained throughput of packets larger than the linear FIFO, streamed with
+ * SPIRIT_Stream.h through the FIFO almost empty/almost full IRQs, on the
+ * simulated chip. Each IRQ is served lateNs after nIRQ, the latency of the
+ * radio thread.
+ *
+ *   spirit1-bench-stream [IRQ latency in us] [TX refill level] [RX drain level] [SPI clock in Hz]
+ *
+ * airtime: time on air of the packet; TX: TX command to TX_DATA_SENT served,
+ * RX: first bit on the air to RX_DATA_READY served; kbps: payload bits over
+ * that time; irqs: refills or drains; result: done, underflow or overflow.
+ * All times are virtual.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SPIRIT_Config.h"
+#include "standInTransport.h"
+
+static const uint16_t MAX_PAYLOAD = 4096;
+
+static uint8_t payload[MAX_PAYLOAD], received[MAX_PAYLOAD];
+
+static uint64_t lateNs;
+
+static void radioInit(uint32_t datarate) {
+    uint32_t fdev = datarate / 2;
+    uint32_t bandwidth = 2 * (datarate + fdev) < 800000 ? 2 * (datarate + fdev) : 800000;
+    SRadioInit radio = {0, 868000000, 20000, 0, FSK, datarate, fdev, bandwidth};
+    PktBasicInit basic = {PKT_PREAMBLE_LENGTH_04BYTES, PKT_SYNC_LENGTH_4BYTES, 0x1A2635A8, PKT_LENGTH_VAR, 13,
+                          PKT_CRC_MODE_16BITS_1, PKT_CONTROL_LENGTH_0BYTES, S_DISABLE, S_DISABLE, S_ENABLE};
+
+    SpiritCmdStrobeSres();
+    SpiritRadioSetXtalFrequency(50000000);
+    SpiritRadioInit(&radio);
+    SpiritPktBasicInit(&basic);
+    SpiritIrqDeInit(NULL);
+    SpiritIrqClearStatus();
+}
+
+static const char *name(SpiritStreamResult result) {
+    switch (result) {
+        case SPIRIT_STREAM_DONE:
+            return "done";
+        case SPIRIT_STREAM_UNDERFLOW:
+            return "underflow";
+        case SPIRIT_STREAM_OVERFLOW:
+            return "overflow";
+        case SPIRIT_STREAM_DISCARDED:
+            return "discarded";
+        default:
+            return "timeout";
+    }
+}
+
+/* the IRQ handler of the radio thread, until the stream ends */
+static SpiritStreamResult serve() {
+    Spirit1Sim &chip = standInBus().chip();
+    SpiritStreamResult result = SPIRIT_STREAM_BUSY;
+    uint64_t end = chip.now() + 10000000000ULL;
+    while (result == SPIRIT_STREAM_BUSY && chip.now() < end) {
+        if (!chip.irqPending()) {
+            uint64_t event = chip.clock().nextEventNs();
+            chip.advance(event > chip.now() ? event - chip.now() : 0);
+            continue;
+        }
+        chip.advance(lateNs);
+        SpiritIrqs irqs;
+        SpiritIrqGetStatus(&irqs);
+        result = SpiritStreamHandleIrqs(&irqs);
+    }
+    return result;
+}
+
+static void report(const char *way, uint16_t length, uint32_t datarate, uint64_t airtime, uint64_t elapsed,
+                   uint32_t irqs, SpiritStreamResult result, bool intact) {
+    printf("%-3s %6u %7lu %9.1f %9.1f ", way, length, (unsigned long) datarate, airtime / 1e6, elapsed / 1e6);
+    if (result == SPIRIT_STREAM_DONE) printf("%7.1f", length * 8 * 1e6 / (double) elapsed);
+    else printf("%7s", "-");
+    printf(" %5lu %s%s\r\n", (unsigned long) irqs, name(result),
+           result == SPIRIT_STREAM_DONE && !intact ? " (damaged)" : "");
+}
+
+static void transmit(uint16_t length, uint32_t datarate) {
+    Spirit1Sim &chip = standInBus().chip();
+    SpiritStreamCounters counters;
+
+    SpiritStreamResetCounters();
+    SpiritPktBasicSetPayloadLength(length);
+    uint64_t start = chip.now();
+    SpiritStreamTxStart(payload, length);
+    SpiritStreamResult result = serve();
+    uint64_t elapsed = chip.now() - start;
+    SpiritStreamGetCounters(&counters);
+
+    const Spirit1SimFrame &sent = chip.lastTransmitted();
+    bool intact = sent.payload.size() == length && memcmp(&sent.payload[0], payload, length) == 0;
+    report("TX", length, datarate, chip.airtimeNs(length), elapsed, counters.lRefills, result, intact);
+}
+
+static void receive(uint16_t length, uint32_t datarate) {
+    Spirit1Sim &chip = standInBus().chip();
+    SpiritStreamCounters counters;
+    Spirit1SimFrame frame = Spirit1SimFrame();
+
+    frame.crcOk = true;
+    frame.payload.assign(payload, payload + length);
+    SpiritStreamResetCounters();
+    SpiritStreamRxStart(received, sizeof(received));
+    chip.advance(1000000);
+    chip.inject(frame);
+    uint64_t start = chip.now();
+    SpiritStreamResult result = serve();
+    uint64_t elapsed = chip.now() - start;
+    SpiritStreamGetCounters(&counters);
+    /* let a frame cut short by an overflow go by */
+    chip.advance(chip.airtimeNs(length));
+
+    bool intact = SpiritStreamGetLength() == length && memcmp(received, payload, length) == 0;
+    report("RX", length, datarate, chip.airtimeNs(length), elapsed, counters.lDrains, result, intact);
+}
+
+int main(int argc, char **argv) {
+    static const uint16_t lengths[] = {1024, 2048, 4096};
+    static const uint32_t datarates[] = {250000, 500000};
+    lateNs = (argc > 1 ? strtoul(argv[1], NULL, 0) : 100) * 1000ULL;
+    StreamInit levels = {
+            (uint8_t) (argc > 2 ? strtoul(argv[2], NULL, 0) : SPIRIT_STREAM_TX_REFILL_LEVEL),
+            (uint8_t) (argc > 3 ? strtoul(argv[3], NULL, 0) : SPIRIT_STREAM_RX_DRAIN_LEVEL)};
+    uint32_t spiHz = argc > 4 ? (uint32_t) strtoul(argv[4], NULL, 0) : 8000000;
+
+    for (uint16_t i = 0; i < MAX_PAYLOAD; i++) payload[i] = (uint8_t) (i * 13 + (i >> 8));
+    standInBus().chip().setSpiFrequency(spiHz);
+
+    printf("SPIRIT1 streams, IRQ latency %lu us, TX refill at %u bytes, RX drain at %u bytes, SPI %.1f MHz\r\n",
+           (unsigned long) (lateNs / 1000), levels.cTxRefillLevel, levels.cRxDrainLevel, spiHz / 1e6);
+    printf("%-3s %6s %7s %9s %9s %7s %5s %s\r\n", "", "bytes", "bps", "air ms", "ms", "kbps", "irqs", "result");
+    for (size_t d = 0; d < sizeof(datarates) / sizeof(datarates[0]); d++) {
+        radioInit(datarates[d]);
+        SpiritStreamInit(&levels);
+        for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+            transmit(lengths[l], datarates[d]);
+            receive(lengths[l], datarates[d]);
+        }
+    }
+    return 0;
+}
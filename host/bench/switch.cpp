@@ -0,0 +1,110 @@
+/**
+ * Profile switches of spirit1RadioProfile.h against the full configuration
+ * by the library (SpiritRadioInit() and the PA, packet length and RX timeout
+ * setters), on the timed stand-in bus, for the common transitions between a
+ * long range and a high rate profile on the same channel and a move to
+ * another channel.
+ *
+ *   spirit1-bench-switch [spi frequency in Hz] [select delay in ns] [iterations]
+ *
+ * "switch" recalibrates the VCO when the synthesizer changes, "switch, words"
+ * uses the calibration words captured with the profile. trans., bytes, polls:
+ * SPI transactions, bus bytes and MC_STATE reads per switch; chip us: virtual
+ * time on the model; us/switch: the bus time.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SPIRIT_Config.h"
+#include "spirit1RadioProfile.h"
+#include "standInTransport.h"
+
+typedef struct {
+    const char *name;
+    uint32_t base;
+    uint32_t datarate;
+    float dbm;
+    uint16_t length;
+    float timeoutMs;
+} Config;
+
+static const Config CONFIGS[] = {
+    {"long range", 868000000, 4800, 11, 20, 500},
+    {"high rate", 868000000, 250000, 0, 60, 20},
+    {"other channel", 869525000, 38400, 5, 32, 100},
+};
+
+static void configure(const Config &config) {
+    SRadioInit radio = {0, config.base, 20000, 0, FSK, config.datarate, config.datarate / 2,
+                        3 * config.datarate < 600000 ? 3 * config.datarate : 600000};
+    SpiritRadioInit(&radio);
+    SpiritRadioSetPALeveldBm(0, config.dbm);
+    SpiritRadioSetPALevelMaxIndex(0);
+    SpiritPktBasicSetPayloadLength(config.length);
+    SpiritTimerSetRxTimeoutMs(config.timeoutMs);
+}
+
+static void run(const char *transition, int from, int to, int method, int iterations) {
+    static const char *methods[] = {"library", "switch", "switch, words"};
+    Spirit1Sim &chip = standInBus().chip();
+    Spirit1ProfileSwitch<3> profiles(method != 2);
+
+    SpiritCmdStrobeSres();
+    SpiritRadioSetXtalFrequency(50000000);
+    for (int c = 0; c < 3; c++) {
+        configure(CONFIGS[c]);
+        profiles.capture(CONFIGS[c].name);
+    }
+
+    uint64_t chipNs = 0;
+    uint32_t busUs = 0, transactions = 0, bytes = 0, polls = 0;
+    for (int i = 0; i < iterations; i++) {
+        if (method) profiles.select(CONFIGS[from].name);
+        else configure(CONFIGS[from]);
+        chip.resetStats();
+        uint64_t chipBegin = chip.now();
+        uint32_t begin = standInBus().nowUs();
+        if (method) profiles.select(CONFIGS[to].name);
+        else configure(CONFIGS[to]);
+        busUs += standInBus().nowUs() - begin;
+        chipNs += chip.now() - chipBegin;
+        transactions += chip.stats().transactions;
+        bytes += chip.stats().bytes;
+        polls += chip.stats().statePolls;
+    }
+
+    printf("%-27s %-14s %7.1f %7.1f %6.1f %9.1f %9.1f\r\n", transition, methods[method],
+           (double) transactions / iterations, (double) bytes / iterations, (double) polls / iterations,
+           chipNs / 1000.0 / iterations, (double) busUs / iterations);
+}
+
+int main(int argc, char **argv) {
+    static const struct {
+        const char *name;
+        int from, to;
+    } transitions[] = {
+        {"long range -> high rate", 0, 1},
+        {"high rate -> long range", 1, 0},
+        {"long range -> other chan.", 0, 2},
+        {"high rate -> high rate", 1, 1},
+    };
+    uint32_t frequency = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 5000000;
+    uint32_t selectNs = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 0) : 2000;
+    int iterations = argc > 3 ? atoi(argv[3]) : 100;
+    Spirit1ProfileSwitchCost bound = Spirit1ProfileSwitch<3>::bound();
+
+    standInBus().setFrequency(frequency);
+    standInBus().setSelectDelayNs(selectNs);
+
+    printf("SPIRIT1 profile switch, stand-in bus @ %lu Hz, %lu ns per transaction, %d iterations\r\n",
+           (unsigned long) frequency, (unsigned long) selectNs, iterations);
+    printf("bound: %u transactions, %u bytes and the VCO calibration\r\n", bound.transactions, bound.bytes);
+    printf("%-27s %-14s %7s %7s %6s %9s %9s\r\n", "transition", "", "trans.", "bytes", "polls", "chip us",
+           "us/switch");
+    for (size_t t = 0; t < sizeof(transitions) / sizeof(transitions[0]); t++) {
+        for (int method = 0; method < 3; method++) {
+            run(transitions[t].name, transitions[t].from, transitions[t].to, method, iterations);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+/**
+ * The integer timer search of SPIRIT_Timer.c (SpiritTimerSearchValues())
+ * against the float one it replaced (radioFloatReference.h), for the RX
+ * timeout and the wake-up timer: time per call on the host CPU and error of
+ * the period reached, over targets spread from 50 us to 1.8 s, within the
+ * reach of both timers.
+ *
+ *   spirit1-bench-timer [xtal in Hz] [iterations]
+ *
+ * cycles: time stamp counter ticks per call (x86 only, 0 elsewhere); ns: host
+ * time per call; mean and max: error of the period in us; closer: targets on
+ * which the integer search is closer than the float one. The host has
+ * hardware floats: on a Cortex-M0 the float search runs in library calls.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "SPIRIT_Config.h"
+#include "radioFloatReference.h"
+
+#define INPUTS 4096
+
+static uint32_t xtal, iterations;
+static volatile uint32_t sink;
+static uint32_t targets[INPUTS];
+
+static uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static uint32_t nextRandom() {
+    static uint32_t state = 12345;
+    state = state * 1664525 + 1013904223;
+    return state >> 8;
+}
+
+/* as many in each decade from 50 us to 1.8 s */
+static void fillInputs() {
+    for (int i = 0; i < INPUTS; i++) {
+        uint32_t from = 50;
+        for (int decade = i % 5; decade > 0; decade--) from *= 10;
+        targets[i] = from + nextRandom() % (from * 9 + 1);
+        if (targets[i] > 1800000) targets[i] = 500000 + nextRandom() % 1300001;
+    }
+}
+
+static uint32_t rxTimeout(uint32_t us, bool fixed, uint8_t *counter, uint8_t *prescaler) {
+    if (fixed) SpiritTimerComputeRxTimeoutValues(us / 1000.0f, counter, prescaler);
+    else referenceRxTimeoutValues(xtal, us / 1000.0f, counter, prescaler);
+    return xtal > DOUBLE_XTAL_THR ? xtal / 2 : xtal;
+}
+
+static uint32_t wakeUp(uint32_t us, bool fixed, uint8_t *counter, uint8_t *prescaler) {
+    uint16_t rco = SpiritTimerGetRcoFrequency();
+    if (fixed) SpiritTimerComputeWakeUpValues(us / 1000.0f, counter, prescaler);
+    else referenceWakeUpValues(rco, us / 1000.0f, counter, prescaler);
+    return rco;
+}
+
+struct Timer {
+    const char *name;
+    uint32_t den;          /* of the period in ticks times 10^6: 1210 * 10^6 for the RX timeout */
+    uint32_t (*run)(uint32_t us, bool fixed, uint8_t *counter, uint8_t *prescaler);
+};
+
+static const Timer timers[] = {
+    {"RX timeout", 1210000000, rxTimeout},
+    {"wake-up", 1000000, wakeUp},
+};
+
+/* error in us of the period of counter and prescaler, clock the timer clock times den / 10^6 */
+static double errorUs(uint32_t us, uint32_t clock, uint32_t den, uint8_t counter, uint8_t prescaler) {
+    double period = (double) (counter + 1) * (prescaler + 1) * den / clock;
+    return period > us ? period - us : us - period;
+}
+
+static void run(const Timer &timer) {
+    double ns[2], cycles[2], mean[2] = {0, 0}, max[2] = {0, 0};
+    uint32_t closer = 0;
+
+    for (int i = 0; i < INPUTS; i++) {
+        double error[2];
+        for (int fixed = 0; fixed < 2; fixed++) {
+            uint8_t counter, prescaler;
+            uint32_t clock = timer.run(targets[i], fixed != 0, &counter, &prescaler);
+            error[fixed] = errorUs(targets[i], clock, timer.den, counter, prescaler);
+            mean[fixed] += error[fixed] / INPUTS;
+            if (error[fixed] > max[fixed]) max[fixed] = error[fixed];
+        }
+        closer += error[1] < error[0];
+    }
+    for (int fixed = 0; fixed < 2; fixed++) {
+        uint32_t sum = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        uint64_t begin = ticks();
+        for (uint32_t n = 0; n < iterations; n++) {
+            uint8_t counter, prescaler;
+            timer.run(targets[n % INPUTS], fixed != 0, &counter, &prescaler);
+            sum += counter + prescaler;
+        }
+        cycles[fixed] = (double) (ticks() - begin) / iterations;
+        ns[fixed] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                    iterations;
+        sink = sum;
+    }
+
+    printf("%-11s %-8s %9.1f %9.1f %9.2f %9.2f\r\n", timer.name, "float", cycles[0], ns[0], mean[0], max[0]);
+    printf("%-11s %-8s %9.1f %9.1f %9.2f %9.2f %6lu\r\n", timer.name, "integer", cycles[1], ns[1], mean[1], max[1],
+           (unsigned long) closer);
+}
+
+int main(int argc, char **argv) {
+    xtal = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 52000000;
+    iterations = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 0) : 1000000;
+
+    /* the RCO frequency is read from the chip, over the stand-in bus, for a 25 MHz xtal only */
+    SpiritRadioSetXtalFrequency(xtal);
+    fillInputs();
+    printf("SPIRIT1 timer search, xtal %lu Hz, %d targets, %lu calls each\r\n", (unsigned long) xtal, INPUTS,
+           (unsigned long) iterations);
+    printf("%-11s %-8s %9s %9s %9s %9s %6s\r\n", "timer", "search", "cycles", "ns", "mean us", "max us", "closer");
+    for (size_t t = 0; t < sizeof(timers) / sizeof(timers[0]); t++) run(timers[t]);
+    return 0;
+}
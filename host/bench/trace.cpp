@@ -0,0 +1,68 @@
+/**
+ * Per-call cost of the SPIRIT1 driver functions at the trace level the
+ * benchmark was compiled with (one executable per level), on the untimed
+ * stand-in bus, so only the software cost is measured.
+ *
+ *   spirit1-bench-trace-<level> [iterations] [console baud rate]
+ *
+ * The dump level output is formatted but discarded; the time the characters
+ * would take on the console UART is estimated separately.
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "spirit1Trace.h"
+#include "standInTransport.h"
+
+static uint64_t traceCharacters = 0;
+
+int traceSinkPrintf(const char *format, ...) {
+    char line[128];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    traceCharacters += n;
+    return n;
+}
+
+static const char *const levelNames[] = {"off", "counters", "ring", "dump"};
+
+static void run(const char *name, int kind, uint8_t n, int iterations, uint32_t baud) {
+    uint8_t buffer[96];
+    for (int i = 0; i < n; i++) buffer[i] = (uint8_t) i;
+
+    traceCharacters = 0;
+    uint32_t begin = standInBus().nowUs();
+    for (int i = 0; i < iterations; i++) {
+        switch (kind) {
+            case SPIRIT1_TRACE_WRITE: RadioSpiWriteRegisters(0x10, n, buffer); break;
+            case SPIRIT1_TRACE_READ: RadioSpiReadRegisters(0x10, n, buffer); break;
+            case SPIRIT1_TRACE_COMMAND: RadioSpiCommandStrobes(0x62); break;
+            case SPIRIT1_TRACE_WRITE_FIFO: RadioSpiWriteFifo(n, buffer); break;
+            default: RadioSpiReadFifo(n, buffer); break;
+        }
+    }
+    uint32_t elapsed = standInBus().nowUs() - begin;
+
+    double characters = (double) traceCharacters / iterations;
+    printf("%-9s %-13s %4d %9.3f %8.1f %10.1f\r\n", levelNames[SPIRIT1_TRACE_LEVEL], name, n,
+           1.0 * elapsed / iterations, characters, characters * 10 * 1e6 / baud);
+}
+
+int main(int argc, char **argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 100000;
+    uint32_t baud = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 0) : 115200;
+
+    standInSpi().setBurstThreshold(256);
+
+    printf("%-9s %-13s %4s %9s %8s %10s\r\n", "level", "call", "size", "us/call", "chars", "uart us");
+    run("write regs", SPIRIT1_TRACE_WRITE, 4, iterations, baud);
+    run("read regs", SPIRIT1_TRACE_READ, 4, iterations, baud);
+    run("strobe", SPIRIT1_TRACE_COMMAND, 0, iterations, baud);
+    run("write fifo", SPIRIT1_TRACE_WRITE_FIFO, 32, iterations, baud);
+    run("read fifo", SPIRIT1_TRACE_READ_FIFO, 32, iterations, baud);
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * Back to back transmissions with the TX queue of spirit1TxQueue.h against
+ * the former loop (flush, write the frame, TX command, wait for
+ * TX_DATA_SENT), on the simulated chip. Each IRQ is served lateNs after
+ * nIRQ, the latency of the radio thread; the application keeps the queue
+ * full.
+ *
+ *   spirit1-bench-txqueue [frames] [IRQ latency in us] [SPI clock in Hz]
+ *
+ * air: frames/s if the frames followed each other with no gap at all;
+ * gap us: average time between the end of a frame and the start of the
+ * next. All times are virtual.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SPIRIT_Config.h"
+#include "spirit1TxQueue.h"
+#include "standInTransport.h"
+
+static uint32_t frames;
+static uint64_t lateNs;
+static uint8_t payload[SPIRIT1_TX_PAYLOAD_MAX];
+static uint32_t completed, disorders;
+
+static void radioInit(uint32_t datarate) {
+    uint32_t fdev = datarate / 2;
+    uint32_t bandwidth = 2 * (datarate + fdev) < 800000 ? 2 * (datarate + fdev) : 800000;
+    SRadioInit radio = {0, 868000000, 20000, 0, FSK, datarate, fdev, bandwidth};
+    PktBasicInit basic = {PKT_PREAMBLE_LENGTH_04BYTES, PKT_SYNC_LENGTH_4BYTES, 0x1A2635A8, PKT_LENGTH_VAR, 7,
+                          PKT_CRC_MODE_16BITS_1, PKT_CONTROL_LENGTH_0BYTES, S_DISABLE, S_DISABLE, S_ENABLE};
+
+    SpiritCmdStrobeSres();
+    SpiritRadioSetXtalFrequency(50000000);
+    SpiritRadioInit(&radio);
+    SpiritPktBasicInit(&basic);
+    SpiritIrqDeInit(NULL);
+    SpiritIrqClearStatus();
+}
+
+/* lets the time pass until nIRQ, then for the latency of the radio thread */
+static void waitIrq() {
+    Spirit1Sim &chip = standInBus().chip();
+    while (!chip.irqPending()) {
+        uint64_t event = chip.clock().nextEventNs();
+        chip.advance(event > chip.now() ? event - chip.now() : 10000);
+    }
+    chip.advance(lateNs);
+}
+
+static void done(void *context, bool sent) {
+    if (!sent || (uintptr_t) context != completed) disorders++;
+    completed++;
+}
+
+/* one frame at a time */
+static uint64_t sequential(uint8_t length) {
+    Spirit1Sim &chip = standInBus().chip();
+    SpiritIrqs irqs;
+
+    SpiritIrq(TX_DATA_SENT, S_ENABLE);
+    SpiritPktBasicSetPayloadLength(length);
+    uint64_t start = chip.now();
+    for (uint32_t k = 0; k < frames; k++) {
+        SpiritCmdStrobeFlushTxFifo();
+        SpiritSpiWriteLinearFifo(length, payload);
+        SpiritCmdStrobeTx();
+        do {
+            waitIrq();
+            SpiritIrqGetStatus(&irqs);
+        } while (!irqs.IRQ_TX_DATA_SENT);
+    }
+    return chip.now() - start;
+}
+
+static uint64_t pipelined(uint8_t length, Spirit1TxQueueStats *stats) {
+    Spirit1Sim &chip = standInBus().chip();
+    Spirit1TxQueue<8> queue;
+    SpiritIrqs irqs;
+    uint32_t pushed = 0;
+
+    completed = disorders = 0;
+    queue.init();
+    uint64_t start = chip.now();
+    while (completed < frames) {
+        /* the application, waking the radio thread up only for a push on the empty queue */
+        bool wake = false;
+        while (pushed < frames && queue.push(payload, length, done, (void *) (uintptr_t) pushed)) {
+            pushed++;
+            wake = wake || queue.startNeeded();
+        }
+        if (wake) queue.start();
+
+        waitIrq();
+        SpiritIrqGetStatus(&irqs);
+        queue.handleIrqs(irqs);
+    }
+    *stats = queue.stats();
+    return chip.now() - start;
+}
+
+int main(int argc, char **argv) {
+    static const uint32_t datarates[] = {38400, 250000, 500000};
+    static const uint8_t lengths[] = {20, 60, 96};
+    frames = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 1000;
+    lateNs = (argc > 2 ? strtoul(argv[2], NULL, 0) : 50) * 1000ULL;
+    uint32_t spiHz = argc > 3 ? (uint32_t) strtoul(argv[3], NULL, 0) : 8000000;
+    Spirit1Sim &chip = standInBus().chip();
+
+    for (int i = 0; i < SPIRIT1_TX_PAYLOAD_MAX; i++) payload[i] = (uint8_t) (i * 3);
+
+    chip.setSpiFrequency(spiHz);
+    printf("SPIRIT1 TX queue, %u frames, IRQ latency %lu us, SPI %.1f MHz\r\n", frames,
+           (unsigned long) (lateNs / 1000), spiHz / 1e6);
+    printf("%7s %5s %9s | %9s %7s | %9s %7s %5s %5s\r\n", "bps", "bytes", "air f/s", "loop f/s", "gap us",
+           "queue f/s", "gap us", "pre", "bad");
+    for (size_t d = 0; d < sizeof(datarates) / sizeof(datarates[0]); d++) {
+        for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+            Spirit1TxQueueStats stats;
+            radioInit(datarates[d]);
+            uint64_t airtime = chip.airtimeNs(lengths[l]);
+            uint64_t loop = sequential(lengths[l]);
+            radioInit(datarates[d]);
+            chip.resetStats();
+            uint64_t queued = pipelined(lengths[l], &stats);
+            if (chip.stats().framesSent != frames || chip.lastTransmitted().payload.size() != lengths[l]) disorders++;
+
+            printf("%7lu %5u %9.1f | %9.1f %7.1f | %9.1f %7.1f %5lu %5u\r\n", (unsigned long) datarates[d],
+                   lengths[l], 1e9 / airtime, frames * 1e9 / loop, (double) (loop / frames - airtime) / 1000,
+                   frames * 1e9 / queued, (double) (queued / frames - airtime) / 1000,
+                   (unsigned long) stats.preloaded, disorders);
+        }
+    }
+    return 0;
+}
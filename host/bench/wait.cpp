@@ -0,0 +1,79 @@
+/**
+ * MC_STATE polls of the library radio bring-up (SpiritRadioInit() and the VCO
+ * calibration workaround), with the state waits of SPIRIT_Wait.h polling the
+ * status bytes or blocking on a GPIO of the simulated chip, on the timed
+ * stand-in bus.
+ *
+ *   spirit1-bench-wait [spi frequency in Hz] [select delay in ns] [iterations]
+ *
+ * polls: MC_STATE reads per init; chip us: virtual time of the init on the
+ * model, the transition times included.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SPIRIT_Config.h"
+#include "standInTransport.h"
+
+static void radioInit() {
+    SRadioInit radio = {0, 868000000, 20000, 0, FSK, 38400, 20000, 100000};
+
+    SpiritCmdStrobeSres();
+    SpiritManagementWaExtraCurrent();
+    SpiritRadioSetXtalFrequency(50000000);
+    SpiritRadioInit(&radio);
+    SpiritManagementWaVcoCalibration();
+}
+
+static void run(const char *name, SpiritFunctionalState shadow, bool gpio, int iterations) {
+    Spirit1Sim &chip = standInBus().chip();
+    SpiritWaitCounters waits;
+
+    SpiritShadowEnable(shadow);
+    if (gpio) {
+        SpiritWaitGpioInit(SPIRIT_GPIO_0);
+        standInBus().setStateGpio(0);
+    } else {
+        SpiritWaitGpioDeInit();
+        standInBus().setStateGpio(-1);
+    }
+    standInSpi().resetStats();
+    chip.resetStats();
+    SpiritWaitResetCounters();
+
+    uint64_t chipBegin = chip.now();
+    uint32_t begin = standInBus().nowUs();
+    for (int i = 0; i < iterations; i++) radioInit();
+    uint32_t elapsed = standInBus().nowUs() - begin;
+
+    SpiritWaitGetCounters(&waits);
+    printf("%-12s %8.1f %8.1f %6.1f %6.1f %6lu %9.1f %9.1f\r\n", name,
+           (double) standInSpi().stats().transactions / iterations,
+           (double) standInSpi().stats().bytes / iterations,
+           (double) waits.lWaits / iterations,
+           (double) chip.stats().statePolls / iterations,
+           (unsigned long) waits.lFailures,
+           (double) (chip.now() - chipBegin) / 1000.0 / iterations,
+           (double) elapsed / iterations);
+}
+
+int main(int argc, char **argv) {
+    uint32_t frequency = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 5000000;
+    uint32_t selectNs = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 0) : 2000;
+    int iterations = argc > 3 ? atoi(argv[3]) : 200;
+
+    standInBus().setFrequency(frequency);
+    standInBus().setSelectDelayNs(selectNs);
+
+    printf("SPIRIT1 library bring-up, stand-in bus @ %lu Hz, %lu ns per transaction, %d iterations\r\n",
+           (unsigned long) frequency, (unsigned long) selectNs, iterations);
+    printf("%-12s %8s %8s %6s %6s %6s %9s %9s\r\n",
+           "waits", "trans.", "bytes", "waits", "polls", "errors", "chip us", "us/init");
+
+    run("poll", S_DISABLE, false, iterations);
+    run("poll+shadow", S_ENABLE, false, iterations);
+    run("gpio", S_DISABLE, true, iterations);
+    run("gpio+shadow", S_ENABLE, true, iterations);
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * Time to first RX: a cold boot (SRES, SpiritManagementWaExtraCurrent(), the
+ * configuration, the VCO calibration workaround) against a warm boot from the
+ * snapshot of spirit1WarmBoot.h, each followed by the RX strobe until
+ * MC_STATE is RX, on the timed stand-in bus.
+ *
+ *   spirit1-bench-warmboot [spi frequency in Hz] [select delay in ns] [iterations]
+ *
+ * trans., bytes, polls: SPI transactions, bus bytes and MC_STATE reads per
+ * boot; chip us: virtual time of the boot on the model, the transition times
+ * included; us/boot: the bus time.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SPIRIT_Config.h"
+#include "spirit1WarmBoot.h"
+#include "standInTransport.h"
+
+/* the snapshot in RAM */
+struct Storage {
+    Storage() : stored(false) {}
+
+    bool read(void *data, uint16_t length) {
+        if (stored) memcpy(data, &record, length);
+        return stored;
+    }
+
+    bool write(const void *data, uint16_t length) {
+        memcpy(&record, data, length);
+        stored = true;
+        return true;
+    }
+
+    Spirit1WarmBootRecord record;
+    bool stored;
+};
+
+static uint8_t coldInit() {
+    SRadioInit radio = {0, 868000000, 20000, 0, FSK, 38400, 20000, 100000};
+    PktBasicInit basic = {PKT_PREAMBLE_LENGTH_04BYTES, PKT_SYNC_LENGTH_4BYTES, 0x88888888, PKT_LENGTH_VAR, 7,
+                          PKT_CRC_MODE_16BITS_1, PKT_CONTROL_LENGTH_0BYTES, S_ENABLE, S_DISABLE, S_ENABLE};
+    PktBasicAddressesInit addresses = {S_ENABLE, 0x44, S_DISABLE, 0xEE, S_ENABLE, 0xFF};
+    SGpioInit gpioIrq = {SPIRIT_GPIO_3, SPIRIT_GPIO_MODE_DIGITAL_OUTPUT_LP, SPIRIT_GPIO_DIG_OUT_IRQ};
+
+    SpiritCmdStrobeSres();
+    SpiritManagementWaExtraCurrent();
+    SpiritRadioSetXtalFrequency(50000000);
+    if (SpiritRadioInit(&radio)) return 1;
+    SpiritPktBasicInit(&basic);
+    SpiritPktBasicAddressesInit(&addresses);
+    SpiritGpioInit(&gpioIrq);
+    SpiritIrqDeInit(NULL);
+    SpiritIrq(RX_DATA_READY, S_ENABLE);
+    SpiritIrq(RX_DATA_DISC, S_ENABLE);
+    SpiritIrqClearStatus();
+    return 0;
+}
+
+static void run(const char *name, bool warm, int iterations) {
+    Spirit1Sim &chip = standInBus().chip();
+    Storage storage;
+    Spirit1WarmBoot<Storage> warmBoot(storage, 0, 10);
+    int failures = 0;
+
+    /* the first boot is cold and saves the snapshot */
+    warmBoot.boot(1, 0, 25, coldInit);
+    chip.resetStats();
+
+    uint64_t chipBegin = chip.now();
+    uint32_t begin = standInBus().nowUs();
+    for (int i = 0; i < iterations; i++) {
+        if (!warm) storage.stored = false;
+        warmBoot.boot(1, 0, 25, coldInit);
+        SpiritCmdStrobeRx();
+        if (SpiritWaitState(MC_STATE_RX, SPIRIT_WAIT_STATE_TIMEOUT_US) != SPIRIT_WAIT_OK) failures++;
+    }
+    uint32_t elapsed = standInBus().nowUs() - begin;
+    if (warmBoot.stats().warm != (warm ? (uint32_t) iterations : 0)) failures++;
+
+    printf("%-8s %8.1f %8.1f %6.1f %6d %9.1f %9.1f\r\n", name,
+           (double) chip.stats().transactions / iterations,
+           (double) chip.stats().bytes / iterations,
+           (double) chip.stats().statePolls / iterations,
+           failures,
+           (double) (chip.now() - chipBegin) / 1000.0 / iterations,
+           (double) elapsed / iterations);
+}
+
+int main(int argc, char **argv) {
+    uint32_t frequency = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : 5000000;
+    uint32_t selectNs = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 0) : 2000;
+    int iterations = argc > 3 ? atoi(argv[3]) : 200;
+
+    standInBus().setFrequency(frequency);
+    standInBus().setSelectDelayNs(selectNs);
+
+    printf("SPIRIT1 boot to RX, stand-in bus @ %lu Hz, %lu ns per transaction, %d iterations\r\n",
+           (unsigned long) frequency, (unsigned long) selectNs, iterations);
+    printf("%-8s %8s %8s %6s %6s %9s %9s\r\n", "boot", "trans.", "bytes", "polls", "errors", "chip us", "us/boot");
+
+    run("cold", false, iterations);
+    run("warm", true, iterations);
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * The float and double formulas of SPIRIT_Radio.c and SPIRIT_Management.c
+ * as they were before SPIRIT_Fixed.h, the references of the equivalence test
+ * and of spirit1-bench-solver, and the float timer searches of SPIRIT_Timer.c
+ * as they were before SpiritTimerSearchValues(), for spirit1-bench-timer.
+ * Same expressions, same operand types: do not tidy them up, and do not
+ * build them with -ffast-math.
+ */
+#ifndef RADIO_FLOAT_REFERENCE_H
+#define RADIO_FLOAT_REFERENCE_H
+
+#include <math.h>
+#include <stdint.h>
+
+#include "SPIRIT_Config.h"
+
+#define REFERENCE_ROUND(A) (((A-(uint32_t)A)> 0.5)? (uint32_t)A+1:(uint32_t)A)
+
+/* SpiritRadioInit(), shift 12, or 13 for the digital IF offset of a doubled xtal */
+static inline uint8_t referenceIfOffset(uint32_t xtal, int shift) {
+    float if_off = (3.0 * 480140) / (xtal >> shift) - 64;
+    return REFERENCE_ROUND(if_off);
+}
+
+/* SpiritRadioInit(), SpiritRadioSetFrequencyOffsetPpm() */
+static inline int32_t referencePpmOffset(int16_t ppm, uint32_t fbase) {
+    return (int32_t) (((float) ppm * fbase) / PPM_FACTOR);
+}
+
+/* SpiritRadioInit(), SpiritRadioSetFrequencyOffsetPpm(), SpiritRadioSetFrequencyOffset() */
+static inline int16_t referenceOffsetFactor(int32_t offset, uint32_t xtal) {
+    return (int16_t) (((float) offset * FBASE_DIVIDER) / xtal);
+}
+
+/* SpiritRadioGetFrequencyDev(), SpiritRadioGetInfo() */
+static inline uint32_t referenceFdev(uint32_t xtal, uint8_t m, uint8_t e) {
+    return (uint32_t) ((float) xtal / (((uint32_t) 1) << 18) * (uint32_t) ((8.0 + m) / 2 * (1 << e)));
+}
+
+/* a threshold of the exponent search of SpiritRadioSearchFreqDevME() */
+static inline uint32_t referenceFdevThreshold(uint32_t xtal, uint8_t i) {
+    float xtalDivtmp = (float) xtal / (((uint32_t) 1) << 18);
+    return (uint32_t) (xtalDivtmp * (uint32_t) (7.5 * (1 << i)));
+}
+
+static inline void referenceSearchFreqDevME(uint32_t xtal, uint32_t lFDev, uint8_t *pcM, uint8_t *pcE) {
+    uint8_t i;
+    uint32_t a, bp, b = 0;
+    float xtalDivtmp = (float) xtal / (((uint32_t) 1) << 18);
+
+    for (i = 0; i < 10; i++) {
+        a = (uint32_t) (xtalDivtmp * (uint32_t) (7.5 * (1 << i)));
+        if (lFDev < a) break;
+    }
+    (*pcE) = i;
+
+    for (i = 0; i < 8; i++) {
+        bp = b;
+        b = (uint32_t) (xtalDivtmp * (uint32_t) ((8.0 + i) / 2 * (1 << (*pcE))));
+        if (lFDev < b) break;
+    }
+
+    (*pcM) = i;
+    if ((lFDev - bp) < (b - lFDev)) (*pcM)--;
+}
+
+/* SpiritRadioSetFrequencyBase() */
+static inline uint32_t referenceSynthWord(uint32_t fbase, uint8_t bHalf, uint8_t refDiv, uint32_t xtal) {
+    return (uint32_t) (fbase * bHalf * (((double) (FBASE_DIVIDER * refDiv)) / xtal));
+}
+
+/* SpiritManagementSetFrequencyBase() */
+static inline uint32_t referenceManagementSynthWord(uint32_t fbase, uint8_t bHalf, uint8_t refDiv, uint32_t xtal) {
+    return (uint32_t) (fbase * (((double) (FBASE_DIVIDER * refDiv * bHalf)) / xtal));
+}
+
+/* SpiritRadioGetFrequencyBase(), SpiritRadioGetInfo() */
+static inline uint32_t referenceFrequencyBase(uint32_t synthWord, uint8_t bHalf, uint8_t refDiv, uint32_t xtal) {
+    return (uint32_t) round(synthWord * (((double) xtal) / (FBASE_DIVIDER * refDiv * bHalf)));
+}
+
+/* SpiritRadioGetInfo(), xtalDivided F_Xo>>cDivider */
+static inline uint32_t referenceInfoBandwidth(uint16_t bandwidth26M, uint32_t xtalDivided) {
+    return (uint32_t) (100.0 * bandwidth26M * (xtalDivided / 26e6));
+}
+
+/* SpiritRadioGetChannelBW() */
+static inline uint32_t referenceChannelBw(uint16_t bandwidth26M, uint32_t xtal) {
+    return (uint32_t) (100.0 * bandwidth26M * xtal / 26e6);
+}
+
+/* SpiritTimerComputeWakeUpValues(), rcoFrequency from SpiritTimerGetRcoFrequency() */
+static inline void referenceWakeUpValues(uint16_t rcoFrequency, float fDesiredMsec, uint8_t *pcCounter,
+                                         uint8_t *pcPrescaler) {
+    float rco_freq, err;
+    uint32_t n;
+
+    rco_freq = ((float) rcoFrequency) / 1000;
+    n = (uint32_t) (fDesiredMsec * rco_freq);
+    if (n / 0xFF > 0xFD) {
+        (*pcCounter) = 0xFF;
+        (*pcPrescaler) = 0xFF;
+        return;
+    }
+    (*pcPrescaler) = (n / 0xFF) + 2;
+    (*pcCounter) = n / (*pcPrescaler);
+    err = S_ABS((float) (*pcCounter) * (*pcPrescaler) / rco_freq - fDesiredMsec);
+    if ((*pcCounter) <= 254) {
+        if (S_ABS((float) ((*pcCounter) + 1) * (*pcPrescaler) / rco_freq - fDesiredMsec) < err)
+            (*pcCounter) = (*pcCounter) + 1;
+    }
+    (*pcPrescaler)--;
+    if ((*pcCounter) > 1) (*pcCounter)--;
+    else (*pcCounter) = 1;
+}
+
+/* SpiritTimerComputeRxTimeoutValues() */
+static inline void referenceRxTimeoutValues(uint32_t xtal, float fDesiredMsec, uint8_t *pcCounter,
+                                            uint8_t *pcPrescaler) {
+    uint32_t nXtalFrequency = xtal;
+    uint32_t n;
+    float err;
+
+    if (nXtalFrequency > DOUBLE_XTAL_THR) nXtalFrequency >>= 1;
+    n = (uint32_t) (fDesiredMsec * nXtalFrequency / 1210000);
+    if (n / 0xFF > 0xFD) {
+        (*pcCounter) = 0xFF;
+        (*pcPrescaler) = 0xFF;
+        return;
+    }
+    (*pcPrescaler) = (n / 0xFF) + 2;
+    (*pcCounter) = n / (*pcPrescaler);
+    err = S_ABS((float) (*pcCounter) * (*pcPrescaler) * 1210000 / nXtalFrequency - fDesiredMsec);
+    if ((*pcCounter) <= 254) {
+        if (S_ABS((float) ((*pcCounter) + 1) * (*pcPrescaler) * 1210000 / nXtalFrequency - fDesiredMsec) < err)
+            (*pcCounter) = (*pcCounter) + 1;
+    }
+    (*pcPrescaler)--;
+    if ((*pcCounter) > 1) (*pcCounter)--;
+    else (*pcCounter) = 1;
+}
+
+#endif // RADIO_FLOAT_REFERENCE_H
@@ -0,0 +1,190 @@
+/**
+ * Host stand-in for the SPIRIT1 SPI bus.
+ *
+ * Implements the bus adapter interface of spirit1Spi.h with the timing of a
+ * real SPI peripheral: write() keeps the CPU busy for one byte time (polled
+ * SPI), startTransfer() returns immediately and signals completion from a
+ * worker thread after the payload time has elapsed (DMA + interrupt).
+ * The bytes are exchanged with the behavioural SPIRIT1 model of spirit1Sim.h
+ * (chip()), which keeps its own virtual time paced by the same SPI clock;
+ * use() connects it to another model, to drive several radios in turn.
+ * A frequency of 0 disables the wall clock timing, for tests that only count
+ * traffic; the model then assumes a 10 MHz SPI clock.
+ * The select delay models the fixed cost of a transaction on the target
+ * (driver call, chip select toggling and setup time).
+ * Also the in-process transport backend (see spirit1Transport.h): shutdown
+ * drives the SDN pin of the model, leaving it is a power on reset, and one
+ * GPIO of the model can be wired for the state waits; waiting on it lets the
+ * virtual time pass, like a thread sleeping until the edge.
+ */
+#ifndef SPIRIT1_SPI_STAND_IN_H
+#define SPIRIT1_SPI_STAND_IN_H
+
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "spirit1Sim.h"
+
+class SpiStandInBus {
+public:
+    explicit SpiStandInBus(uint32_t frequency)
+            : _frequency(frequency), _selectNs(0), _current(&_chip), _stateGpio(-1), _running(true), _job(false),
+              _complete(false), _worker(&SpiStandInBus::run, this) {
+        _current->setSpiFrequency(frequency);
+    }
+
+    ~SpiStandInBus() {
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            _running = false;
+        }
+        _signal.notify_all();
+        _worker.join();
+    }
+
+    void setFrequency(uint32_t frequency) {
+        _frequency = frequency;
+        _current->setSpiFrequency(frequency);
+    }
+
+    void setSelectDelayNs(uint32_t ns) {
+        _selectNs = ns;
+        _current->setTransactionNs(ns);
+    }
+
+    /** the simulated SPIRIT1 the bus is connected to */
+    Spirit1Sim &chip() { return *_current; }
+
+    /**
+     * connects the bus to another model, e.g. one of the radios of a medium
+     * (spirit1Medium.h), or with NULL back to its own; only between
+     * transactions
+     */
+    void use(Spirit1Sim *chip) { _current = chip ? chip : &_chip; }
+
+    void lock() {}
+
+    void unlock() {}
+
+    void select() {
+        if (_selectNs) {
+            std::chrono::steady_clock::time_point until =
+                    std::chrono::steady_clock::now() + std::chrono::nanoseconds(_selectNs);
+            while (std::chrono::steady_clock::now() < until);
+        }
+        _current->select();
+    }
+
+    void deselect() { _current->deselect(); }
+
+    uint8_t write(uint8_t value) {
+        spin(1);
+        return _current->exchange(value);
+    }
+
+    bool canBlock() { return true; }
+
+    uint32_t nowUs() {
+        return (uint32_t) std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    bool startTransfer(const uint8_t *tx, uint8_t *rx, uint16_t n, void (*done)(void *), void *context) {
+        std::lock_guard<std::mutex> guard(_mutex);
+        if (_job) return false;
+        _tx = tx;
+        _rx = rx;
+        _n = n;
+        _done = done;
+        _context = context;
+        _complete = false;
+        _due = std::chrono::steady_clock::now() + byteTime() * n;
+        _job = true;
+        _signal.notify_all();
+        return true;
+    }
+
+    void waitTransfer() {
+        std::unique_lock<std::mutex> guard(_mutex);
+        _signal.wait(guard, [this] { return _complete; });
+    }
+
+    void enterShutdown() { _current->shutdown(true); }
+
+    void exitShutdown() { _current->shutdown(false); }
+
+    bool isShutdown() { return _current->isShutdown(); }
+
+    /** wires GPIO_n of the model to the pin waitGpioHigh() watches (SPIRIT_Wait.h), -1: none */
+    void setStateGpio(int gpio) { _stateGpio = gpio; }
+
+    /** runs the model until the wired GPIO is high, for at most timeoutUs of virtual time */
+    bool waitGpioHigh(uint32_t timeoutUs) {
+        if (_stateGpio < 0) return false;
+        uint64_t deadline = _current->now() + (uint64_t) timeoutUs * 1000;
+        while (!stateGpioHigh()) {
+            uint64_t now = _current->now();
+            uint64_t next = _current->clock().nextEventNs();
+            if (next > deadline) {
+                _current->advance(deadline - now);
+                return stateGpioHigh();
+            }
+            _current->advance(next > now ? next - now : 0);
+        }
+        return true;
+    }
+
+private:
+    bool stateGpioHigh() const { return (_current->gpio() >> _stateGpio) & 1; }
+
+    std::chrono::nanoseconds byteTime() const {
+        return std::chrono::nanoseconds(_frequency ? 8000000000ULL / _frequency : 0);
+    }
+
+    void spin(uint32_t bytes) {
+        if (!_frequency) return;
+        std::chrono::steady_clock::time_point until = std::chrono::steady_clock::now() + byteTime() * bytes;
+        while (std::chrono::steady_clock::now() < until);
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> guard(_mutex);
+        while (_running) {
+            _signal.wait(guard, [this] { return _job || !_running; });
+            if (!_running) break;
+            guard.unlock();
+            std::this_thread::sleep_until(_due);
+            for (uint16_t i = 0; i < _n; i++) {
+                uint8_t value = _current->exchange(_tx ? _tx[i] : 0xFF);
+                if (_rx) _rx[i] = value;
+            }
+            _done(_context);
+            guard.lock();
+            _job = false;
+            _complete = true;
+            _signal.notify_all();
+        }
+    }
+
+    uint32_t _frequency;
+    uint32_t _selectNs;
+    Spirit1Sim _chip;
+    Spirit1Sim *_current;
+    int _stateGpio;
+
+    std::mutex _mutex;
+    std::condition_variable _signal;
+    bool _running, _job, _complete;
+    const uint8_t *_tx;
+    uint8_t *_rx;
+    uint16_t _n;
+    void (*_done)(void *);
+    void *_context;
+    std::chrono::steady_clock::time_point _due;
+    std::thread _worker;
+};
+
+#endif // SPIRIT1_SPI_STAND_IN_H
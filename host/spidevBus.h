@@ -0,0 +1,149 @@
+/**
+ * Linux spidev backend for the SPIRIT1 transport (see spirit1Transport.h),
+ * for a SPIRIT1 wired to the SPI controller of a Linux host (Raspberry Pi,
+ * BeagleBone, USB-SPI bridges).
+ *
+ * Chip select is driven by the controller: every byte is sent as a message
+ * that leaves CS asserted (cs_change on the last transfer) and deselect()
+ * sends an empty message that releases it. Bursts are one ioctl; they run
+ * synchronously, so done() is called before startTransfer() returns.
+ * The SDN pin and a SPIRIT GPIO for the state waits are optional and go
+ * through the sysfs GPIO interface; the state GPIO is polled, every 10 us.
+ */
+#ifndef SPIRIT1_SPIDEV_BUS_H
+#define SPIRIT1_SPIDEV_BUS_H
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <linux/spi/spidev.h>
+#include <chrono>
+#include <thread>
+
+class SpidevBus {
+public:
+    /**
+     * device: e.g. /dev/spidev0.0, shutdownGpio: sysfs GPIO number of the SDN
+     * pin, already exported and configured as output, or -1
+     */
+    SpidevBus(const char *device, uint32_t frequency, int shutdownGpio = -1)
+            : _frequency(frequency), _shutdownGpio(shutdownGpio), _stateGpio(-1), _shutdown(false) {
+        _fd = open(device, O_RDWR);
+        if (_fd >= 0) {
+            uint8_t mode = SPI_MODE_0;
+            uint8_t bits = 8;
+            ioctl(_fd, SPI_IOC_WR_MODE, &mode);
+            ioctl(_fd, SPI_IOC_WR_BITS_PER_WORD, &bits);
+            ioctl(_fd, SPI_IOC_WR_MAX_SPEED_HZ, &_frequency);
+        }
+    }
+
+    ~SpidevBus() {
+        if (_fd >= 0) close(_fd);
+    }
+
+    bool isOpen() const { return _fd >= 0; }
+
+    void lock() {}
+
+    void unlock() {}
+
+    void select() {}
+
+    void deselect() { message(NULL, NULL, 0, false); }
+
+    uint8_t write(uint8_t value) {
+        uint8_t in = 0;
+        message(&value, &in, 1, true);
+        return in;
+    }
+
+    bool canBlock() { return true; }
+
+    uint32_t nowUs() {
+        return (uint32_t) std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    bool startTransfer(const uint8_t *tx, uint8_t *rx, uint16_t n, void (*done)(void *), void *context) {
+        if (!message(tx, rx, n, true)) return false;
+        done(context);
+        return true;
+    }
+
+    void waitTransfer() {}
+
+    void enterShutdown() {
+        _shutdown = true;
+        gpio(1);
+    }
+
+    void exitShutdown() {
+        _shutdown = false;
+        gpio(0);
+        // power on reset takes about 700 us
+        std::this_thread::sleep_for(std::chrono::microseconds(1000));
+    }
+
+    bool isShutdown() { return _shutdown; }
+
+    void setFrequency(uint32_t hz) { _frequency = hz; }
+
+    /** sysfs GPIO number of the input wired to the SPIRIT GPIO of the state waits (SPIRIT_Wait.h), or -1 */
+    void setStateGpio(int stateGpio) { _stateGpio = stateGpio; }
+
+    bool waitGpioHigh(uint32_t timeoutUs) {
+        if (_stateGpio < 0) return false;
+        std::chrono::steady_clock::time_point until =
+                std::chrono::steady_clock::now() + std::chrono::microseconds(timeoutUs);
+        while (readGpio(_stateGpio) != 1) {
+            if (std::chrono::steady_clock::now() >= until) return false;
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+        }
+        return true;
+    }
+
+private:
+    bool message(const uint8_t *tx, uint8_t *rx, uint32_t n, bool keepSelected) {
+        struct spi_ioc_transfer transfer;
+        memset(&transfer, 0, sizeof(transfer));
+        transfer.tx_buf = (unsigned long) tx;
+        transfer.rx_buf = (unsigned long) rx;
+        transfer.len = n;
+        transfer.speed_hz = _frequency;
+        transfer.bits_per_word = 8;
+        transfer.cs_change = keepSelected;
+        return ioctl(_fd, SPI_IOC_MESSAGE(1), &transfer) >= 0;
+    }
+
+    void gpio(int value) {
+        if (_shutdownGpio < 0) return;
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/class/gpio/gpio%d/value", _shutdownGpio);
+        FILE *file = fopen(path, "w");
+        if (!file) return;
+        fputc(value ? '1' : '0', file);
+        fclose(file);
+    }
+
+    int readGpio(int number) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/class/gpio/gpio%d/value", number);
+        FILE *file = fopen(path, "r");
+        if (!file) return -1;
+        int value = fgetc(file);
+        fclose(file);
+        return value == '1' ? 1 : 0;
+    }
+
+    int _fd;
+    uint32_t _frequency;
+    int _shutdownGpio;
+    int _stateGpio;
+    bool _shutdown;
+};
+
+#endif // SPIRIT1_SPIDEV_BUS_H
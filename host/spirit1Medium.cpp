@@ -0,0 +1,140 @@
+#include <math.h>
+#include <string.h>
+
+#include "SPIRIT_Config.h"
+#include "spirit1Medium.h"
+
+Spirit1Medium::Spirit1Medium()
+        : _defaultRssiDbm(-60), _defaultLossRate(0), _sensitivityDbm(-110), _noiseDbm(-120), _captureDb(10),
+          _seed(1) {
+    resetStats();
+}
+
+Spirit1Medium::~Spirit1Medium() {
+    for (size_t i = 0; i < _radios.size(); i++) _radios[i]->setAir(0);
+}
+
+size_t Spirit1Medium::attach(Spirit1Sim &sim) {
+    Link link = {_defaultRssiDbm, _defaultLossRate};
+    for (size_t i = 0; i < _links.size(); i++) _links[i].push_back(link);
+    _radios.push_back(&sim);
+    _links.push_back(std::vector<Link>(_radios.size(), link));
+    sim.setAir(this);
+    return _radios.size() - 1;
+}
+
+void Spirit1Medium::setRssi(int dbm) {
+    _defaultRssiDbm = dbm;
+    for (size_t i = 0; i < _links.size(); i++) {
+        for (size_t j = 0; j < _links[i].size(); j++) _links[i][j].rssiDbm = dbm;
+    }
+}
+
+void Spirit1Medium::setRssi(size_t from, size_t to, int dbm) {
+    _links[from][to].rssiDbm = dbm;
+}
+
+void Spirit1Medium::setLossRate(double rate) {
+    _defaultLossRate = rate;
+    for (size_t i = 0; i < _links.size(); i++) {
+        for (size_t j = 0; j < _links[i].size(); j++) _links[i][j].lossRate = rate;
+    }
+}
+
+void Spirit1Medium::setLossRate(size_t from, size_t to, double rate) {
+    _links[from][to].lossRate = rate;
+}
+
+void Spirit1Medium::resetStats() {
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+size_t Spirit1Medium::indexOf(const Spirit1Sim *sim) const {
+    for (size_t i = 0; i < _radios.size(); i++) {
+        if (_radios[i] == sim) return i;
+    }
+    return _radios.size();
+}
+
+/* same channel, datarate, sync word and packet format */
+bool Spirit1Medium::tunedAlike(size_t a, size_t b) const {
+    static const uint8_t registers[] = {
+            SYNT3_BASE, SYNT2_BASE, SYNT1_BASE, SYNT0_BASE, CHSPACE_BASE, CHNUM_BASE,
+            SYNC4_BASE, SYNC3_BASE, SYNC2_BASE, SYNC1_BASE,
+    };
+    const Spirit1Sim &x = *_radios[a], &y = *_radios[b];
+    for (size_t i = 0; i < sizeof(registers); i++) {
+        if (x.peek(registers[i]) != y.peek(registers[i])) return false;
+    }
+    if ((x.peek(PCKTCTRL2_BASE) & PCKTCTRL2_SYNC_LENGTH_MASK) != (y.peek(PCKTCTRL2_BASE) & PCKTCTRL2_SYNC_LENGTH_MASK)) {
+        return false;
+    }
+    if ((x.peek(PCKTCTRL3_BASE) & PCKTCTRL3_PKT_FRMT_MASK) != (y.peek(PCKTCTRL3_BASE) & PCKTCTRL3_PKT_FRMT_MASK)) {
+        return false;
+    }
+    uint32_t dx = x.datarate(), dy = y.datarate();
+    uint32_t difference = dx > dy ? dx - dy : dy - dx;
+    return difference * 50 <= (dx > dy ? dx : dy);
+}
+
+bool Spirit1Medium::heard(size_t from, size_t to) const {
+    return from != to && _links[from][to].rssiDbm >= _sensitivityDbm && tunedAlike(from, to);
+}
+
+double Spirit1Medium::random() {
+    _seed = _seed * 1103515245u + 12345u;
+    return (double) (_seed >> 8) / (double) (1u << 24);
+}
+
+void Spirit1Medium::transmitStart(Spirit1Sim *from, const std::shared_ptr<const Spirit1SimTransmission> &transmission) {
+    size_t sender = indexOf(from);
+    if (sender == _radios.size()) return;
+    _stats.transmissions++;
+
+    for (size_t to = 0; to < _radios.size(); to++) {
+        if (to == sender) continue;
+        if (!heard(sender, to)) {
+            _stats.unheard++;
+            continue;
+        }
+        Spirit1Sim &receiver = *_radios[to];
+        int rssi = _links[sender][to].rssiDbm;
+        _stats.receptions++;
+        receiver.receive(transmission, rssi);
+        if (random() < _links[sender][to].lossRate) {
+            receiver.corrupt(transmission.get());
+            _stats.losses++;
+        }
+
+        /* overlaps with the frames already on the air at this receiver */
+        for (size_t i = 0; i < _active.size(); i++) {
+            size_t other = _active[i].from;
+            if (other == to || !heard(other, to)) continue;
+            int otherRssi = _links[other][to].rssiDbm;
+            if (otherRssi < rssi + _captureDb && receiver.corrupt(_active[i].transmission.get())) _stats.collisions++;
+            if (rssi < otherRssi + _captureDb) receiver.corrupt(transmission.get());
+        }
+    }
+    Active active = {sender, transmission};
+    _active.push_back(active);
+}
+
+void Spirit1Medium::transmitEnd(Spirit1Sim *, const std::shared_ptr<const Spirit1SimTransmission> &transmission) {
+    for (size_t i = 0; i < _active.size(); i++) {
+        if (_active[i].transmission != transmission) continue;
+        _active.erase(_active.begin() + i);
+        return;
+    }
+}
+
+/* power sum of the noise floor and of the transmissions heard */
+int Spirit1Medium::channelDbm(const Spirit1Sim *at) {
+    size_t receiver = indexOf(at);
+    double milliwatts = pow(10.0, _noiseDbm / 10.0);
+    for (size_t i = 0; i < _active.size(); i++) {
+        if (receiver < _radios.size() && heard(_active[i].from, receiver)) {
+            milliwatts += pow(10.0, _links[_active[i].from][receiver].rssiDbm / 10.0);
+        }
+    }
+    return (int) floor(10.0 * log10(milliwatts) + 0.5);
+}
@@ -0,0 +1,111 @@
+/**
+ * In-process RF medium connecting simulated SPIRIT1 radios (spirit1Sim.h).
+ *
+ * The radios share one Spirit1SimClock. A transmission reaches every other
+ * radio when its header goes on the air and is played back by the receivers
+ * at the datarate and packet format they are configured for, so frames land
+ * in the RX FIFOs with the timing of the real packet engine. Per link:
+ *
+ *  - the RSSI at the receiver; below the sensitivity the frame is not heard
+ *  - a loss rate: the frame is received with a CRC error (bit errors)
+ *
+ * A radio only hears transmissions on the same synthesizer setting and
+ * channel, datarate (2 %), sync word and packet format. Two transmissions
+ * that overlap at a receiver collide: the frame being received is damaged
+ * unless it is at least captureDb stronger than the other one, the later
+ * frame is missed since the receiver is busy. CSMA and the RSSI threshold
+ * see the power sum of the transmissions on the air plus the noise floor.
+ *
+ * Random decisions come from a seeded generator, runs are reproducible.
+ */
+#ifndef SPIRIT1_MEDIUM_H
+#define SPIRIT1_MEDIUM_H
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "spirit1Sim.h"
+
+typedef struct {
+    uint32_t transmissions;
+    uint32_t receptions;      /*!< transmission heard by a radio, received or not */
+    uint32_t unheard;         /*!< below the sensitivity or not tuned alike */
+    uint32_t losses;          /*!< damaged by the loss rate */
+    uint32_t collisions;      /*!< frame being received damaged by an overlapping transmission */
+} Spirit1MediumStats;
+
+class Spirit1Medium : public Spirit1SimAir {
+public:
+    Spirit1Medium();
+
+    ~Spirit1Medium();
+
+    /** connects sim, which must run on the clock of the other radios; returns its index */
+    size_t attach(Spirit1Sim &sim);
+
+    /** RSSI of every link, -60 dBm by default */
+    void setRssi(int dbm);
+
+    /** RSSI at to of the transmissions of from */
+    void setRssi(size_t from, size_t to, int dbm);
+
+    /** probability that a frame is received with a CRC error, every link, 0 by default */
+    void setLossRate(double rate);
+
+    void setLossRate(size_t from, size_t to, double rate);
+
+    /** -110 dBm by default */
+    void setSensitivityDbm(int dbm) { _sensitivityDbm = dbm; }
+
+    /** -120 dBm by default */
+    void setNoiseDbm(int dbm) { _noiseDbm = dbm; }
+
+    /** margin above an interferer a frame survives with, 10 dB by default */
+    void setCaptureDb(int db) { _captureDb = db; }
+
+    void setSeed(uint32_t seed) { _seed = seed ? seed : 1; }
+
+    const Spirit1MediumStats &stats() const { return _stats; }
+
+    void resetStats();
+
+    /* Spirit1SimAir */
+    void transmitStart(Spirit1Sim *from, const std::shared_ptr<const Spirit1SimTransmission> &transmission);
+
+    void transmitEnd(Spirit1Sim *from, const std::shared_ptr<const Spirit1SimTransmission> &transmission);
+
+    int channelDbm(const Spirit1Sim *at);
+
+private:
+    struct Link {
+        int rssiDbm;
+        double lossRate;
+    };
+
+    struct Active {
+        size_t from;
+        std::shared_ptr<const Spirit1SimTransmission> transmission;
+    };
+
+    size_t indexOf(const Spirit1Sim *sim) const;
+
+    bool tunedAlike(size_t a, size_t b) const;
+
+    bool heard(size_t from, size_t to) const;
+
+    double random();
+
+    std::vector<Spirit1Sim *> _radios;
+    std::vector<std::vector<Link> > _links;
+    std::vector<Active> _active;
+    int _defaultRssiDbm;
+    double _defaultLossRate;
+    int _sensitivityDbm;
+    int _noiseDbm;
+    int _captureDb;
+    uint32_t _seed;
+    Spirit1MediumStats _stats;
+};
+
+#endif // SPIRIT1_MEDIUM_H
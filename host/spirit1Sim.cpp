@@ -0,0 +1,856 @@
+#include <string.h>
+#include <algorithm>
+
+#include "SPIRIT_Config.h"
+#include "spirit1Spi.h"
+#include "spirit1Sim.h"
+
+/* reset values, from the "Default value" of the register descriptions in SPIRIT_Regs.h */
+static const struct {
+    uint8_t address;
+    uint8_t value;
+} resetValues[] = {
+        {ANA_FUNC_CONF1_BASE, 0x0C}, {ANA_FUNC_CONF0_BASE, 0xC0},
+        {GPIO3_CONF_BASE, 0x03}, {GPIO2_CONF_BASE, 0x03}, {GPIO1_CONF_BASE, 0x03}, {GPIO0_CONF_BASE, 0x03},
+        {IF_OFFSET_ANA_BASE, 0xA3}, {SYNT3_BASE, 0x0C}, {SYNT2_BASE, 0x84}, {SYNT1_BASE, 0xEC}, {SYNT0_BASE, 0x51},
+        {CHSPACE_BASE, 0xFC}, {IF_OFFSET_DIG_BASE, 0xA3}, {FC_OFFSET1_BASE, 0xA3},
+        {PA_POWER8_BASE, 0x03}, {PA_POWER7_BASE, 0x0E}, {PA_POWER6_BASE, 0x1A}, {PA_POWER5_BASE, 0x25},
+        {PA_POWER4_BASE, 0x35}, {PA_POWER3_BASE, 0x40}, {PA_POWER2_BASE, 0x4E}, {PA_POWER0_BASE, 0x07},
+        {MOD1_BASE, 0x83}, {MOD0_BASE, 0x1A}, {FDEV0_BASE, 0x45}, {CHFLT_BASE, 0x23},
+        {AFC2_BASE, 0x48}, {AFC1_BASE, 0x18}, {AFC0_BASE, 0x25}, {RSSI_FLT_BASE, 0xF3}, {RSSI_TH_BASE, 0x24},
+        {CLOCKREC_BASE, 0x58}, {AGCCTRL2_BASE, 0x22}, {AGCCTRL1_BASE, 0x65}, {AGCCTRL0_BASE, 0x8A},
+        {ANT_SELECT_CONF_BASE, 0x05},
+        {PCKTCTRL3_BASE, 0x07}, {PCKTCTRL2_BASE, 0x1E}, {PCKTCTRL1_BASE, 0x20}, {PCKTLEN0_BASE, 0x14},
+        {SYNC4_BASE, 0x88}, {SYNC3_BASE, 0x88}, {SYNC2_BASE, 0x88}, {SYNC1_BASE, 0x88},
+        {QI_BASE, 0x02}, {MBUS_PRMBL_BASE, 0x20}, {MBUS_PSTMBL_BASE, 0x20},
+        {FIFO_CONFIG3_RXAFTHR_BASE, 0x30}, {FIFO_CONFIG2_RXAETHR_BASE, 0x30},
+        {FIFO_CONFIG1_TXAFTHR_BASE, 0x30}, {FIFO_CONFIG0_TXAETHR_BASE, 0x30},
+        {PCKT_FLT_OPTIONS_BASE, 0x70}, {PROTOCOL2_BASE, 0x06}, {PROTOCOL0_BASE, 0x08},
+        {CSMA_CONFIG3_BASE, 0xFF}, {CSMA_CONFIG1_BASE, 0x04},
+        {RCO_VCO_CALIBR_IN2_BASE, 0x70}, {RCO_VCO_CALIBR_IN1_BASE, 0x48}, {RCO_VCO_CALIBR_IN0_BASE, 0x48},
+        {RCO_VCO_CALIBR_OUT1_BASE, 0x70},
+        {SYNTH_CONFIG1_BASE, 0x5B}, {SYNTH_CONFIG0_BASE, 0x20}, {VCO_CONFIG_BASE, 0x11}, {0xA3, 0x37}, /* DEM_CONFIG */
+        {XO_RCO_TEST_BASE, 0x21}, {DEVICE_INFO1_PARTNUM, 0x01}, {DEVICE_INFO0_VERSION, 0x30},
+};
+
+const uint64_t Spirit1Sim::NEVER;
+
+void Spirit1SimClock::advance(uint64_t ns) {
+    uint64_t until = _now + ns;
+    for (;;) {
+        Spirit1Sim *next = 0;
+        uint64_t at = ~(uint64_t) 0;
+        for (size_t i = 0; i < _sims.size(); i++) {
+            uint64_t t = _sims[i]->nextEventNs();
+            if (t < at) {
+                at = t;
+                next = _sims[i];
+            }
+        }
+        if (!next || at > until) break;
+        if (at > _now) _now = at;
+        next->runEvents(_now);
+    }
+    _now = until;
+}
+
+uint64_t Spirit1SimClock::nextEventNs() const {
+    uint64_t at = ~(uint64_t) 0;
+    for (size_t i = 0; i < _sims.size(); i++) at = std::min(at, _sims[i]->nextEventNs());
+    return at;
+}
+
+void Spirit1SimClock::attach(Spirit1Sim *sim) {
+    _sims.push_back(sim);
+}
+
+void Spirit1SimClock::detach(Spirit1Sim *sim) {
+    _sims.erase(std::remove(_sims.begin(), _sims.end(), sim), _sims.end());
+}
+
+bool Spirit1Sim::Fifo::push(uint8_t value) {
+    if (count == FIFO_SIZE) return false;
+    data[(head + count++) % FIFO_SIZE] = value;
+    return true;
+}
+
+bool Spirit1Sim::Fifo::pop(uint8_t *value) {
+    if (!count) return false;
+    *value = data[head];
+    head = (uint8_t) ((head + 1) % FIFO_SIZE);
+    count--;
+    return true;
+}
+
+Spirit1Sim::Spirit1Sim(Spirit1SimClock *clock)
+        : _clock(clock ? clock : &_ownClock), _xtal(50000000), _spiByteNs(800), _spiHz(0), _spiLimitHz(0), _spiSeed(1),
+          _transactionNs(1000),
+          _shutdown(false), _air(0), _seed(1), _channelDbm(-120), _gpio(0), _gpioCallback(0), _gpioContext(0),
+          _transactionCallback(0), _transactionContext(0) {
+    _timing.standbyToReadyNs = 50000;
+    _timing.sleepToReadyNs = 30000;
+    _timing.lockNs = 50000;
+    _timing.calibrationNs = 40000;
+    _timing.txRxStartNs = 20000;
+    _timing.aesNs = 5000;
+    _position = _header = _address = _index = 0;
+    _status1 = _status0 = 0;
+    _polled = false;
+    _lastTx = Spirit1SimFrame();
+    reset();
+    resetStats();
+    _clock->attach(this);
+}
+
+Spirit1Sim::~Spirit1Sim() {
+    _clock->detach(this);
+}
+
+void Spirit1Sim::setSpiFrequency(uint32_t hz) {
+    _spiByteNs = hz ? 8000000000ULL / hz : 800;
+    _spiHz = hz;
+}
+
+void Spirit1Sim::onGpioChange(void (*callback)(void *, uint8_t), void *context) {
+    _gpioCallback = callback;
+    _gpioContext = context;
+}
+
+void Spirit1Sim::onTransaction(void (*callback)(void *, uint8_t, uint8_t), void *context) {
+    _transactionCallback = callback;
+    _transactionContext = context;
+}
+
+void Spirit1Sim::resetStats() {
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+void Spirit1Sim::reset() {
+    memset(_regs, 0, sizeof(_regs));
+    for (size_t i = 0; i < sizeof(resetValues) / sizeof(resetValues[0]); i++) {
+        _regs[resetValues[i].address] = resetValues[i].value;
+    }
+    _txFifo.clear();
+    _rxFifo.clear();
+    _irqStatus = 0;
+    _state = MC_STATE_READY;
+    _transitionAt = NEVER;
+    _transitionTo = MC_STATE_READY;
+    _transitionThen = NONE;
+    if (_transmission) endTx(false);
+    _txAt = NEVER;
+    _txLength = 0;
+    _txSeq = 0;
+    _csmaAt = NEVER;
+    _csmaBackoffs = 0;
+    _receiving = false;
+    _rxFailed = false;
+    _rxTimeoutAt = NEVER;
+    _playback.clear();
+    _playIndex = 0;
+    _playAt = NEVER;
+    _aesAt = NEVER;
+    _aesCommand = 0;
+    updateGpio();
+}
+
+void Spirit1Sim::shutdown(bool on) {
+    if (!on && _shutdown) reset();
+    _shutdown = on;
+}
+
+/* SPI */
+
+void Spirit1Sim::select() {
+    _stats.transactions++;
+    _clock->advance(_transactionNs);
+    _position = 0;
+    _index = 0;
+    _polled = false;
+}
+
+uint8_t Spirit1Sim::exchange(uint8_t value) {
+    _stats.bytes++;
+    _clock->advance(_spiByteNs);
+    if (_shutdown) return 0;
+    /* header and address are left alone, the chip would run wild */
+    if (_position >= 2) value ^= spiError();
+
+    uint8_t out = 0;
+    if (_position == 0) {
+        _header = value;
+        _status1 = mcState1();
+        _status0 = mcState0();
+        out = _status1;
+        _position++;
+    } else if (_position == 1) {
+        _address = value;
+        out = _status0;
+        _position++;
+        if (_transactionCallback) _transactionCallback(_transactionContext, _header, _address);
+        if (_header == WRITE_HEADER) {
+            if (_address == LINEAR_FIFO_ADDRESS) _stats.fifoWrites++; else _stats.writes++;
+        } else if (_header == READ_HEADER) {
+            if (_address == LINEAR_FIFO_ADDRESS) _stats.fifoReads++; else _stats.reads++;
+        } else if (_header == COMMAND_HEADER) {
+            _stats.commands++;
+            strobe(value);
+        }
+    } else {
+        /* the FIFO address does not auto-increment */
+        uint8_t address = _address == LINEAR_FIFO_ADDRESS ? _address : (uint8_t) (_address + _index++);
+        if (_header == READ_HEADER) out = readRegister(address);
+        else if (_header == WRITE_HEADER) writeRegister(address, value);
+    }
+    updateGpio();
+    return out ^ spiError();
+}
+
+/* registers */
+
+uint8_t Spirit1Sim::mcState1() const {
+    /* ANT_SELECT and ERROR_LOCK stay 0, reserved bits [7:4] read 0 (SpiritRefreshStatus() relies on it) */
+    return (uint8_t) ((_txFifo.count == FIFO_SIZE ? 0x04 : 0) | (_rxFifo.count == 0 ? 0x02 : 0));
+}
+
+uint8_t Spirit1Sim::mcState0() const {
+    bool xoOn = _state != MC_STATE_STANDBY && _state != MC_STATE_SLEEP && _state != MC_STATE_XO_SETTLING;
+    return (uint8_t) ((_state << 1) | (xoOn ? 1 : 0));
+}
+
+uint8_t Spirit1Sim::peek(uint8_t address) const {
+    switch (address) {
+        case MC_STATE1_BASE:
+            return mcState1();
+        case MC_STATE0_BASE:
+            return mcState0();
+        case LINEAR_FIFO_STATUS1_BASE:
+            return _txFifo.count;
+        case LINEAR_FIFO_STATUS0_BASE:
+            return _rxFifo.count;
+        case IRQ_STATUS3_BASE:
+        case IRQ_STATUS2_BASE:
+        case IRQ_STATUS1_BASE:
+        case IRQ_STATUS0_BASE:
+            return (uint8_t) (_irqStatus >> (8 * (IRQ_STATUS0_BASE - address)));
+        case LINEAR_FIFO_ADDRESS:
+            return 0;
+        default:
+            return _regs[address];
+    }
+}
+
+uint8_t Spirit1Sim::readRegister(uint8_t address) {
+    if (address == MC_STATE1_BASE || address == MC_STATE0_BASE) {
+        if (!_polled) _stats.statePolls++;
+        _polled = true;
+    }
+    if (address == LINEAR_FIFO_ADDRESS) {
+        uint8_t value = 0;
+        if (!popRx(&value)) raise(RX_FIFO_ERROR);
+        return value;
+    }
+    uint8_t value = peek(address);
+    if (address >= IRQ_STATUS3_BASE && address <= IRQ_STATUS0_BASE) {
+        _irqStatus &= ~((uint32_t) 0xFF << (8 * (IRQ_STATUS0_BASE - address)));
+    }
+    return value;
+}
+
+void Spirit1Sim::writeRegister(uint8_t address, uint8_t value) {
+    if (address == LINEAR_FIFO_ADDRESS) {
+        if (!pushTx(value)) raise(TX_FIFO_ERROR);
+        return;
+    }
+    /* status and read-only registers */
+    if (address >= MC_STATE1_BASE) return;
+    _regs[address] = value;
+}
+
+/* state machine */
+
+void Spirit1Sim::strobe(uint8_t command) {
+    uint8_t synthState = (_regs[PROTOCOL2_BASE] & PROTOCOL2_VCO_CALIBRATION_MASK) ? MC_STATE_SYNTH_CALIBRATION
+                                                                                 : MC_STATE_SYNTH_SETUP;
+    uint64_t lockNs = _timing.lockNs;
+    if (_regs[PROTOCOL2_BASE] & PROTOCOL2_VCO_CALIBRATION_MASK) lockNs += _timing.calibrationNs;
+
+    switch (command) {
+        case COMMAND_TX:
+        case COMMAND_RX: {
+            Action then = command == COMMAND_TX ? START_TX : START_RX;
+            if (_state == MC_STATE_READY) transition(synthState, MC_STATE_LOCK, lockNs + _timing.txRxStartNs, then);
+            else if (_state == MC_STATE_LOCK) transition(MC_STATE_LOCK, MC_STATE_LOCK, _timing.txRxStartNs, then);
+            break;
+        }
+        case COMMAND_READY:
+            if (_state == MC_STATE_STANDBY) {
+                transition(MC_STATE_XO_SETTLING, MC_STATE_READY, _timing.standbyToReadyNs, NONE);
+            } else if (_state == MC_STATE_SLEEP) {
+                transition(MC_STATE_XO_SETTLING, MC_STATE_READY, _timing.sleepToReadyNs, NONE);
+            } else if (_state == MC_STATE_LOCK && _transitionAt == NEVER && _csmaAt == NEVER) {
+                enter(MC_STATE_READY);
+            }
+            break;
+        case COMMAND_STANDBY:
+            if (_state == MC_STATE_READY) enter(MC_STATE_STANDBY);
+            break;
+        case COMMAND_SLEEP:
+            if (_state == MC_STATE_READY) enter(MC_STATE_SLEEP);
+            break;
+        case COMMAND_LOCKRX:
+        case COMMAND_LOCKTX:
+            if (_state == MC_STATE_READY) transition(synthState, MC_STATE_LOCK, lockNs, NONE);
+            break;
+        case COMMAND_SABORT:
+            if (_state == MC_STATE_TX) {
+                endTx(false);
+            } else if (_state == MC_STATE_RX) {
+                abortRx();
+                enter(MC_STATE_READY);
+            } else if (_transitionThen != NONE || _csmaAt != NEVER) {
+                /* TX or RX requested, still locking or in CCA */
+                _transitionAt = NEVER;
+                _transitionThen = NONE;
+                _csmaAt = NEVER;
+                enter(MC_STATE_READY);
+            }
+            break;
+        case COMMAND_SEQUENCE_UPDATE:
+            _txSeq = (uint8_t) ((_regs[PROTOCOL2_BASE] >> 3) & 0x03);
+            break;
+        case COMMAND_AES_ENC:
+        case COMMAND_AES_KEY:
+        case COMMAND_AES_DEC:
+        case COMMAND_AES_KEY_DEC:
+            _aesCommand = command;
+            _aesAt = now() + _timing.aesNs;
+            break;
+        case COMMAND_SRES:
+            reset();
+            break;
+        case COMMAND_FLUSHRXFIFO:
+            _rxFifo.clear();
+            break;
+        case COMMAND_FLUSHTXFIFO:
+            _txFifo.clear();
+            break;
+        default:
+            /* COMMAND_LDC_RELOAD, unknown codes */
+            break;
+    }
+}
+
+void Spirit1Sim::transition(uint8_t through, uint8_t to, uint64_t ns, Action then) {
+    _state = through;
+    _transitionTo = to;
+    _transitionThen = then;
+    _transitionAt = now() + ns;
+    if (to == MC_STATE_LOCK) setCalibrationWords();
+}
+
+void Spirit1Sim::transitionEvent() {
+    Action then = _transitionThen;
+    _transitionAt = NEVER;
+    _transitionThen = NONE;
+    enter(_transitionTo);
+    if (then == START_TX) requestTx();
+    else if (then == START_RX) beginRx();
+}
+
+void Spirit1Sim::enter(uint8_t state) {
+    _state = state;
+    if (state == MC_STATE_READY) raise(READY);
+    else if (state == MC_STATE_LOCK) raise(LOCK);
+}
+
+void Spirit1Sim::setCalibrationWords() {
+    /* a word that depends on the synthesizer setting, like the real one */
+    uint32_t synth = ((uint32_t) (_regs[SYNT3_BASE] & 0x1F) << 21) | ((uint32_t) _regs[SYNT2_BASE] << 13) |
+                     ((uint32_t) _regs[SYNT1_BASE] << 5) | (_regs[SYNT0_BASE] >> 3);
+    _regs[RCO_VCO_CALIBR_OUT0_BASE] = (uint8_t) (0x20 + (synth >> 14) % 0x40);
+}
+
+/* IRQ and GPIO */
+
+uint32_t Spirit1Sim::irqMask() const {
+    return ((uint32_t) _regs[IRQ_MASK3_BASE] << 24) | ((uint32_t) _regs[IRQ_MASK2_BASE] << 16) |
+           ((uint32_t) _regs[IRQ_MASK1_BASE] << 8) | _regs[IRQ_MASK0_BASE];
+}
+
+void Spirit1Sim::raise(uint32_t irqs) {
+    /* only the enabled IRQs are latched in IRQ_STATUS */
+    _irqStatus |= irqs & irqMask();
+}
+
+bool Spirit1Sim::signal(uint8_t select) const {
+    switch (select) {
+        case SPIRIT_GPIO_DIG_OUT_IRQ:
+            return _irqStatus == 0;
+        case SPIRIT_GPIO_DIG_OUT_POR_INV:
+        case SPIRIT_GPIO_DIG_OUT_VDD:
+            return true;
+        case SPIRIT_GPIO_DIG_OUT_TX_STATE:
+            return _state == MC_STATE_TX;
+        case SPIRIT_GPIO_DIG_OUT_RX_STATE:
+            return _state == MC_STATE_RX;
+        case SPIRIT_GPIO_DIG_OUT_TX_RX_MODE:
+            return _state == MC_STATE_TX || _state == MC_STATE_RX;
+        case SPIRIT_GPIO_DIG_OUT_TX_FIFO_ALMOST_EMPTY:
+            return _txFifo.count <= (_regs[FIFO_CONFIG0_TXAETHR_BASE] & 0x7F);
+        case SPIRIT_GPIO_DIG_OUT_TX_FIFO_ALMOST_FULL:
+            return _txFifo.count >= FIFO_SIZE - (_regs[FIFO_CONFIG1_TXAFTHR_BASE] & 0x7F);
+        case SPIRIT_GPIO_DIG_OUT_RX_FIFO_ALMOST_EMPTY:
+            return _rxFifo.count <= (_regs[FIFO_CONFIG2_RXAETHR_BASE] & 0x7F);
+        case SPIRIT_GPIO_DIG_OUT_RX_FIFO_ALMOST_FULL:
+            return _rxFifo.count >= FIFO_SIZE - (_regs[FIFO_CONFIG3_RXAFTHR_BASE] & 0x7F);
+        case SPIRIT_GPIO_DIG_OUT_VALID_PREAMBLE:
+        case SPIRIT_GPIO_DIG_OUT_SYNC_DETECTED:
+            return _receiving;
+        case SPIRIT_GPIO_DIG_OUT_RSSI_THRESHOLD:
+            return channelDbm() >= (int) _regs[RSSI_TH_BASE] / 2 - 130;
+        case SPIRIT_GPIO_DIG_OUT_SLEEP_OR_STANDBY:
+            return _state == MC_STATE_SLEEP || _state == MC_STATE_STANDBY;
+        case SPIRIT_GPIO_DIG_OUT_READY:
+            return _state == MC_STATE_READY;
+        case SPIRIT_GPIO_DIG_OUT_LOCK:
+            return _state == MC_STATE_LOCK;
+        default:
+            return false;
+    }
+}
+
+void Spirit1Sim::updateGpio() {
+    uint8_t levels = 0;
+    for (uint8_t n = 0; n < 4; n++) {
+        uint8_t conf = _regs[GPIO0_CONF_BASE - n];
+        if ((conf & 0x03) >= SPIRIT_GPIO_MODE_DIGITAL_OUTPUT_LP && signal(conf & 0xF8)) levels |= (uint8_t) (1 << n);
+    }
+    if (levels == _gpio) return;
+    _gpio = levels;
+    if (_gpioCallback) _gpioCallback(_gpioContext, levels);
+}
+
+/*
+ * FIFOs, the almost full/empty IRQs fire when the level reaches the threshold;
+ * the almost full thresholds count from the top (SPIRIT_LinearFifo.c)
+ */
+
+bool Spirit1Sim::pushTx(uint8_t value) {
+    if (!_txFifo.push(value)) return false;
+    if (_txFifo.count == FIFO_SIZE - (_regs[FIFO_CONFIG1_TXAFTHR_BASE] & 0x7F)) raise(TX_FIFO_ALMOST_FULL);
+    return true;
+}
+
+bool Spirit1Sim::popTx(uint8_t *value) {
+    if (!_txFifo.pop(value)) return false;
+    if (_txFifo.count == (_regs[FIFO_CONFIG0_TXAETHR_BASE] & 0x7F)) raise(TX_FIFO_ALMOST_EMPTY);
+    return true;
+}
+
+bool Spirit1Sim::pushRx(uint8_t value) {
+    if (!_rxFifo.push(value)) return false;
+    if (_rxFifo.count == FIFO_SIZE - (_regs[FIFO_CONFIG3_RXAFTHR_BASE] & 0x7F)) raise(RX_FIFO_ALMOST_FULL);
+    return true;
+}
+
+bool Spirit1Sim::popRx(uint8_t *value) {
+    if (!_rxFifo.pop(value)) return false;
+    if (_rxFifo.count == (_regs[FIFO_CONFIG2_RXAETHR_BASE] & 0x7F)) raise(RX_FIFO_ALMOST_EMPTY);
+    return true;
+}
+
+/* packet timing */
+
+uint32_t Spirit1Sim::datarate() const {
+    uint8_t divider = (_regs[XO_RCO_TEST_BASE] & 0x08) ? 0 : 1;
+    uint32_t datarate = (uint32_t) ((((uint64_t) (_xtal >> (5 + divider))) * (256 + _regs[MOD1_BASE]))
+            >> (23 - (_regs[MOD0_BASE] & 0x0F)));
+    return datarate ? datarate : 1;
+}
+
+uint16_t Spirit1Sim::overSize() const {
+    uint8_t control = _regs[PCKTCTRL4_BASE] & PCKTCTRL4_CONTROL_LEN_MASK;
+    switch (_regs[PCKTCTRL3_BASE] & PCKTCTRL3_PKT_FRMT_MASK) {
+        case PCKTCTRL3_PCKT_FRMT_STACK:
+            return (uint16_t) (2 + control);
+        case PCKTCTRL3_PCKT_FRMT_MBUS:
+            return 0;
+        default:
+            return (uint16_t) (((_regs[PCKTCTRL4_BASE] & PCKTCTRL4_ADDRESS_LEN_MASK) ? 1 : 0) + control);
+    }
+}
+
+/* one payload byte on the air, FEC doubles everything after the sync word */
+uint64_t Spirit1Sim::byteNs() const {
+    uint32_t bits = (_regs[PCKTCTRL1_BASE] & PCKTCTRL1_FEC_MASK) ? 16 : 8;
+    return bits * 1000000000ULL / datarate();
+}
+
+/* preamble, sync, length, address and control fields, plus the STack sequence/NO_ACK byte */
+uint64_t Spirit1Sim::headerNs() const {
+    uint8_t ctrl2 = _regs[PCKTCTRL2_BASE];
+    uint32_t preamble = (uint32_t) (ctrl2 >> 3) + 1;
+    uint32_t sync = (uint32_t) ((ctrl2 >> 1) & 0x03) + 1;
+    uint32_t fields = overSize();
+    if (ctrl2 & PCKTCTRL2_FIX_VAR_LEN_MASK) fields += ((_regs[PCKTCTRL3_BASE] & PCKTCTRL3_LEN_WID_MASK) + 1 + 7) / 8;
+    if ((_regs[PCKTCTRL3_BASE] & PCKTCTRL3_PKT_FRMT_MASK) == PCKTCTRL3_PCKT_FRMT_STACK) fields++;
+    return (preamble + sync) * 8 * 1000000000ULL / datarate() + fields * byteNs();
+}
+
+uint64_t Spirit1Sim::trailerNs() const {
+    static const uint8_t crcBytes[8] = {0, 1, 2, 2, 3, 0, 0, 0};
+    return crcBytes[_regs[PCKTCTRL1_BASE] >> 5] * byteNs();
+}
+
+uint64_t Spirit1Sim::airtimeNs(uint16_t payloadLength) const {
+    return headerNs() + payloadLength * byteNs() + trailerNs();
+}
+
+/* (counter + 1) * (prescaler + 1) periods of 1210 cycles of the (halved) xtal, 0 means no timeout */
+uint64_t Spirit1Sim::rxTimeoutNs() const {
+    uint8_t counter = _regs[TIMERS4_RX_TIMEOUT_COUNTER_BASE];
+    uint8_t prescaler = _regs[TIMERS5_RX_TIMEOUT_PRESCALER_BASE];
+    if (!counter || !prescaler) return 0;
+    uint32_t clock = _xtal > DOUBLE_XTAL_THR ? _xtal / 2 : _xtal;
+    return (uint64_t) (counter + 1) * (prescaler + 1) * 1210 * 1000000000ULL / clock;
+}
+
+/* TX */
+
+void Spirit1Sim::requestTx() {
+    if (_regs[PROTOCOL1_BASE] & PROTOCOL1_CSMA_ON_MASK) {
+        _csmaBackoffs = 0;
+        _seed = ((uint32_t) _regs[CSMA_CONFIG3_BASE] << 8) | _regs[CSMA_CONFIG2_BASE];
+        if (!_seed) _seed = 1;
+        uint32_t ccaLength = _regs[CSMA_CONFIG0_BASE] >> 4;
+        uint32_t ccaBits = (64u << (_regs[CSMA_CONFIG1_BASE] & 0x03)) * (ccaLength ? ccaLength : 1);
+        _csmaAt = now() + ccaBits * 1000000000ULL / datarate();
+        return;
+    }
+    enter(MC_STATE_TX);
+    beginTx();
+}
+
+/* clear channel assessment at the end of each listening period, then back-off */
+void Spirit1Sim::csmaEvent() {
+    _csmaAt = NEVER;
+    int threshold = (int) _regs[RSSI_TH_BASE] / 2 - 130;
+    if (channelDbm() < threshold) {
+        enter(MC_STATE_TX);
+        beginTx();
+        return;
+    }
+    bool persistent = (_regs[PROTOCOL1_BASE] & PROTOCOL1_CSMA_PERS_ON_MASK) != 0;
+    uint8_t maxBackoffs = (uint8_t) ((_regs[CSMA_CONFIG0_BASE] >> 1) & 0x07);
+    if (!persistent && _csmaBackoffs++ >= maxBackoffs) {
+        raise(MAX_BO_CCA_REACH);
+        enter(MC_STATE_READY);
+        return;
+    }
+    uint32_t ccaLength = _regs[CSMA_CONFIG0_BASE] >> 4;
+    uint32_t ccaBits = (64u << (_regs[CSMA_CONFIG1_BASE] & 0x03)) * (ccaLength ? ccaLength : 1);
+    uint32_t slots = persistent ? 0 : random() % (1u << std::min<uint8_t>(_csmaBackoffs, 8));
+    uint32_t backoffBits = slots * 32 * ((_regs[CSMA_CONFIG1_BASE] >> 2) + 1);
+    _csmaAt = now() + (uint64_t) (ccaBits + backoffBits) * 1000000000ULL / datarate();
+}
+
+int Spirit1Sim::channelDbm() const {
+    return _air ? _air->channelDbm(this) : _channelDbm;
+}
+
+/* a bit to flip in a byte on the bus at the current SPI clock, own generator: the radio stays reproducible */
+uint8_t Spirit1Sim::spiError() {
+    if (!_spiLimitHz || _spiHz <= _spiLimitHz - _spiLimitHz / 10) return 0;
+    _spiSeed = _spiSeed * 1103515245u + 12345u;
+    uint32_t draw = _spiSeed >> 16;
+    if ((draw & (_spiHz > _spiLimitHz ? 0x03 : 0xFF)) != 0) return 0;
+    _stats.spiErrors++;
+    return (uint8_t) (1 << ((draw >> 8) & 7));
+}
+
+uint32_t Spirit1Sim::random() {
+    _seed = _seed * 1103515245u + 12345u;
+    return _seed >> 16;
+}
+
+void Spirit1Sim::beginTx() {
+    uint16_t length = (uint16_t) ((_regs[PCKTLEN1_BASE] << 8) | _regs[PCKTLEN0_BASE]);
+    bool stack = (_regs[PCKTCTRL3_BASE] & PCKTCTRL3_PKT_FRMT_MASK) == PCKTCTRL3_PCKT_FRMT_STACK;
+
+    _txLength = length > overSize() ? (uint16_t) (length - overSize()) : 0;
+    _transmission = std::make_shared<Spirit1SimTransmission>();
+    Spirit1SimFrame &frame = _transmission->frame;
+    frame.destination = _regs[PCKT_FLT_GOALS_SOURCE_ADDR_BASE];
+    frame.source = stack ? _regs[PCKT_FLT_GOALS_TX_ADDR_BASE] : 0;
+    for (uint8_t i = 0; i < 4; i++) frame.control[i] = _regs[TX_CTRL_FIELD0_BASE - i];
+    frame.seq = stack ? _txSeq : 0;
+    frame.noAck = stack && (_regs[PROTOCOL0_BASE] & PROTOCOL0_NACK_TX_MASK);
+    frame.crcOk = true;
+    frame.payload.reserve(_txLength);
+    _transmission->length = _txLength;
+    _transmission->ended = false;
+
+    /* a payload byte leaves the FIFO when its slot on the air starts */
+    _txAt = now() + headerNs() + (_txLength ? 0 : trailerNs());
+    if (_air) _air->transmitStart(this, _transmission);
+}
+
+void Spirit1Sim::txEvent() {
+    std::vector<uint8_t> &payload = _transmission->frame.payload;
+    if (payload.size() == _txLength) {
+        endTx(true);
+        return;
+    }
+    uint8_t value;
+    if (!popTx(&value)) {
+        _stats.txUnderflows++;
+        raise(TX_FIFO_ERROR);
+        endTx(false);
+        return;
+    }
+    payload.push_back(value);
+    _txAt += byteNs();
+    if (payload.size() == _txLength) _txAt += trailerNs();
+}
+
+void Spirit1Sim::endTx(bool complete) {
+    std::shared_ptr<Spirit1SimTransmission> transmission;
+    transmission.swap(_transmission);
+    transmission->ended = true;
+    _txAt = NEVER;
+    if (_air) _air->transmitEnd(this, transmission);
+    if (complete) {
+        _stats.framesSent++;
+        _lastTx = transmission->frame;
+        if ((_regs[PCKTCTRL3_BASE] & PCKTCTRL3_PKT_FRMT_MASK) == PCKTCTRL3_PCKT_FRMT_STACK) {
+            _txSeq = (uint8_t) ((_txSeq + 1) & 0x03);
+        }
+        _regs[TX_PCKT_INFO_BASE] = (uint8_t) (_lastTx.seq << 4);
+        raise(TX_DATA_SENT);
+    }
+    enter(MC_STATE_READY);
+}
+
+/* RX */
+
+void Spirit1Sim::beginRx() {
+    enter(MC_STATE_RX);
+    /* no stop condition selected, with the OR function: timeout always stopped */
+    bool stopped = !(_regs[PROTOCOL2_BASE] & 0xE0) && (_regs[PCKT_FLT_OPTIONS_BASE] & PCKT_FLT_OPTIONS_RX_TIMEOUT_AND_OR_SELECT);
+    uint64_t timeout = rxTimeoutNs();
+    _rxTimeoutAt = timeout && !stopped ? now() + timeout : NEVER;
+}
+
+void Spirit1Sim::rxStart(const Spirit1SimFrame &frame, int rssiDbm) {
+    _receiving = true;
+    _rxFailed = false;
+    _rxFrame = frame;
+    _rxFrame.payload.clear();
+
+    int level = (rssiDbm + 130) * 2;
+    _regs[RSSI_LEVEL_BASE] = (uint8_t) std::max(0, std::min(255, level));
+    uint32_t irqs = VALID_PREAMBLE | VALID_SYNC;
+    if (level >= _regs[RSSI_TH_BASE]) irqs |= RSSI_ABOVE_TH;
+    raise(irqs);
+
+    /* a received frame is above every quality threshold: any stop condition stops the timer */
+    if (_regs[PROTOCOL2_BASE] & 0xE0) _rxTimeoutAt = NEVER;
+}
+
+void Spirit1Sim::rxByte(uint8_t value) {
+    if (_rxFailed) return;
+    if (!pushRx(value)) {
+        _stats.rxOverflows++;
+        _rxFailed = true;
+        raise(RX_FIFO_ERROR);
+        return;
+    }
+    _rxFrame.payload.push_back(value);
+}
+
+bool Spirit1Sim::accept(const Spirit1SimFrame &frame) const {
+    uint8_t options = _regs[PCKT_FLT_OPTIONS_BASE];
+    uint8_t format = _regs[PCKTCTRL3_BASE] & PCKTCTRL3_PKT_FRMT_MASK;
+    bool address = format == PCKTCTRL3_PCKT_FRMT_STACK ||
+                   (format == PCKTCTRL3_PCKT_FRMT_BASIC && (_regs[PCKTCTRL4_BASE] & PCKTCTRL4_ADDRESS_LEN_MASK));
+
+    uint8_t destinationFilters = options & (PCKT_FLT_OPTIONS_DEST_VS_TX_ADDR_MASK |
+                                            PCKT_FLT_OPTIONS_DEST_VS_MULTICAST_ADDR_MASK |
+                                            PCKT_FLT_OPTIONS_DEST_VS_BROADCAST_ADDR_MASK);
+    if (address && destinationFilters) {
+        bool match = ((options & PCKT_FLT_OPTIONS_DEST_VS_TX_ADDR_MASK) &&
+                      frame.destination == _regs[PCKT_FLT_GOALS_TX_ADDR_BASE]) ||
+                     ((options & PCKT_FLT_OPTIONS_DEST_VS_MULTICAST_ADDR_MASK) &&
+                      frame.destination == _regs[PCKT_FLT_GOALS_MULTICAST_BASE]) ||
+                     ((options & PCKT_FLT_OPTIONS_DEST_VS_BROADCAST_ADDR_MASK) &&
+                      frame.destination == _regs[PCKT_FLT_GOALS_BROADCAST_BASE]);
+        if (!match) return false;
+    }
+    if (format == PCKTCTRL3_PCKT_FRMT_STACK && (options & PCKT_FLT_OPTIONS_SOURCE_FILTERING_MASK)) {
+        uint8_t mask = _regs[PCKT_FLT_GOALS_SOURCE_MASK_BASE];
+        if ((frame.source & mask) != (_regs[PCKT_FLT_GOALS_SOURCE_ADDR_BASE] & mask)) return false;
+    }
+    if (options & PCKT_FLT_OPTIONS_CONTROL_FILTERING_MASK) {
+        for (uint8_t i = 0; i < 4; i++) {
+            uint8_t mask = _regs[PCKT_FLT_GOALS_CONTROL0_MASK_BASE + i];
+            if ((frame.control[i] & mask) != (_regs[PCKT_FLT_GOALS_CONTROL0_FIELD_BASE + i] & mask)) return false;
+        }
+    }
+    return true;
+}
+
+void Spirit1Sim::rxEnd() {
+    _receiving = false;
+
+    uint16_t length = (uint16_t) (_rxFrame.payload.size() + overSize());
+    _regs[RX_PCKT_LEN1_BASE] = (uint8_t) (length >> 8);
+    _regs[RX_PCKT_LEN0_BASE] = (uint8_t) length;
+    _regs[RX_ADDR_FIELD1_BASE] = _rxFrame.source;
+    _regs[RX_ADDR_FIELD0_BASE] = _rxFrame.destination;
+    for (uint8_t i = 0; i < 4; i++) _regs[RX_CTRL_FIELD0_BASE + i] = _rxFrame.control[i];
+    _regs[RX_PCKT_INFO_BASE] = (uint8_t) ((_rxFrame.noAck ? TX_PCKT_INFO_NACK_RX : 0) | (_rxFrame.seq & 0x03));
+    /* a clean link: high SQI, LQI and PQI */
+    _regs[LINK_QUALIF2_BASE] = 0x40;
+    _regs[LINK_QUALIF1_BASE] = 0x1F;
+    _regs[LINK_QUALIF0_BASE] = 0xF0;
+
+    bool crcError = !_rxFrame.crcOk && (_regs[PCKTCTRL1_BASE] & PCKTCTRL1_CRC_MODE_MASK);
+    bool discard = _rxFailed || !accept(_rxFrame) ||
+                   (crcError && (_regs[PCKT_FLT_OPTIONS_BASE] & PCKT_FLT_OPTIONS_CRC_CHECK_MASK));
+    if (crcError) raise(CRC_ERROR);
+    if (discard) {
+        /* the packet engine flushes a discarded packet */
+        _rxFifo.clear();
+        _stats.framesDiscarded++;
+        raise(RX_DATA_DISC);
+    } else {
+        _stats.framesReceived++;
+        raise(RX_DATA_READY);
+    }
+
+    if (_regs[PROTOCOL0_BASE] & PROTOCOL0_PERS_RX_MASK) beginRx();
+    else enter(MC_STATE_READY);
+}
+
+void Spirit1Sim::abortRx() {
+    _receiving = false;
+    _rxTimeoutAt = NEVER;
+}
+
+void Spirit1Sim::timeoutEvent() {
+    _rxTimeoutAt = NEVER;
+    if (_state != MC_STATE_RX) return;
+    if (_receiving) abortRx();
+    raise(RX_TIMEOUT);
+    enter(MC_STATE_READY);
+}
+
+void Spirit1Sim::inject(const Spirit1SimFrame &frame, int rssiDbm, uint64_t delayNs) {
+    std::shared_ptr<Spirit1SimTransmission> transmission = std::make_shared<Spirit1SimTransmission>();
+    transmission->frame = frame;
+    transmission->length = (uint16_t) frame.payload.size();
+    transmission->ended = true;
+    Playback playback = {transmission, rssiDbm, now() + delayNs, false};
+    _playback.push_back(playback);
+    if (_playback.size() == 1) {
+        _playIndex = 0;
+        _playAt = playback.at;
+    }
+}
+
+void Spirit1Sim::receive(const std::shared_ptr<const Spirit1SimTransmission> &transmission, int rssiDbm) {
+    Playback playback = {transmission, rssiDbm, now(), false};
+    _playback.push_back(playback);
+    if (_playback.size() == 1) {
+        _playIndex = 0;
+        _playAt = playback.at;
+    }
+}
+
+bool Spirit1Sim::corrupt(const Spirit1SimTransmission *transmission) {
+    for (size_t i = 0; i < _playback.size(); i++) {
+        if (_playback[i].transmission.get() != transmission) continue;
+        _playback[i].corrupted = true;
+        return i == 0 && _receiving;
+    }
+    return false;
+}
+
+void Spirit1Sim::nextPlayback() {
+    _playback.pop_front();
+    _playIndex = 0;
+    _playAt = _playback.empty() ? NEVER : std::max(_playback.front().at, now());
+}
+
+/*
+ * index 0: start of the frame, 1..n: payload byte n received, n + 1: end of
+ * the frame. The payload of a live transmission is complete up to the byte
+ * being received unless its transmitter stopped early: the frame is then
+ * truncated and fails the CRC.
+ */
+void Spirit1Sim::playbackEvent() {
+    Playback &playback = _playback.front();
+    const Spirit1SimTransmission &transmission = *playback.transmission;
+    const std::vector<uint8_t> &payload = transmission.frame.payload;
+
+    if (_playIndex == 0) {
+        if (_state != MC_STATE_RX || _receiving || playback.at < now()) {
+            _stats.framesMissed++;
+            nextPlayback();
+            return;
+        }
+        rxStart(transmission.frame, playback.rssiDbm);
+        _playIndex = 1;
+        _playAt = now() + headerNs() + (transmission.length ? byteNs() : trailerNs());
+        return;
+    }
+    if (!_receiving) {
+        /* aborted or timed out */
+        nextPlayback();
+        return;
+    }
+    if (_playIndex <= transmission.length && _playIndex <= payload.size()) {
+        rxByte(payload[_playIndex - 1]);
+        _playAt += _playIndex == transmission.length ? trailerNs() : byteNs();
+        _playIndex++;
+        return;
+    }
+    if (_playIndex <= transmission.length || playback.corrupted) _rxFrame.crcOk = false;
+    rxEnd();
+    nextPlayback();
+}
+
+/* AES: keyed XOR in place of AES-128, enough for the encrypt/decrypt round trip */
+void Spirit1Sim::aesEvent() {
+    _aesAt = NEVER;
+    for (uint8_t i = 0; i < 16; i++) {
+        uint8_t key = _regs[AES_KEY_IN_15_BASE + i];
+        uint8_t out = _aesCommand == COMMAND_AES_KEY ? key : (uint8_t) (_regs[AES_DATA_IN_15_BASE + i] ^ key);
+        _regs[AES_DATA_OUT_15_BASE + i] = out;
+    }
+    raise(AES_END);
+}
+
+/* events */
+
+uint64_t Spirit1Sim::nextEventNs() const {
+    uint64_t next = std::min(std::min(_transitionAt, _txAt), std::min(_csmaAt, _rxTimeoutAt));
+    next = std::min(next, _aesAt);
+    if (!_playback.empty()) next = std::min(next, _playAt);
+    return next;
+}
+
+void Spirit1Sim::runEvents(uint64_t now) {
+    for (;;) {
+        uint64_t next = nextEventNs();
+        if (next > now) break;
+        if (_transitionAt == next) transitionEvent();
+        else if (_aesAt == next) aesEvent();
+        else if (_csmaAt == next) csmaEvent();
+        else if (_txAt == next) txEvent();
+        else if (!_playback.empty() && _playAt == next) playbackEvent();
+        else timeoutEvent();
+    }
+    updateGpio();
+}
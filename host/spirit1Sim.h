@@ -0,0 +1,416 @@
+/**
+ * Behavioural model of the SPIRIT1 for host builds.
+ *
+ * Sits behind the SPI byte interface (select, exchange, deselect) that the
+ * stand-in bus drives (see spiStandIn.h) and models what the library relies
+ * on, so that every SPIRIT1_Library function runs unmodified against it:
+ *
+ *  - the register file 0x00-0xFF with the reset values of SPIRIT_Regs.h;
+ *    MC_STATE, the FIFO levels and IRQ_STATUS are computed on read,
+ *    IRQ_STATUS is cleared by reading it, writes to 0xC0-0xFE are ignored
+ *  - the MC_STATE machine: READY, STANDBY, SLEEP, LOCK, TX and RX on the
+ *    command strobes, with the transition times of Spirit1SimTiming during
+ *    which the intermediate state (XO_SETTLING, SYNTH_SETUP) is reported
+ *  - the two 96 byte linear FIFOs with the FIFO_CONFIG almost full/empty
+ *    thresholds (almost full counted from the top) and the FIFO error IRQs
+ *  - IRQ_MASK/IRQ_STATUS and the digital GPIO outputs (nIRQ, state and
+ *    FIFO flags)
+ *  - packet TX and RX paced by the configured datarate and packet format:
+ *    the TX FIFO is drained byte by byte while transmitting and the RX FIFO
+ *    filled while receiving, address and CRC filtering, persistent RX, the
+ *    RX timeout timer and CSMA against an external channel level
+ *  - the two status bytes at the start of every transaction
+ *
+ * Several models on one clock can share a medium (Spirit1SimAir, see
+ * spirit1Medium.h): a transmission is announced when its header goes on the
+ * air and its payload grows while the transmitter drains its TX FIFO, the
+ * receivers play it back byte by byte at their own pace.
+ *
+ * Time is virtual: the clock (Spirit1SimClock, shared by all the models of
+ * one simulation) advances by one byte time at the SPI clock for every byte
+ * exchanged, by a fixed cost for every transaction and by advance(). The
+ * model is deterministic and single threaded.
+ *
+ * Not modelled: the RF and analog parts (the calibration words are derived
+ * from the synthesizer setting), LDC mode, direct modes, automatic
+ * acknowledgement and retransmission. The AES engine is a keyed XOR that
+ * only preserves the encrypt/decrypt round trip, not AES-128.
+ */
+#ifndef SPIRIT1_SIM_H
+#define SPIRIT1_SIM_H
+
+#include <stdint.h>
+#include <deque>
+#include <memory>
+#include <vector>
+
+class Spirit1Sim;
+
+/** virtual time of a simulation, in ns */
+class Spirit1SimClock {
+public:
+    Spirit1SimClock() : _now(0) {}
+
+    uint64_t now() const { return _now; }
+
+    /** moves the time forward, running the events of the attached models in time order */
+    void advance(uint64_t ns);
+
+    /** time of the next event of the attached models, ~0 if there is none */
+    uint64_t nextEventNs() const;
+
+    void attach(Spirit1Sim *sim);
+
+    void detach(Spirit1Sim *sim);
+
+private:
+    uint64_t _now;
+    std::vector<Spirit1Sim *> _sims;
+};
+
+/** state transition times, rough orders of magnitude of the datasheet */
+typedef struct {
+    uint32_t standbyToReadyNs;   /*!< XO start-up */
+    uint32_t sleepToReadyNs;
+    uint32_t lockNs;             /*!< READY to LOCK, synthesizer settling */
+    uint32_t calibrationNs;      /*!< added to lockNs when the VCO calibration is enabled */
+    uint32_t txRxStartNs;        /*!< LOCK to TX or RX */
+    uint32_t aesNs;
+} Spirit1SimTiming;
+
+/** a packet as handled by the packet engine, payload only in payload */
+typedef struct {
+    uint8_t destination;         /*!< address field (basic with address, STack) */
+    uint8_t source;              /*!< STack only */
+    uint8_t control[4];          /*!< control field, control[i] is TX_CTRL_FIELDi / RX_CTRL_FIELDi */
+    uint8_t seq;                 /*!< STack sequence number */
+    bool noAck;                  /*!< STack NO_ACK flag */
+    bool crcOk;                  /*!< false: received with a CRC error */
+    std::vector<uint8_t> payload;
+} Spirit1SimFrame;
+
+/** a frame on the air, the transmitter appends the payload bytes as they are sent */
+typedef struct {
+    Spirit1SimFrame frame;
+    uint16_t length;             /*!< payload length announced in the header */
+    bool ended;                  /*!< the transmitter is done: sent, aborted or TX FIFO underflow */
+} Spirit1SimTransmission;
+
+/** the medium models transmit into */
+class Spirit1SimAir {
+public:
+    virtual ~Spirit1SimAir() {}
+
+    /** from has put the header of transmission on the air */
+    virtual void transmitStart(Spirit1Sim *from, const std::shared_ptr<const Spirit1SimTransmission> &transmission) = 0;
+
+    /** transmission is off the air, complete or not */
+    virtual void transmitEnd(Spirit1Sim *from, const std::shared_ptr<const Spirit1SimTransmission> &transmission) = 0;
+
+    /** power on the channel of at, in dBm */
+    virtual int channelDbm(const Spirit1Sim *at) = 0;
+};
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;              /*!< all bytes on the bus, header and address included */
+    uint32_t writes;             /*!< register write transactions */
+    uint32_t reads;              /*!< register read transactions */
+    uint32_t commands;
+    uint32_t fifoWrites;
+    uint32_t fifoReads;
+    uint32_t statePolls;         /*!< reads that include MC_STATE[1:0] */
+    uint32_t framesSent;
+    uint32_t framesReceived;     /*!< RX_DATA_READY */
+    uint32_t framesDiscarded;    /*!< RX_DATA_DISC: filtered, CRC error or RX FIFO overflow */
+    uint32_t framesMissed;       /*!< injected while not in RX or busy receiving */
+    uint32_t txUnderflows;
+    uint32_t rxOverflows;
+    uint32_t spiErrors;          /*!< bytes with a flipped bit, see setSpiLimit() */
+} Spirit1SimStats;
+
+class Spirit1Sim {
+public:
+    /** with clock NULL the model runs on a clock of its own */
+    explicit Spirit1Sim(Spirit1SimClock *clock = 0);
+
+    ~Spirit1Sim();
+
+    /* SPI slave */
+    void select();
+
+    uint8_t exchange(uint8_t value);
+
+    void deselect() {}
+
+    /** SDN pin: leaving shutdown is a power on reset */
+    void shutdown(bool on);
+
+    bool isShutdown() const { return _shutdown; }
+
+    /** levels of the digital outputs, bit n is GPIO_n */
+    uint8_t gpio() const { return _gpio; }
+
+    /**
+     * called with the new levels whenever a digital output changes, e.g.
+     * nIRQ; runs inside exchange() or advance() and must not access the SPI
+     */
+    void onGpioChange(void (*callback)(void *context, uint8_t gpio), void *context);
+
+    /**
+     * called with the header and address of every transaction as it reaches
+     * the chip, before its data; runs inside exchange() and must not access the SPI
+     */
+    void onTransaction(void (*callback)(void *context, uint8_t header, uint8_t address), void *context);
+
+    /** an enabled IRQ is pending, i.e. nIRQ is asserted */
+    bool irqPending() const { return _irqStatus != 0; }
+
+    /* model configuration */
+    void setXtalFrequency(uint32_t hz) { _xtal = hz; }
+
+    /** SPI clock that paces the bytes in virtual time */
+    void setSpiFrequency(uint32_t hz);
+
+    /**
+     * signal integrity of the bus: above hz every byte has a 1 in 4 chance of
+     * a flipped bit on MISO and on MOSI (data bytes only), in the last 10 %
+     * below hz 1 in 256; 0 (default) for a clean bus at any clock
+     */
+    void setSpiLimit(uint32_t hz) { _spiLimitHz = hz; }
+
+    /** fixed cost of a transaction in virtual time (driver call, chip select) */
+    void setTransactionNs(uint32_t ns) { _transactionNs = ns; }
+
+    Spirit1SimTiming &timing() { return _timing; }
+
+    Spirit1SimClock &clock() { return *_clock; }
+
+    uint64_t now() const { return _clock->now(); }
+
+    /** lets the virtual time pass */
+    void advance(uint64_t ns) { _clock->advance(ns); }
+
+    /* radio */
+
+    /**
+     * puts a frame on the air of this radio delayNs from now, received at
+     * rssiDbm; it is received only if the radio is in RX and idle by then.
+     * Frames are played back in the order injected.
+     */
+    void inject(const Spirit1SimFrame &frame, int rssiDbm = -60, uint64_t delayNs = 0);
+
+    /** channel power seen by CSMA and the RSSI threshold, -120 dBm (idle) by default; unused with an air */
+    void setChannelDbm(int dbm) { _channelDbm = dbm; }
+
+    /** connects the model to a medium: its transmissions go there, CSMA listens to it */
+    void setAir(Spirit1SimAir *air) { _air = air; }
+
+    /**
+     * a transmission of the medium reaches this radio now at rssiDbm; it is
+     * received like an injected frame, the payload is taken from the
+     * transmission as the bytes arrive
+     */
+    void receive(const std::shared_ptr<const Spirit1SimTransmission> &transmission, int rssiDbm);
+
+    /**
+     * damages transmission for this radio (collision, bit errors): it is
+     * received with a CRC error; returns true if it was being received
+     */
+    bool corrupt(const Spirit1SimTransmission *transmission);
+
+    /** the last frame transmitted completely */
+    const Spirit1SimFrame &lastTransmitted() const { return _lastTx; }
+
+    /** datarate in bps from MOD1/MOD0 and the xtal, as SpiritRadioGetDatarate() */
+    uint32_t datarate() const;
+
+    /** time on air of a frame with the current packet configuration */
+    uint64_t airtimeNs(uint16_t payloadLength) const;
+
+    /** MC_STATE as reported in the status bytes */
+    uint8_t state() const { return _state; }
+
+    /** register content without side effects (no read-to-clear, no FIFO pop) */
+    uint8_t peek(uint8_t address) const;
+
+    uint8_t txFifoLevel() const { return _txFifo.count; }
+
+    uint8_t rxFifoLevel() const { return _rxFifo.count; }
+
+    const Spirit1SimStats &stats() const { return _stats; }
+
+    void resetStats();
+
+    /* driven by the clock */
+    uint64_t nextEventNs() const;
+
+    void runEvents(uint64_t now);
+
+private:
+    enum { FIFO_SIZE = 96 };
+
+    struct Fifo {
+        uint8_t data[FIFO_SIZE];
+        uint8_t head, count;
+
+        void clear() { head = count = 0; }
+
+        bool push(uint8_t value);
+
+        bool pop(uint8_t *value);
+    };
+
+    enum Action { NONE, START_TX, START_RX };
+
+    struct Playback {
+        std::shared_ptr<const Spirit1SimTransmission> transmission;
+        int rssiDbm;
+        uint64_t at;
+        bool corrupted;
+    };
+
+    void reset();
+
+    uint8_t mcState1() const;
+
+    uint8_t mcState0() const;
+
+    uint8_t readRegister(uint8_t address);
+
+    void writeRegister(uint8_t address, uint8_t value);
+
+    void strobe(uint8_t command);
+
+    void transition(uint8_t through, uint8_t to, uint64_t ns, Action then);
+
+    void transitionEvent();
+
+    void enter(uint8_t state);
+
+    uint32_t irqMask() const;
+
+    void raise(uint32_t irqs);
+
+    void updateGpio();
+
+    bool pushTx(uint8_t value);
+
+    bool popTx(uint8_t *value);
+
+    bool pushRx(uint8_t value);
+
+    bool popRx(uint8_t *value);
+
+    bool signal(uint8_t select) const;
+
+    uint16_t overSize() const;
+
+    uint64_t byteNs() const;
+
+    uint64_t headerNs() const;
+
+    uint64_t trailerNs() const;
+
+    uint64_t rxTimeoutNs() const;
+
+    void setCalibrationWords();
+
+    void requestTx();
+
+    void beginTx();
+
+    void txEvent();
+
+    void endTx(bool complete);
+
+    void beginRx();
+
+    void rxStart(const Spirit1SimFrame &frame, int rssiDbm);
+
+    void rxByte(uint8_t value);
+
+    void rxEnd();
+
+    void abortRx();
+
+    void timeoutEvent();
+
+    bool accept(const Spirit1SimFrame &frame) const;
+
+    void nextPlayback();
+
+    void playbackEvent();
+
+    void aesEvent();
+
+    void csmaEvent();
+
+    int channelDbm() const;
+
+    uint32_t random();
+
+    uint8_t spiError();
+
+    static const uint64_t NEVER = ~(uint64_t) 0;
+
+    Spirit1SimClock _ownClock;
+    Spirit1SimClock *_clock;
+    Spirit1SimTiming _timing;
+    uint32_t _xtal;
+    uint64_t _spiByteNs;
+    uint32_t _spiHz, _spiLimitHz, _spiSeed;
+    uint32_t _transactionNs;
+    bool _shutdown;
+
+    uint8_t _regs[256];
+    Fifo _txFifo, _rxFifo;
+    uint32_t _irqStatus;
+    uint8_t _state;
+
+    /* SPI framing */
+    uint8_t _position, _header, _address, _index;
+    uint8_t _status1, _status0;
+    bool _polled;
+
+    /* pending transition */
+    uint64_t _transitionAt;
+    uint8_t _transitionTo;
+    Action _transitionThen;
+
+    Spirit1SimAir *_air;
+
+    /* TX */
+    std::shared_ptr<Spirit1SimTransmission> _transmission;
+    Spirit1SimFrame _lastTx;
+    uint16_t _txLength;
+    uint64_t _txAt;           /*!< next payload byte, or the end of the frame */
+    uint8_t _txSeq;
+    uint64_t _csmaAt;
+    uint8_t _csmaBackoffs;
+    uint32_t _seed;
+    int _channelDbm;
+
+    /* RX */
+    bool _receiving;
+    bool _rxFailed;
+    Spirit1SimFrame _rxFrame;
+    uint64_t _rxTimeoutAt;
+    std::deque<Playback> _playback;
+    uint16_t _playIndex;
+    uint64_t _playAt;         /*!< next received byte, start or end of the frame played back */
+
+    /* AES */
+    uint64_t _aesAt;
+    uint8_t _aesCommand;
+
+    uint8_t _gpio;
+    void (*_gpioCallback)(void *, uint8_t);
+    void *_gpioContext;
+    void (*_transactionCallback)(void *, uint8_t, uint8_t);
+    void *_transactionContext;
+
+    Spirit1SimStats _stats;
+};
+
+#endif // SPIRIT1_SIM_H
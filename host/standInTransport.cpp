@@ -0,0 +1,14 @@
+#include "standInTransport.h"
+
+static SpiStandInBus bus(0);
+static Spirit1Transport<SpiStandInBus> spi(bus);
+
+SpiStandInBus &standInBus() {
+    return bus;
+}
+
+Spirit1Transport<SpiStandInBus> &standInSpi() {
+    return spi;
+}
+
+SPIRIT1_TRANSPORT(spi)
@@ -0,0 +1,18 @@
+/**
+ * SPIRIT1 transport on the in-process simulated chip (see spiStandIn.h).
+ * Link it with the SPIRIT1 library to run library code on the development
+ * machine.
+ */
+#ifndef SPIRIT1_STAND_IN_TRANSPORT_H
+#define SPIRIT1_STAND_IN_TRANSPORT_H
+
+#include "spirit1Transport.h"
+#include "spiStandIn.h"
+
+/** the simulated chip, untimed (frequency 0) until told otherwise */
+SpiStandInBus &standInBus();
+
+/** the transport behind the RadioSpi* functions, for its traffic statistics */
+Spirit1Transport<SpiStandInBus> &standInSpi();
+
+#endif // SPIRIT1_STAND_IN_TRANSPORT_H
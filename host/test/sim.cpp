@@ -0,0 +1,1802 @@
+/**
+ * Runs the SPIRIT1 library against the behavioural model (spirit1Sim.h):
+ * state machine and the state waits, the integer radio formulas
+ * (SPIRIT_Fixed.h), the register image (spirit1RegisterImage.h), the warm
+ * boot (spirit1WarmBoot.h), profile switching (spirit1RadioProfile.h), the PA
+ * curves (spirit1PaCurve.h), FIFOs, IRQs, packet TX and RX, filtering,
+ * the deferred IRQ (spirit1Irq.h), the TX queue (spirit1TxQueue.h), the RX ring (spirit1RxRing.h), the ARQ
+ * (spirit1Arq.h), record aggregation (spirit1Aggregate.h), streams larger
+ * than the FIFO, RX timeout and the timer search, CSMA, AES and the GPIO
+ * outputs, the SPI clock discovery, radios with a library context each and
+ * radios connected by the medium (spirit1Medium.h); the register shadow and
+ * the write batch by the transactions that reach the model.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+#include "SPIRIT_Config.h"
+#include "spirit1Spi.h"
+#include "spirit1Medium.h"
+#include "spirit1Irq.h"
+#include "spirit1RxRing.h"
+#include "spirit1BufferPool.h"
+#include "spirit1Fragment.h"
+#include "spirit1Arq.h"
+#include "spirit1Aggregate.h"
+#include "spirit1RegisterImage.h"
+#include "spirit1WarmBoot.h"
+#include "spirit1RadioProfile.h"
+#include "spirit1PaCurve.h"
+#include "spirit1TxQueue.h"
+#include "radioFloatReference.h"
+#include "standInTransport.h"
+
+static int failures;
+
+#define CHECK(condition)                                                    \
+    do {                                                                    \
+        if (!(condition)) {                                                 \
+            printf("%s:%d: CHECK(%s) failed\r\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                     \
+        }                                                                   \
+    } while (0)
+
+static Spirit1Sim &chip() {
+    return standInBus().chip();
+}
+
+static uint32_t pendingIrqs(const Spirit1Sim &radio) {
+    return ((uint32_t) radio.peek(IRQ_STATUS3_BASE) << 24) | ((uint32_t) radio.peek(IRQ_STATUS2_BASE) << 16) |
+           ((uint32_t) radio.peek(IRQ_STATUS1_BASE) << 8) | radio.peek(IRQ_STATUS0_BASE);
+}
+
+static uint32_t pendingIrqs() {
+    return pendingIrqs(chip());
+}
+
+/** lets the time pass until one of the IRQs is pending, false after limitNs */
+static bool waitIrq(uint32_t irqs, uint64_t limitNs) {
+    uint64_t end = chip().now() + limitNs;
+    while (!(pendingIrqs() & irqs)) {
+        if (chip().now() >= end) return false;
+        chip().advance(10000);
+    }
+    return true;
+}
+
+static void radioInit() {
+    SRadioInit radio = {0, 868000000, 20000, 0, FSK, 38400, 20000, 100000};
+    PktBasicInit basic = {PKT_PREAMBLE_LENGTH_04BYTES, PKT_SYNC_LENGTH_4BYTES, 0x88888888, PKT_LENGTH_VAR, 7,
+                          PKT_CRC_MODE_16BITS_1, PKT_CONTROL_LENGTH_0BYTES, S_ENABLE, S_DISABLE, S_ENABLE};
+    PktBasicAddressesInit addresses = {S_ENABLE, 0x44, S_DISABLE, 0xEE, S_ENABLE, 0xFF};
+
+    SpiritCmdStrobeSres();
+    SpiritRadioSetXtalFrequency(50000000);
+    CHECK(SpiritRadioInit(&radio) == 0);
+    SpiritPktBasicInit(&basic);
+    SpiritPktBasicAddressesInit(&addresses);
+    SpiritIrqDeInit(NULL);
+    SpiritIrqClearStatus();
+}
+
+static void testInit() {
+    chip().resetStats();
+    radioInit();
+    SpiritRefreshStatus();
+    CHECK(g_xStatus.MC_STATE == MC_STATE_READY);
+    CHECK(g_xStatus.XO_ON == 1);
+    /* the VCO calibration workaround and the state waits poll MC_STATE */
+    CHECK(chip().stats().statePolls > 0);
+    CHECK(chip().peek(RCO_VCO_CALIBR_OUT0_BASE) != 0);
+    CHECK(SpiritGeneralGetDevicePartNumber() == 0x0130);
+    CHECK(SpiritGeneralGetSpiritVersion() == 0x30);
+    CHECK(SpiritRadioGetDatarate() == chip().datarate());
+    CHECK(chip().datarate() > 38000 && chip().datarate() < 39000);
+}
+
+/* the register shadow: what it knows stays off the bus, the status area and the test registers do not, SRES forgets */
+static void testShadow() {
+    uint8_t sync[4], written[4] = {0x11, 0x22, 0x33, 0x44}, value = 0x5A, status[2];
+    SpiritShadowCounters counters;
+
+    CHECK(SpiritShadowGetState() == S_ENABLE);
+    SpiritShadowInvalidate();
+    SpiritShadowResetCounters();
+    chip().resetStats();
+
+    /* read once from the chip, then locally, also in part */
+    SpiritSpiReadRegisters(SYNC4_BASE, 4, sync);
+    CHECK(chip().stats().transactions == 1 && sync[0] == chip().peek(SYNC4_BASE));
+    SpiritSpiReadRegisters(SYNC4_BASE, 4, sync);
+    SpiritSpiReadRegisters(SYNC3_BASE, 1, sync);
+    CHECK(chip().stats().transactions == 1);
+    /* a range with a register not in the shadow goes to the chip whole */
+    SpiritSpiReadRegisters(PCKTLEN0_BASE, 2, sync);
+    CHECK(chip().stats().transactions == 2 && chip().stats().bytes == 6 + 4);
+
+    /* written through: the chip gets it, the next read does not */
+    SpiritSpiWriteRegisters(SYNC4_BASE, 4, written);
+    CHECK(chip().stats().transactions == 3 && chip().peek(SYNC1_BASE) == 0x44);
+    SpiritSpiReadRegisters(SYNC4_BASE, 4, sync);
+    CHECK(chip().stats().transactions == 3 && memcmp(sync, written, 4) == 0);
+    SpiritShadowGetCounters(&counters);
+    CHECK(counters.lTransactions == 3 && counters.lTransactionsSaved == 3 && counters.lBytesSaved == 6 + 3 + 6);
+
+    /* the status area and the test registers 0xA8, 0xB2 reach the chip every time */
+    chip().resetStats();
+    SpiritSpiWriteRegisters(0xA8, 1, &value);
+    SpiritSpiReadRegisters(0xA8, 1, &value);
+    SpiritSpiReadRegisters(0xA8, 1, &value);
+    CHECK(chip().stats().transactions == 3 && chip().stats().reads == 2 && !SpiritShadowPeek(0xA8, &value));
+    SpiritSpiReadRegisters(0xB2, 1, &value);
+    SpiritSpiReadRegisters(0xB2, 1, &value);
+    SpiritSpiReadRegisters(MC_STATE1_BASE, 2, status);
+    SpiritSpiReadRegisters(MC_STATE1_BASE, 2, status);
+    CHECK(chip().stats().reads == 6 && chip().stats().statePolls == 2);
+    CHECK(status[1] == chip().peek(MC_STATE0_BASE) && !SpiritShadowPeek(MC_STATE0_BASE, &value));
+    /* nor do they spoil a range around them */
+    SpiritSpiReadRegisters(0xA7, 3, sync);
+    SpiritSpiReadRegisters(0xA7, 3, sync);
+    CHECK(chip().stats().reads == 8);
+
+    /* SRES: the reset values are read from the chip, not the ones written before */
+    SpiritCmdStrobeSres();
+    chip().resetStats();
+    SpiritSpiReadRegisters(SYNC4_BASE, 4, sync);
+    CHECK(chip().stats().transactions == 1 && sync[3] == chip().peek(SYNC1_BASE) && sync[3] != 0x44);
+    SpiritShadowGetCounters(&counters);
+    CHECK(counters.lInvalidations == 1);
+    radioInit();
+}
+
+/* the transactions reaching the chip, in order */
+struct TransactionLog {
+    uint8_t header[16], address[16];
+    int count;
+};
+
+static void logTransaction(void *context, uint8_t header, uint8_t address) {
+    TransactionLog *log = (TransactionLog *) context;
+    if (log->count < 16) {
+        log->header[log->count] = header;
+        log->address[log->count] = address;
+    }
+    log->count++;
+}
+
+static bool logged(const TransactionLog &log, int i, uint8_t header, uint8_t address) {
+    return i < log.count && i < 16 && log.header[i] == header && log.address[i] == address;
+}
+
+/*
+ * the write batch keeps the order the library relies on (the state waits, the
+ * workarounds of Register_Setting.c): reads see the pending values, the status
+ * area, the test registers and the commands go after them, FIFO writes around them
+ */
+static void testBatch() {
+    TransactionLog log = TransactionLog();
+    uint8_t sync[4] = {0x11, 0x22, 0x33, 0x44}, values[5], value = 0x5A, payload[4] = {1, 2, 3, 4};
+    uint8_t reset = chip().peek(SYNC4_BASE);
+    SpiritBatchCounters counters;
+
+    /* the shadow would answer the reads before the batch sees them */
+    SpiritShadowEnable(S_DISABLE);
+    SpiritBatchResetCounters();
+    chip().onTransaction(logTransaction, &log);
+    SpiritBatchBegin();
+
+    /* read after write: the pending values, from the chip only what is not pending */
+    SpiritSpiWriteRegisters(SYNC4_BASE, 4, sync);
+    SpiritSpiReadRegisters(SYNC3_BASE, 2, values);
+    CHECK(log.count == 0 && values[0] == 0x22 && values[1] == 0x33);
+    SpiritSpiReadRegisters(PCKTLEN0_BASE, 5, values);
+    CHECK(log.count == 1 && logged(log, 0, READ_HEADER, PCKTLEN0_BASE));
+    CHECK(values[0] == chip().peek(PCKTLEN0_BASE) && values[1] == 0x11 && values[4] == 0x44);
+    CHECK(chip().peek(SYNC4_BASE) == reset && reset != 0x11);
+
+    /* FIFO writes go around the batch, the pending writes stay pending */
+    SpiritSpiWriteLinearFifo(4, payload);
+    CHECK(log.count == 2 && logged(log, 1, WRITE_HEADER, LINEAR_FIFO_ADDRESS) && chip().txFifoLevel() == 4);
+    CHECK(chip().peek(SYNC4_BASE) == reset);
+
+    /* a status read: the pending writes first, in one burst */
+    SpiritSpiReadRegisters(MC_STATE1_BASE, 2, values);
+    CHECK(log.count == 4 && logged(log, 2, WRITE_HEADER, SYNC4_BASE) && logged(log, 3, READ_HEADER, MC_STATE1_BASE));
+    CHECK(chip().peek(SYNC1_BASE) == 0x44);
+
+    /* likewise a test register write and a command */
+    SpiritSpiWriteRegisters(PCKTLEN0_BASE, 1, &value);
+    SpiritSpiWriteRegisters(0xB2, 1, &value);
+    SpiritSpiWriteRegisters(PCKTLEN1_BASE, 1, &value);
+    SpiritCmdStrobeFlushTxFifo();
+    CHECK(log.count == 8 && logged(log, 4, WRITE_HEADER, PCKTLEN0_BASE) && logged(log, 5, WRITE_HEADER, 0xB2));
+    CHECK(logged(log, 6, WRITE_HEADER, PCKTLEN1_BASE) && logged(log, 7, COMMAND_HEADER, COMMAND_FLUSHTXFIFO));
+    CHECK(chip().txFifoLevel() == 0);
+
+    /* the flush joins contiguous writes */
+    SpiritSpiWriteRegisters(SYNC2_BASE, 2, sync);
+    SpiritSpiWriteRegisters(SYNC4_BASE, 2, sync + 2);
+    CHECK(log.count == 8);
+    SpiritBatchFlush();
+    CHECK(log.count == 9 && logged(log, 8, WRITE_HEADER, SYNC4_BASE) && !SpiritBatchIsOpen());
+    CHECK(chip().peek(SYNC4_BASE) == 0x33 && chip().peek(SYNC1_BASE) == 0x22);
+    SpiritBatchGetCounters(&counters);
+    CHECK(counters.lEarlyFlushes == 3 && counters.lReadsPatched == 2 && counters.lBursts == 4);
+
+    chip().onTransaction(NULL, NULL);
+    SpiritShadowEnable(S_ENABLE);
+    radioInit();
+}
+
+/* one band of SpiritRadioSetFrequencyBase(): limits and B/2 */
+struct FixedBand {
+    uint32_t lower, upper;
+    uint8_t bHalf;
+};
+
+static const FixedBand FIXED_BANDS[] = {
+    {HIGH_BAND_LOWER_LIMIT, HIGH_BAND_UPPER_LIMIT, HIGH_BAND_FACTOR / 2},
+    {MIDDLE_BAND_LOWER_LIMIT, MIDDLE_BAND_UPPER_LIMIT, MIDDLE_BAND_FACTOR / 2},
+    {LOW_BAND_LOWER_LIMIT, LOW_BAND_UPPER_LIMIT, LOW_BAND_FACTOR / 2},
+    {VERY_LOW_BAND_LOWER_LIMIT, VERY_LOW_BAND_UPPER_LIMIT, VERY_LOW_BAND_FACTOR / 2},
+};
+
+/* the search at both sides of every mantissa and exponent step, where its result changes */
+static int fdevSearchMismatches(uint32_t xtal) {
+    int mismatches = 0;
+    uint8_t m, e, referenceM, referenceE;
+
+    SpiritRadioSetXtalFrequency(xtal);
+    for (uint8_t step = 0; step < 90; step++) {
+        uint32_t at = step < 80 ? referenceFdev(xtal, step % 8, step / 8) : referenceFdevThreshold(xtal, step - 80);
+        for (uint32_t fdev = at - 1; fdev <= at + 1; fdev++) {
+            if (fdev < F_DEV_LOWER_LIMIT(xtal) || fdev > F_DEV_UPPER_LIMIT(xtal)) continue;
+            SpiritRadioSearchFreqDevME(fdev, &m, &e);
+            referenceSearchFreqDevME(xtal, fdev, &referenceM, &referenceE);
+            if (m != referenceM || e != referenceE) mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+/* SPIRIT_Fixed.h is bit exact with the float and double formulas it replaced (radioFloatReference.h) */
+static void testFixedPoint() {
+    static const uint32_t xtals[] = {24000000, 25000000, 26000000, 48000000, 50000000, 52000000};
+    static const uint32_t ranges[][2] = {{24000000, 26000000}, {48000000, 52000000}};
+    int mismatches = 0;
+
+    /* every divided xtal: IF offsets */
+    for (uint32_t divided = 24000000 >> 13; divided <= 52000000 >> 12; divided++) {
+        if (SpiritFixedIfOffset(divided) != referenceIfOffset(divided << 12, 12)) mismatches++;
+    }
+    CHECK(mismatches == 0);
+
+    /* every xtal: its float, which the deviation formulas depend on, and the deviations at a 64 Hz step */
+    mismatches = 0;
+    for (const uint32_t *range : ranges) {
+        for (uint32_t xtal = range[0]; xtal <= range[1]; xtal++) {
+            if (SpiritFixedFloat(xtal) != (uint64_t) (float) xtal) mismatches++;
+            if (xtal % 64) continue;
+            for (uint8_t i = 0; i < 10; i++) {
+                if (SpiritFixedFdev(xtal, (15u << i) >> 1) != referenceFdevThreshold(xtal, i)) mismatches++;
+            }
+            for (uint8_t step = 0; step < 80; step++) {
+                uint8_t m = step % 8, e = step / 8;
+                if (SpiritFixedFdev(xtal, ((8u + m) << e) >> 1) != referenceFdev(xtal, m, e)) mismatches++;
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+
+    mismatches = 0;
+    for (uint32_t xtal : xtals) {
+        mismatches += fdevSearchMismatches(xtal);
+
+        /* every frequency offset */
+        for (int32_t offset = F_OFFSET_LOWER_LIMIT(xtal); offset <= F_OFFSET_UPPER_LIMIT(xtal); offset++) {
+            if (SpiritFixedOffsetFactor(offset, xtal) != referenceOffsetFactor(offset, xtal)) mismatches++;
+        }
+
+        /* every channel filter */
+        for (uint8_t i = 0; i < 90; i++) {
+            if (SpiritFixedScale(100 * spirit1ImageBandwidth26M[i], xtal >> 1, 26000000) !=
+                referenceInfoBandwidth(spirit1ImageBandwidth26M[i], xtal >> 1)) mismatches++;
+            if (SpiritFixedScale(100 * spirit1ImageBandwidth26M[i], xtal, 26000000) !=
+                referenceInfoBandwidth(spirit1ImageBandwidth26M[i], xtal)) mismatches++;
+        }
+    }
+    CHECK(mismatches == 0);
+
+    /* xtal errors up to 100 ppm at a 10 kHz step of the bands */
+    mismatches = 0;
+    for (const FixedBand &band : FIXED_BANDS) {
+        for (uint32_t base = band.lower; base <= band.upper; base += 10000) {
+            for (int16_t ppm = -100; ppm <= 100; ppm++) {
+                if (SpiritFixedPpmOffset(ppm, base) != referencePpmOffset(ppm, base)) mismatches++;
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+
+    /* every synth word of the bands for the frequency base; synth words at a 100 Hz step of the
+    bands, and where the exact value is an integer, which the double may miss */
+    mismatches = 0;
+    for (uint32_t xtal : xtals) {
+        for (uint8_t refDiv = 1; refDiv <= 2; refDiv++) {
+            for (const FixedBand &band : FIXED_BANDS) {
+                uint32_t first = referenceSynthWord(band.lower, band.bHalf, refDiv, xtal);
+                uint32_t last = referenceSynthWord(band.upper, band.bHalf, refDiv, xtal);
+                uint32_t den = FBASE_DIVIDER * refDiv * band.bHalf;
+                for (uint32_t word = first; word <= last; word++) {
+                    if (SpiritFixedScaleRound(word, xtal, den) != referenceFrequencyBase(word, band.bHalf, refDiv, xtal))
+                        mismatches++;
+                }
+
+                uint32_t num = FBASE_DIVIDER * refDiv, gcd = xtal, rest = num * band.bHalf;
+                while (rest) {
+                    uint32_t next = gcd % rest;
+                    gcd = rest;
+                    rest = next;
+                }
+                for (uint32_t base = band.lower; base <= band.upper; base += 100) {
+                    if (SpiritFixedScale(base * band.bHalf, num, xtal) != referenceSynthWord(base, band.bHalf, refDiv, xtal))
+                        mismatches++;
+                    if (SpiritFixedScale(base, num * band.bHalf, xtal) !=
+                        referenceManagementSynthWord(base, band.bHalf, refDiv, xtal)) mismatches++;
+                }
+                uint32_t exact = xtal / gcd;
+                for (uint32_t base = band.lower + exact - 1 - (band.lower + exact - 1) % exact; base <= band.upper;
+                     base += exact) {
+                    if (SpiritFixedScale(base * band.bHalf, num, xtal) != referenceSynthWord(base, band.bHalf, refDiv, xtal))
+                        mismatches++;
+                    if (SpiritFixedScale(base, num * band.bHalf, xtal) !=
+                        referenceManagementSynthWord(base, band.bHalf, refDiv, xtal)) mismatches++;
+                }
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+
+    /* through the library */
+    SpiritCmdStrobeSres();
+    for (uint32_t xtal : xtals) {
+        SpiritRadioSetXtalFrequency(xtal);
+        for (uint8_t i = 0; i < 90; i++) {
+            uint8_t chflt = (uint8_t) (((i % 9) << 4) | (i / 9));
+            SpiritSpiWriteRegisters(CHFLT_BASE, 1, &chflt);
+            CHECK(SpiritRadioGetChannelBW() == referenceChannelBw(spirit1ImageBandwidth26M[i], xtal));
+        }
+    }
+    radioInit();
+}
+
+/** the first register the image leaves unlike the library, -1 if none */
+static int imageMismatch(uint32_t xtal, const SRadioInit &radio, const PktBasicInit &basic,
+                         const Spirit1RegisterImage &image) {
+    SRadioInit copy = radio;
+    PktBasicInit basicCopy = basic;
+    uint8_t expected[256];
+
+    SpiritCmdStrobeSres();
+    SpiritRadioSetXtalFrequency(xtal);
+    if (SpiritRadioInit(&copy) != 0) return 0x100;
+    SpiritPktBasicInit(&basicCopy);
+    for (int i = 0; i < 256; i++) expected[i] = chip().peek((uint8_t) i);
+
+    SpiritCmdStrobeSres();
+    if (spirit1ImageLoad(image) != 0) return 0x101;
+    for (int i = 0; i < 256; i++) {
+        if (chip().peek((uint8_t) i) != expected[i]) {
+            printf("xtal %u base %u dr %u: register 0x%02X is 0x%02X, the library writes 0x%02X\r\n", xtal,
+                   radio.lFrequencyBase, radio.lDatarate, i, chip().peek((uint8_t) i), expected[i]);
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void testRegisterImage() {
+    static constexpr SRadioInit radio = {0, 868000000, 20000, 0, FSK, 38400, 20000, 100000};
+    static constexpr PktBasicInit basic = {PKT_PREAMBLE_LENGTH_04BYTES, PKT_SYNC_LENGTH_4BYTES, 0x88888888,
+                                           PKT_LENGTH_VAR, 7, PKT_CRC_MODE_16BITS_1, PKT_CONTROL_LENGTH_0BYTES,
+                                           S_ENABLE, S_DISABLE, S_ENABLE};
+    static constexpr Spirit1RegisterImage image = spirit1RegisterImage(50000000, radio, basic);
+    static constexpr SRadioInit low = {-40, 169400000, 12500, 3, GFSK_BT05, 4800, 2400, 10000};
+    static constexpr PktBasicInit fixed = {PKT_PREAMBLE_LENGTH_08BYTES, PKT_SYNC_LENGTH_2BYTES, 0x1A2635A8,
+                                           PKT_LENGTH_FIX, 0, PKT_NO_CRC, PKT_CONTROL_LENGTH_2BYTES,
+                                           S_DISABLE, S_ENABLE, S_DISABLE};
+    static constexpr Spirit1RegisterImage lowImage = spirit1RegisterImage(26000000, low, fixed);
+    static const uint32_t xtals[] = {24000000, 25000000, 26000000, 48000000, 50000000, 52000000};
+    static const uint32_t bases[] = {169000000, 315000000, 433920000, 868300000, 915000000};
+    static const uint32_t datarates[] = {1200, 9600, 38400, 100000, 250000};
+    static const int16_t ppms[] = {0, 25, -30};
+    int mismatches = 0;
+
+    CHECK(image.xtal == 50000000 && lowImage.xtal == 26000000);
+    CHECK(imageMismatch(50000000, radio, basic, image) == -1);
+    CHECK(imageMismatch(26000000, low, fixed, lowImage) == -1);
+    SpiritRefreshStatus();
+    CHECK(g_xStatus.MC_STATE == MC_STATE_READY);
+
+    for (size_t x = 0; x < sizeof(xtals) / sizeof(xtals[0]); x++) {
+        for (size_t b = 0; b < sizeof(bases) / sizeof(bases[0]); b++) {
+            for (size_t d = 0; d < sizeof(datarates) / sizeof(datarates[0]); d++) {
+                uint32_t datarate = datarates[d];
+                SRadioInit sweep = {ppms[(x + d) % 3], bases[b], 25000, (uint8_t) (d * 2), (ModulationSelect) (d % 2 ? GFSK_BT1 : FSK),
+                                    datarate, datarate / 2 < 1500 ? 1500 : datarate / 2,
+                                    3 * datarate < 700000 ? (3 * datarate < 2000 ? 2000 : 3 * datarate) : 700000};
+                PktBasicInit packet = {PKT_PREAMBLE_LENGTH_04BYTES, d % 2 ? PKT_SYNC_LENGTH_3BYTES : PKT_SYNC_LENGTH_4BYTES,
+                                       0x1A2635A8, d % 2 ? PKT_LENGTH_FIX : PKT_LENGTH_VAR, (uint8_t) (d + 4),
+                                       d % 2 ? PKT_CRC_MODE_8BITS : PKT_CRC_MODE_24BITS, PKT_CONTROL_LENGTH_1BYTE,
+                                       d % 2 ? S_ENABLE : S_DISABLE, S_DISABLE, d % 2 ? S_DISABLE : S_ENABLE};
+                Spirit1RegisterImage swept = spirit1RegisterImage(xtals[x], sweep, packet);
+                if (!swept.xtal) continue;
+                if (imageMismatch(xtals[x], sweep, packet, swept) != -1) mismatches++;
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+
+    /* an invalid configuration at run time: no image, nothing loaded */
+    SRadioInit wrong = radio;
+    wrong.lDatarate = 600000;
+    CHECK(spirit1RegisterImage(50000000, wrong, basic).xtal == 0);
+    CHECK(spirit1RegisterImage(40000000, radio, basic).xtal == 0);
+    CHECK(spirit1ImageLoad(spirit1RegisterImage(40000000, radio, basic)) == 1);
+    radioInit();
+}
+
+/** non-volatile storage of the warm boot, in RAM */
+struct TestStorage {
+    TestStorage() : stored(false), writes(0) {}
+
+    bool read(void *data, uint16_t length) {
+        if (!stored) return false;
+        memcpy(data, &record, length);
+        return true;
+    }
+
+    bool write(const void *data, uint16_t length) {
+        memcpy(&record, data, length);
+        stored = true;
+        writes++;
+        return true;
+    }
+
+    Spirit1WarmBootRecord record;
+    bool stored;
+    int writes;
+};
+
+static uint8_t warmBootCold() {
+    SRadioInit radio = {0, 868000000, 20000, 0, FSK, 38400, 20000, 100000};
+    PktBasicInit basic = {PKT_PREAMBLE_LENGTH_04BYTES, PKT_SYNC_LENGTH_4BYTES, 0x88888888, PKT_LENGTH_VAR, 7,
+                          PKT_CRC_MODE_16BITS_1, PKT_CONTROL_LENGTH_0BYTES, S_ENABLE, S_DISABLE, S_ENABLE};
+    SGpioInit gpioIrq = {SPIRIT_GPIO_3, SPIRIT_GPIO_MODE_DIGITAL_OUTPUT_LP, SPIRIT_GPIO_DIG_OUT_IRQ};
+
+    SpiritCmdStrobeSres();
+    SpiritManagementWaExtraCurrent();
+    SpiritRadioSetXtalFrequency(50000000);
+    if (SpiritRadioInit(&radio)) return 1;
+    SpiritPktBasicInit(&basic);
+    SpiritGpioInit(&gpioIrq);
+    SpiritIrqDeInit(NULL);
+    SpiritIrq(RX_DATA_READY, S_ENABLE);
+    SpiritIrqClearStatus();
+    return 0;
+}
+
+static uint8_t warmBootFailing() {
+    return 1;
+}
+
+static void testWarmBoot() {
+    TestStorage storage;
+    Spirit1WarmBoot<TestStorage> warmBoot(storage, 3600, 10);
+    uint8_t cold[256];
+    uint32_t coldPolls;
+
+    /* nothing stored: cold, then the snapshot */
+    chip().resetStats();
+    CHECK(warmBoot.boot(0x1234, 1000, 25, warmBootCold) == SPIRIT1_WARM_BOOT_EMPTY);
+    CHECK(storage.writes == 1 && warmBoot.stats().cold == 1 && warmBoot.stats().empty == 1);
+    coldPolls = chip().stats().statePolls;
+    for (int i = 0; i < 256; i++) cold[i] = chip().peek((uint8_t) i);
+    CHECK(storage.record.vcoTx == (cold[RCO_VCO_CALIBR_IN1_BASE] & 0x7F) && storage.record.vcoRx == cold[RCO_VCO_CALIBR_IN0_BASE]);
+
+    /* warm: the registers of the cold boot without a calibration, the words of the cold boot in place */
+    chip().resetStats();
+    CHECK(warmBoot.boot(0x1234, 2000, 30, warmBootCold) == SPIRIT1_WARM_BOOT_WARM && warmBoot.stats().warm == 1);
+    CHECK(storage.writes == 1);
+    for (int i = 0; i < 256; i++) {
+        if (i == PROTOCOL2_BASE || i == RCO_VCO_CALIBR_IN2_BASE || i == RCO_VCO_CALIBR_IN1_BASE) continue;
+        if (i == RCO_VCO_CALIBR_OUT0_BASE) continue;
+        if (chip().peek((uint8_t) i) != cold[i]) {
+            printf("warm boot: register 0x%02X is 0x%02X, 0x%02X after the cold boot\r\n", i, chip().peek((uint8_t) i), cold[i]);
+            CHECK(false);
+        }
+    }
+    CHECK(chip().peek(PROTOCOL2_BASE) == (cold[PROTOCOL2_BASE] & ~PROTOCOL2_RCO_CALIBRATION_MASK));
+    CHECK((chip().peek(RCO_VCO_CALIBR_IN1_BASE) & 0x7F) == (cold[RCO_VCO_CALIBR_IN1_BASE] & 0x7F));
+    CHECK(chip().peek(RCO_VCO_CALIBR_IN2_BASE) == cold[RCO_VCO_CALIBR_OUT1_BASE]);
+    /* STANDBY and READY, none of the LOCK cycles of the calibration */
+    CHECK(chip().stats().statePolls < coldPolls / 2);
+    SpiritRefreshStatus();
+    CHECK(g_xStatus.MC_STATE == MC_STATE_READY && SpiritRadioGetXtalFrequency() == 50000000);
+    SpiritCmdStrobeRx();
+    CHECK(SpiritWaitState(MC_STATE_RX, SPIRIT_WAIT_STATE_TIMEOUT_US) == SPIRIT_WAIT_OK);
+    SpiritCmdStrobeSabort();
+
+    /* invalid: another configuration, too old, too warm, damaged; each cold boot saves anew */
+    CHECK(warmBoot.boot(0x4321, 3000, 25, warmBootCold) == SPIRIT1_WARM_BOOT_OTHER_KEY);
+    CHECK(warmBoot.boot(0x4321, 3000 + 3601, 25, warmBootCold) == SPIRIT1_WARM_BOOT_AGED);
+    CHECK(warmBoot.boot(0x4321, 7000, 10, warmBootCold) == SPIRIT1_WARM_BOOT_DRIFTED);
+    CHECK(warmBoot.boot(0x4321, 6000, 10, warmBootCold) == SPIRIT1_WARM_BOOT_AGED);
+    CHECK(warmBoot.boot(0x4321, 6001, 19, warmBootCold) == SPIRIT1_WARM_BOOT_WARM);
+    storage.record.registers[3] ^= 1;
+    CHECK(warmBoot.boot(0x4321, 6001, 19, warmBootCold) == SPIRIT1_WARM_BOOT_EMPTY);
+    CHECK(warmBoot.stats().otherKey == 1 && warmBoot.stats().aged == 2 && warmBoot.stats().drifted == 1);
+    CHECK(warmBoot.stats().warm == 2 && warmBoot.stats().cold == 6 && storage.writes == 6);
+
+    /* a failed cold init saves nothing, invalidate() forces the next cold boot */
+    CHECK(warmBoot.invalidate());
+    CHECK(warmBoot.boot(0x4321, 6002, 19, warmBootFailing) == SPIRIT1_WARM_BOOT_ERROR);
+    CHECK(warmBoot.stats().errors == 1 && storage.record.magic == 0);
+    radioInit();
+}
+
+static void profileInit(uint32_t base, uint32_t datarate, float dbm, uint16_t length, float timeoutMs) {
+    SRadioInit radio = {0, base, 20000, 0, FSK, datarate, datarate / 2, 3 * datarate < 600000 ? 3 * datarate : 600000};
+    CHECK(SpiritRadioInit(&radio) == 0);
+    SpiritRadioSetPALeveldBm(0, dbm);
+    SpiritRadioSetPALevelMaxIndex(0);
+    SpiritPktBasicSetPayloadLength(length);
+    SpiritTimerSetRxTimeoutMs(timeoutMs);
+}
+
+/** the profile registers of the radio are those of profile */
+static bool profileLoaded(const Spirit1RadioProfile &profile) {
+    const uint8_t *registers = profile.registers;
+    for (size_t r = 0; r < sizeof(spirit1RadioProfileRanges) / sizeof(spirit1RadioProfileRanges[0]); r++) {
+        for (int i = 0; i < spirit1RadioProfileRanges[r][1]; i++) {
+            uint8_t address = (uint8_t) (spirit1RadioProfileRanges[r][0] + i);
+            if (address == RCO_VCO_CALIBR_IN1_BASE || address == RCO_VCO_CALIBR_IN0_BASE) continue;
+            if (chip().peek(address) != registers[i]) return false;
+        }
+        registers += spirit1RadioProfileRanges[r][1];
+    }
+    return true;
+}
+
+static void testProfileSwitch() {
+    Spirit1ProfileSwitch<3> profiles(true, 1);
+    Spirit1ProfileSwitchCost cost, bound = Spirit1ProfileSwitch<3>::bound();
+
+    radioInit();
+    profileInit(868000000, 4800, 11, 20, 500);
+    CHECK(profiles.capture("long range"));
+    profileInit(868000000, 250000, 0, 60, 20);
+    CHECK(profiles.capture("high rate"));
+    profileInit(869525000, 38400, 5, 32, 100);
+    CHECK(profiles.capture("other channel"));
+    CHECK(profiles.count() == 3 && profiles.find("high rate") == &profiles.profile(1) && !profiles.find("none"));
+
+    /* same synthesizer: the modem, PA, packet length and timeout registers, no calibration */
+    const Spirit1RadioProfile &longRange = *profiles.find("long range");
+    CHECK(profiles.select("high rate") == 0 && profileLoaded(profiles.profile(1)));
+    CHECK(profiles.stats().calibrations == 1);
+    cost = profiles.plan(longRange);
+    CHECK(!cost.calibrate && cost.registers > 0 && cost.registers < 20);
+    CHECK(profiles.weight(cost) <= profiles.weight(bound));
+    chip().resetStats();
+    CHECK(profiles.select("long range") == 0);
+    CHECK(chip().stats().transactions == cost.transactions && chip().stats().statePolls == 0);
+    CHECK(profileLoaded(longRange));
+    CHECK(profiles.plan(longRange).registers == 0 && profiles.plan(longRange).transactions == 0);
+    CHECK(profiles.select("long range") == 0 && profiles.stats().unchanged == 1);
+
+    /* another synthesizer: calibrated again */
+    cost = profiles.plan(*profiles.find("other channel"));
+    CHECK(cost.calibrate && profiles.weight(cost) <= profiles.weight(bound));
+    chip().resetStats();
+    CHECK(profiles.select("other channel") == 0);
+    CHECK(chip().stats().statePolls > 0 && profileLoaded(*profiles.find("other channel")));
+    CHECK(profiles.stats().calibrations == 2);
+    SpiritCmdStrobeRx();
+    CHECK(SpiritWaitState(MC_STATE_RX, SPIRIT_WAIT_STATE_TIMEOUT_US) == SPIRIT_WAIT_OK);
+    SpiritCmdStrobeSabort();
+    CHECK(SpiritWaitState(MC_STATE_READY, SPIRIT_WAIT_STATE_TIMEOUT_US) == SPIRIT_WAIT_OK);
+
+    /* every pair stays within the bound */
+    for (uint8_t from = 0; from < 3; from++) {
+        for (uint8_t to = 0; to < 3; to++) {
+            CHECK(profiles.select(profiles.profile(from)) == 0);
+            cost = profiles.plan(profiles.profile(to));
+            CHECK(profiles.weight(cost) <= profiles.weight(bound) && cost.bytes <= bound.bytes);
+            CHECK(profiles.select(profiles.profile(to)) == 0 && profileLoaded(profiles.profile(to)));
+        }
+    }
+
+    /* the shadow lost: everything written */
+    SpiritShadowInvalidate();
+    cost = profiles.plan(longRange);
+    CHECK(cost.registers == SPIRIT1_RADIO_PROFILE_REGISTERS && cost.calibrate);
+    CHECK(cost.transactions == bound.transactions && cost.bytes == bound.bytes);
+    CHECK(profiles.select("none") == 1 && profiles.stats().errors == 1);
+    radioInit();
+}
+
+/* worst |dBm10(level(d)) - d| over the range, but for the powers out of reach (levels 1 and 90) */
+static int paRoundTripError(const Spirit1PaCurve &curve) {
+    int worst = 0;
+    for (int d = SPIRIT1_PA_DBM10_MIN; d <= SPIRIT1_PA_DBM10_MAX; d++) {
+        uint8_t level = curve.level[spirit1PaIndex(d)];
+        if (level == 1 || level == 90) continue;
+        int error = curve.dBm10[level] - d;
+        if (error < 0) error = -error;
+        if (error > worst) worst = error;
+    }
+    return worst;
+}
+
+static void testPaCurve() {
+    static const uint32_t bases[5] = {915000000, 868000000, 433920000, 315000000, 169400000};
+    static constexpr Spirit1PaCurve curve868 = spirit1PaModelCurve(SPIRIT1_PA_BAND_868);
+    static_assert(curve868.level[spirit1PaIndex(110)] == 1, "11 dBm at 868 MHz is PA_LEVEL 1");
+    int levelMismatches = 0, dBmMismatches = 0;
+
+    /* the tables against the float model of the library, every power and every level */
+    for (uint8_t band = 0; band < 5; band++) {
+        const Spirit1PaCurve &curve = spirit1PaCurves[band];
+        CHECK(spirit1PaBand(bases[band]) == band);
+        for (int d = SPIRIT1_PA_DBM10_MIN; d <= SPIRIT1_PA_DBM10_MAX; d++) {
+            levelMismatches += curve.level[spirit1PaIndex(d)] != SpiritRadioGetdBm2Reg(bases[band], d / 10.0f);
+        }
+        for (uint8_t r = 0; r <= 90; r++) {
+            dBmMismatches += curve.dBm10[r] != (int16_t) lround(SpiritRadioGetReg2dBm(bases[band], r) * 10.0);
+        }
+        /* a level step is at most 1/1.8 dB */
+        CHECK(paRoundTripError(curve) <= 5);
+    }
+    CHECK(levelMismatches == 0 && dBmMismatches == 0);
+    CHECK(spirit1PaIndex(-400) == 0 && spirit1PaIndex(500) == SPIRIT1_PA_STEPS - 1);
+
+    /* a measured curve, 0.5 dB per level: the closest level of each power */
+    static constexpr int16_t measured[91] = {
+        0, 125, 120, 115, 110, 105, 100, 95, 90, 85, 80, 75, 70, 65, 60, 55, 50, 45, 40, 35,
+        30, 25, 20, 15, 10, 5, 0, -5, -10, -15, -20, -25, -30, -35, -40, -45, -50, -55, -60, -65,
+        -70, -75, -80, -85, -90, -95, -100, -105, -110, -115, -120, -125, -130, -135, -140, -145, -150, -155, -160, -165,
+        -170, -175, -180, -185, -190, -195, -200, -205, -210, -215, -220, -225, -230, -235, -240, -245, -250, -255, -260, -265,
+        -270, -275, -280, -285, -290, -295, -300, -305, -310, -315, -320,
+    };
+    static constexpr Spirit1PaCurve board = spirit1PaMeasuredCurve(measured);
+    CHECK(board.dBm10[0] == SPIRIT1_PA_OFF_DBM10 && board.dBm10[1] == 125 && board.dBm10[90] == -320);
+    CHECK(board.level[spirit1PaIndex(120)] == 2 && board.level[spirit1PaIndex(-310)] == 88);
+    /* 11.0 dBm at 4, 11.5 at 3 */
+    CHECK(board.level[spirit1PaIndex(112)] == 4 && board.level[spirit1PaIndex(113)] == 3);
+    CHECK(paRoundTripError(board) <= 2);
+
+    /* on the radio: the band looked up once, one write per level */
+    Spirit1Pa pa(spirit1PaCurves[spirit1PaBand(SpiritRadioGetFrequencyBase())]);
+    CHECK(&pa.curve() == &spirit1PaCurves[SPIRIT1_PA_BAND_868]);
+    chip().resetStats();
+    pa.setLevel(0, 55);
+    CHECK(chip().stats().transactions == 1);
+    CHECK(SpiritRadioGetPALevel(0) == SpiritRadioGetdBm2Reg(868000000, 5.5f));
+    CHECK(pa.getLevel(0) == (int16_t) lround(SpiritRadioGetPALeveldBm(0) * 10.0));
+
+    static const int16_t table[4] = {-200, -50, 60, 110};
+    float tabledBm[4] = {-20.0f, -5.0f, 6.0f, 11.0f};
+    uint8_t maxIndex, libraryLevels[8], levels[8];
+    SpiritRadioSetPATabledBm(3, 2, LOAD_1_2_PF, tabledBm);
+    SpiritRadioGetPATable(&maxIndex, libraryLevels);
+    uint8_t libraryPower = chip().peek(PA_POWER0_BASE);
+    SpiritRadioSetPATable(3, 1, LOAD_0_PF, (uint8_t *) "\x10\x10\x10\x10");
+    chip().resetStats();
+    pa.setTable(3, 2, LOAD_1_2_PF, table);
+    CHECK(chip().stats().transactions == 1);
+    SpiritRadioGetPATable(&maxIndex, levels);
+    CHECK(maxIndex == 3 && memcmp(levels, libraryLevels, 4) == 0 && chip().peek(PA_POWER0_BASE) == libraryPower);
+
+    pa.bind(board);
+    pa.setLevel(0, 112);
+    CHECK(SpiritRadioGetPALevel(0) == 4 && pa.getLevel(0) == 110);
+    CHECK(pa.dBm10(0) == SPIRIT1_PA_OFF_DBM10 && pa.dBm10(91) == SPIRIT1_PA_OFF_DBM10);
+    radioInit();
+}
+
+static void testStates() {
+    SpiritCmdStrobeStandby();
+    SpiritRefreshStatus();
+    CHECK(g_xStatus.MC_STATE == MC_STATE_STANDBY);
+    CHECK(g_xStatus.XO_ON == 0);
+
+    SpiritCmdStrobeReady();
+    SpiritRefreshStatus();
+    CHECK(g_xStatus.MC_STATE == MC_STATE_XO_SETTLING);
+    chip().advance(chip().timing().standbyToReadyNs);
+    SpiritRefreshStatus();
+    CHECK(g_xStatus.MC_STATE == MC_STATE_READY);
+
+    SpiritIrq(LOCK, S_ENABLE);
+    SpiritCmdStrobeLockTx();
+    CHECK(waitIrq(LOCK, 1000000));
+    SpiritRefreshStatus();
+    CHECK(g_xStatus.MC_STATE == MC_STATE_LOCK);
+    SpiritCmdStrobeReady();
+    SpiritRefreshStatus();
+    CHECK(g_xStatus.MC_STATE == MC_STATE_READY);
+    SpiritIrqDeInit(NULL);
+    SpiritIrqClearStatus();
+}
+
+static void testWait() {
+    SpiritWaitCounters counters;
+
+    /* polling the status bytes */
+    SpiritWaitResetCounters();
+    SpiritCmdStrobeLockTx();
+    CHECK(SpiritWaitState(MC_STATE_LOCK, SPIRIT_WAIT_LOCK_TIMEOUT_US) == SPIRIT_WAIT_OK);
+    CHECK(chip().state() == MC_STATE_LOCK);
+    SpiritCmdStrobeReady();
+    CHECK(SpiritWaitState(MC_STATE_READY, SPIRIT_WAIT_STATE_TIMEOUT_US) == SPIRIT_WAIT_OK);
+    SpiritWaitGetCounters(&counters);
+    CHECK(counters.lWaits == 2 && counters.lPolls > 2 && counters.lFailures == 0);
+
+    /* a state that never comes: bounded */
+    SpiritWaitResetCounters();
+    CHECK(SpiritWaitState(MC_STATE_TX, 50) == SPIRIT_WAIT_TIMEOUT);
+    SpiritWaitGetCounters(&counters);
+    CHECK(counters.lPolls == 51 && counters.lFailures == 1);
+
+    /* blocking on GPIO_0 */
+    SpiritWaitGpioInit(SPIRIT_GPIO_0);
+    standInBus().setStateGpio(0);
+    SpiritWaitResetCounters();
+    chip().resetStats();
+    SpiritCmdStrobeLockRx();
+    CHECK(SpiritWaitState(MC_STATE_LOCK, SPIRIT_WAIT_LOCK_TIMEOUT_US) == SPIRIT_WAIT_OK);
+    CHECK(chip().state() == MC_STATE_LOCK);
+    CHECK(g_xStatus.MC_STATE == MC_STATE_LOCK);
+    SpiritCmdStrobeReady();
+    CHECK(SpiritWaitState(MC_STATE_READY, SPIRIT_WAIT_STATE_TIMEOUT_US) == SPIRIT_WAIT_OK);
+    CHECK(chip().stats().statePolls == 0);
+    SpiritWaitGetCounters(&counters);
+    CHECK(counters.lGpioWaits == 2 && counters.lPolls == 0);
+
+    /* the GPIO times out, one poll tells why */
+    uint64_t start = chip().now();
+    CHECK(SpiritWaitState(MC_STATE_TX, 50) == SPIRIT_WAIT_TIMEOUT);
+    CHECK(chip().now() - start >= 50000);
+    SpiritWaitGetCounters(&counters);
+    CHECK(counters.lPolls == 1 && counters.lFailures == 1);
+
+    SpiritWaitGpioDeInit();
+    standInBus().setStateGpio(-1);
+}
+
+static void testFifo() {
+    uint8_t data[96];
+    memset(data, 0x5A, sizeof(data));
+
+    SpiritLinearFifoSetAlmostFullThresholdTx(48);
+    SpiritIrq(TX_FIFO_ALMOST_FULL, S_ENABLE);
+    SpiritIrq(TX_FIFO_ERROR, S_ENABLE);
+    SpiritSpiWriteLinearFifo(20, data);
+    CHECK(SpiritLinearFifoReadNumElementsTxFifo() == 20);
+    CHECK(!chip().irqPending());
+    SpiritSpiWriteLinearFifo(28, data);
+    CHECK(SpiritIrqCheckFlag(TX_FIFO_ALMOST_FULL));
+    /* read to clear */
+    CHECK(!chip().irqPending());
+
+    SpiritSpiWriteLinearFifo(60, data);
+    CHECK(chip().txFifoLevel() == 96);
+    CHECK(g_xStatus.TX_FIFO_FULL == 0);
+    SpiritRefreshStatus();
+    CHECK(g_xStatus.TX_FIFO_FULL == 1);
+    CHECK(SpiritIrqCheckFlag(TX_FIFO_ERROR));
+
+    SpiritCmdStrobeFlushTxFifo();
+    CHECK(SpiritLinearFifoReadNumElementsTxFifo() == 0);
+    SpiritIrqDeInit(NULL);
+    SpiritIrqClearStatus();
+}
+
+static void testTx() {
+    uint8_t payload[20];
+    for (int i = 0; i < 20; i++) payload[i] = (uint8_t) i;
+
+    SpiritIrq(TX_DATA_SENT, S_ENABLE);
+    SpiritPktBasicSetPayloadLength(sizeof(payload));
+    SpiritPktCommonSetDestinationAddress(0x33);
+    SpiritCmdStrobeFlushTxFifo();
+    SpiritSpiWriteLinearFifo(sizeof(payload), payload);
+
+    chip().resetStats();
+    uint64_t start = chip().now();
+    SpiritCmdStrobeTx();
+    CHECK(waitIrq(TX_DATA_SENT, 100000000));
+    uint64_t elapsed = chip().now() - start;
+    CHECK(elapsed >= chip().airtimeNs(sizeof(payload)));
+    CHECK(elapsed < chip().airtimeNs(sizeof(payload)) + 200000);
+
+    SpiritIrqs irqs;
+    SpiritIrqGetStatus(&irqs);
+    CHECK(irqs.IRQ_TX_DATA_SENT);
+    CHECK(chip().stats().framesSent == 1);
+    CHECK(chip().lastTransmitted().destination == 0x33);
+    CHECK(chip().lastTransmitted().payload.size() == sizeof(payload));
+    CHECK(memcmp(&chip().lastTransmitted().payload[0], payload, sizeof(payload)) == 0);
+    CHECK(SpiritLinearFifoReadNumElementsTxFifo() == 0);
+    SpiritRefreshStatus();
+    CHECK(g_xStatus.MC_STATE == MC_STATE_READY);
+    SpiritIrqDeInit(NULL);
+}
+
+static void txQueueDone(void *context, bool sent) {
+    uint32_t *done = (uint32_t *) context;
+    if (sent) (*done)++;
+}
+
+static void testDeferredIrq() {
+    Spirit1DeferredIrq irq;
+
+    /* edges while the bottom half is pending merge into it */
+    CHECK(irq.edge(100) && irq.pending());
+    irq.edgeDone(100, 103);
+    CHECK(!irq.edge(110) && !irq.edge(120));
+    CHECK(irq.stats().edges == 3 && irq.stats().signals == 1 && irq.stats().isrMaxUs == 3);
+
+    /* begin() re-arms: an edge during the SPI work signals a new run */
+    irq.begin(150);
+    CHECK(!irq.pending() && irq.stats().handled == 1 && irq.stats().latencyLastUs == 50);
+    CHECK(irq.edge(160));
+    irq.edgeDone(160, 161);
+    irq.begin(180);
+    CHECK(irq.stats().latencyLastUs == 20 && irq.stats().latencyMaxUs == 50 && irq.stats().latencySumUs == 70);
+    CHECK(irq.stats().isrMaxUs == 3);
+
+    /* a signal that failed: the edge is forgotten, the next one signals again */
+    CHECK(irq.edge(200));
+    irq.cancel();
+    CHECK(!irq.pending() && irq.stats().lost == 1);
+    CHECK(irq.edge(300) && irq.stats().signals == 4);
+    irq.begin(305);
+    CHECK(irq.stats().handled == 3 && irq.stats().latencyLastUs == 5 && !irq.pending());
+
+    irq.resetStats();
+    CHECK(irq.stats().edges == 0 && irq.stats().handled == 0 && irq.stats().latencyMaxUs == 0);
+}
+
+static void testTxQueue() {
+    Spirit1TxQueue<4> queue;
+    uint8_t payload[80];
+    uint32_t done = 0;
+    for (int i = 0; i < 80; i++) payload[i] = (uint8_t) (i + 1);
+
+    queue.init();
+    chip().resetStats();
+    /* 20 + 40 bytes fit the FIFO together, 80 only once the 40 are almost gone */
+    /* only the push on the empty queue wakes the radio thread up */
+    CHECK(queue.push(payload, 20, txQueueDone, &done) && queue.startNeeded());
+    CHECK(queue.push(payload, 40, txQueueDone, &done) && !queue.startNeeded());
+    CHECK(queue.push(payload, 80, txQueueDone, &done) && !queue.startNeeded());
+    CHECK(queue.push(payload, 10, txQueueDone, &done) && !queue.startNeeded());
+    CHECK(!queue.push(payload, 10));
+    queue.start();
+    for (int i = 0; i < 1000 && done < 4; i++) {
+        CHECK(waitIrq(TX_DATA_SENT | TX_FIFO_ALMOST_EMPTY, 100000000));
+        SpiritIrqs irqs;
+        SpiritIrqGetStatus(&irqs);
+        queue.handleIrqs(irqs);
+    }
+    CHECK(done == 4 && queue.count() == 0);
+    CHECK(chip().stats().framesSent == 4 && chip().stats().txUnderflows == 0);
+    CHECK(queue.stats().preloaded == 3 && queue.stats().rejected == 1);
+    CHECK(chip().lastTransmitted().payload.size() == 10 && chip().lastTransmitted().payload[9] == 10);
+    CHECK(SpiritLinearFifoReadNumElementsTxFifo() == 0);
+
+    /* idle again: the next push needs a start, the one after it goes from handleIrqs() */
+    CHECK(queue.push(payload, 10, txQueueDone, &done) && queue.startNeeded());
+    queue.start();
+    CHECK(queue.push(payload, 10, txQueueDone, &done) && !queue.startNeeded());
+    for (int i = 0; i < 1000 && done < 6; i++) {
+        CHECK(waitIrq(TX_DATA_SENT | TX_FIFO_ALMOST_EMPTY, 100000000));
+        SpiritIrqs irqs;
+        SpiritIrqGetStatus(&irqs);
+        queue.handleIrqs(irqs);
+    }
+    CHECK(done == 6 && queue.count() == 0 && chip().stats().framesSent == 6);
+    SpiritIrqDeInit(NULL);
+    SpiritIrqClearStatus();
+}
+
+static Spirit1SimFrame frame(uint8_t destination, uint8_t length) {
+    Spirit1SimFrame f = Spirit1SimFrame();
+    f.destination = destination;
+    f.crcOk = true;
+    for (uint8_t i = 0; i < length; i++) f.payload.push_back((uint8_t) (0xA0 + i));
+    return f;
+}
+
+static void testRx() {
+    uint8_t data[96];
+
+    SpiritIrq(RX_DATA_READY, S_ENABLE);
+    SpiritIrq(RX_DATA_DISC, S_ENABLE);
+    SpiritCmdStrobeRx();
+    chip().advance(1000000);
+    SpiritRefreshStatus();
+    CHECK(g_xStatus.MC_STATE == MC_STATE_RX);
+
+    chip().inject(frame(0x44, 12), -70);
+    CHECK(waitIrq(RX_DATA_READY | RX_DATA_DISC, 100000000));
+    CHECK(SpiritIrqCheckFlag(RX_DATA_READY));
+    CHECK(SpiritPktBasicGetReceivedPktLength() == 12);
+    CHECK(SpiritPktCommonGetReceivedDestAddress() == 0x44);
+    CHECK(SpiritLinearFifoReadNumElementsRxFifo() == 12);
+    SpiritSpiReadLinearFifo(12, data);
+    CHECK(data[0] == 0xA0 && data[11] == 0xAB);
+    CHECK(SpiritQiGetRssi() == (uint8_t) ((-70 + 130) * 2));
+    CHECK(g_xStatus.RX_FIFO_EMPTY == 1);
+
+    /* address filtering */
+    SpiritCmdStrobeRx();
+    chip().advance(1000000);
+    chip().inject(frame(0x45, 12));
+    CHECK(waitIrq(RX_DATA_READY | RX_DATA_DISC, 100000000));
+    CHECK(SpiritIrqCheckFlag(RX_DATA_DISC));
+    CHECK(SpiritLinearFifoReadNumElementsRxFifo() == 0);
+
+    /* broadcast and CRC errors */
+    SpiritCmdStrobeRx();
+    chip().advance(1000000);
+    chip().inject(frame(0xFF, 4));
+    CHECK(waitIrq(RX_DATA_READY | RX_DATA_DISC, 100000000));
+    CHECK(SpiritIrqCheckFlag(RX_DATA_READY));
+    SpiritCmdStrobeFlushRxFifo();
+
+    Spirit1SimFrame corrupted = frame(0x44, 4);
+    corrupted.crcOk = false;
+    SpiritCmdStrobeRx();
+    chip().advance(1000000);
+    chip().inject(corrupted);
+    CHECK(waitIrq(RX_DATA_READY | RX_DATA_DISC, 100000000));
+    CHECK(SpiritIrqCheckFlag(RX_DATA_DISC));
+    CHECK(chip().stats().framesDiscarded == 2);
+
+    /* not in RX */
+    SpiritRefreshStatus();
+    CHECK(g_xStatus.MC_STATE == MC_STATE_READY);
+    uint32_t missed = chip().stats().framesMissed;
+    chip().inject(frame(0x44, 4));
+    chip().advance(10000000);
+    CHECK(chip().stats().framesMissed == missed + 1);
+    SpiritIrqDeInit(NULL);
+    SpiritIrqClearStatus();
+}
+
+static void testRxRing() {
+    Spirit1RxRing<4> ring;
+    Spirit1RxPacket packet = Spirit1RxPacket();
+
+    /* the packet and its RX information in one descriptor */
+    SpiritIrq(RX_DATA_READY, S_ENABLE);
+    for (int i = 0; i < 5; i++) {
+        SpiritCmdStrobeRx();
+        chip().advance(1000000);
+        chip().inject(frame(0x44, (uint8_t) (8 + i)), -80);
+        CHECK(waitIrq(RX_DATA_READY, 100000000));
+        SpiritIrqClearStatus();
+        CHECK(spirit1RxReceive(ring, 1000u + i) == (i < 4));
+    }
+    SpiritCmdStrobeFlushRxFifo();
+    CHECK(ring.count() == 4 && ring.stats().overflows == 1 && ring.stats().highWater == 4);
+    CHECK(ring.pop(packet));
+    CHECK(packet.length == 8 && packet.payload[0] == 0xA0 && packet.payload[7] == 0xA7);
+    CHECK(packet.destination == 0x44 && packet.timestampUs == 1000);
+    CHECK(packet.rssi == (uint8_t) ((-80 + 130) * 2) && packet.lqi == 15 && packet.sqi == 0x1F);
+    CHECK(ring.front()->length == 9);
+    SpiritIrqDeInit(NULL);
+    SpiritIrqClearStatus();
+
+    /* one producer and one consumer thread, nothing lost or reordered */
+    Spirit1RxRing<8> shared;
+    const uint32_t count = 50000;
+    uint32_t received = 0, disorders = 0;
+    std::thread consumer([&] {
+        Spirit1RxPacket item;
+        while (received < count) {
+            if (!shared.pop(item)) {
+                std::this_thread::yield();
+                continue;
+            }
+            uint32_t value;
+            memcpy(&value, item.payload, sizeof(value));
+            if (value != received || item.timestampUs != value) disorders++;
+            received++;
+        }
+    });
+    for (uint32_t i = 0; i < count;) {
+        Spirit1RxPacket *slot = shared.claim();
+        if (!slot) {
+            std::this_thread::yield();
+            continue;
+        }
+        memcpy(slot->payload, &i, sizeof(i));
+        slot->timestampUs = i++;
+        shared.commit();
+    }
+    consumer.join();
+    CHECK(received == count && disorders == 0);
+    CHECK(shared.stats().produced == count && shared.stats().consumed == count);
+}
+
+static void testBufferPool() {
+    Spirit1BufferPool<3, 96, 8> pool;
+    Spirit1Buffer *buffers[3];
+
+    /* fixed blocks, the headroom takes a header in place */
+    for (int i = 0; i < 3; i++) CHECK((buffers[i] = pool.alloc()) != NULL);
+    CHECK(pool.alloc() == NULL && pool.stats().failures == 1 && pool.available() == 0);
+    CHECK(buffers[0]->headroom() == 8 && buffers[0]->capacity() == 96 && buffers[0]->length == 0);
+    memcpy(buffers[0]->data(), "data", 4);
+    buffers[0]->length = 4;
+    CHECK(buffers[0]->prepend(9) == NULL);
+    uint8_t *header = buffers[0]->prepend(2);
+    CHECK(header == buffers[0]->data() && header[2] == 'd' && buffers[0]->length == 6);
+    CHECK(buffers[0]->strip(2) == header && buffers[0]->data()[0] == 'd' && buffers[0]->length == 4);
+    for (int i = 0; i < 3; i++) buffers[i]->release();
+    buffers[0]->release();
+    CHECK(pool.stats().doubleFrees == 1 && pool.stats().inUse == 0 && pool.stats().highWater == 3);
+
+    /* RX: the FIFO straight into the buffers, until the pool runs dry */
+    Spirit1RxRing<4, Spirit1Buffer *> ring;
+    Spirit1Buffer *packet = NULL;
+    SpiritIrq(RX_DATA_READY, S_ENABLE);
+    for (int i = 0; i < 4; i++) {
+        SpiritCmdStrobeRx();
+        chip().advance(1000000);
+        chip().inject(frame(0x44, (uint8_t) (20 + i)), -80);
+        CHECK(waitIrq(RX_DATA_READY, 100000000));
+        SpiritIrqClearStatus();
+        CHECK(spirit1RxReceive(ring, pool, 2000u + i) == (i < 3));
+        SpiritCmdStrobeFlushRxFifo();
+    }
+    CHECK(ring.count() == 3 && pool.stats().failures == 2 && ring.stats().overflows == 0);
+    CHECK(ring.pop(packet) && packet != NULL);
+    if (packet != NULL) {
+        CHECK(packet->length == 20 && packet->data()[0] == 0xA0 && packet->data()[19] == 0xB3);
+        CHECK(packet->rx.destination == 0x44 && packet->rx.timestampUs == 2000 && packet->headroom() == 8);
+        packet->release();
+    }
+    while (ring.pop(packet)) packet->release();
+    SpiritIrqDeInit(NULL);
+    SpiritIrqClearStatus();
+
+    /* TX: the queue sends from the buffer and releases it after the callback */
+    Spirit1TxQueue<4> queue;
+    uint32_t done = 0;
+    Spirit1Buffer *frame = pool.alloc();
+    for (int i = 0; i < 50; i++) frame->data()[i] = (uint8_t) (i + 1);
+    frame->length = 50;
+    queue.init();
+    CHECK(queue.push(frame, txQueueDone, &done));
+    CHECK(pool.available() == 2);
+    queue.start();
+    CHECK(waitIrq(TX_DATA_SENT, 100000000));
+    SpiritIrqs irqs;
+    SpiritIrqGetStatus(&irqs);
+    queue.handleIrqs(irqs);
+    CHECK(done == 1 && pool.available() == 3);
+    CHECK(chip().lastTransmitted().payload.size() == 50 && chip().lastTransmitted().payload[49] == 50);
+    SpiritIrqDeInit(NULL);
+    SpiritIrqClearStatus();
+
+    /* both threads allocate and free, buffers pass from one to the other by pointer */
+    Spirit1BufferPool<8, 16> shared;
+    Spirit1RxRing<4, Spirit1Buffer *> handoff;
+    const uint32_t count = 20000;
+    uint32_t received = 0, disorders = 0;
+    std::thread consumer([&] {
+        Spirit1Buffer *item;
+        while (received < count) {
+            if (!handoff.pop(item)) {
+                std::this_thread::yield();
+                continue;
+            }
+            uint32_t value;
+            memcpy(&value, item->data(), sizeof(value));
+            if (value != received) disorders++;
+            received++;
+            item->release();
+            shared.free(shared.alloc());
+        }
+    });
+    for (uint32_t i = 0; i < count;) {
+        Spirit1Buffer **slot = handoff.claim();
+        Spirit1Buffer *item = slot ? shared.alloc() : NULL;
+        if (!item) {
+            std::this_thread::yield();
+            continue;
+        }
+        memcpy(item->data(), &i, sizeof(i));
+        *slot = item;
+        handoff.commit();
+        i++;
+    }
+    consumer.join();
+    CHECK(received == count && disorders == 0);
+    CHECK(shared.stats().inUse == 0 && shared.stats().doubleFrees == 0 && shared.available() == 8);
+    CHECK(shared.stats().allocs == shared.stats().frees && shared.stats().highWater <= 8);
+}
+
+static void testFragment() {
+    Spirit1Fragmenter<20> fragmenter;
+    Spirit1Reassembler<256, 2, 20> reassembler(1000);
+    uint8_t message[200], frames[11][20], lengths[11];
+    const uint8_t *complete;
+    uint16_t length;
+    for (int i = 0; i < 200; i++) message[i] = (uint8_t) (i * 5 + 1);
+
+    /* 200 bytes in 18 byte chunks: 11 fragments, the last one short */
+    CHECK(!fragmenter.begin(message, 0) && !fragmenter.begin(message, 128 * 18 + 1));
+    CHECK(fragmenter.begin(message, 200) && fragmenter.fragments() == 12);
+    CHECK(fragmenter.begin(message, 198) && fragmenter.fragments() == 11);
+    for (int i = 0; i < 11; i++) lengths[i] = fragmenter.next(frames[i]);
+    CHECK(fragmenter.next(frames[0]) == 0);
+    CHECK(lengths[0] == 20 && lengths[10] == 2 + 198 - 180 && frames[10][1] == (SPIRIT1_FRAGMENT_LAST | 10));
+
+    /* out of order with a duplicate, from two sources interleaved */
+    static const int order[] = {10, 3, 0, 7, 1, 2, 3, 4, 5, 6, 8, 9};
+    for (int i = 0; i < 12; i++) {
+        CHECK(reassembler.receive(0x21, frames[order[i]], lengths[order[i]], 100, &length) == NULL ||
+              i == 11);
+        if (i == 11) break;
+        CHECK(reassembler.receive(0x22, frames[order[i]], lengths[order[i]], 100, &length) == NULL);
+    }
+    complete = reassembler.receive(0x22, frames[9], lengths[9], 100, &length);
+    CHECK(complete && length == 198 && memcmp(complete, message, 198) == 0);
+    CHECK(reassembler.stats().messages == 2 && reassembler.stats().duplicates == 2 && reassembler.pending() == 0);
+
+    /* a fragment sent again after a lost ACK: the message is done, a duplicate */
+    CHECK(reassembler.receive(0x21, frames[5], lengths[5], 150, &length) == NULL);
+    CHECK(reassembler.stats().duplicates == 3 && reassembler.pending() == 0 && reassembler.stats().evictions == 0);
+
+    /* stale partials time out, a third message evicts the oldest */
+    CHECK(reassembler.receive(0x21, frames[0], lengths[0], 2000, &length) == NULL);
+    CHECK(reassembler.receive(0x21, frames[1], lengths[1], 4000, &length) == NULL);
+    CHECK(reassembler.stats().timeouts == 1);
+    frames[2][0]++;
+    CHECK(reassembler.receive(0x22, frames[2], lengths[2], 4100, &length) == NULL);
+    frames[3][0] += 2;
+    CHECK(reassembler.receive(0x23, frames[3], lengths[3], 4200, &length) == NULL);
+    CHECK(reassembler.stats().evictions == 1 && reassembler.stats().highWater == 2);
+
+    /* a late fragment of a done message evicts nothing, a new message takes the done slot */
+    Spirit1Reassembler<256, 2, 20> late(1000);
+    uint8_t first[11][20], second[11][20], firstLengths[11], secondLengths[11];
+    CHECK(fragmenter.begin(message, 198));
+    for (int i = 0; i < 11; i++) firstLengths[i] = fragmenter.next(first[i]);
+    CHECK(fragmenter.begin(message, 198));
+    for (int i = 0; i < 11; i++) secondLengths[i] = fragmenter.next(second[i]);
+    for (int i = 0; i < 11; i++) complete = late.receive(0x21, first[i], firstLengths[i], 10, &length);
+    CHECK(complete && length == 198);
+    CHECK(late.receive(0x22, second[0], secondLengths[0], 20, &length) == NULL);
+    CHECK(late.receive(0x21, first[4], firstLengths[4], 30, &length) == NULL);
+    CHECK(late.stats().duplicates == 1 && late.pending() == 1);
+    CHECK(late.receive(0x23, second[0], secondLengths[0], 40, &length) == NULL);
+    CHECK(late.stats().evictions == 0 && late.pending() == 2);
+    for (int i = 1; i < 11; i++) complete = late.receive(0x22, second[i], secondLengths[i], 50, &length);
+    CHECK(complete && length == 198 && memcmp(complete, message, 198) == 0 && late.stats().messages == 2);
+    CHECK(late.receive(0x21, first[4], firstLengths[4], 2000, &length) == NULL && late.stats().timeouts == 1);
+
+    /* one fragment: in place; malformed fragments */
+    CHECK(fragmenter.begin(message, 18) && fragmenter.next(frames[0]) == 20);
+    complete = reassembler.receive(0x21, frames[0], 20, 5000, &length);
+    CHECK(complete == frames[0] + SPIRIT1_FRAGMENT_HEADER && length == 18);
+    CHECK(reassembler.receive(0x21, frames[1], 2, 5000, &length) == NULL);
+    CHECK(reassembler.receive(0x21, frames[1], 10, 5000, &length) == NULL);
+    frames[1][1] = SPIRIT1_FRAGMENT_LAST | 20;
+    CHECK(reassembler.receive(0x21, frames[1], 20, 5000, &length) == NULL);
+    CHECK(reassembler.stats().malformed == 3);
+}
+
+static void testArq() {
+    Spirit1ArqSender<4, 20> sender(10000, 100, 100000);
+    Spirit1ArqReceiver<4, 20> receiver;
+    uint8_t payload[18], frames[4][20], lengths[4], ack[SPIRIT1_ARQ_ACK_LENGTH], frame[20], length = 0;
+    const uint8_t *delivered;
+
+    for (int i = 0; i < 4; i++) {
+        memset(payload, i, sizeof(payload));
+        CHECK(sender.push(payload, (uint8_t) (10 + i)));
+    }
+    CHECK(!sender.push(payload, 10) && sender.count() == 4);
+
+    /* one burst, the ACK request on its last frame */
+    for (int i = 0; i < 4; i++) lengths[i] = sender.poll(0, frames[i]);
+    CHECK(lengths[0] == 12 && frames[0][0] == SPIRIT1_ARQ_DATA && frames[0][1] == 0);
+    CHECK((frames[3][0] & ~SPIRIT1_ARQ_TAG_MASK) == (SPIRIT1_ARQ_DATA | SPIRIT1_ARQ_ACK_REQ) && frames[3][1] == 3);
+    CHECK(sender.awaitingAck() && sender.poll(500, frame) == 0);
+
+    /* frame 1 lost: delivery stops at the hole, the ACK carries it */
+    CHECK(!receiver.onData(frames[0], lengths[0]));
+    CHECK(!receiver.onData(frames[2], lengths[2]));
+    CHECK(receiver.onData(frames[3], lengths[3]));
+    CHECK(receiver.ack(ack) == SPIRIT1_ARQ_ACK_LENGTH && ack[1] == 1 && ack[2] == 0x03);
+    CHECK((ack[0] & SPIRIT1_ARQ_TAG_MASK) == (frames[3][0] & SPIRIT1_ARQ_TAG_MASK));
+    CHECK((delivered = receiver.front(&length)) != NULL && length == 10 && delivered[0] == 0);
+    receiver.release();
+    CHECK(receiver.front(&length) == NULL);
+
+    /* only the hole goes again, the ACK request with it */
+    CHECK(!sender.onAck(frames[0], lengths[0], 1000));
+    CHECK(sender.onAck(ack, sizeof(ack), 1000) && sender.count() == 3 && sender.stats().acked == 3);
+    CHECK(sender.stats().srttUs == 1000 && sender.stats().rtoUs == 3000);
+    CHECK(sender.poll(1000, frame) == 13 && frame[1] == 1 && (frame[0] & SPIRIT1_ARQ_ACK_REQ));
+    CHECK(sender.stats().retransmissions == 1 && sender.poll(1100, frame) == 0);
+
+    /* lost again: after the RTO the oldest frame probes, the RTO backs off */
+    CHECK(sender.poll(3999, frame) == 0);
+    CHECK(sender.poll(4000, frame) == 13 && frame[1] == 1 && sender.stats().timeouts == 1);
+    CHECK(sender.stats().rtoUs == 6000);
+    CHECK(receiver.onData(frame, 13) && receiver.ack(ack) && ack[1] == 4 && ack[2] == 0);
+    for (int i = 1; i < 4; i++) {
+        CHECK((delivered = receiver.front(&length)) != NULL && length == 10 + i && delivered[0] == i);
+        receiver.release();
+    }
+    CHECK(!receiver.onData(frames[2], lengths[2]) && receiver.stats().duplicates == 1);
+
+    /* the probe has a tag of its own: its ACK gives a round trip and ends the back-off */
+    CHECK(sender.onAck(ack, sizeof(ack), 5000) && sender.idle() && !sender.awaitingAck());
+    CHECK(sender.stats().srttUs == 1000 && sender.stats().rtoUs == 2500);
+    CHECK(sender.onAck(ack, sizeof(ack), 5000) && sender.poll(6000, frame) == 0);
+
+    frames[0][1] = 8;
+    CHECK(!receiver.onData(frames[0], lengths[0]) && receiver.stats().outOfWindow == 1);
+    CHECK(receiver.stats().received == 4 && receiver.stats().delivered == 4);
+
+    /* the late ACK of the request before a probe acknowledges, but neither ends the wait nor times */
+    Spirit1ArqSender<4, 20> late(10000, 100, 100000);
+    Spirit1ArqReceiver<4, 20> peer;
+    uint8_t lateAck[SPIRIT1_ARQ_ACK_LENGTH], probeAck[SPIRIT1_ARQ_ACK_LENGTH];
+    CHECK(late.push(payload, 10) && (length = late.poll(0, frame)) == 12 && late.awaitingAck());
+    CHECK(peer.onData(frame, length) && peer.ack(lateAck));
+    CHECK(late.poll(10000, frame) == 12 && late.stats().timeouts == 1 && late.stats().rtoUs == 20000);
+    CHECK(peer.onData(frame, 12) && peer.ack(probeAck) && lateAck[0] != probeAck[0]);
+    CHECK(late.onAck(lateAck, sizeof(lateAck), 10500) && late.idle() && late.awaitingAck());
+    CHECK(late.stats().acked == 1 && late.stats().srttUs == 0 && late.stats().rtoUs == 20000);
+    CHECK(late.onAck(probeAck, sizeof(probeAck), 11000) && !late.awaitingAck());
+    CHECK(late.stats().srttUs == 1000 && late.stats().rtoUs == 3000);
+
+    /* nor does it time the next request */
+    CHECK(late.push(payload, 11) && late.poll(11000, frame) == 13 && late.awaitingAck());
+    CHECK(late.onAck(probeAck, sizeof(probeAck), 11800) && late.awaitingAck() && late.stats().srttUs == 1000);
+    CHECK(peer.onData(frame, 13) && peer.ack(ack) && late.onAck(ack, sizeof(ack), 12000) && late.idle());
+    CHECK(!late.awaitingAck() && late.stats().srttUs == 1000 && late.stats().acks == 4);
+}
+
+static void testAggregate() {
+    Spirit1Aggregator<32> aggregator(24, 1000);
+    uint8_t record[31], frame[32], length;
+    const uint8_t *read;
+    for (int i = 0; i < 31; i++) record[i] = (uint8_t) (i + 1);
+
+    /* 10 + 11 bytes, 12 more would pass maxBytes: the frame is due */
+    CHECK(!aggregator.add(record, 0, 0) && !aggregator.add(record, 32, 0) && aggregator.stats().rejected == 2);
+    CHECK(aggregator.add(record, 9, 100) && aggregator.add(record + 1, 10, 200) && !aggregator.due(1099));
+    CHECK(!aggregator.add(record, 11, 300) && aggregator.due(300) && aggregator.count() == 2);
+    CHECK(aggregator.take(frame) == 21 && aggregator.empty() && aggregator.take(frame) == 0);
+
+    Spirit1RecordReader reader(frame, 21);
+    CHECK((read = reader.next(&length)) != NULL && length == 9 && memcmp(read, record, 9) == 0);
+    CHECK((read = reader.next(&length)) != NULL && length == 10 && read[0] == 2);
+    CHECK(reader.next(&length) == NULL && !reader.malformed());
+
+    /* a lone record past maxBytes goes, a light load leaves at the deadline */
+    CHECK(aggregator.add(record, 31, 2000) && aggregator.due(2000) && aggregator.take(frame) == 32);
+    CHECK(aggregator.add(record, 4, 3000) && !aggregator.due(3999) && aggregator.due(4000));
+    CHECK(aggregator.deadlineUs() == 4000 && aggregator.take(frame) == 5);
+    CHECK(aggregator.stats().records == 4 && aggregator.stats().full == 2 && aggregator.stats().expired == 1);
+
+    /* a record running past the frame, and a zero length, stop the reader */
+    frame[0] = 5;
+    Spirit1RecordReader past(frame, 5);
+    CHECK(past.next(&length) == NULL && past.malformed());
+    frame[0] = 0;
+    Spirit1RecordReader zero(frame, 5);
+    CHECK(zero.next(&length) == NULL && zero.malformed());
+}
+
+/** serves the IRQs of the running stream, each one lateNs after nIRQ */
+static SpiritStreamResult runStream(uint64_t lateNs) {
+    SpiritStreamResult result = SPIRIT_STREAM_BUSY;
+    uint64_t end = chip().now() + 1000000000;
+    while (result == SPIRIT_STREAM_BUSY && chip().now() < end) {
+        if (!chip().irqPending()) {
+            chip().advance(10000);
+            continue;
+        }
+        chip().advance(lateNs);
+        SpiritIrqs irqs;
+        SpiritIrqGetStatus(&irqs);
+        result = SpiritStreamHandleIrqs(&irqs);
+    }
+    return result;
+}
+
+static void testStream() {
+    static uint8_t payload[1000], data[1000];
+    StreamInit levels = {SPIRIT_STREAM_TX_REFILL_LEVEL, SPIRIT_STREAM_RX_DRAIN_LEVEL};
+    SpiritStreamCounters counters;
+    uint64_t byteNs = chip().airtimeNs(1) - chip().airtimeNs(0);
+    for (int i = 0; i < 1000; i++) payload[i] = (uint8_t) (i * 7);
+
+    SpiritStreamInit(&levels);
+    SpiritStreamResetCounters();
+    SpiritPktBasicSetVarLengthWidth(sizeof(payload), S_ENABLE, PKT_CONTROL_LENGTH_0BYTES);
+
+    /* TX: refilled on almost empty */
+    SpiritPktBasicSetPayloadLength(sizeof(payload));
+    CHECK(SpiritStreamTxStart(payload, sizeof(payload)));
+    CHECK(!SpiritStreamTxStart(payload, sizeof(payload)));
+    CHECK(runStream(0) == SPIRIT_STREAM_DONE);
+    CHECK(chip().lastTransmitted().payload.size() == sizeof(payload));
+    CHECK(memcmp(&chip().lastTransmitted().payload[0], payload, sizeof(payload)) == 0);
+    SpiritStreamGetCounters(&counters);
+    CHECK(counters.lRefills == (1000 - 96 + 63) / 64);
+
+    /* TX underflow: the refill comes after the last 32 bytes are gone */
+    CHECK(SpiritStreamTxStart(payload, sizeof(payload)));
+    CHECK(runStream(40 * byteNs) == SPIRIT_STREAM_UNDERFLOW);
+    CHECK(SpiritLinearFifoReadNumElementsTxFifo() == 0);
+    SpiritRefreshStatus();
+    CHECK(g_xStatus.MC_STATE == MC_STATE_READY);
+
+    /* RX: drained on almost full and on data ready */
+    Spirit1SimFrame large = Spirit1SimFrame();
+    large.destination = 0x44;
+    large.crcOk = true;
+    large.payload.assign(payload, payload + sizeof(payload));
+    CHECK(SpiritStreamRxStart(data, sizeof(data)));
+    chip().advance(1000000);
+    chip().inject(large);
+    CHECK(runStream(0) == SPIRIT_STREAM_DONE);
+    CHECK(SpiritStreamGetLength() == sizeof(payload));
+    CHECK(memcmp(data, payload, sizeof(payload)) == 0);
+
+    /* RX buffer too short, then RX FIFO overflow */
+    CHECK(SpiritStreamRxStart(data, 500));
+    chip().advance(1000000);
+    chip().inject(large);
+    CHECK(runStream(0) == SPIRIT_STREAM_OVERFLOW);
+    CHECK(SpiritStreamRxStart(data, sizeof(data)));
+    chip().advance(1000000);
+    chip().inject(large);
+    CHECK(runStream(40 * byteNs) == SPIRIT_STREAM_OVERFLOW);
+    CHECK(SpiritLinearFifoReadNumElementsRxFifo() == 0);
+    SpiritRefreshStatus();
+    CHECK(g_xStatus.MC_STATE == MC_STATE_READY);
+    SpiritStreamGetCounters(&counters);
+    CHECK(counters.lUnderflows == 1 && counters.lOverflows == 2 && counters.lTxStreams == 2);
+
+    SpiritPktBasicSetVarLengthWidth(96, S_ENABLE, PKT_CONTROL_LENGTH_0BYTES);
+    SpiritIrqDeInit(NULL);
+    SpiritIrqClearStatus();
+}
+
+static void testRxTimeout() {
+    SpiritIrq(RX_TIMEOUT, S_ENABLE);
+    SpiritTimerSetRxTimeoutMs(10.0);
+    SpiritTimerSetRxTimeoutStopCondition(NO_TIMEOUT_STOP);
+    uint64_t start = chip().now();
+    SpiritCmdStrobeRx();
+    CHECK(waitIrq(RX_TIMEOUT, 100000000));
+    uint64_t elapsed = chip().now() - start;
+    CHECK(elapsed > 9000000 && elapsed < 11000000);
+    SpiritRefreshStatus();
+    CHECK(g_xStatus.MC_STATE == MC_STATE_READY);
+    SpiritTimerSetRxTimeoutCounter(0);
+    SpiritIrqDeInit(NULL);
+    SpiritIrqClearStatus();
+}
+
+/* |(counter + 1) * (prescaler + 1) * den - num|: the error of the registers in ticks, times den */
+static uint64_t timerError(uint8_t counter, uint8_t prescaler, uint64_t num, uint32_t den) {
+    uint64_t period = (uint64_t) (counter + 1) * (prescaler + 1) * den;
+    return period > num ? period - num : num - period;
+}
+
+/* targets from 1 us to 3.4 s: the error of the float search against the integer one, in ticks times den */
+static void timerAgainstFloat(bool rxTimeout, uint32_t xtal, int *worse, int *better) {
+    SpiritRadioSetXtalFrequency(xtal);
+    uint32_t clock = rxTimeout ? (xtal > DOUBLE_XTAL_THR ? xtal / 2 : xtal) : SpiritTimerGetRcoFrequency();
+    uint32_t den = rxTimeout ? 1210000000 : 1000000;
+
+    for (uint32_t us = 1; us <= 3400000; us += 13) {
+        uint8_t counter, prescaler, floatCounter, floatPrescaler;
+        if (rxTimeout) {
+            SpiritTimerComputeRxTimeoutValues(us / 1000.0f, &counter, &prescaler);
+            referenceRxTimeoutValues(xtal, us / 1000.0f, &floatCounter, &floatPrescaler);
+        } else {
+            SpiritTimerComputeWakeUpValues(us / 1000.0f, &counter, &prescaler);
+            referenceWakeUpValues((uint16_t) clock, us / 1000.0f, &floatCounter, &floatPrescaler);
+        }
+        uint64_t error = timerError(counter, prescaler, (uint64_t) us * clock, den);
+        uint64_t floatError = timerError(floatCounter, floatPrescaler, (uint64_t) us * clock, den);
+        *worse += error > floatError;
+        *better += error < floatError;
+    }
+}
+
+static void testTimerSearch() {
+    /* the periods of the registers from 1 to 255 (0 is the infinite RX timeout), and the closest ones */
+    static bool reached[65537];
+    static uint32_t below[66001], above[66002];
+    int mismatches = 0, worse = 0, better = 0;
+
+    for (uint32_t p = 2; p <= 256; p++) {
+        for (uint32_t c = 2; c <= 256; c++) reached[p * c] = true;
+    }
+    for (uint32_t t = 0; t <= 66000; t++) below[t] = t <= 65536 && reached[t] ? t : t ? below[t - 1] : 0;
+    above[66001] = 0;
+    for (uint32_t t = 66001; t-- > 0;) above[t] = t <= 65536 && reached[t] ? t : above[t + 1];
+
+    /* every target of whole, half and third ticks up to past the longest period */
+    for (uint32_t den = 1; den <= 3; den++) {
+        for (uint64_t num = 0; num <= (uint64_t) 66000 * den; num++) {
+            TimerValues values;
+            SpiritTimerSearchValues(num, den, &values);
+            uint32_t t = (uint32_t) (num / den);
+            uint64_t best = UINT64_MAX;
+            if (below[t]) best = num - (uint64_t) below[t] * den;
+            uint32_t up = t + (num % den != 0);
+            if (up <= 66000 && above[up]) {
+                uint64_t error = (uint64_t) above[up] * den - num;
+                if (error < best) best = error;
+            }
+            mismatches += values.cCounter == 0 || values.cPrescaler == 0 || values.cPrescaler > values.cCounter ||
+                          timerError(values.cCounter, values.cPrescaler, num, den) != best;
+        }
+    }
+    CHECK(mismatches == 0);
+
+    /* 7 * 59, and 2 * 207 of the pairs of 414, the smallest prescaler */
+    TimerValues values;
+    SpiritTimerSearchValues(413, 1, &values);
+    CHECK(values.cPrescaler == 6 && values.cCounter == 58);
+    SpiritTimerSearchValues(414, 1, &values);
+    CHECK(values.cPrescaler == 1 && values.cCounter == 206);
+
+    /* never farther than the float search, closer on part of the targets */
+    timerAgainstFloat(true, 24000000, &worse, &better);
+    timerAgainstFloat(true, 50000000, &worse, &better);
+    timerAgainstFloat(false, 52000000, &worse, &better);
+    timerAgainstFloat(false, 50000000, &worse, &better);
+    CHECK(worse == 0 && better > 0);
+
+    /* a table of timeouts: the single searches, the clock read once */
+    static const uint32_t timeouts[5] = {0, 500, 20000, 1000000, 4000000};
+    TimerValues table[5];
+    uint8_t counter, prescaler;
+    SpiritRadioSetXtalFrequency(50000000);
+    chip().resetStats();
+    SpiritTimerComputeWakeUpTable(timeouts, 5, table);
+    CHECK(chip().stats().transactions <= 1);
+    for (int i = 0; i < 5; i++) {
+        SpiritTimerComputeWakeUpValuesUs(timeouts[i], &counter, &prescaler);
+        CHECK(table[i].cCounter == counter && table[i].cPrescaler == prescaler);
+    }
+    chip().resetStats();
+    SpiritTimerComputeRxTimeoutTable(timeouts, 5, table);
+    CHECK(chip().stats().transactions == 0);
+    for (int i = 0; i < 5; i++) {
+        SpiritTimerComputeRxTimeoutValuesUs(timeouts[i], &counter, &prescaler);
+        CHECK(table[i].cCounter == counter && table[i].cPrescaler == prescaler);
+    }
+    CHECK(table[0].cCounter == 1 && table[0].cPrescaler == 1);
+    CHECK(table[4].cCounter == 255 && table[4].cPrescaler == 255);
+
+    /* 20 ms at 25 MHz: 413.2 ticks of 48.4 us, 7 * 59 */
+    SpiritTimerSetRxTimeoutUs(20000);
+    CHECK(chip().peek(TIMERS5_RX_TIMEOUT_PRESCALER_BASE) == table[2].cPrescaler);
+    CHECK(chip().peek(TIMERS4_RX_TIMEOUT_COUNTER_BASE) == table[2].cCounter);
+    CHECK(timerError(table[2].cCounter, table[2].cPrescaler, (uint64_t) 20000 * 25000000, 1210000000) <
+          1210000000 / 2);
+    SpiritTimerSetRxTimeoutCounter(0);
+}
+
+static void testCsma() {
+    CsmaInit csma = {S_DISABLE, TBIT_TIME_64, TCCA_TIME_3, 3, 1, 1};
+    uint8_t payload[4] = {1, 2, 3, 4};
+
+    SpiritCsmaInit(&csma);
+    SpiritCsma(S_ENABLE);
+    SpiritQiSetRssiThresholddBm(-90);
+    SpiritIrq(MAX_BO_CCA_REACH, S_ENABLE);
+    SpiritIrq(TX_DATA_SENT, S_ENABLE);
+    SpiritPktBasicSetPayloadLength(sizeof(payload));
+    SpiritCmdStrobeFlushTxFifo();
+    SpiritSpiWriteLinearFifo(sizeof(payload), payload);
+
+    chip().setChannelDbm(-60);
+    SpiritCmdStrobeTx();
+    CHECK(waitIrq(MAX_BO_CCA_REACH | TX_DATA_SENT, 100000000));
+    CHECK(SpiritIrqCheckFlag(MAX_BO_CCA_REACH));
+
+    chip().setChannelDbm(-120);
+    SpiritCmdStrobeTx();
+    CHECK(waitIrq(MAX_BO_CCA_REACH | TX_DATA_SENT, 100000000));
+    CHECK(SpiritIrqCheckFlag(TX_DATA_SENT));
+    SpiritCsma(S_DISABLE);
+    SpiritIrqDeInit(NULL);
+    SpiritIrqClearStatus();
+}
+
+static void testAes() {
+    uint8_t key[16], in[16], encrypted[16], out[16];
+    for (int i = 0; i < 16; i++) {
+        key[i] = (uint8_t) (0x10 * i + 3);
+        in[i] = (uint8_t) i;
+    }
+
+    SpiritIrq(AES_END, S_ENABLE);
+    SpiritAesMode(S_ENABLE);
+    SpiritAesWriteKey(key);
+    SpiritAesWriteDataIn(in, 16);
+    SpiritAesExecuteEncryption();
+    CHECK(waitIrq(AES_END, 1000000));
+    SpiritIrqClearStatus();
+    SpiritAesReadDataOut(encrypted, 16);
+    CHECK(memcmp(encrypted, in, 16) != 0);
+
+    SpiritAesWriteDataIn(encrypted, 16);
+    SpiritAesDeriveDecKeyExecuteDec();
+    CHECK(waitIrq(AES_END, 1000000));
+    SpiritAesReadDataOut(out, 16);
+    CHECK(memcmp(out, in, 16) == 0);
+    SpiritAesMode(S_DISABLE);
+    SpiritIrqDeInit(NULL);
+    SpiritIrqClearStatus();
+}
+
+static void testGpio() {
+    SGpioInit irqOutput = {SPIRIT_GPIO_3, SPIRIT_GPIO_MODE_DIGITAL_OUTPUT_LP, SPIRIT_GPIO_DIG_OUT_IRQ};
+    SGpioInit readyOutput = {SPIRIT_GPIO_2, SPIRIT_GPIO_MODE_DIGITAL_OUTPUT_LP, SPIRIT_GPIO_DIG_OUT_READY};
+
+    SpiritGpioInit(&irqOutput);
+    SpiritGpioInit(&readyOutput);
+    CHECK(chip().gpio() & (1 << 3));
+    CHECK(chip().gpio() & (1 << 2));
+
+    SpiritIrq(TX_FIFO_ALMOST_FULL, S_ENABLE);
+    /* counted from the top: raised by the first byte */
+    SpiritLinearFifoSetAlmostFullThresholdTx(95);
+    uint8_t value = 0;
+    SpiritSpiWriteLinearFifo(1, &value);
+    /* nIRQ is active low */
+    CHECK(!(chip().gpio() & (1 << 3)));
+    SpiritIrqClearStatus();
+    CHECK(chip().gpio() & (1 << 3));
+
+    SpiritCmdStrobeStandby();
+    CHECK(!(chip().gpio() & (1 << 2)));
+    SpiritCmdStrobeReady();
+    chip().advance(chip().timing().standbyToReadyNs);
+    CHECK(chip().gpio() & (1 << 2));
+    SpiritCmdStrobeFlushTxFifo();
+    SpiritIrqDeInit(NULL);
+}
+
+static void testCounters() {
+    uint8_t data[8];
+
+    chip().resetStats();
+    SpiritSpiReadRegisters(LINK_QUALIF2_BASE, 4, data);
+    SpiritSpiCommandStrobes(COMMAND_FLUSHRXFIFO);
+    const Spirit1SimStats &stats = chip().stats();
+    CHECK(stats.transactions == 2);
+    CHECK(stats.reads == 1);
+    CHECK(stats.commands == 1);
+    CHECK(stats.bytes == 2 + 4 + 2);
+}
+
+static void testSpiClock() {
+    SpiClockInit init = {1000000, 10000000, 1000000, 1, 8};
+    uint8_t key[16], sync[4];
+    SpiritSpiClockCounters counters;
+
+    radioInit();
+    for (int i = 0; i < 16; i++) key[i] = chip().peek((uint8_t) (AES_KEY_IN_15_BASE + i));
+    for (int i = 0; i < 4; i++) sync[i] = chip().peek((uint8_t) (SYNC4_BASE + i));
+
+    /* errors from 5.4 MHz, frequent above 6 MHz: 5 or 6 MHz clean, one step of margin */
+    chip().setSpiLimit(6000000);
+    SpiritSpiClockResetCounters();
+    uint32_t hz = SpiritSpiClockCalibrate(&init);
+    CHECK(hz == SpiritSpiClockGet() && hz >= 4000000 && hz <= 5000000);
+    SpiritSpiClockGetCounters(&counters);
+    CHECK(counters.lErrors == 1 && counters.lDegrades == 0);
+    for (int i = 0; i < 16; i++) CHECK(chip().peek((uint8_t) (AES_KEY_IN_15_BASE + i)) == key[i]);
+    for (int i = 0; i < 4; i++) CHECK(chip().peek((uint8_t) (SYNC4_BASE + i)) == sync[i]);
+
+    /* the saved rate is taken back as it is */
+    CHECK(SpiritSpiClockRestore(hz, &init) == S_TRUE && SpiritSpiClockGet() == hz);
+
+    /* the bus gets worse: the check steps down to a clean rate */
+    chip().setSpiLimit(3000000);
+    CHECK(SpiritSpiClockCheck() == S_FALSE);
+    CHECK(SpiritSpiClockGet() <= 2000000);
+    CHECK(SpiritSpiClockCheck() == S_TRUE);
+    for (int i = 0; i < 4; i++) CHECK(chip().peek((uint8_t) (SYNC4_BASE + i)) == sync[i]);
+
+    /* not even the lowest rate */
+    chip().setSpiLimit(500000);
+    CHECK(SpiritSpiClockCalibrate(&init) == 0 && SpiritSpiClockGet() == 1000000);
+
+    chip().setSpiLimit(0);
+    standInBus().setFrequency(0);
+}
+
+static void testContexts() {
+    Spirit1Sim a, b;
+    SpiritContext contextA, contextB;
+
+    /* one chip per context; the shadow of each context follows its own chip */
+    SpiritContextInit(&contextA, 0);
+    SpiritContextInit(&contextB, 1);
+    SpiritContextBind(&contextA);
+    CHECK(SpiritContextGet() == &contextA && SpiritContextGetBus() == 0);
+    standInBus().use(&a);
+    radioInit();
+    SpiritContextBind(&contextB);
+    CHECK(SpiritContextGetBus() == 1);
+    standInBus().use(&b);
+    radioInit();
+    SpiritRadioSetXtalFrequency(52000000);
+    SpiritRadioSetDatarate(100000);
+    SpiritPktCommonSetMyAddress(0x45);
+
+    SpiritContextBind(&contextA);
+    standInBus().use(&a);
+    CHECK(SpiritRadioGetXtalFrequency() == 50000000);
+    CHECK(SpiritPktCommonGetMyAddress() == 0x44);
+    CHECK(SpiritRadioGetDatarate() == a.datarate() && a.datarate() < 40000);
+    SpiritContextBind(&contextB);
+    standInBus().use(&b);
+    CHECK(SpiritRadioGetXtalFrequency() == 52000000);
+    CHECK(SpiritPktCommonGetMyAddress() == 0x45);
+    CHECK(a.peek(PCKT_FLT_GOALS_TX_ADDR_BASE) == 0x44 && b.peek(PCKT_FLT_GOALS_TX_ADDR_BASE) == 0x45);
+
+    /* the default context is untouched */
+    SpiritContextBind(NULL);
+    CHECK(SpiritContextGet() != &contextA && SpiritContextGet() != &contextB);
+    CHECK(SpiritContextGetBus() == 0);
+    standInBus().use(NULL);
+}
+
+static void sendFrom(Spirit1Sim &radio, uint8_t destination, uint8_t length) {
+    uint8_t payload[96];
+    for (uint8_t i = 0; i < length; i++) payload[i] = (uint8_t) (i * 3);
+    standInBus().use(&radio);
+    SpiritPktBasicSetPayloadLength(length);
+    SpiritPktCommonSetDestinationAddress(destination);
+    SpiritSpiWriteLinearFifo(length, payload);
+    SpiritCmdStrobeTx();
+}
+
+static void testMedium() {
+    Spirit1SimClock clock;
+    Spirit1Sim a(&clock), b(&clock), c(&clock);
+    Spirit1Medium medium;
+    Spirit1Sim *radios[] = {&a, &b, &c};
+
+    for (int i = 0; i < 3; i++) {
+        medium.attach(*radios[i]);
+        standInBus().use(radios[i]);
+        radioInit();
+        SpiritIrq(RX_DATA_READY, S_ENABLE);
+        SpiritIrq(RX_DATA_DISC, S_ENABLE);
+        SpiritIrq(CRC_ERROR, S_ENABLE);
+    }
+    SpiritPktCommonSetMyAddress(0x45);
+    medium.setRssi(0, 1, -75);
+
+    /* a to b, received with the timing of the packet engine */
+    standInBus().use(&b);
+    SpiritCmdStrobeRx();
+    standInBus().use(&c);
+    SpiritCmdStrobeRx();
+    clock.advance(1000000);
+    uint64_t start = clock.now();
+    sendFrom(a, 0x44, 30);
+    while (!b.irqPending() && clock.now() - start < 100000000) clock.advance(10000);
+    CHECK(pendingIrqs(b) & RX_DATA_READY);
+    CHECK(clock.now() - start >= a.airtimeNs(30));
+    CHECK(b.rxFifoLevel() == 30);
+    CHECK(b.peek(RSSI_LEVEL_BASE) == (-75 + 130) * 2);
+    /* c heard it and filtered it */
+    CHECK(pendingIrqs(c) & RX_DATA_DISC);
+    CHECK(medium.stats().transmissions == 1 && medium.stats().receptions == 2);
+
+    /* b and c at the same time: a receives one of them damaged */
+    standInBus().use(&a);
+    SpiritIrqClearStatus();
+    SpiritCmdStrobeRx();
+    standInBus().use(&b);
+    SpiritCmdStrobeFlushRxFifo();
+    SpiritIrqClearStatus();
+    clock.advance(1000000);
+    sendFrom(b, 0x44, 10);
+    sendFrom(c, 0x44, 10);
+    clock.advance(2 * a.airtimeNs(10));
+    CHECK(pendingIrqs(a) & CRC_ERROR);
+    CHECK(a.stats().framesMissed == 1);
+    CHECK(medium.stats().collisions == 1);
+
+    /* loss */
+    medium.setLossRate(1.0);
+    standInBus().use(&a);
+    SpiritIrqClearStatus();
+    SpiritCmdStrobeRx();
+    clock.advance(1000000);
+    sendFrom(b, 0x44, 10);
+    clock.advance(2 * a.airtimeNs(10));
+    CHECK(pendingIrqs(a) & RX_DATA_DISC);
+    CHECK(medium.stats().losses > 0);
+    medium.setLossRate(0.0);
+
+    /* another channel is not heard */
+    standInBus().use(&a);
+    SpiritIrqClearStatus();
+    SpiritRadioSetChannel(3);
+    SpiritCmdStrobeRx();
+    clock.advance(1000000);
+    uint32_t unheard = medium.stats().unheard;
+    sendFrom(b, 0x44, 10);
+    clock.advance(2 * a.airtimeNs(10));
+    CHECK(!a.irqPending());
+    CHECK(medium.stats().unheard == unheard + 1);
+
+    standInBus().use(NULL);
+}
+
+int main() {
+    testInit();
+    testShadow();
+    testBatch();
+    testFixedPoint();
+    testRegisterImage();
+    testWarmBoot();
+    testProfileSwitch();
+    testPaCurve();
+    testStates();
+    testWait();
+    testFifo();
+    testTx();
+    testDeferredIrq();
+    testTxQueue();
+    testRx();
+    testRxRing();
+    testBufferPool();
+    testFragment();
+    testArq();
+    testAggregate();
+    testStream();
+    testRxTimeout();
+    testTimerSearch();
+    testCsma();
+    testAes();
+    testGpio();
+    testCounters();
+    testSpiClock();
+    testContexts();
+    testMedium();
+
+    if (failures) printf("%d failure(s)\r\n", failures);
+    else printf("OK\r\n");
+    return failures ? 1 : 0;
+}
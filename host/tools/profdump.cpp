@@ -0,0 +1,130 @@
+/**
+ * Prints a SPIRIT1 profile dump (spirit1Profile.h) as a table, with the
+ * function names taken from the symbols of the program that wrote it.
+ *
+ *   spirit1-profdump <dump> [symbols]
+ *
+ * dump:    the binary image, or a console log with the "PROF <hex>" lines of
+ *          spirit1ProfileDump()
+ * symbols: nm output of the firmware ELF, e.g. arm-none-eabi-nm firmware.elf
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "spirit1Profile.h"
+
+static std::map<uint64_t, std::string> symbols;
+
+static const char *symbolName(uint64_t function, void *) {
+    std::map<uint64_t, std::string>::const_iterator symbol = symbols.find(function);
+    /* Thumb function pointers have bit 0 set */
+    if (symbol == symbols.end()) symbol = symbols.find(function & ~(uint64_t) 1);
+    return symbol == symbols.end() ? NULL : symbol->second.c_str();
+}
+
+static bool loadSymbols(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) return false;
+    char line[512], name[400];
+    unsigned long long address;
+    char type;
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "%llx %c %399s", &address, &type, name) != 3) continue;
+        if (type == 'T' || type == 't' || type == 'W' || type == 'w') symbols[address] = name;
+    }
+    fclose(file);
+    return true;
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/* the raw image, or the bytes of the PROF lines of a log */
+static bool loadDump(const char *path, std::vector<uint8_t> &image) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+    std::vector<uint8_t> content;
+    int c;
+    while ((c = fgetc(file)) != EOF) content.push_back((uint8_t) c);
+    fclose(file);
+
+    if (content.size() >= 4 && memcmp(&content[0], SPIRIT1_PROFILE_MAGIC, 4) == 0) {
+        image = content;
+        return true;
+    }
+    std::string text(content.begin(), content.end());
+    size_t position = 0;
+    while ((position = text.find("PROF ", position)) != std::string::npos) {
+        position += 5;
+        while (position + 1 < text.size() && hexValue(text[position]) >= 0 && hexValue(text[position + 1]) >= 0) {
+            image.push_back((uint8_t) (hexValue(text[position]) << 4 | hexValue(text[position + 1])));
+            position += 2;
+        }
+    }
+    return true;
+}
+
+static uint64_t get(const uint8_t *p, int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) value = value << 8 | p[i];
+    return value;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <dump> [symbols]\n", argv[0]);
+        return 2;
+    }
+    std::vector<uint8_t> image;
+    if (!loadDump(argv[1], image)) {
+        perror(argv[1]);
+        return 1;
+    }
+    if (argc > 2 && !loadSymbols(argv[2])) {
+        perror(argv[2]);
+        return 1;
+    }
+    if (image.size() < 8 || memcmp(&image[0], SPIRIT1_PROFILE_MAGIC, 4) != 0 ||
+        image[4] != SPIRIT1_PROFILE_VERSION) {
+        fprintf(stderr, "%s: not a SPIRIT1 profile dump\n", argv[1]);
+        return 1;
+    }
+    size_t count = (size_t) get(&image[6], 2);
+    if (image.size() < 8 + 28 * count) {
+        fprintf(stderr, "%s: truncated, %u of %u records\n", argv[1],
+                (unsigned) ((image.size() - 8) / 28), (unsigned) count);
+        count = (image.size() - 8) / 28;
+    }
+
+    std::vector<Spirit1ProfileEntry> entries;
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *p = &image[8 + 28 * i];
+        Spirit1ProfileEntry entry;
+        entry.function = get(p, 8);
+        entry.calls = (uint32_t) get(p + 8, 4);
+        entry.transactions = (uint32_t) get(p + 12, 4);
+        entry.selfTransactions = (uint32_t) get(p + 16, 4);
+        entry.bytes = (uint32_t) get(p + 20, 4);
+        entry.timeUs = (uint32_t) get(p + 24, 4);
+        /* most transactions first */
+        size_t j = entries.size();
+        entries.push_back(entry);
+        while (j && entries[j - 1].transactions < entry.transactions) {
+            entries[j] = entries[j - 1];
+            j--;
+        }
+        entries[j] = entry;
+    }
+
+    printf("%u-bit target, %u functions\r\n", (unsigned) image[5] * 8, (unsigned) entries.size());
+    spirit1ProfilePrint(entries.empty() ? NULL : &entries[0], entries.size(), symbolName, NULL);
+    return 0;
+}
@@ -0,0 +1,54 @@
+/**
+ * Dumps the SPIRIT1 registers after a reset and after the base configuration,
+ * over Linux spidev: the host counterpart of TESTS/reg/readRegValues.
+ *
+ *   spirit1-regdump [device] [spi frequency in Hz] [SDN sysfs GPIO]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SPIRIT_Config.h"
+#include "spirit1Transport.h"
+#include "spidevBus.h"
+
+extern "C" void SpiritBaseConfiguration(void);
+
+static const char *device = "/dev/spidev0.0";
+static uint32_t frequency = 5000000;
+static int shutdownGpio = -1;
+
+static SpidevBus &spidevBus() {
+    static SpidevBus bus(device, frequency, shutdownGpio);
+    return bus;
+}
+
+static Spirit1Transport<SpidevBus> &spidevSpi() {
+    static Spirit1Transport<SpidevBus> spi(spidevBus());
+    return spi;
+}
+
+SPIRIT1_TRANSPORT(spidevSpi())
+
+int main(int argc, char **argv) {
+    if (argc > 1) device = argv[1];
+    if (argc > 2) frequency = (uint32_t) strtoul(argv[2], NULL, 0);
+    if (argc > 3) shutdownGpio = atoi(argv[3]);
+
+    if (!spidevBus().isOpen()) {
+        perror(device);
+        return 1;
+    }
+
+    SpiritExitShutdown();
+
+    uint8_t regs[0xf2];
+    SpiritSpiCommandStrobes(COMMAND_SRES);
+    SpiritSpiReadRegisters(0x00, 0xf2, regs);
+    spirit1TraceHexDump("RESET", regs, 0xf2);
+
+    SpiritBaseConfiguration();
+    SpiritSpiReadRegisters(0x00, 0xf2, regs);
+    spirit1TraceHexDump("CONFI", regs, 0xf2);
+
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include <stdint.h>
 #include "MCU_Interface.h"
+#include "SPIRIT_Wait.h"
 
 //uint16_t SpiritSpiWriteRegisters(uint8_t address, uint8_t n_regs, uint8_t *buffer);
 //uint16_t SpiritSpiReadRegisters(uint8_t address, uint8_t n_regs, uint8_t *buffer);
@@ -60,6 +61,11 @@ void SpiritBaseConfiguration(void) {
     tmp[0] = 0x00;
     SpiritSpiWriteRegisters(0xA8, 1, tmp);
 
+#ifdef SPIRIT_USE_WRITE_BATCH
+    /* the configuration below is sent as a few bursts of contiguous registers */
+    SpiritBatchBegin();
+#endif
+
     tmp[0] = 0xA3; /* reg. GPIO3_CONF (0x02) */
     SpiritSpiWriteRegisters(0x02, 1, tmp);
     tmp[0] = 0x36; /* reg. IF_OFFSET_ANA (0x07) */
@@ -119,6 +125,9 @@ void SpiritBaseConfiguration(void) {
     tmp[0] = 0x22;
     SpiritSpiWriteRegisters(0xBC, 1, tmp);
 
+#ifdef SPIRIT_USE_WRITE_BATCH
+    SpiritBatchFlush();
+#endif
 }
 
 /* This is a VCO calibration routine used to recalibrate the VCO of SPIRIT1 in a safe way.
@@ -126,7 +135,6 @@ void SpiritBaseConfiguration(void) {
 void SpiritVcoCalibration(void) {
     uint8_t tmp[4];
     uint8_t cal_words[2];
-    uint8_t state;
 
 
     SpiritSpiReadRegisters(0x9E, 1, tmp);
@@ -149,26 +157,19 @@ void SpiritVcoCalibration(void) {
     SpiritSpiWriteRegisters(0x50, 1, tmp); /* enable VCO calibration (to be restored) */
 
     SpiritSpiCommandStrobes(COMMAND_LOCKTX);
-    do {
-        SpiritSpiReadRegisters(0xC1, 1, &state);
-    } while ((state & 0xFE) != 0x1E); /* wait until LOCK (MC_STATE = 0x0F <<1) */
+    /* on a timeout the calibration word read is meaningless, the settings are restored anyway */
+    SpiritWaitState(MC_STATE_LOCK, SPIRIT_WAIT_LOCK_TIMEOUT_US);
     SpiritSpiReadRegisters(0xE5, 1, &cal_words[0]); /* calib out word for TX */
 
     SpiritSpiCommandStrobes(COMMAND_READY);
-    do {
-        SpiritSpiReadRegisters(0xC1, 1, &state);
-    } while ((state & 0xFE) != 0x06); /* wait until READY (MC_STATE = 0x03 <<1) */
+    SpiritWaitState(MC_STATE_READY, SPIRIT_WAIT_STATE_TIMEOUT_US);
 
     SpiritSpiCommandStrobes(COMMAND_LOCKRX);
-    do {
-        SpiritSpiReadRegisters(0xC1, 1, &state);
-    } while ((state & 0xFE) != 0x1E); /* wait until LOCK (MC_STATE = 0x0F <<1) */
+    SpiritWaitState(MC_STATE_LOCK, SPIRIT_WAIT_LOCK_TIMEOUT_US);
     SpiritSpiReadRegisters(0xE5, 1, &cal_words[1]); /* calib out word for RX */
 
     SpiritSpiCommandStrobes(COMMAND_READY);
-    do {
-        SpiritSpiReadRegisters(0xC1, 1, &state);
-    } while ((state & 0xFE) != 0x06); /* wait until READY (MC_STATE = 0x03 <<1) */
+    SpiritWaitState(MC_STATE_READY, SPIRIT_WAIT_STATE_TIMEOUT_US);
 
     SpiritSpiReadRegisters(0x50, 1, tmp);
     tmp[0] &= 0xFD;
@@ -4,32 +4,28 @@
 #include "mbed.h"
 
 #include "spirit1Driver.h"
+#include "spirit1Board.h"
+#include "spirit1Irq.h"
+#include "spirit1RxRing.h"
+#include "spirit1BufferPool.h"
+#include "spirit1TxQueue.h"
+#include "spirit1Profile.h"
+#include "spirit1PaCurve.h"
 
 #define ENABLETX 0  // Puts the device in TX mode
+#define POWER_DBM10 110  // TX power, 10ths of dBm
 #define ENABLERX 1  // Puts the device in RX mode
 
-// hardware ssel (where applicable)
-SPI spirit1(PTB22, PTB23, PTB21); // mosi, miso, sclk, ssel
-DigitalOut spirit1ChipSelect(PTB20);
-DigitalOut spirit1Shutdown(PTA18);
 InterruptIn spiritInterrupt(PTC11);
 
 DigitalOut    led1(LED1);
 
-void dbg_dump(const char *prefix, const uint8_t *b, size_t size) {
-    for (int i = 0; i < size; i += 16) {
-        if (prefix && strlen(prefix) > 0) printf("%s %06x: ", prefix, i);
-        for (int j = 0; j < 16; j++) {
-            if ((i + j) < size) printf("%02x", b[i + j]); else printf("  ");
-            if ((j + 1) % 2 == 0) putchar(' ');
-        }
-        putchar(' ');
-        for (int j = 0; j < 16 && (i + j) < size; j++) {
-            putchar(b[i + j] >= 0x20 && b[i + j] <= 0x7E ? b[i + j] : '.');
-        }
-        printf("\r\n");
-    }
-}
+// SPIRIT1 interrupts are handled by the radio thread, the ISR only signals it:
+// a signal flag cannot run out like the slots of an event queue
+#define RADIO_SIGNAL_IRQ 0x1  // nIRQ edge, run the bottom half
+#define RADIO_SIGNAL_TX 0x2   // frames queued, start the TX queue
+Thread radioThread(osPriorityRealtime);
+Spirit1DeferredIrq spirit1Irq;
 
 extern "C" {
 
@@ -46,152 +42,61 @@ extern "C" {
 #define    COMMAND_FLUSHRXFIFO                                 ((uint8_t)(0x71)) /*!< Clean the RX FIFO; valid from all states */
 #define    COMMAND_FLUSHTXFIFO                                 ((uint8_t)(0x72)) /*!< Clean the TX FIFO; valid from all states */
 
-#define HEADER_WRITE_MASK     0x00 /*!< Write mask for header byte*/
-#define HEADER_READ_MASK      0x01 /*!< Read mask for header byte*/
-#define HEADER_ADDRESS_MASK   0x00 /*!< Address mask for header byte*/
-#define HEADER_COMMAND_MASK   0x80 /*!< Command mask for header byte*/
-
-#define LINEAR_FIFO_ADDRESS 0xFF  /*!< Linear FIFO address*/
-
-#define BUILT_HEADER(add_comm, w_r) (add_comm | w_r)  /*!< macro to build the header byte*/
-#define WRITE_HEADER    BUILT_HEADER(HEADER_ADDRESS_MASK, HEADER_WRITE_MASK) /*!< macro to build the write header byte*/
-#define READ_HEADER     BUILT_HEADER(HEADER_ADDRESS_MASK, HEADER_READ_MASK)  /*!< macro to build the read header byte*/
-#define COMMAND_HEADER  BUILT_HEADER(HEADER_COMMAND_MASK, HEADER_WRITE_MASK) /*!< macro to build the command header byte*/
-
 void SpiritBaseConfiguration(void);
 void SpiritVcoCalibration(void);
-
-StatusBytes RadioSpiWriteRegisters(uint8_t address, uint8_t n_regs, uint8_t *buffer) {
-    static uint16_t tmpstatus;
-
-    StatusBytes *status = (StatusBytes *) &tmpstatus;
-
-    spirit1.lock();
-    spirit1ChipSelect = 0;
-
-    tmpstatus = (uint16_t) (spirit1.write(WRITE_HEADER) << 8 | spirit1.write(address));
-
-//    printf("WRTE %04x=%x (%d)\r\n", address, status, n_regs);
-    uint8_t response[n_regs];
-    for (int i = 0; i < n_regs; i++) response[i] = (uint8_t) spirit1.write(buffer[i]);
-    dbg_dump("WRTE", response, n_regs);
-
-    spirit1ChipSelect = 1;
-    spirit1.unlock();
-
-    return *status;
-}
-
-StatusBytes RadioSpiReadRegisters(uint8_t address, uint8_t n_regs, uint8_t *buffer) {
-    static uint16_t tmpstatus;
-
-    StatusBytes *status = (StatusBytes *) &tmpstatus;
-    spirit1.lock();
-    spirit1ChipSelect = 0;
-
-    tmpstatus = (uint16_t) (spirit1.write(READ_HEADER) << 8 | spirit1.write(address));
-
-//    printf("READ %04x=%x (%d)\r\n", address, status, n_regs);
-    for (int i = 0; i < n_regs; i++) buffer[i] = (uint8_t) spirit1.write(0);
-//    dbg_dump("READ", buffer, n_regs);
-
-    spirit1ChipSelect = 1;
-    spirit1.unlock();
-
-    return *status;
-
-}
-
-StatusBytes RadioSpiCommandStrobes(uint8_t cmd_code) {
-    static uint16_t tmpstatus;
-
-    StatusBytes *status = (StatusBytes *) &tmpstatus;
-
-    spirit1.lock();
-    spirit1ChipSelect = 0;
-
-    tmpstatus = (uint16_t) (spirit1.write(COMMAND_HEADER) << 8 | spirit1.write(cmd_code));
-
-    spirit1ChipSelect = 1;
-    spirit1.unlock();
-
-    return *status;
-}
-
-StatusBytes RadioSpiWriteFifo(uint8_t n_regs, uint8_t *buffer) {
-
-    static uint16_t tmpstatus;
-
-    StatusBytes *status = (StatusBytes *) &tmpstatus;
-
-    spirit1.lock();
-    spirit1ChipSelect = 0;
-
-    tmpstatus = (uint16_t) (spirit1.write(WRITE_HEADER) << 8 | spirit1.write(LINEAR_FIFO_ADDRESS));
-
-//    printf("WRTE %04x=%x (%d)\r\n", address, status, n_regs);
-    uint8_t response[n_regs];
-    for (int i = 0; i < n_regs; i++) response[i] = (uint8_t) spirit1.write(buffer[i]);
-    dbg_dump("WRITE", response, n_regs);
-
-    spirit1ChipSelect = 1;
-    spirit1.unlock();
-
-    return *status;
-}
-
-StatusBytes RadioSpiReadFifo(uint8_t n_regs, uint8_t *buffer) {
-    static uint16_t tmpstatus;
-
-    StatusBytes *status = (StatusBytes *) &tmpstatus;
-
-    spirit1.lock();
-    spirit1ChipSelect = 0;
-
-    tmpstatus = (uint16_t) (spirit1.write(READ_HEADER) << 8 | spirit1.write(LINEAR_FIFO_ADDRESS));
-
-    printf("READ %04x=%x (%d)\r\n", LINEAR_FIFO_ADDRESS, status, n_regs);
-    for (int i = 0; i < n_regs; i++) buffer[i] = (uint8_t) spirit1.write(0);
-    dbg_dump("READ", buffer, n_regs);
-
-    spirit1ChipSelect = 1;
-    spirit1.unlock();
-
-    return *status;
-}
 }
 
 void led_thread(void const *args) {
     while (true) {
         led1 = !led1;
         Thread::wait(1000);
+
+        const Spirit1IrqStats &irq = spirit1Irq.stats();
+        if (irq.handled) {
+            printf("IRQ: %lu edges, %lu handled, %lu lost, latency %lu us avg %lu us max, ISR %lu us max\r\n",
+                   (unsigned long) irq.edges, (unsigned long) irq.handled, (unsigned long) irq.lost,
+                   (unsigned long) (irq.latencySumUs / irq.handled), (unsigned long) irq.latencyMaxUs,
+                   (unsigned long) irq.isrMaxUs);
+        }
     }
 }
 
 osThreadDef(led_thread, osPriorityNormal, DEFAULT_STACK_SIZE);
 
-uint8_t vectcRxBuff[96], cRxData;
+// packet buffers of both directions, passed by pointer
+Spirit1BufferPool<24, SPIRIT1_RX_PAYLOAD_MAX> radioPool;
+
+// received packets, from the radio thread to the main loop
+Spirit1RxRing<16, Spirit1Buffer *> rxRing;
+
+// frames to send, from the main loop to the radio thread
+Spirit1TxQueue<8> txQueue;
+volatile uint32_t txSent;
+uint32_t txStartLost;
 
+// the PA curve of the band, bound after the base configuration; a power change is one register write
+Spirit1Pa radioPa(spirit1PaCurves[SPIRIT1_PA_BAND_868]);
+
+// TX completion, runs on the radio thread
+void txDone(void *, bool sent) {
+    if (sent) txSent = txSent + 1;
+}
+
+// bottom half, runs on the radio thread
 void STxIRQH() {
+    uint32_t now = us_ticker_read();
+    spirit1Irq.begin(now);
+
     /* Get the IRQ status */
     SpiritIrqGetStatus(&xIrqStatus);
-    printf("In IRQ Handler: %d\r\n", xIrqStatus.IRQ_RX_DATA_READY);
-
-#ifdef ENABLETX
-    /* Check the SPIRIT TX_DATA_SENT IRQ flag */
-    if (xIrqStatus.IRQ_TX_DATA_SENT) {
-        /* set the tx_done_flag to manage the event in the main() */
-        xTxDoneFlag = 1;
-        printf("xTxDoneFlag \r\n");
-    }
+
+#if ENABLETX
+    /* TX_DATA_SENT: the preloaded frame goes out at once; TX FIFO almost empty: preload */
+    txQueue.handleIrqs(xIrqStatus);
 #endif
 
 #ifdef ENABLERX
     if (xIrqStatus.IRQ_RX_DATA_DISC) {
-        printf("discard\r\n");
-
-        SpiritSpiReadLinearFifo(cRxData, vectcRxBuff);
-
         /* Flush the RX FIFO */
         SpiritCmdStrobeFlushRxFifo();
 
@@ -201,12 +106,8 @@ void STxIRQH() {
 
     /* Check the SPIRIT RX_DATA_READY IRQ flag */
     if (xIrqStatus.IRQ_RX_DATA_READY) {
-        /* Get the RX FIFO size */
-        cRxData = SpiritLinearFifoReadNumElementsRxFifo();
-
-        printf("read from fifo\r\n");
-        /* Read the RX FIFO */
-        SpiritSpiReadLinearFifo(cRxData, vectcRxBuff);
+        /* Queue the packet, stamped with the nIRQ edge; dropped if the main loop is behind */
+        spirit1RxReceive(rxRing, radioPool, now - spirit1Irq.stats().latencyLastUs);
 
         /* Flush the RX FIFO */
         SpiritCmdStrobeFlushRxFifo();
@@ -218,6 +119,25 @@ void STxIRQH() {
     SpiritIrqClearStatus();
 }
 
+// top half: stamp the edge and hand over to the radio thread
+void STxISR() {
+    uint32_t now = us_ticker_read();
+    if (spirit1Irq.edge(now) && radioThread.signal_set(RADIO_SIGNAL_IRQ) < 0) spirit1Irq.cancel();
+    spirit1Irq.edgeDone(now, us_ticker_read());
+}
+
+// the radio thread: the bottom half first, then the frames queued meanwhile
+void radioLoop() {
+    while (true) {
+        osEvent event = Thread::signal_wait(0);
+        if (event.status != osEventSignal) continue;
+        if (event.value.signals & RADIO_SIGNAL_IRQ) STxIRQH();
+#if ENABLETX
+        if (event.value.signals & RADIO_SIGNAL_TX) txQueue.start();
+#endif
+    }
+}
+
 int main() {
     osThreadCreate(osThread(led_thread), NULL);
 
@@ -227,6 +147,10 @@ int main() {
     // set the SPI format
     spirit1.format(8);
 
+    // the fastest SPI clock the board sustains, instead of the 1 MHz default
+    SpiClockInit xSpiClockInit = {1000000, SPIRIT_SPI_CLOCK_MAX_HZ, 1000000, 1, 8};
+    printf("SPI clock: %lu Hz\r\n", (unsigned long) SpiritSpiClockCalibrate(&xSpiClockInit));
+
     SpiritManagementWaExtraCurrent();
 
     /* Manually set the XTAL_FREQUENCY */
@@ -235,22 +159,29 @@ int main() {
     /*Init GUI generated configuration*/
     SpiritBaseConfiguration();
 
+#ifdef SPIRIT_USE_WRITE_BATCH
+    // the setters below are sent as bursts of contiguous registers
+    SpiritBatchBegin();
+#endif
+
     //Set the Board IRQ
-    spiritInterrupt.fall(&STxIRQH);
+    radioThread.start(radioLoop);
+    spiritInterrupt.fall(&STxISR);
 
     //SPIRIT! IRQ
     SpiritGpioInit(&xGpioIRQ);
 
 #if ENABLETX
     /* Spirit Radio set power */
-    SpiritRadioSetPALeveldBm(7, POWER_DBM);
+    radioPa.bind(spirit1PaCurves[spirit1PaBand(SpiritRadioGetFrequencyBase())]);
+    radioPa.setLevel(7, POWER_DBM10);
     SpiritRadioSetPALevelMaxIndex(7);
 #endif
 
     /* Spirit IRQs enable */
     SpiritIrqDeInit(NULL);
 #if ENABLETX
-    SpiritIrq(TX_DATA_SENT, S_ENABLE);
+    txQueue.init();
 #endif //ENABLETX
 
 #ifdef ENABLERX
@@ -269,6 +200,10 @@ int main() {
     /* IRQ registers blanking */
     SpiritIrqClearStatus();
 
+#ifdef SPIRIT_USE_WRITE_BATCH
+    SpiritBatchFlush();
+#endif
+
     SRadioInit xradio;
     SpiritRadioGetInfo(&xradio);
 
@@ -308,6 +243,11 @@ int main() {
            pxPktBasicInit.xControlLength, pxPktBasicInit.xAddressField,
            pxPktBasicInit.xFec, pxPktBasicInit.xDataWhitening);
 
+#if SPIRIT1_PROFILE
+    // SPI cost of the bring-up per library call, print it with host/tools/profdump.cpp
+    spirit1ProfileDump(NULL, NULL);
+#endif
+
 #ifdef ENABLERX
     /* RX command */
     SpiritCmdStrobeRx();
@@ -316,21 +256,45 @@ int main() {
     while (1) {
 
 #if ENABLETX
-        printf("new loop \r\n");
-        /* fit the TX FIFO */
-        SpiritCmdStrobeFlushTxFifo();
-//        SpiritSpiWriteLinearFifo(20, vectcTxBuff);
-        SpiritSpiWriteLinearFifo(7, (uint8_t *)"HELLO");
-
-        /* send the TX command */
-        SpiritCmdStrobeTx();
-
-        /* wait for TX done */
-//        while (!xTxDoneFlag);
-        xTxDoneFlag = 0;
-        wait(2);
-//        Thread::wait(2000);
+        /* queue the frame, the radio thread sends it back to back with the previous ones */
+        Spirit1Buffer *frame = radioPool.alloc();
+        if (frame) {
+            memcpy(frame->data(), "HELLO", sizeof("HELLO"));
+            frame->length = sizeof("HELLO");
+        }
+        if (frame && txQueue.push(frame, txDone)) {
+            /* only an idle queue needs the radio thread, handleIrqs() sends the rest back to back */
+            if (txQueue.startNeeded() && radioThread.signal_set(RADIO_SIGNAL_TX) < 0) txStartLost++;
+        } else {
+            radioPool.free(frame);
+            Thread::wait(10);
+        }
+        static uint32_t reported;
+        if (txSent - reported >= 1000) {
+            reported = txSent;
+            printf("TX: %lu frames sent, %lu wake-ups failed\r\n", (unsigned long) reported,
+                   (unsigned long) txStartLost);
+        }
 #endif //ENABLETX
+
+#ifdef ENABLERX
+        Spirit1Buffer *packet;
+        while (rxRing.pop(packet)) {
+            printf("RX %u bytes from %02x, RSSI %d dBm, LQI %u, SQI %u, at %lu us\r\n",
+                   packet->length, packet->rx.source, packet->rx.rssi / 2 - 130, packet->rx.lqi, packet->rx.sqi,
+                   (unsigned long) packet->rx.timestampUs);
+            packet->release();
+        }
+        static uint32_t overflows, failures;
+        if (rxRing.stats().overflows != overflows || radioPool.stats().failures != failures) {
+            overflows = rxRing.stats().overflows;
+            failures = radioPool.stats().failures;
+            printf("RX ring: %lu packets dropped; pool: %lu allocations failed, %lu of %u buffers in use at most\r\n",
+                   (unsigned long) overflows, (unsigned long) failures, (unsigned long) radioPool.stats().highWater,
+                   radioPool.count());
+        }
+        Thread::wait(10);
+#endif //ENABLERX
     }
 }
 
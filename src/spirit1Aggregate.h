@@ -0,0 +1,172 @@
+/**
+ * Small application records packed into one frame ahead of the TX path, and
+ * unpacked on the receiving side.
+ *
+ * A 6 to 20 byte reading sent alone pays the preamble, the sync word, the
+ * header, the CRC and a TX turnaround for itself. The aggregator collects
+ * records into the frame being built until one of two limits is reached:
+ * maxBytes of frame (up to Frame, the FIFO; a single record may exceed it)
+ * or maxDelayUs since the oldest record went in. maxBytes trades airtime per
+ * record for frame length, and so for the loss of several records with one
+ * frame; maxDelayUs bounds the latency the aggregation adds when the traffic
+ * is light.
+ *
+ * Every record goes on the air behind a 1 byte length, records of 1 to
+ * Frame - 1 bytes:
+ *
+ *   [length] record [length] record ...
+ *
+ * Neither class touches the radio, the frame goes through the TX queue or a
+ * pool buffer like any other. Usage:
+ *
+ *   Spirit1Aggregator<> aggregator(96, 20000);
+ *
+ *   // application thread, for every reading
+ *   if (!aggregator.add(reading, length, us_ticker_read())) {
+ *       send(aggregator);
+ *       aggregator.add(reading, length, us_ticker_read());
+ *   }
+ *   // and on a timer at aggregator.deadlineUs()
+ *   if (aggregator.due(us_ticker_read())) send(aggregator);
+ *
+ *   void send(Spirit1Aggregator<> &aggregator) {
+ *       Spirit1Buffer *frame = radioPool.alloc();
+ *       frame->length = aggregator.take(frame->data());
+ *       txQueue.push(frame, txDone);
+ *   }
+ *
+ *   // receiving side
+ *   Spirit1RecordReader reader(packet->data(), packet->length);
+ *   while (const uint8_t *record = reader.next(&length)) handle(record, length);
+ */
+#ifndef SPIRIT1_AGGREGATE_H
+#define SPIRIT1_AGGREGATE_H
+
+#include <stdint.h>
+#include <string.h>
+
+/* length byte in front of every record */
+#define SPIRIT1_AGGREGATE_PREFIX 1
+
+typedef struct {
+    uint32_t records;         /*!< records accepted by add() */
+    uint32_t rejected;        /*!< empty or longer than a frame can carry */
+    uint32_t frames;          /*!< frames taken */
+    uint32_t bytes;           /*!< frame bytes taken, length prefixes included */
+    uint32_t full;            /*!< frames taken at maxBytes or with a record that did not fit */
+    uint32_t expired;         /*!< frames taken at maxDelayUs */
+} Spirit1AggregatorStats;
+
+/** Frame: largest frame payload, the linear FIFO by default */
+template<uint8_t Frame = 96>
+class Spirit1Aggregator {
+public:
+    /** longest record */
+    static const uint8_t RECORD_MAX = Frame - SPIRIT1_AGGREGATE_PREFIX;
+
+    /** maxBytes: longest frame, up to Frame; maxDelayUs: oldest record waiting at most */
+    Spirit1Aggregator(uint8_t maxBytes = Frame, uint32_t maxDelayUs = 20000) :
+            _maxBytes(maxBytes > Frame ? Frame : maxBytes), _maxDelayUs(maxDelayUs), _length(0), _count(0),
+            _overflow(false), _firstUs(0) {
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    /**
+     * appends record, added at nowUs; false if it does not fit in the frame
+     * being built (take() it first, due() is true) or cannot be sent at all
+     */
+    bool add(const uint8_t *record, uint8_t length, uint32_t nowUs) {
+        if (length == 0 || length > RECORD_MAX) {
+            _stats.rejected++;
+            return false;
+        }
+        if (_count && _length + SPIRIT1_AGGREGATE_PREFIX + length > _maxBytes) {
+            _overflow = true;
+            return false;
+        }
+        if (!_count) _firstUs = nowUs;
+        _frame[_length] = length;
+        memcpy(_frame + _length + SPIRIT1_AGGREGATE_PREFIX, record, length);
+        _length = (uint8_t) (_length + SPIRIT1_AGGREGATE_PREFIX + length);
+        _count++;
+        _stats.records++;
+        return true;
+    }
+
+    /** the frame is to be sent now: a record did not fit, maxBytes reached or the oldest one waited maxDelayUs */
+    bool due(uint32_t nowUs) const { return _count && (full() || nowUs - _firstUs >= _maxDelayUs); }
+
+    /** when the frame expires, if not empty() */
+    uint32_t deadlineUs() const { return _firstUs + _maxDelayUs; }
+
+    /** writes the frame into frame (Frame bytes) and starts a new one, returns its length, 0 if empty */
+    uint8_t take(uint8_t *frame) {
+        uint8_t length = _length;
+        if (!length) return 0;
+        memcpy(frame, _frame, length);
+        if (full()) _stats.full++;
+        else _stats.expired++;
+        _stats.frames++;
+        _stats.bytes += length;
+        _length = 0;
+        _count = 0;
+        _overflow = false;
+        return length;
+    }
+
+    bool empty() const { return _count == 0; }
+
+    /** records in the frame being built */
+    uint8_t count() const { return _count; }
+
+    /** bytes of the frame being built */
+    uint8_t length() const { return _length; }
+
+    const Spirit1AggregatorStats &stats() const { return _stats; }
+
+    void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+
+private:
+    bool full() const { return _overflow || _length >= _maxBytes; }
+
+    typedef char frameHoldsARecord[Frame > SPIRIT1_AGGREGATE_PREFIX ? 1 : -1];
+
+    uint8_t _frame[Frame];
+    uint8_t _maxBytes;
+    uint32_t _maxDelayUs;
+    uint8_t _length;
+    uint8_t _count;
+    bool _overflow;           /*!< add() turned a record down for room */
+    uint32_t _firstUs;        /*!< add() of the oldest record */
+    Spirit1AggregatorStats _stats;
+};
+
+/** walks the records of a received frame, in place */
+class Spirit1RecordReader {
+public:
+    Spirit1RecordReader(const uint8_t *frame, uint8_t length) : _frame(frame), _length(length), _offset(0) {}
+
+    /** the next record with its length in length, NULL at the end of the frame or on a malformed record */
+    const uint8_t *next(uint8_t *length) {
+        if (_offset >= _length) return NULL;
+        uint8_t record = _frame[_offset];
+        if (record == 0 || _offset + SPIRIT1_AGGREGATE_PREFIX + record > _length) {
+            _offset = (uint16_t) (_length + 1);
+            return NULL;
+        }
+        const uint8_t *data = _frame + _offset + SPIRIT1_AGGREGATE_PREFIX;
+        _offset = (uint16_t) (_offset + SPIRIT1_AGGREGATE_PREFIX + record);
+        *length = record;
+        return data;
+    }
+
+    /** next() stopped on a zero length or a record running past the frame */
+    bool malformed() const { return _offset > _length; }
+
+private:
+    const uint8_t *_frame;
+    uint8_t _length;
+    uint16_t _offset;
+};
+
+#endif // SPIRIT1_AGGREGATE_H
@@ -0,0 +1,368 @@
+/**
+ * Selective repeat ARQ over STack frames, in place of the LLP auto-ack.
+ *
+ * The LLP acknowledges every frame before the next one may go (stop and
+ * wait, 2 bit sequence number): each frame costs a turnaround and an ACK on
+ * the air. Here the sender keeps up to Window frames in flight: it sends
+ * them back to back, asks for an ACK on the last one of the burst and only
+ * then listens. The ACK carries the cumulative sequence number (next frame
+ * expected) and a bitmap of the 32 frames after it already received, so one
+ * ACK covers a whole burst and the next burst resends exactly the holes. A
+ * frame is taken as lost once a frame sent after it is acknowledged; the
+ * retransmission timeout (RTO) only covers a lost ACK request or a lost ACK,
+ * and adapts to the measured round trip (SRTT + max(G, 4 RTTVAR) with a
+ * margin G for the jitter a steady link never shows, doubled on every
+ * timeout until the next ACK). Only one ACK request is out at a time and
+ * every ACK request, a probe as well, carries a 5 bit tag the ACK echoes: only
+ * the ACK with the tag of the request out ends the wait and gives a round
+ * trip, a late ACK of an earlier request (after a timeout) only acknowledges
+ * frames. The tag wraps after 32 requests, far longer than an ACK is late.
+ *
+ *   data: [0x01 | tag << 2 | ACK_REQ] [seq] payload     2 bytes per frame
+ *   ACK:  [0x02 | tag << 2] [cumulative] [bitmap LE32]  6 bytes
+ *
+ * The receiver buffers out of order frames and hands them out in order; a
+ * frame beyond its window (the application is behind) is dropped, not
+ * acknowledged, and comes again. Neither class touches the radio: the
+ * application sends what poll() returns, listens after a frame with the ACK
+ * request, and passes the ACKs to onAck(). spirit1ArqTakeOver() turns the
+ * LLP off first, spirit1ArqHandBack() restores it. Usage:
+ *
+ *   Spirit1ArqSender<16> arq(100000, 2000, 1000000);
+ *
+ *   spirit1ArqTakeOver();
+ *   arq.push(reading, length);
+ *   // main loop
+ *   if (uint8_t length = arq.poll(nowUs, frame)) send(frame, length);
+ *   if (arq.awaitingAck()) listen();
+ *   // on RX_DATA_READY
+ *   arq.onAck(frame, length, nowUs);
+ *
+ *   Spirit1ArqReceiver<16> arq;
+ *   // on RX_DATA_READY
+ *   if (arq.onData(frame, length)) send(ack, arq.ack(ack));
+ *   while (const uint8_t *payload = arq.front(&length)) { handle(payload, length); arq.release(); }
+ */
+#ifndef SPIRIT1_ARQ_H
+#define SPIRIT1_ARQ_H
+
+#include <stdint.h>
+#include <string.h>
+#include "SPIRIT_Config.h"
+
+#define SPIRIT1_ARQ_DATA 0x01
+#define SPIRIT1_ARQ_ACK 0x02
+#define SPIRIT1_ARQ_TYPE_MASK 0x03
+#define SPIRIT1_ARQ_ACK_REQ 0x80
+#define SPIRIT1_ARQ_TAG_MASK 0x7C
+#define SPIRIT1_ARQ_TAG_SHIFT 2
+#define SPIRIT1_ARQ_HEADER 2
+#define SPIRIT1_ARQ_ACK_LENGTH 6
+/* frames acknowledged selectively beyond the cumulative one */
+#define SPIRIT1_ARQ_WINDOW_MAX 32
+
+/**
+ * hands the link over from the LLP: no auto-ack, no ACK request, no
+ * automatic retransmission. The radio must be in READY with no LLP frame
+ * pending (TX_DATA_SENT or MAX_RE_TX_REACH seen).
+ */
+inline void spirit1ArqTakeOver() {
+    PktStackLlpInit off = {S_DISABLE, S_DISABLE, PKT_DISABLE_RETX};
+    SpiritPktStackLlpInit(&off);
+    SpiritPktStackRequireAck(S_DISABLE);
+    SpiritCmdStrobeFlushTxFifo();
+    SpiritCmdStrobeFlushRxFifo();
+}
+
+/** back to the LLP, once the ARQ sender is idle() */
+inline void spirit1ArqHandBack(PktStackLlpInit *llp) {
+    SpiritPktStackLlpInit(llp);
+    SpiritPktStackRequireAck(llp->xAutoAck);
+}
+
+typedef struct {
+    uint32_t queued;          /*!< payloads accepted by push() */
+    uint32_t sent;            /*!< first transmissions */
+    uint32_t retransmissions;
+    uint32_t timeouts;        /*!< RTO expired waiting for an ACK */
+    uint32_t acks;            /*!< ACKs taken */
+    uint32_t acked;           /*!< frames acknowledged */
+    uint32_t srttUs;          /*!< smoothed round trip, 0 before the first sample */
+    uint32_t rtoUs;
+} Spirit1ArqSenderStats;
+
+/** Window: frames in flight, a power of two up to 32; Frame: largest frame payload */
+template<uint8_t Window, uint8_t Frame = 96>
+class Spirit1ArqSender {
+public:
+    static const uint8_t PAYLOAD_MAX = Frame - SPIRIT1_ARQ_HEADER;
+
+    /** rtoUs: until the first round trip is measured; marginUs: G above; maxRtoUs: bound of the RTO */
+    Spirit1ArqSender(uint32_t rtoUs, uint32_t marginUs, uint32_t maxRtoUs) :
+            _base(0), _unsent(0), _next(0), _order(0), _ackedOrder(0), _awaiting(false), _requestTag(0),
+            _srttUs(0), _rttvarUs(0), _rtoUs(rtoUs), _marginUs(marginUs), _maxRtoUs(maxRtoUs) {
+        memset(_slots, 0, sizeof(_slots));
+        memset(&_stats, 0, sizeof(_stats));
+        _stats.rtoUs = rtoUs;
+    }
+
+    /** copies a payload into the window, false if the window is full or the payload too long */
+    bool push(const uint8_t *payload, uint8_t length) {
+        if (length > PAYLOAD_MAX || _next - _base == Window) return false;
+        Slot &slot = _slots[_next & (Window - 1)];
+        memcpy(slot.payload, payload, length);
+        slot.length = length;
+        slot.acked = false;
+        slot.order = 0;
+        _next++;
+        _stats.queued++;
+        return true;
+    }
+
+    /**
+     * the next frame to send, written into frame (Frame bytes): a hole, a
+     * new frame or, after a timeout, the oldest frame again as a probe.
+     * Returns its length, 0 if there is nothing to send now.
+     */
+    uint8_t poll(uint32_t nowUs, uint8_t *frame) {
+        uint32_t seq;
+        bool request;
+        if (_awaiting) {
+            if (nowUs - _requestUs < _rtoUs) return 0;
+            /* the ACK request or the ACK got lost: probe with the oldest frame, under a new tag */
+            _stats.timeouts++;
+            setRto(_rtoUs * 2);
+            seq = _base;
+            request = true;
+        } else {
+            uint32_t due = 0;
+            seq = _next;
+            for (uint32_t s = _base; s != _next; s++) {
+                if (dueNow(s)) {
+                    if (!due) seq = s;
+                    due++;
+                }
+            }
+            if (!due) {
+                /* nothing new and no hole known: ask about the oldest frame again */
+                if (_base == _unsent) return 0;
+                seq = _base;
+                due = 1;
+            }
+            request = due == 1;
+        }
+
+        Slot &slot = _slots[seq & (Window - 1)];
+        bool retransmission = slot.order != 0;
+        if (retransmission) _stats.retransmissions++;
+        else _stats.sent++;
+        if (seq == _unsent) _unsent++;
+        slot.order = ++_order;
+        frame[0] = SPIRIT1_ARQ_DATA;
+        frame[1] = (uint8_t) seq;
+        memcpy(frame + SPIRIT1_ARQ_HEADER, slot.payload, slot.length);
+        if (request) {
+            _requestTag = (uint8_t) ((_requestTag + (1 << SPIRIT1_ARQ_TAG_SHIFT)) & SPIRIT1_ARQ_TAG_MASK);
+            frame[0] |= SPIRIT1_ARQ_ACK_REQ | _requestTag;
+            _awaiting = true;
+            _requestUs = nowUs;
+        }
+        return (uint8_t) (SPIRIT1_ARQ_HEADER + slot.length);
+    }
+
+    /** takes an ACK, false if frame is not one or is stale */
+    bool onAck(const uint8_t *frame, uint8_t length, uint32_t nowUs) {
+        if (length < SPIRIT1_ARQ_ACK_LENGTH || (frame[0] & SPIRIT1_ARQ_TYPE_MASK) != SPIRIT1_ARQ_ACK) return false;
+        uint32_t cumulative = _base + (uint8_t) (frame[1] - (uint8_t) _base);
+        if (cumulative - _base > _unsent - _base) return false;
+        uint32_t bitmap = (uint32_t) frame[2] | ((uint32_t) frame[3] << 8) | ((uint32_t) frame[4] << 16) |
+                          ((uint32_t) frame[5] << 24);
+
+        for (uint32_t s = _base; s != _unsent; s++) {
+            uint32_t offset = s - cumulative;
+            if (s - _base < cumulative - _base || (offset >= 1 && offset <= 32 && (bitmap >> (offset - 1)) & 1)) {
+                acknowledge(s);
+            }
+        }
+        while (_base != _next && _slots[_base & (Window - 1)].acked) _base++;
+
+        /* the answer to the request out, not a late one to a request before it */
+        if (_awaiting && (frame[0] & SPIRIT1_ARQ_TAG_MASK) == _requestTag) {
+            _awaiting = false;
+            sample(nowUs - _requestUs);
+        }
+        /* the link is back: drop the back-off */
+        if (_srttUs) setRto(_srttUs + (4 * _rttvarUs > _marginUs ? 4 * _rttvarUs : _marginUs));
+        _stats.acks++;
+        return true;
+    }
+
+    /** an ACK request is out, listen for the ACK until the RTO */
+    bool awaitingAck() const { return _awaiting; }
+
+    /** time of the RTO if awaitingAck() */
+    uint32_t timeoutUs() const { return _requestUs + _rtoUs; }
+
+    /** frames in the window, acknowledged or not */
+    uint32_t count() const { return _next - _base; }
+
+    /** every frame acknowledged */
+    bool idle() const { return _base == _next; }
+
+    const Spirit1ArqSenderStats &stats() const { return _stats; }
+
+private:
+    typedef struct {
+        uint8_t payload[PAYLOAD_MAX];
+        uint8_t length;
+        bool acked;
+        uint32_t order;           /*!< of the last transmission, 0 before the first */
+    } Slot;
+
+    /* never sent, or sent before a frame that has been acknowledged since */
+    bool dueNow(uint32_t seq) const {
+        const Slot &slot = _slots[seq & (Window - 1)];
+        return !slot.acked && (slot.order == 0 || slot.order < _ackedOrder);
+    }
+
+    void acknowledge(uint32_t seq) {
+        Slot &slot = _slots[seq & (Window - 1)];
+        if (slot.acked || !slot.order) return;
+        slot.acked = true;
+        if (slot.order > _ackedOrder) _ackedOrder = slot.order;
+        _stats.acked++;
+    }
+
+    /* RFC 6298 with alpha 1/8, beta 1/4 */
+    void sample(uint32_t rttUs) {
+        if (!_srttUs) {
+            _srttUs = rttUs;
+            _rttvarUs = rttUs / 2;
+        } else {
+            uint32_t delta = _srttUs > rttUs ? _srttUs - rttUs : rttUs - _srttUs;
+            _rttvarUs = (3 * _rttvarUs + delta) / 4;
+            _srttUs = (7 * _srttUs + rttUs) / 8;
+        }
+        _stats.srttUs = _srttUs;
+    }
+
+    void setRto(uint32_t rtoUs) {
+        _rtoUs = rtoUs < _maxRtoUs ? rtoUs : _maxRtoUs;
+        _stats.rtoUs = _rtoUs;
+    }
+
+    Slot _slots[Window];
+    uint32_t _base;           /*!< oldest frame not acknowledged */
+    uint32_t _unsent;         /*!< frames before it went out at least once */
+    uint32_t _next;           /*!< next push() */
+    uint32_t _order;          /*!< transmissions so far */
+    uint32_t _ackedOrder;     /*!< latest transmission acknowledged */
+    bool _awaiting;
+    uint8_t _requestTag;      /*!< of the last ACK request, in place in the first byte */
+    uint32_t _requestUs;
+    uint32_t _srttUs;
+    uint32_t _rttvarUs;
+    uint32_t _rtoUs;
+    uint32_t _marginUs;
+    uint32_t _maxRtoUs;
+    Spirit1ArqSenderStats _stats;
+
+    typedef char windowFitsTheBitmap[(Window & (Window - 1)) == 0 && Window && Window <= SPIRIT1_ARQ_WINDOW_MAX
+                                     ? 1 : -1];
+};
+
+typedef struct {
+    uint32_t received;        /*!< new frames buffered */
+    uint32_t duplicates;      /*!< frames received again, already acknowledged or delivered */
+    uint32_t outOfWindow;     /*!< frames beyond the window, dropped */
+    uint32_t delivered;       /*!< frames released in order */
+    uint32_t ackRequests;
+} Spirit1ArqReceiverStats;
+
+template<uint8_t Window, uint8_t Frame = 96>
+class Spirit1ArqReceiver {
+public:
+    static const uint8_t PAYLOAD_MAX = Frame - SPIRIT1_ARQ_HEADER;
+
+    Spirit1ArqReceiver() : _head(0), _requestTag(0) {
+        memset(_slots, 0, sizeof(_slots));
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    /** takes a data frame, returns true if the sender asks for an ACK now, see ack() */
+    bool onData(const uint8_t *frame, uint8_t length) {
+        if (length < SPIRIT1_ARQ_HEADER || length > Frame ||
+            (frame[0] & SPIRIT1_ARQ_TYPE_MASK) != SPIRIT1_ARQ_DATA) return false;
+        bool request = (frame[0] & SPIRIT1_ARQ_ACK_REQ) != 0;
+        if (request) {
+            _requestTag = (uint8_t) (frame[0] & SPIRIT1_ARQ_TAG_MASK);
+            _stats.ackRequests++;
+        }
+
+        int8_t offset = (int8_t) (frame[1] - (uint8_t) _head);
+        if (offset < 0) {
+            _stats.duplicates++;
+        } else if (offset >= Window) {
+            _stats.outOfWindow++;
+        } else {
+            Slot &slot = _slots[(_head + offset) & (Window - 1)];
+            if (slot.present) {
+                _stats.duplicates++;
+            } else {
+                slot.present = true;
+                slot.length = (uint8_t) (length - SPIRIT1_ARQ_HEADER);
+                memcpy(slot.payload, frame + SPIRIT1_ARQ_HEADER, slot.length);
+                _stats.received++;
+            }
+        }
+        return request;
+    }
+
+    /** writes the ACK of what has been received, to the last ACK request, into frame, returns its length */
+    uint8_t ack(uint8_t *frame) const {
+        uint32_t cumulative = _head;
+        while (cumulative - _head < Window && _slots[cumulative & (Window - 1)].present) cumulative++;
+        uint32_t bitmap = 0;
+        for (uint32_t s = cumulative + 1; s - _head < Window; s++) {
+            if (_slots[s & (Window - 1)].present) bitmap |= 1u << (s - cumulative - 1);
+        }
+        frame[0] = (uint8_t) (SPIRIT1_ARQ_ACK | _requestTag);
+        frame[1] = (uint8_t) cumulative;
+        for (int i = 0; i < 4; i++) frame[2 + i] = (uint8_t) (bitmap >> (8 * i));
+        return SPIRIT1_ARQ_ACK_LENGTH;
+    }
+
+    /** the next payload in order, NULL if it has not arrived yet; valid until release() */
+    const uint8_t *front(uint8_t *length) const {
+        const Slot &slot = _slots[_head & (Window - 1)];
+        if (!slot.present) return NULL;
+        *length = slot.length;
+        return slot.payload;
+    }
+
+    /** frees the payload returned by front() */
+    void release() {
+        _slots[_head & (Window - 1)].present = false;
+        _head++;
+        _stats.delivered++;
+    }
+
+    const Spirit1ArqReceiverStats &stats() const { return _stats; }
+
+private:
+    typedef struct {
+        uint8_t payload[PAYLOAD_MAX];
+        uint8_t length;
+        bool present;
+    } Slot;
+
+    Slot _slots[Window];
+    uint32_t _head;           /*!< next frame to deliver */
+    uint8_t _requestTag;      /*!< of the last ACK request, echoed by ack() */
+    Spirit1ArqReceiverStats _stats;
+
+    typedef char windowFitsTheBitmap[(Window & (Window - 1)) == 0 && Window && Window <= SPIRIT1_ARQ_WINDOW_MAX
+                                     ? 1 : -1];
+};
+
+#endif // SPIRIT1_ARQ_H
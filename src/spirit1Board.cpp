@@ -0,0 +1,12 @@
+#include "spirit1Board.h"
+
+// hardware ssel (where applicable)
+SPI spirit1(PTB22, PTB23, PTB21); // mosi, miso, sclk, ssel
+DigitalOut spirit1ChipSelect(PTB20);
+DigitalOut spirit1Shutdown(PTA18);
+
+// FIFO and large register transfers run as DMA bursts
+Spirit1MbedBus spirit1Bus(spirit1, spirit1ChipSelect, spirit1Shutdown);
+Spirit1Transport<Spirit1MbedBus> spirit1Spi(spirit1Bus);
+
+SPIRIT1_TRANSPORT(spirit1Spi)
@@ -0,0 +1,19 @@
+/**
+ * SPIRIT1 wiring of the ubirch#1 board and the transport the SPIRIT1 library
+ * runs on (defined in spirit1Board.cpp).
+ */
+#ifndef SPIRIT1_BOARD_H
+#define SPIRIT1_BOARD_H
+
+#include "mbed.h"
+#include "spirit1MbedBus.h"
+#include "spirit1Transport.h"
+
+extern SPI spirit1;
+extern DigitalOut spirit1ChipSelect;
+extern DigitalOut spirit1Shutdown;
+
+extern Spirit1MbedBus spirit1Bus;
+extern Spirit1Transport<Spirit1MbedBus> spirit1Spi;
+
+#endif // SPIRIT1_BOARD_H
@@ -0,0 +1,251 @@
+/**
+ * Fixed-block packet buffers shared by the radio thread and the application.
+ *
+ * A pool is a static slab of Count buffers of Headroom + Size bytes, no heap.
+ * alloc() and free() are constant time: the free buffers form a lock-free
+ * stack of indexes (a tag in the upper half of the head defeats ABA), so
+ * either side may allocate or free at any time, the radio thread included.
+ *
+ * A buffer moves by pointer, never by copy: the RX bottom half reads the FIFO
+ * straight into a pool buffer and passes its pointer through a
+ * Spirit1RxRing<N, Spirit1Buffer *>; the application fills a buffer in place
+ * and hands it to Spirit1TxQueue::push(), which writes it to the FIFO and
+ * releases it once the frame is done. Whoever holds the pointer owns the
+ * buffer and releases it.
+ *
+ * The headroom in front of the data lets a layer prepend its header in place
+ * (prepend()) and the receiving layer strip it again (strip()). Usage:
+ *
+ *   Spirit1BufferPool<24, 96> radioPool;
+ *   Spirit1RxRing<16, Spirit1Buffer *> rxRing;
+ *
+ *   // radio thread, on RX_DATA_READY
+ *   spirit1RxReceive(rxRing, radioPool, irqEdgeUs);
+ *
+ *   // application thread
+ *   Spirit1Buffer *packet;
+ *   while (rxRing.pop(packet)) {
+ *       handle(packet->data(), packet->length, packet->rx);
+ *       packet->release();
+ *   }
+ *
+ *   Spirit1Buffer *frame = radioPool.alloc();
+ *   if (frame) {
+ *       frame->length = build(frame->data());
+ *       if (!txQueue.push(frame, sent)) frame->release();
+ *   }
+ */
+#ifndef SPIRIT1_BUFFER_POOL_H
+#define SPIRIT1_BUFFER_POOL_H
+
+#include <stdint.h>
+#include <string.h>
+#include "SPIRIT_Config.h"
+#include "spirit1RxRing.h"
+
+/* room in front of the data for the headers of the upper layers */
+#define SPIRIT1_BUFFER_HEADROOM 8
+
+typedef struct {
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t failures;        /*!< alloc() on an empty pool */
+    uint32_t doubleFrees;     /*!< free() of a buffer already free, ignored */
+    uint32_t inUse;           /*!< buffers allocated now */
+    uint32_t highWater;       /*!< most buffers allocated at once */
+} Spirit1BufferPoolStats;
+
+class Spirit1BufferPoolBase;
+
+class Spirit1Buffer {
+public:
+    uint8_t *data() { return _base + _offset; }
+    const uint8_t *data() const { return _base + _offset; }
+
+    /** room in front of data() */
+    uint16_t headroom() const { return _offset; }
+
+    /** room for data from data() on */
+    uint16_t capacity() const { return (uint16_t) (_size - _offset); }
+
+    /** moves data() n bytes back for a header, NULL if the headroom is too small */
+    uint8_t *prepend(uint16_t n) {
+        if (n > _offset) return NULL;
+        _offset = (uint16_t) (_offset - n);
+        length = (uint16_t) (length + n);
+        return data();
+    }
+
+    /** moves data() n bytes forward past a header, returns the header, NULL if the data is shorter */
+    uint8_t *strip(uint16_t n) {
+        if (n > length) return NULL;
+        uint8_t *header = data();
+        _offset = (uint16_t) (_offset + n);
+        length = (uint16_t) (length - n);
+        return header;
+    }
+
+    /** empty, with the full headroom of the pool */
+    void reset() {
+        _offset = _headroom;
+        length = 0;
+    }
+
+    /** gives the buffer back to its pool */
+    inline void release();
+
+    uint16_t length;          /*!< bytes from data() on */
+    Spirit1RxInfo rx;         /*!< set by spirit1RxReceive() */
+
+private:
+    friend class Spirit1BufferPoolBase;
+
+    uint8_t *_base;
+    Spirit1BufferPoolBase *_pool;
+    uint16_t _size;
+    uint16_t _headroom;
+    uint16_t _offset;
+    uint16_t _next;           /*!< next free buffer, IN_USE while allocated */
+};
+
+/** the pool without its slab, see Spirit1BufferPool */
+class Spirit1BufferPoolBase {
+public:
+    /** a buffer reset to the full headroom, NULL if the pool is empty */
+    Spirit1Buffer *alloc() {
+        uint32_t head = __atomic_load_n(&_free, __ATOMIC_ACQUIRE);
+        uint16_t index, next;
+        do {
+            index = (uint16_t) head;
+            if (index == NONE) {
+                __atomic_fetch_add(&_stats.failures, 1, __ATOMIC_RELAXED);
+                return NULL;
+            }
+            /* a stale next only costs a failed exchange, the tag has moved on */
+            next = __atomic_load_n(&_buffers[index]._next, __ATOMIC_RELAXED);
+        } while (!__atomic_compare_exchange_n(&_free, &head, tagged(head, next), false, __ATOMIC_ACQ_REL,
+                                              __ATOMIC_ACQUIRE));
+
+        Spirit1Buffer *buffer = &_buffers[index];
+        buffer->_next = IN_USE;
+        buffer->reset();
+        __atomic_fetch_add(&_stats.allocs, 1, __ATOMIC_RELAXED);
+        uint32_t inUse = __atomic_add_fetch(&_stats.inUse, 1, __ATOMIC_RELAXED);
+        uint32_t highWater = __atomic_load_n(&_stats.highWater, __ATOMIC_RELAXED);
+        while (inUse > highWater && !__atomic_compare_exchange_n(&_stats.highWater, &highWater, inUse, true,
+                                                                 __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        }
+        return buffer;
+    }
+
+    /** gives a buffer back, NULL is ignored */
+    void free(Spirit1Buffer *buffer) {
+        if (!buffer) return;
+        if (buffer->_next != IN_USE) {
+            __atomic_fetch_add(&_stats.doubleFrees, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        uint16_t index = (uint16_t) (buffer - _buffers);
+        uint32_t head = __atomic_load_n(&_free, __ATOMIC_ACQUIRE);
+        do {
+            __atomic_store_n(&buffer->_next, (uint16_t) head, __ATOMIC_RELAXED);
+        } while (!__atomic_compare_exchange_n(&_free, &head, tagged(head, index), false, __ATOMIC_ACQ_REL,
+                                              __ATOMIC_ACQUIRE));
+        __atomic_fetch_add(&_stats.frees, 1, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&_stats.inUse, 1, __ATOMIC_RELAXED);
+    }
+
+    uint16_t count() const { return _count; }
+
+    /** buffers free now */
+    uint16_t available() const {
+        return (uint16_t) (_count - __atomic_load_n(&_stats.inUse, __ATOMIC_RELAXED));
+    }
+
+    const Spirit1BufferPoolStats &stats() const { return _stats; }
+
+    /** clears the counters, inUse stays and becomes the high water mark */
+    void resetStats() {
+        uint32_t inUse = __atomic_load_n(&_stats.inUse, __ATOMIC_RELAXED);
+        memset(&_stats, 0, sizeof(_stats));
+        _stats.inUse = _stats.highWater = inUse;
+    }
+
+protected:
+    Spirit1BufferPoolBase(Spirit1Buffer *buffers, uint8_t *slab, uint16_t count, uint16_t blockSize,
+                          uint16_t headroom) : _buffers(buffers), _free(0), _count(count) {
+        memset(&_stats, 0, sizeof(_stats));
+        for (uint16_t i = 0; i < count; i++) {
+            Spirit1Buffer &buffer = buffers[i];
+            buffer._base = slab + (uint32_t) i * blockSize;
+            buffer._pool = this;
+            buffer._size = blockSize;
+            buffer._headroom = headroom;
+            buffer._next = i + 1 < count ? (uint16_t) (i + 1) : NONE;
+            buffer.reset();
+        }
+        _free = count ? 0 : NONE;
+    }
+
+private:
+    static const uint16_t NONE = 0xFFFF;
+    static const uint16_t IN_USE = 0xFFFE;
+
+    /* head of the free stack: the index below, a tag bumped on every change above */
+    static uint32_t tagged(uint32_t head, uint16_t index) {
+        return ((head + 0x10000) & 0xFFFF0000) | index;
+    }
+
+    Spirit1Buffer *_buffers;
+    uint32_t _free;
+    uint16_t _count;
+    Spirit1BufferPoolStats _stats;
+};
+
+void Spirit1Buffer::release() {
+    _pool->free(this);
+}
+
+/** Count buffers of Size bytes of data behind Headroom bytes, Count below 0xFFFE */
+template<uint16_t Count, uint16_t Size, uint16_t Headroom = SPIRIT1_BUFFER_HEADROOM>
+class Spirit1BufferPool : public Spirit1BufferPoolBase {
+public:
+    Spirit1BufferPool() : Spirit1BufferPoolBase(_buffers, (uint8_t *) _slab, Count, BLOCK, Headroom) {}
+
+private:
+    /* whole words per block */
+    static const uint16_t BLOCK = (Headroom + Size + 3) & ~3;
+
+    Spirit1Buffer _buffers[Count];
+    uint32_t _slab[Count * BLOCK / 4];
+
+    typedef char countFitsTheIndexes[Count > 0 && Count < 0xFFFE ? 1 : -1];
+};
+
+/**
+ * bottom half of RX_DATA_READY, without copy: reads the packet and its RX
+ * information into a buffer of pool and queues the buffer in ring. Returns
+ * false if the ring is full or the pool empty, the packet is then left in the
+ * RX FIFO.
+ */
+template<uint32_t Size>
+bool spirit1RxReceive(Spirit1RxRing<Size, Spirit1Buffer *> &ring, Spirit1BufferPoolBase &pool, uint32_t timestampUs) {
+    Spirit1Buffer **slot = ring.claim();
+    if (!slot) return false;
+    Spirit1Buffer *buffer = pool.alloc();
+    if (!buffer) return false;
+
+    spirit1RxReadInfo(&buffer->rx, timestampUs);
+
+    uint16_t length = SpiritLinearFifoReadNumElementsRxFifo();
+    if (length > SPIRIT1_RX_PAYLOAD_MAX) length = SPIRIT1_RX_PAYLOAD_MAX;
+    if (length > buffer->capacity()) length = buffer->capacity();
+    SpiritSpiReadLinearFifo((uint8_t) length, buffer->data());
+    buffer->length = length;
+
+    *slot = buffer;
+    ring.commit();
+    return true;
+}
+
+#endif // SPIRIT1_BUFFER_POOL_H
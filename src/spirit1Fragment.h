@@ -0,0 +1,255 @@
+/**
+ * Messages larger than a frame, split into STack frames and put back
+ * together on the receiving side.
+ *
+ * Every fragment starts with a 2 byte header: the tag of the message (one
+ * counter per sender), then the index of the fragment in bits 0-6 with bit 7
+ * set on the last one. All fragments but the last carry Frame - 2 bytes of
+ * the message, so a fragment lands at index * (Frame - 2) whatever the order
+ * of arrival; a message has at most 128 fragments (12032 bytes with 96 byte
+ * frames). Sender and receiver must agree on Frame.
+ *
+ * The reassembler keeps a fixed table of Slots partial messages of up to
+ * MaxMessage bytes, keyed by the STack source address and the tag: its memory
+ * is bounded and static. A partial message that got no fragment for timeoutUs
+ * is dropped; a new message finding the table full evicts the least recently
+ * updated one. Duplicates are counted and ignored. A completed message keeps
+ * its slot for timeoutUs, marked done: the fragments the sender retransmits
+ * after a lost ACK count as duplicates instead of opening a new message, and
+ * a new message takes a done slot before it evicts a partial one. A message
+ * of a single fragment is returned in place, without copy. Usage:
+ *
+ *   Spirit1Fragmenter<> fragmenter;
+ *   uint8_t frame[96];
+ *   fragmenter.begin(bundle, bundleLength);
+ *   while (uint8_t length = fragmenter.next(frame)) send(frame, length);
+ *
+ *   Spirit1Reassembler<4096, 4> reassembler;
+ *   uint16_t length;
+ *   const uint8_t *message = reassembler.receive(packet->rx.source, packet->data(), packet->length,
+ *                                                us_ticker_read(), &length);
+ *   if (message) handle(message, length);
+ *
+ * Neither class touches the radio, the frames travel with the STack packet
+ * format (SpiritPktStackSetPayloadLength()), the RX ring, the TX queue or
+ * pool buffers alike.
+ */
+#ifndef SPIRIT1_FRAGMENT_H
+#define SPIRIT1_FRAGMENT_H
+
+#include <stdint.h>
+#include <string.h>
+
+/* tag, index and last flag */
+#define SPIRIT1_FRAGMENT_HEADER 2
+#define SPIRIT1_FRAGMENT_LAST 0x80
+#define SPIRIT1_FRAGMENT_MAX 128
+
+/** Frame: largest frame payload, the linear FIFO by default */
+template<uint8_t Frame = 96>
+class Spirit1Fragmenter {
+public:
+    /** message bytes per fragment */
+    static const uint16_t CHUNK = Frame - SPIRIT1_FRAGMENT_HEADER;
+    static const uint16_t MAX_MESSAGE = SPIRIT1_FRAGMENT_MAX * CHUNK;
+
+    Spirit1Fragmenter() : _message(NULL), _length(0), _offset(0), _index(0), _tag(0) {}
+
+    /** starts a new message, false if it is empty or longer than MAX_MESSAGE; message must stay valid until the end */
+    bool begin(const uint8_t *message, uint16_t length) {
+        if (length == 0 || length > MAX_MESSAGE) return false;
+        _message = message;
+        _length = length;
+        _offset = 0;
+        _index = 0;
+        _tag++;
+        return true;
+    }
+
+    /** writes the next fragment into frame (Frame bytes), returns its length, 0 once the message is done */
+    uint8_t next(uint8_t *frame) {
+        if (_offset >= _length) return 0;
+        uint16_t chunk = _length - _offset < CHUNK ? (uint16_t) (_length - _offset) : CHUNK;
+        frame[0] = _tag;
+        frame[1] = (uint8_t) (_index | (_offset + chunk == _length ? SPIRIT1_FRAGMENT_LAST : 0));
+        memcpy(frame + SPIRIT1_FRAGMENT_HEADER, _message + _offset, chunk);
+        _offset = (uint16_t) (_offset + chunk);
+        _index++;
+        return (uint8_t) (SPIRIT1_FRAGMENT_HEADER + chunk);
+    }
+
+    /** fragments of the current message */
+    uint8_t fragments() const { return (uint8_t) ((_length + CHUNK - 1) / CHUNK); }
+
+    /** back to the first fragment, e.g. to send the message again */
+    void rewind() {
+        _offset = 0;
+        _index = 0;
+    }
+
+    uint8_t tag() const { return _tag; }
+
+private:
+    typedef char frameHoldsAFragment[Frame > SPIRIT1_FRAGMENT_HEADER ? 1 : -1];
+
+    const uint8_t *_message;
+    uint16_t _length;
+    uint16_t _offset;
+    uint8_t _index;
+    uint8_t _tag;
+};
+
+typedef struct {
+    uint32_t fragments;       /*!< fragments accepted */
+    uint32_t messages;        /*!< messages complete */
+    uint32_t duplicates;      /*!< fragments received twice, ignored */
+    uint32_t malformed;       /*!< short, oversized or past MaxMessage */
+    uint32_t timeouts;        /*!< partial messages dropped after timeoutUs */
+    uint32_t evictions;       /*!< partial messages dropped for a new one, table full */
+    uint32_t highWater;       /*!< most partial messages at once */
+} Spirit1ReassemblerStats;
+
+/** MaxMessage: longest message, Slots: partial messages at once, Frame as for Spirit1Fragmenter */
+template<uint16_t MaxMessage, uint8_t Slots, uint8_t Frame = 96>
+class Spirit1Reassembler {
+public:
+    static const uint16_t CHUNK = Frame - SPIRIT1_FRAGMENT_HEADER;
+
+    explicit Spirit1Reassembler(uint32_t timeoutUs = 2000000) : _timeoutUs(timeoutUs) {
+        memset(_slots, 0, sizeof(_slots));
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    /**
+     * takes the fragment frame of length bytes from source, received at
+     * nowUs; returns the message once complete, with its length in
+     * messageLength, NULL otherwise. The message is valid until the next
+     * call of receive() or expire() (single fragment: as long as frame).
+     */
+    const uint8_t *receive(uint8_t source, const uint8_t *frame, uint8_t length, uint32_t nowUs,
+                           uint16_t *messageLength) {
+        if (length <= SPIRIT1_FRAGMENT_HEADER || length > Frame) {
+            _stats.malformed++;
+            return NULL;
+        }
+        uint8_t tag = frame[0];
+        uint8_t index = frame[1] & (SPIRIT1_FRAGMENT_MAX - 1);
+        bool last = (frame[1] & SPIRIT1_FRAGMENT_LAST) != 0;
+        uint16_t chunk = (uint16_t) (length - SPIRIT1_FRAGMENT_HEADER);
+        uint32_t offset = (uint32_t) index * CHUNK;
+        if ((!last && chunk != CHUNK) || offset + chunk > MaxMessage) {
+            _stats.malformed++;
+            return NULL;
+        }
+        _stats.fragments++;
+
+        /* the whole message in one frame */
+        if (index == 0 && last) {
+            _stats.messages++;
+            *messageLength = chunk;
+            return frame + SPIRIT1_FRAGMENT_HEADER;
+        }
+
+        expire(nowUs);
+        Slot *slot = find(source, tag);
+        if (!slot) slot = open(source, tag, nowUs);
+        uint32_t bit = 1u << (index & 31);
+        if (slot->done || (slot->received[index >> 5] & bit)) {
+            _stats.duplicates++;
+            return NULL;
+        }
+        slot->received[index >> 5] |= bit;
+        slot->count++;
+        slot->updatedUs = nowUs;
+        memcpy(slot->data + offset, frame + SPIRIT1_FRAGMENT_HEADER, chunk);
+        if (last) {
+            slot->fragments = (uint8_t) (index + 1);
+            slot->length = (uint16_t) (offset + chunk);
+        }
+        if (slot->fragments == 0 || slot->count != slot->fragments) return NULL;
+
+        slot->done = true;
+        _stats.messages++;
+        *messageLength = slot->length;
+        return slot->data;
+    }
+
+    /**
+     * drops the partial messages older than timeoutUs and forgets the done
+     * ones completed as long ago, receive() does it on every fragment
+     */
+    void expire(uint32_t nowUs) {
+        for (uint8_t i = 0; i < Slots; i++) {
+            if (_slots[i].used && nowUs - _slots[i].updatedUs > _timeoutUs) {
+                _slots[i].used = false;
+                if (!_slots[i].done) _stats.timeouts++;
+            }
+        }
+    }
+
+    /** partial messages now */
+    uint8_t pending() const {
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < Slots; i++) count = (uint8_t) (count + (_slots[i].used && !_slots[i].done));
+        return count;
+    }
+
+    const Spirit1ReassemblerStats &stats() const { return _stats; }
+
+    void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+
+private:
+    typedef struct {
+        bool used;
+        bool done;                /*!< complete, kept to recognise late fragments */
+        uint8_t source;
+        uint8_t tag;
+        uint8_t fragments;        /*!< known once the last fragment is in, 0 before */
+        uint8_t count;            /*!< fragments in */
+        uint16_t length;          /*!< known with fragments */
+        uint32_t updatedUs;
+        uint32_t received[SPIRIT1_FRAGMENT_MAX / 32];
+        uint8_t data[MaxMessage];
+    } Slot;
+
+    Slot *find(uint8_t source, uint8_t tag) {
+        for (uint8_t i = 0; i < Slots; i++) {
+            if (_slots[i].used && _slots[i].source == source && _slots[i].tag == tag) return &_slots[i];
+        }
+        return NULL;
+    }
+
+    /* a free slot, else the least recently done one, else the least recently updated one */
+    Slot *open(uint8_t source, uint8_t tag, uint32_t nowUs) {
+        Slot *slot = NULL;
+        for (uint8_t i = 0; i < Slots && (!slot || slot->used); i++) {
+            if (!slot || rank(_slots[i]) > rank(*slot) ||
+                (rank(_slots[i]) == rank(*slot) && nowUs - _slots[i].updatedUs > nowUs - slot->updatedUs)) {
+                slot = &_slots[i];
+            }
+        }
+        if (slot->used && !slot->done) _stats.evictions++;
+        slot->used = true;
+        slot->done = false;
+        slot->source = source;
+        slot->tag = tag;
+        slot->fragments = 0;
+        slot->count = 0;
+        slot->length = 0;
+        memset(slot->received, 0, sizeof(slot->received));
+        uint8_t used = pending();
+        if (used > _stats.highWater) _stats.highWater = used;
+        return slot;
+    }
+
+    /* the order slots are taken in: free, done, partial */
+    static uint8_t rank(const Slot &slot) { return slot.used ? slot.done ? 1 : 0 : 2; }
+
+    Slot _slots[Slots];
+    uint32_t _timeoutUs;
+    Spirit1ReassemblerStats _stats;
+
+    typedef char slotsAndFrame[Slots > 0 && Frame > SPIRIT1_FRAGMENT_HEADER ? 1 : -1];
+};
+
+#endif // SPIRIT1_FRAGMENT_H
@@ -0,0 +1,97 @@
+/**
+ * Deferred SPIRIT1 interrupt handling.
+ *
+ * The nIRQ edge handler (top half) only stamps the time and signals the radio
+ * thread; the thread (bottom half) does the SPI work: reading the IRQ status,
+ * draining the FIFO and re-arming RX. Edges that arrive while a bottom half is
+ * pending are merged into it, since the IRQ status registers accumulate the
+ * events until they are read.
+ *
+ * The signal must not get lost: nIRQ stays low until the status is read, so
+ * no further edge comes to retry it. Signal a thread of its own (a flag can
+ * always be set) rather than post to an event queue another producer can
+ * fill, and cancel() the edge if the signal fails all the same.
+ *
+ * Timestamps are passed in by the caller (us_ticker_read() on the target),
+ * so the bookkeeping is platform independent. Usage:
+ *
+ *   // interrupt context
+ *   uint32_t now = us_ticker_read();
+ *   if (irq.edge(now) && radioThread.signal_set(RADIO_SIGNAL_IRQ) < 0) irq.cancel();
+ *   irq.edgeDone(now, us_ticker_read());
+ *
+ *   // radio thread
+ *   irq.begin(us_ticker_read());
+ *   ... SPI work ...
+ */
+#ifndef SPIRIT1_IRQ_H
+#define SPIRIT1_IRQ_H
+
+#include <stdint.h>
+#include <string.h>
+
+typedef struct {
+    uint32_t edges;           /*!< nIRQ edges seen by the top half */
+    uint32_t signals;         /*!< bottom half runs requested, edges while one is pending are merged */
+    uint32_t lost;            /*!< signals that could not be delivered, see cancel() */
+    uint32_t handled;         /*!< bottom half runs */
+    uint32_t latencyLastUs;   /*!< edge to bottom half start, last run */
+    uint32_t latencyMaxUs;
+    uint64_t latencySumUs;    /*!< divide by handled for the average */
+    uint32_t isrMaxUs;        /*!< longest top half, i.e. the longest time lower priority interrupts were held off */
+} Spirit1IrqStats;
+
+class Spirit1DeferredIrq {
+public:
+    Spirit1DeferredIrq() : _pending(false), _edgeUs(0) {
+        resetStats();
+    }
+
+    /** top half: returns true if the bottom half has to be signalled */
+    bool edge(uint32_t nowUs) {
+        _stats.edges++;
+        if (__atomic_load_n(&_pending, __ATOMIC_ACQUIRE)) return false;
+        _edgeUs = nowUs;
+        __atomic_store_n(&_pending, true, __ATOMIC_RELEASE);
+        _stats.signals++;
+        return true;
+    }
+
+    /** top half: the signal of edge() failed, the next edge signals again */
+    void cancel() {
+        _stats.lost++;
+        __atomic_store_n(&_pending, false, __ATOMIC_RELEASE);
+    }
+
+    /** top half: account the time spent in the interrupt handler */
+    void edgeDone(uint32_t startUs, uint32_t endUs) {
+        uint32_t duration = endUs - startUs;
+        if (duration > _stats.isrMaxUs) _stats.isrMaxUs = duration;
+    }
+
+    /**
+     * bottom half: call first, before reading the IRQ status, so that an edge
+     * arriving during the SPI work signals a new run
+     */
+    void begin(uint32_t nowUs) {
+        uint32_t latency = nowUs - _edgeUs;
+        __atomic_store_n(&_pending, false, __ATOMIC_RELEASE);
+        _stats.handled++;
+        _stats.latencyLastUs = latency;
+        _stats.latencySumUs += latency;
+        if (latency > _stats.latencyMaxUs) _stats.latencyMaxUs = latency;
+    }
+
+    bool pending() const { return __atomic_load_n(&_pending, __ATOMIC_ACQUIRE); }
+
+    const Spirit1IrqStats &stats() const { return _stats; }
+
+    void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+
+private:
+    bool _pending;
+    volatile uint32_t _edgeUs;
+    Spirit1IrqStats _stats;
+};
+
+#endif // SPIRIT1_IRQ_H
@@ -0,0 +1,100 @@
+/**
+ * mbed bus adapter for the SPIRIT1 SPI engine (see spirit1Spi.h).
+ *
+ * Bursts use the asynchronous SPI::transfer() API (DEVICE_SPI_ASYNCH), which
+ * runs on DMA on the K82F, and report completion through a semaphore so the
+ * calling thread sleeps while the payload is clocked.
+ * Also the transport backend (see spirit1Transport.h): SDN pin, SPI clock and
+ * the optional pin wired to a SPIRIT GPIO for the state waits (SPIRIT_Wait.h),
+ * on which the calling thread sleeps until the rising edge.
+ */
+#ifndef SPIRIT1_MBED_BUS_H
+#define SPIRIT1_MBED_BUS_H
+
+#include "mbed.h"
+#include "rtos.h"
+#include "us_ticker_api.h"
+
+class Spirit1MbedBus {
+public:
+    Spirit1MbedBus(SPI &spi, DigitalOut &chipSelect, DigitalOut &shutdown)
+            : _spi(spi), _chipSelect(chipSelect), _shutdown(shutdown), _done(NULL), _context(NULL), _complete(0),
+              _stateGpio(NULL), _stateEdge(0) {}
+
+    void lock() { _spi.lock(); }
+
+    void unlock() { _spi.unlock(); }
+
+    void select() { _chipSelect = 0; }
+
+    void deselect() { _chipSelect = 1; }
+
+    uint8_t write(uint8_t value) { return (uint8_t) _spi.write(value); }
+
+    bool canBlock() { return __get_IPSR() == 0; }
+
+    uint32_t nowUs() { return us_ticker_read(); }
+
+    bool startTransfer(const uint8_t *tx, uint8_t *rx, uint16_t n, void (*done)(void *), void *context) {
+#if DEVICE_SPI_ASYNCH
+        _done = done;
+        _context = context;
+        return _spi.transfer(tx, tx ? n : 0, rx, rx ? n : 0,
+                             callback(this, &Spirit1MbedBus::onEvent), SPI_EVENT_COMPLETE) == 0;
+#else
+        return false;
+#endif
+    }
+
+    void waitTransfer() { _complete.wait(); }
+
+    void enterShutdown() { _shutdown = 1; }
+
+    void exitShutdown() {
+        _shutdown = 0;
+        // power on reset takes about 700 us
+        wait_us(1000);
+    }
+
+    bool isShutdown() { return _shutdown.read() != 0; }
+
+    void setFrequency(uint32_t hz) { _spi.frequency((int) hz); }
+
+    /** the pin wired to the SPIRIT GPIO given to SpiritWaitGpioInit(), NULL: the waits poll */
+    void setStateGpio(InterruptIn *pin) {
+        _stateGpio = pin;
+        if (pin) pin->rise(callback(this, &Spirit1MbedBus::onStateEdge));
+    }
+
+    bool waitGpioHigh(uint32_t timeoutUs) {
+        if (!_stateGpio) return false;
+        uint32_t start = us_ticker_read();
+        while (!_stateGpio->read()) {
+            uint32_t elapsed = us_ticker_read() - start;
+            if (elapsed >= timeoutUs) return false;
+            // the semaphore counts in ms; in an ISR, spin
+            if (canBlock()) _stateEdge.wait((timeoutUs - elapsed + 999) / 1000);
+        }
+        return true;
+    }
+
+private:
+    void onStateEdge() { _stateEdge.release(); }
+
+    void onEvent(int event) {
+        (void) event;
+        if (_done) _done(_context);
+        _complete.release();
+    }
+
+    SPI &_spi;
+    DigitalOut &_chipSelect;
+    DigitalOut &_shutdown;
+    void (*_done)(void *);
+    void *_context;
+    Semaphore _complete;
+    InterruptIn *_stateGpio;
+    Semaphore _stateEdge;
+};
+
+#endif // SPIRIT1_MBED_BUS_H
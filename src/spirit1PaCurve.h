@@ -0,0 +1,209 @@
+/**
+ * The PA power curves of SpiritRadioGetdBm2Reg() and SpiritRadioGetReg2dBm()
+ * as lookup tables worked out by the compiler, and the PA setters on them.
+ *
+ * The library evaluates the piecewise linear model of fPowerFactors in float
+ * on every call, after finding the band of the frequency base, which
+ * SpiritRadioSetPALeveldBm() and SpiritRadioSetPATabledBm() first read back
+ * from the synthesizer registers. A Spirit1PaCurve holds both directions for
+ * one band, in 10ths of dBm: the PA_LEVEL value of every power of the
+ * IS_PAPOWER_DBM() range, -31.0 to 12.0 dBm, and the power of every PA_LEVEL
+ * value. spirit1PaModelCurve() computes them as constexpr functions, to the
+ * bit of the library: level[d] is SpiritRadioGetdBm2Reg() of
+ * (d + SPIRIT1_PA_DBM10_MIN) / 10.0f, dBm10[r] SpiritRadioGetReg2dBm() of r
+ * rounded to the nearest 10th, -1300 for 0 (output stage off).
+ *
+ * A board with a measured PA curve supplies its own: spirit1PaMeasuredCurve()
+ * takes the output power measured at every PA_LEVEL value and picks for each
+ * power the closest level, the weaker one on a tie:
+ *
+ *   constexpr int16_t measured[91] = {-1300, 118, 115, ...};
+ *   constexpr Spirit1PaCurve boardCurve = spirit1PaMeasuredCurve(measured);
+ *
+ * The band is looked up once, when a Spirit1Pa is bound to its curve; a power
+ * change, the step of an adaptive power control, is then an index into the
+ * table and one register write:
+ *
+ *   Spirit1Pa pa(spirit1PaCurves[spirit1PaBand(SpiritRadioGetFrequencyBase())]);
+ *   pa.setLevel(0, 55);    // SpiritRadioSetPALeveldBm(0, 5.5)
+ *
+ * The factors are the library's own (PA_POWER_FACTORS). The tables round
+ * every multiply and add on its own, and so does the library: the SPIRIT
+ * targets are built with -ffp-contract=off, without which an FMA could move a
+ * value across a truncation boundary by one level.
+ */
+#ifndef SPIRIT1_PA_CURVE_H
+#define SPIRIT1_PA_CURVE_H
+
+#include <stdint.h>
+#include "SPIRIT_Config.h"
+
+/* the IS_PAPOWER_DBM() range in 10ths of dBm, and the power of PA_LEVEL 0 */
+#define SPIRIT1_PA_DBM10_MIN    (-310)
+#define SPIRIT1_PA_DBM10_MAX    120
+#define SPIRIT1_PA_STEPS        (SPIRIT1_PA_DBM10_MAX - SPIRIT1_PA_DBM10_MIN + 1)
+#define SPIRIT1_PA_OFF_DBM10    (-1300)
+
+/* the curves of fPowerFactors, in its order */
+#define SPIRIT1_PA_BAND_915     0
+#define SPIRIT1_PA_BAND_868     1
+#define SPIRIT1_PA_BAND_433     2
+#define SPIRIT1_PA_BAND_315     3
+#define SPIRIT1_PA_BAND_169     4
+
+typedef struct {
+    uint8_t level[SPIRIT1_PA_STEPS];   /*!< PA_LEVEL value of SPIRIT1_PA_DBM10_MIN + index, 10ths of dBm */
+    int16_t dBm10[91];                 /*!< power of the PA_LEVEL value, 10ths of dBm */
+} Spirit1PaCurve;
+
+/* fPowerFactors of SPIRIT_Radio.c: {m-up, q-up, m-mid, q-mid, m-low, q-low}, power_reg = m*power_dBm + q */
+constexpr float spirit1PaFactors[5][6] = PA_POWER_FACTORS;
+
+/** the curve of the band of frequencyBase, as the library finds it */
+constexpr uint8_t spirit1PaBand(uint32_t frequencyBase) {
+    return IS_FREQUENCY_BAND_HIGH(frequencyBase)
+           ? (frequencyBase < 900000000 ? SPIRIT1_PA_BAND_868 : SPIRIT1_PA_BAND_915)
+           : IS_FREQUENCY_BAND_MIDDLE(frequencyBase) ? SPIRIT1_PA_BAND_433
+           : IS_FREQUENCY_BAND_LOW(frequencyBase) ? SPIRIT1_PA_BAND_315 : SPIRIT1_PA_BAND_169;
+}
+
+/** index of dBm10 in Spirit1PaCurve::level, clamped to the range */
+constexpr uint16_t spirit1PaIndex(int32_t dBm10) {
+    return (uint16_t) ((dBm10 < SPIRIT1_PA_DBM10_MIN ? SPIRIT1_PA_DBM10_MIN
+                        : dBm10 > SPIRIT1_PA_DBM10_MAX ? SPIRIT1_PA_DBM10_MAX : dBm10) - SPIRIT1_PA_DBM10_MIN);
+}
+
+/* SpiritRadioGetdBm2Reg(): the region compared in double, the level in float */
+constexpr uint8_t spirit1PaModelRegion(const float *factors, float dBm) {
+    return dBm > 0 && 13.0 / factors[2] - factors[3] / factors[2] < dBm ? 0
+           : dBm <= 0 && 40.0 / factors[2] - factors[3] / factors[2] > dBm ? 2 : 1;
+}
+
+constexpr uint8_t spirit1PaModelClamp(float reg) {
+    return reg < 1 ? 1 : reg > 90 ? 90 : (uint8_t) reg;
+}
+
+constexpr uint8_t spirit1PaModelLevel(const float *factors, float dBm, uint8_t region) {
+    return spirit1PaModelClamp(factors[2 * region] * dBm + factors[2 * region + 1]);
+}
+
+constexpr uint8_t spirit1PaModelLevel(const float *factors, float dBm) {
+    return spirit1PaModelLevel(factors, dBm, spirit1PaModelRegion(factors, dBm));
+}
+
+/* SpiritRadioGetReg2dBm(), rounded half away from zero; the product by 10 is exact in double */
+constexpr int16_t spirit1PaRound10(float dBm) {
+    return (int16_t) (dBm < 0 ? (double) dBm * 10 - 0.5 : (double) dBm * 10 + 0.5);
+}
+
+constexpr int16_t spirit1PaModelDbm10(const float *factors, uint8_t level, uint8_t region) {
+    return spirit1PaRound10(((float) level) / factors[2 * region] - factors[2 * region + 1] / factors[2 * region]);
+}
+
+constexpr int16_t spirit1PaModelDbm10(const float *factors, uint8_t level) {
+    return level == 0 ? SPIRIT1_PA_OFF_DBM10
+           : spirit1PaModelDbm10(factors, level, level < 13 ? 0 : level > 40 ? 2 : 1);
+}
+
+/* the indices 0 .. N-1 as a parameter pack */
+template<int... I>
+struct Spirit1PaIndices {};
+
+template<int N, int... I>
+struct Spirit1PaSequence : Spirit1PaSequence<N - 1, N - 1, I...> {};
+
+template<int... I>
+struct Spirit1PaSequence<0, I...> {
+    typedef Spirit1PaIndices<I...> type;
+};
+
+template<int... D, int... R>
+constexpr Spirit1PaCurve spirit1PaModelCurve(const float *factors, Spirit1PaIndices<D...>, Spirit1PaIndices<R...>) {
+    return Spirit1PaCurve{{spirit1PaModelLevel(factors, (SPIRIT1_PA_DBM10_MIN + D) / 10.0f)...},
+                          {spirit1PaModelDbm10(factors, (uint8_t) R)...}};
+}
+
+/** the curve of fPowerFactors[band] */
+constexpr Spirit1PaCurve spirit1PaModelCurve(uint8_t band) {
+    return spirit1PaModelCurve(spirit1PaFactors[band], Spirit1PaSequence<SPIRIT1_PA_STEPS>::type(),
+                               Spirit1PaSequence<91>::type());
+}
+
+constexpr int32_t spirit1PaDistance(int32_t a, int32_t b) {
+    return a < b ? b - a : a - b;
+}
+
+/* the level from 1 to 90 of the measured power closest to dBm10, the highest (weakest) on a tie */
+constexpr uint8_t spirit1PaClosest(const int16_t *measured, int32_t dBm10, uint8_t level, uint8_t best) {
+    return level > 90 ? best
+           : spirit1PaClosest(measured, dBm10, (uint8_t) (level + 1),
+                              spirit1PaDistance(measured[level], dBm10) <= spirit1PaDistance(measured[best], dBm10)
+                              ? level : best);
+}
+
+template<int... D, int... R>
+constexpr Spirit1PaCurve spirit1PaMeasuredCurve(const int16_t *measured, Spirit1PaIndices<D...>,
+                                                Spirit1PaIndices<R...>) {
+    return Spirit1PaCurve{{spirit1PaClosest(measured, SPIRIT1_PA_DBM10_MIN + D, 2, 1)...},
+                          {(int16_t) (R ? measured[R] : SPIRIT1_PA_OFF_DBM10)...}};
+}
+
+/** the curve of a board: measured[r], the output power at PA_LEVEL value r in 10ths of dBm, r from 1 to 90 */
+constexpr Spirit1PaCurve spirit1PaMeasuredCurve(const int16_t (&measured)[91]) {
+    return spirit1PaMeasuredCurve(measured, Spirit1PaSequence<SPIRIT1_PA_STEPS>::type(),
+                                  Spirit1PaSequence<91>::type());
+}
+
+/** the curves of the evaluation boards, indexed by spirit1PaBand() */
+constexpr Spirit1PaCurve spirit1PaCurves[5] = {
+    spirit1PaModelCurve(SPIRIT1_PA_BAND_915), spirit1PaModelCurve(SPIRIT1_PA_BAND_868),
+    spirit1PaModelCurve(SPIRIT1_PA_BAND_433), spirit1PaModelCurve(SPIRIT1_PA_BAND_315),
+    spirit1PaModelCurve(SPIRIT1_PA_BAND_169),
+};
+
+/** the PA setters of SPIRIT_Radio.c in 10ths of dBm, on a curve bound once */
+class Spirit1Pa {
+public:
+    explicit Spirit1Pa(const Spirit1PaCurve &curve) : _curve(&curve) {}
+
+    /** another curve, after a band change */
+    void bind(const Spirit1PaCurve &curve) { _curve = &curve; }
+
+    const Spirit1PaCurve &curve() const { return *_curve; }
+
+    /** PA_LEVEL value of dBm10, clamped to the range */
+    uint8_t level(int32_t dBm10) const { return _curve->level[spirit1PaIndex(dBm10)]; }
+
+    /** power of a PA_LEVEL value, SPIRIT1_PA_OFF_DBM10 for 0 and above 90 */
+    int16_t dBm10(uint8_t level) const { return level <= 90 ? _curve->dBm10[level] : SPIRIT1_PA_OFF_DBM10; }
+
+    /** SpiritRadioSetPALeveldBm(): one register write */
+    void setLevel(uint8_t index, int32_t dBm10) const {
+        uint8_t value = level(dBm10);
+        SpiritSpiWriteRegisters((uint8_t) (PA_POWER8_BASE + 7 - index), 1, &value);
+    }
+
+    /** SpiritRadioGetPALeveldBm() */
+    int16_t getLevel(uint8_t index) const {
+        uint8_t value;
+        SpiritSpiReadRegisters((uint8_t) (PA_POWER8_BASE + 7 - index), 1, &value);
+        return dBm10(value);
+    }
+
+    /**
+     * SpiritRadioSetPATabledBm(): dBm10[i] to PA_LEVEL[i] for i up to
+     * maxIndex and PA_POWER[0], in one burst
+     */
+    void setTable(uint8_t maxIndex, uint8_t width, PALoadCapacitor load, const int16_t *dBm10) const {
+        uint8_t registers[9];
+
+        for (uint8_t i = 0; i <= maxIndex; i++) registers[maxIndex - i] = level(dBm10[i]);
+        registers[maxIndex + 1] = (uint8_t) (load | (width - 1) << 3 | maxIndex);
+        SpiritSpiWriteRegisters((uint8_t) (PA_POWER8_BASE + 7 - maxIndex), (uint8_t) (maxIndex + 2), registers);
+    }
+
+private:
+    const Spirit1PaCurve *_curve;
+};
+
+#endif // SPIRIT1_PA_CURVE_H
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <string.h>
+#include "spirit1Profile.h"
+#include "spirit1Trace.h"
+
+#if !defined(__MBED__) && (defined(__linux__) || defined(__APPLE__))
+#include <dlfcn.h>
+#define SPIRIT1_PROFILE_DLADDR 1
+#endif
+
+/* where the report and the dump go, printf() on the console by default */
+#ifndef SPIRIT1_TRACE_PRINTF
+#define SPIRIT1_TRACE_PRINTF printf
+#else
+int SPIRIT1_TRACE_PRINTF(const char *format, ...);
+#endif
+
+#define NO_PROFILE __attribute__((no_instrument_function))
+
+typedef struct {
+    int16_t entry;      /*!< -1: table full, not tracked */
+    uint32_t startUs;
+} Frame;
+
+/* slot 0 collects the transactions issued outside of any library call */
+static Spirit1ProfileEntry table[SPIRIT1_PROFILE_FUNCTIONS];
+static Frame stack[SPIRIT1_PROFILE_DEPTH];
+static uint32_t depth;
+
+/* open addressing on the function address, slot 0 reserved */
+NO_PROFILE static int16_t lookup(uint64_t function) {
+    uint32_t hash = (uint32_t) ((function >> 2) * 2654435761u);
+    for (uint32_t i = 0; i < SPIRIT1_PROFILE_FUNCTIONS - 1; i++) {
+        uint32_t slot = 1 + (hash + i) % (SPIRIT1_PROFILE_FUNCTIONS - 1);
+        if (table[slot].function == function) return (int16_t) slot;
+        if (table[slot].function == 0) {
+            table[slot].function = function;
+            return (int16_t) slot;
+        }
+    }
+    return -1;
+}
+
+extern "C" NO_PROFILE void __cyg_profile_func_enter(void *function, void *) {
+    int16_t entry = lookup((uint64_t) (uintptr_t) function);
+    if (entry >= 0) table[entry].calls++;
+    if (depth < SPIRIT1_PROFILE_DEPTH) {
+        stack[depth].entry = entry;
+        stack[depth].startUs = spirit1TraceNowUs();
+    }
+    depth++;
+}
+
+extern "C" NO_PROFILE void __cyg_profile_func_exit(void *, void *) {
+    if (!depth) return;
+    depth--;
+    if (depth < SPIRIT1_PROFILE_DEPTH && stack[depth].entry >= 0) {
+        table[stack[depth].entry].timeUs += spirit1TraceNowUs() - stack[depth].startUs;
+    }
+}
+
+NO_PROFILE void spirit1ProfileTransaction(uint8_t n) {
+    uint32_t tracked = depth < SPIRIT1_PROFILE_DEPTH ? depth : SPIRIT1_PROFILE_DEPTH;
+    if (!tracked) {
+        table[0].transactions++;
+        table[0].selfTransactions++;
+        table[0].bytes += 2u + n;
+        return;
+    }
+    for (uint32_t i = 0; i < tracked; i++) {
+        int16_t entry = stack[i].entry;
+        if (entry < 0) continue;
+        table[entry].transactions++;
+        table[entry].bytes += 2u + n;
+        if (i == tracked - 1) table[entry].selfTransactions++;
+    }
+}
+
+NO_PROFILE void spirit1ProfileReset() {
+    memset(table, 0, sizeof(table));
+    depth = 0;
+}
+
+NO_PROFILE size_t spirit1ProfileEntries(Spirit1ProfileEntry *entries, size_t max) {
+    size_t n = 0;
+    for (uint32_t slot = 0; slot < SPIRIT1_PROFILE_FUNCTIONS && n < max; slot++) {
+        if ((slot && !table[slot].function) || (!slot && !table[0].transactions)) continue;
+        /* insertion sort, most transactions first */
+        size_t i = n++;
+        while (i && entries[i - 1].transactions < table[slot].transactions) {
+            entries[i] = entries[i - 1];
+            i--;
+        }
+        entries[i] = table[slot];
+    }
+    return n;
+}
+
+NO_PROFILE void spirit1ProfilePrint(const Spirit1ProfileEntry *entries, size_t n, Spirit1ProfileNamer namer,
+                                    void *context) {
+    SPIRIT1_TRACE_PRINTF("%-40s %7s %8s %8s %9s %10s %9s\r\n",
+                         "function", "calls", "trans.", "self", "bytes", "us", "us/call");
+    for (size_t i = 0; i < n; i++) {
+        const Spirit1ProfileEntry &entry = entries[i];
+        const char *name = entry.function ? (namer ? namer(entry.function, context) : NULL) : "(outside the library)";
+        char address[24];
+        if (!name) {
+            snprintf(address, sizeof(address), "0x%08llx", (unsigned long long) entry.function);
+            name = address;
+        }
+        SPIRIT1_TRACE_PRINTF("%-40s %7lu %8lu %8lu %9lu %10lu %9.1f\r\n", name,
+                             (unsigned long) entry.calls, (unsigned long) entry.transactions,
+                             (unsigned long) entry.selfTransactions, (unsigned long) entry.bytes,
+                             (unsigned long) entry.timeUs,
+                             entry.calls ? (double) entry.timeUs / entry.calls : 0.0);
+    }
+}
+
+#if SPIRIT1_PROFILE_DLADDR
+NO_PROFILE static const char *dladdrName(uint64_t function, void *) {
+    Dl_info info;
+    if (!dladdr((void *) (uintptr_t) function, &info) || !info.dli_sname) return NULL;
+    return info.dli_sname;
+}
+#endif
+
+NO_PROFILE void spirit1ProfileReport() {
+    static Spirit1ProfileEntry entries[SPIRIT1_PROFILE_FUNCTIONS];
+    size_t n = spirit1ProfileEntries(entries, SPIRIT1_PROFILE_FUNCTIONS);
+#if SPIRIT1_PROFILE_DLADDR
+    spirit1ProfilePrint(entries, n, dladdrName, NULL);
+#else
+    spirit1ProfilePrint(entries, n, NULL, NULL);
+#endif
+}
+
+NO_PROFILE static void hexLine(const uint8_t *data, size_t size, void *) {
+    SPIRIT1_TRACE_PRINTF("PROF ");
+    for (size_t i = 0; i < size; i++) SPIRIT1_TRACE_PRINTF("%02x", data[i]);
+    SPIRIT1_TRACE_PRINTF("\r\n");
+}
+
+NO_PROFILE static uint8_t *put(uint8_t *p, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) *p++ = (uint8_t) (value >> (8 * i));
+    return p;
+}
+
+NO_PROFILE void spirit1ProfileDump(Spirit1ProfileWriter writer, void *context) {
+    if (!writer) writer = hexLine;
+
+    uint16_t count = 0;
+    for (uint32_t slot = 0; slot < SPIRIT1_PROFILE_FUNCTIONS; slot++) {
+        if (table[slot].function || (!slot && table[0].transactions)) count++;
+    }
+    uint8_t header[8];
+    memcpy(header, SPIRIT1_PROFILE_MAGIC, 4);
+    header[4] = SPIRIT1_PROFILE_VERSION;
+    header[5] = sizeof(void *);
+    put(header + 6, count, 2);
+    writer(header, sizeof(header), context);
+
+    for (uint32_t slot = 0; slot < SPIRIT1_PROFILE_FUNCTIONS; slot++) {
+        const Spirit1ProfileEntry &entry = table[slot];
+        if (!entry.function && (slot || !entry.transactions)) continue;
+        uint8_t record[28];
+        uint8_t *p = put(record, entry.function, 8);
+        p = put(p, entry.calls, 4);
+        p = put(p, entry.transactions, 4);
+        p = put(p, entry.selfTransactions, 4);
+        p = put(p, entry.bytes, 4);
+        put(p, entry.timeUs, 4);
+        writer(record, sizeof(record), context);
+    }
+}
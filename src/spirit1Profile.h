@@ -0,0 +1,87 @@
+/**
+ * SPI cost of the SPIRIT1 library calls.
+ *
+ * With SPIRIT1_PROFILE=1 and the library compiled with -finstrument-functions
+ * (the transport layers excluded: -finstrument-functions-exclude-file-list=
+ * SPIRIT_Shadow.c,SPIRIT_Batch.c) every library function entry and exit is
+ * tracked on a call stack and every transport transaction is charged to the
+ * functions on it: a transaction of SpiritCalibrationSelectVco() called by
+ * SpiritRadioSetFrequencyBase() counts in the total of both and in the self
+ * count of SpiritCalibrationSelectVco() only. Time is the wall time of the
+ * calls, nested calls included. Writes held back by the write batch are
+ * charged to the caller of SpiritBatchFlush(), reads served by the register
+ * shadow cost nothing.
+ *
+ * There is one call stack: profile the library from one thread at a time.
+ *
+ * Functions are known by address. spirit1ProfileReport() prints the table
+ * with the names where the platform can resolve them (dladdr(), host
+ * executables linked with -rdynamic). On the target spirit1ProfileDump()
+ * writes a binary image of the table, by default as "PROF" hex lines on the
+ * console; host/tools/profdump.cpp prints it with the symbols of the
+ * firmware ELF.
+ */
+#ifndef SPIRIT1_PROFILE_H
+#define SPIRIT1_PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef SPIRIT1_PROFILE
+#define SPIRIT1_PROFILE 0
+#endif
+
+/* functions tracked, a power of two */
+#ifndef SPIRIT1_PROFILE_FUNCTIONS
+#define SPIRIT1_PROFILE_FUNCTIONS 128
+#endif
+
+/* deepest call chain tracked */
+#ifndef SPIRIT1_PROFILE_DEPTH
+#define SPIRIT1_PROFILE_DEPTH 16
+#endif
+
+/* dump image: magic, version, address size, number of records, then the records, little endian */
+#define SPIRIT1_PROFILE_MAGIC   "S1PF"
+#define SPIRIT1_PROFILE_VERSION 1
+
+typedef struct {
+    uint64_t function;           /*!< address, 0: transactions outside any library call */
+    uint32_t calls;
+    uint32_t transactions;       /*!< nested calls included */
+    uint32_t selfTransactions;   /*!< issued by the function itself */
+    uint32_t bytes;              /*!< on the bus, two header bytes per transaction included, nested calls included */
+    uint32_t timeUs;             /*!< nested calls included */
+} Spirit1ProfileEntry;
+
+/** charges a transaction of n payload bytes to the functions on the call stack */
+void spirit1ProfileTransaction(uint8_t n);
+
+/** clears the table, call outside of library calls */
+void spirit1ProfileReset();
+
+/** copies up to max entries in use, most transactions first; returns the number copied */
+size_t spirit1ProfileEntries(Spirit1ProfileEntry *entries, size_t max);
+
+/** resolves an address to a name, NULL if unknown */
+typedef const char *(*Spirit1ProfileNamer)(uint64_t function, void *context);
+
+/** prints entries as a table */
+void spirit1ProfilePrint(const Spirit1ProfileEntry *entries, size_t n, Spirit1ProfileNamer namer, void *context);
+
+/** prints the table of this program */
+void spirit1ProfileReport();
+
+/** receives the dump image piece by piece */
+typedef void (*Spirit1ProfileWriter)(const uint8_t *data, size_t size, void *context);
+
+/** writes the dump image with writer, or as "PROF <hex>" lines on the console with NULL */
+void spirit1ProfileDump(Spirit1ProfileWriter writer, void *context);
+
+#if SPIRIT1_PROFILE
+#define SPIRIT1_PROFILE_TRANSACTION(n) spirit1ProfileTransaction(n)
+#else
+#define SPIRIT1_PROFILE_TRANSACTION(n) ((void) 0)
+#endif
+
+#endif // SPIRIT1_PROFILE_H
@@ -0,0 +1,248 @@
+/**
+ * Named radio profiles (datarate, deviation, bandwidth, channel, PA, packet
+ * length, timeouts...) kept as register images, and a switch between them
+ * that writes only the registers that differ.
+ *
+ * A profile is captured once, after configuring the radio with the library:
+ *
+ *   Spirit1ProfileSwitch<2> profiles;
+ *
+ *   SpiritRadioInit(&longRange);
+ *   SpiritRadioSetPALeveldBm(0, 11);
+ *   SpiritPktBasicSetPayloadLength(20);
+ *   SpiritTimerSetRxTimeoutMs(500.0);
+ *   profiles.capture("long range");
+ *   SpiritRadioInit(&highRate);
+ *   ...
+ *   profiles.capture("high rate");
+ *
+ * and selected from READY:
+ *
+ *   SpiritCmdStrobeSabort();
+ *   profiles.select("long range");
+ *   SpiritCmdStrobeRx();
+ *
+ * select() compares the profile with the register shadow (SPIRIT_Shadow.h)
+ * and writes the registers that differ, or that the shadow does not know, in
+ * runs of contiguous registers. Runs closer than the cost of a transaction
+ * (2 header bytes plus overheadBytes, the chip select and turnaround time in
+ * byte times) are written as one, across the registers in between. When the
+ * synthesizer changed (SYNT3..SYNT0: word, charge pump and band, or the VCO
+ * selection) the VCO calibration runs, like after SpiritRadioSetFrequencyBase(),
+ * unless the switch was made with recalibrate false: then the calibration
+ * words captured with the profile are used as they are.
+ *
+ * Bounds: the SPI cost of a switch, bytes + overheadBytes per transaction, is
+ * never above that of bound(), every profile register written in one
+ * transaction per range. The VCO calibration adds two LOCK cycles, each one
+ * bounded by SPIRIT_WAIT_LOCK_TIMEOUT_US (SPIRIT_Wait.h). plan() gives the
+ * cost of a switch without making it.
+ *
+ * Without SPIRIT_USE_REGISTER_SHADOW every switch writes every register and
+ * calibrates.
+ */
+#ifndef SPIRIT1_RADIO_PROFILE_H
+#define SPIRIT1_RADIO_PROFILE_H
+
+#include <stdint.h>
+#include <string.h>
+#include "SPIRIT_Config.h"
+
+/* registers of a profile, the sum of the counts of spirit1RadioProfileRanges */
+#define SPIRIT1_RADIO_PROFILE_REGISTERS 64
+
+/* {first register, count}; addresses, FIFO thresholds and IRQ masks are not part of a profile */
+constexpr uint8_t spirit1RadioProfileRanges[][2] = {
+    {IF_OFFSET_ANA_BASE, 9},     /* 0x07..0x0F: IF offset, synthesizer, channel space, FC offset */
+    {PA_POWER8_BASE, 9},         /* 0x10..0x18: PA table and level */
+    {MOD1_BASE, 14},             /* 0x1A..0x27: modem, AFC, RSSI, clock recovery, AGC, antenna */
+    {PCKTCTRL4_BASE, 14},        /* 0x30..0x3D: packet format and length, sync, QI, MBUS */
+    {PCKT_FLT_OPTIONS_BASE, 10}, /* 0x4F..0x58: filtering, protocol, RX timeout and LDC timers */
+    {CHNUM_BASE, 4},             /* 0x6C..0x6F: channel, calibration words */
+    {SYNTH_CONFIG1_BASE, 2},
+    {VCO_CONFIG_BASE, 1},
+    {0xA3, 1},                   /* DEM_CONFIG */
+};
+
+constexpr int spirit1RadioProfileCount(size_t r) {
+    return r < sizeof(spirit1RadioProfileRanges) / sizeof(spirit1RadioProfileRanges[0])
+           ? spirit1RadioProfileRanges[r][1] + spirit1RadioProfileCount(r + 1) : 0;
+}
+
+typedef char spirit1RadioProfileRangesCounted[spirit1RadioProfileCount(0) == SPIRIT1_RADIO_PROFILE_REGISTERS ? 1 : -1];
+
+typedef struct {
+    const char *name;
+    uint32_t frequencyBase;      /*!< of SpiritManagementWaTRxFcMem() */
+    uint8_t registers[SPIRIT1_RADIO_PROFILE_REGISTERS]; /*!< spirit1RadioProfileRanges in order */
+} Spirit1RadioProfile;
+
+typedef struct {
+    uint16_t transactions;       /*!< register writes */
+    uint16_t bytes;              /*!< bus bytes, header included */
+    uint16_t registers;          /*!< registers that differ or are not in the shadow */
+    bool calibrate;              /*!< the synthesizer changed */
+} Spirit1ProfileSwitchCost;
+
+typedef struct {
+    uint32_t switches;           /*!< select() calls that made a switch */
+    uint32_t unchanged;          /*!< switches with nothing to write */
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t registers;          /*!< registers that differed */
+    uint32_t calibrations;       /*!< switches that changed the synthesizer */
+    uint32_t errors;             /*!< unknown profile, or the calibration did not reach its state */
+} Spirit1ProfileSwitchStats;
+
+/** Count: profiles kept */
+template<uint8_t Count>
+class Spirit1ProfileSwitch {
+public:
+    /** see above for recalibrate and overheadBytes */
+    explicit Spirit1ProfileSwitch(bool recalibrate = true, uint8_t overheadBytes = 0) :
+            _count(0), _recalibrate(recalibrate), _overheadBytes(overheadBytes) {
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    /** keeps the registers of the radio as profile name, in READY after the configuration; false if full */
+    bool capture(const char *name) {
+        Spirit1RadioProfile *profile = (Spirit1RadioProfile *) find(name);
+        if (!profile) {
+            if (_count == Count) return false;
+            profile = &_profiles[_count++];
+        }
+        uint8_t *registers = profile->registers;
+        profile->name = name;
+        profile->frequencyBase = g_pxSpiritContext->nDesiredFrequency;
+        for (size_t r = 0; r < RANGES; r++) {
+            SpiritSpiReadRegisters(spirit1RadioProfileRanges[r][0], spirit1RadioProfileRanges[r][1], registers);
+            registers += spirit1RadioProfileRanges[r][1];
+        }
+        return true;
+    }
+
+    /** the profile name, NULL if not captured */
+    const Spirit1RadioProfile *find(const char *name) const {
+        for (uint8_t i = 0; i < _count; i++) {
+            if (strcmp(_profiles[i].name, name) == 0) return &_profiles[i];
+        }
+        return NULL;
+    }
+
+    /** what select(to) would write now */
+    Spirit1ProfileSwitchCost plan(const Spirit1RadioProfile &to) const { return walk(to, false); }
+
+    /** switches to the profile name, from READY; 0, 1 for an unknown profile or a failed calibration */
+    uint8_t select(const char *name) {
+        const Spirit1RadioProfile *profile = find(name);
+        if (!profile) {
+            _stats.errors++;
+            return 1;
+        }
+        return select(*profile);
+    }
+
+    uint8_t select(const Spirit1RadioProfile &to) {
+        Spirit1ProfileSwitchCost cost = walk(to, true);
+        _stats.switches++;
+        if (!cost.registers) _stats.unchanged++;
+        _stats.transactions += cost.transactions;
+        _stats.bytes += cost.bytes;
+        _stats.registers += cost.registers;
+        if (cost.calibrate) {
+            _stats.calibrations++;
+            SpiritManagementWaTRxFcMem(to.frequencyBase);
+            if (_recalibrate && g_pxSpiritContext->xDoVcoCalibrationWA == S_ENABLE && SpiritManagementWaVcoCalibration()) {
+                _stats.errors++;
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    /** every register written, one transaction per range, and the calibration */
+    static Spirit1ProfileSwitchCost bound() {
+        Spirit1ProfileSwitchCost cost = {RANGES, 0, SPIRIT1_RADIO_PROFILE_REGISTERS, true};
+        for (size_t r = 0; r < RANGES; r++) cost.bytes = (uint16_t) (cost.bytes + HEADER + spirit1RadioProfileRanges[r][1]);
+        return cost;
+    }
+
+    /** bytes plus overheadBytes per transaction, what bound() caps */
+    uint32_t weight(const Spirit1ProfileSwitchCost &cost) const {
+        return cost.bytes + (uint32_t) cost.transactions * _overheadBytes;
+    }
+
+    uint8_t count() const { return _count; }
+
+    const Spirit1RadioProfile &profile(uint8_t i) const { return _profiles[i]; }
+
+    const Spirit1ProfileSwitchStats &stats() const { return _stats; }
+
+    void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+
+private:
+    static const size_t RANGES = sizeof(spirit1RadioProfileRanges) / sizeof(spirit1RadioProfileRanges[0]);
+    static const uint8_t HEADER = 2;
+
+    /* the value of the radio register, false if the shadow does not know it */
+    static bool known(uint8_t address, uint8_t *value) {
+#ifdef SPIRIT_USE_REGISTER_SHADOW
+        return SpiritShadowPeek(address, value) == S_TRUE;
+#else
+        (void) address;
+        (void) value;
+        return false;
+#endif
+    }
+
+    static bool differs(uint8_t address, uint8_t value) {
+        uint8_t current;
+        return !known(address, &current) || current != value;
+    }
+
+    /* the runs of registers to write, written if write */
+    Spirit1ProfileSwitchCost walk(const Spirit1RadioProfile &to, bool write) const {
+        Spirit1ProfileSwitchCost cost = {0, 0, 0, false};
+        const uint8_t *registers = to.registers;
+
+        /* before the writes: they update the shadow */
+        for (uint8_t i = 0; i < 4; i++) cost.calibrate |= differs((uint8_t) (SYNT3_BASE + i), registers[1 + i]);
+        cost.calibrate |= differs(SYNTH_CONFIG1_BASE, registers[SPIRIT1_RADIO_PROFILE_REGISTERS - 4]);
+
+        for (size_t r = 0; r < RANGES; r++) {
+            uint8_t first = spirit1RadioProfileRanges[r][0], length = spirit1RadioProfileRanges[r][1];
+            int start = -1, last = -1;
+            for (int i = 0; i < length; i++) {
+                if (!differs((uint8_t) (first + i), registers[i])) continue;
+                cost.registers++;
+                /* bridging the gap is cheaper than a transaction */
+                if (start >= 0 && i - last - 1 > HEADER + _overheadBytes) {
+                    emit(first, start, last, registers, write, &cost);
+                    start = -1;
+                }
+                if (start < 0) start = i;
+                last = i;
+            }
+            if (start >= 0) emit(first, start, last, registers, write, &cost);
+            registers += length;
+        }
+        return cost;
+    }
+
+    static void emit(uint8_t first, int start, int last, const uint8_t *registers, bool write,
+                     Spirit1ProfileSwitchCost *cost) {
+        uint8_t length = (uint8_t) (last - start + 1);
+        cost->transactions++;
+        cost->bytes = (uint16_t) (cost->bytes + HEADER + length);
+        /* the library takes non-const buffers */
+        if (write) SpiritSpiWriteRegisters((uint8_t) (first + start), length, (uint8_t *) registers + start);
+    }
+
+    Spirit1RadioProfile _profiles[Count];
+    uint8_t _count;
+    bool _recalibrate;
+    uint8_t _overheadBytes;
+    Spirit1ProfileSwitchStats _stats;
+};
+
+#endif // SPIRIT1_RADIO_PROFILE_H
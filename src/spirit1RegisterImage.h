@@ -0,0 +1,486 @@
+/**
+ * The registers SpiritRadioInit() and SpiritPktBasicInit() leave in a SPIRIT1
+ * after reset, worked out by the compiler, and the loader that writes them.
+ *
+ * SpiritRadioInit() computes the synthesizer word, the charge pump word, the
+ * datarate, frequency deviation and channel filter mantissas and exponents
+ * and the IF offsets at run time, in floating point, and reads most of the
+ * registers it writes. spirit1RegisterImage() does the same arithmetic as
+ * constexpr functions, to the bit: float where the library uses float,
+ * double where it uses double, the same integer truncations and wrap
+ * arounds. With constant parameters the image is a constant, the MCU only
+ * carries its bytes; spirit1ImageLoad() writes them in a dozen bursts and
+ * runs the VCO calibration, the one step that needs the chip.
+ *
+ * The parameter checks of the library (s_assert_param(), compiled out by
+ * default) are part of the computation. An invalid parameter calls a
+ * function that is not constexpr, named after the error, and the constant
+ * evaluation fails on it, here on a datarate above 500 kbps:
+ *
+ *   constexpr Spirit1RegisterImage image = spirit1RegisterImage(50000000,
+ *       SRadioInit{0, 868000000, 20000, 0, FSK, 600000, 20000, 100000},
+ *       PktBasicInit{PKT_PREAMBLE_LENGTH_04BYTES, PKT_SYNC_LENGTH_4BYTES, 0x1A2635A8, PKT_LENGTH_VAR, 7,
+ *                    PKT_CRC_MODE_16BITS_1, PKT_CONTROL_LENGTH_0BYTES, S_ENABLE, S_DISABLE, S_ENABLE});
+ *
+ *   error: call to non-'constexpr' function 'Spirit1RegisterImage spirit1ImageDatarateOutOfRange()'
+ *
+ * With run time parameters it is an ordinary function; an invalid
+ * configuration gives an image with xtal 0, which spirit1ImageLoad()
+ * refuses. Usage, in place of SpiritRadioSetXtalFrequency(),
+ * SpiritRadioInit() and SpiritPktBasicInit():
+ *
+ *   SpiritCmdStrobeSres();
+ *   if (spirit1ImageLoad(image)) error();
+ *   SpiritPktBasicAddressesInit(&addresses);
+ *
+ * The registers the library reads back are taken at their reset value: the
+ * image is for a chip fresh out of SRES. It is the image of the VCO
+ * calibration workaround enabled, the library default. The center frequency
+ * is checked with the signed frequency offset, the library check adds it as
+ * an unsigned value.
+ */
+#ifndef SPIRIT1_REGISTER_IMAGE_H
+#define SPIRIT1_REGISTER_IMAGE_H
+
+#include <stdint.h>
+#include <string.h>
+#include "SPIRIT_Config.h"
+
+/* reset values of the registers the library modifies */
+#define SPIRIT1_IMAGE_RESET_ANA_FUNC_CONF0      0xC0
+#define SPIRIT1_IMAGE_RESET_FDEV0               0x45
+#define SPIRIT1_IMAGE_RESET_AFC2                0x48
+#define SPIRIT1_IMAGE_RESET_PCKTLEN1            0x00
+#define SPIRIT1_IMAGE_RESET_PCKTLEN0            0x14
+#define SPIRIT1_IMAGE_RESET_PCKT_FLT_OPTIONS    0x70
+#define SPIRIT1_IMAGE_RESET_PROTOCOL2           0x06
+#define SPIRIT1_IMAGE_RESET_PROTOCOL1           0x00
+#define SPIRIT1_IMAGE_RESET_SYNTH_CONFIG1       0x5B
+#define SPIRIT1_IMAGE_RESET_DEM_CONFIG          0x37
+#define SPIRIT1_IMAGE_RESET_XO_RCO_TEST         0x21
+
+typedef struct {
+    uint32_t xtal;               /*!< crystal in Hz, 0: invalid configuration */
+    uint32_t frequencyBase;      /*!< lFrequencyBase, for SpiritManagementWaTRxFcMem() */
+    uint8_t anaFuncConf0;        /*!< ANA_FUNC_CONF0: 24/26 MHz flag */
+    uint8_t xoRcoTest;           /*!< XO_RCO_TEST: digital clock divider, written in STANDBY */
+    uint8_t radio[9];            /*!< IF_OFFSET_ANA, SYNT3..SYNT0 to calibrate the VCO at, CHSPACE, IF_OFFSET_DIG, FC_OFFSET1..0 */
+    uint8_t modem[5];            /*!< MOD1, MOD0, FDEV0, CHFLT, AFC2 */
+    uint8_t packet[10];          /*!< PCKTCTRL4..PCKTCTRL1, PCKTLEN1..0, SYNC4..SYNC1 */
+    uint8_t protocol[3];         /*!< PCKT_FLT_OPTIONS, PROTOCOL2 (automatic VCO calibration off), PROTOCOL1 */
+    uint8_t channel;             /*!< CHNUM */
+    uint8_t iqc[2];              /*!< 0x99..0x9A: IQ correction */
+    uint8_t synthConfig[2];      /*!< SYNTH_CONFIG1 to calibrate the VCO with, SYNTH_CONFIG0 */
+    uint8_t vcoConfig;           /*!< VCO_CONFIG: VCO current, raised by the calibration workaround */
+    uint8_t demConfig;           /*!< 0xA3: 2nd order DEM algorithm */
+    uint8_t vcoWorkaround;       /*!< 0xBC: PA on after an unwanted VCO calibration */
+    uint8_t synth[4];            /*!< SYNT3..SYNT0 after the calibration */
+    uint8_t synthConfig1;        /*!< SYNTH_CONFIG1 after the calibration */
+} Spirit1RegisterImage;
+
+/* s_vectnBandwidth26M, s_vectnVCOFreq, s_vectcBHalfFactor and s_vectcBandRegValue of SPIRIT_Radio.c */
+constexpr uint16_t spirit1ImageBandwidth26M[90] = {
+    8001, 7951, 7684, 7368, 7051, 6709, 6423, 5867, 5414,
+    4509, 4259, 4032, 3808, 3621, 3417, 3254, 2945, 2703,
+    2247, 2124, 2011, 1900, 1807, 1706, 1624, 1471, 1350,
+    1123, 1062, 1005,  950,  903,  853,  812,  735,  675,
+     561,  530,  502,  474,  451,  426,  406,  367,  337,
+     280,  265,  251,  237,  226,  213,  203,  184,  169,
+     140,  133,  126,  119,  113,  106,  101,   92,   84,
+      70,   66,   63,   59,   56,   53,   51,   46,   42,
+      35,   33,   31,   30,   28,   27,   25,   23,   21,
+      18,   17,   16,   15,   14,   13,   13,   12,   11,
+};
+constexpr uint16_t spirit1ImageVcoFrequency[16] = {
+    4644, 4708, 4772, 4836, 4902, 4966, 5030, 5095, 5161, 5232, 5303, 5375, 5448, 5519, 5592, 5663,
+};
+constexpr uint8_t spirit1ImageBandHalfFactor[4] = {
+    HIGH_BAND_FACTOR / 2, MIDDLE_BAND_FACTOR / 2, LOW_BAND_FACTOR / 2, VERY_LOW_BAND_FACTOR / 2,
+};
+constexpr uint8_t spirit1ImageBandRegister[4] = {SYNT0_BS_6, SYNT0_BS_12, SYNT0_BS_16, SYNT0_BS_32};
+
+/* lowest center frequency of VCO_H, per band */
+constexpr uint32_t spirit1ImageVcoHighFrom[4] = {860166667, 430083334, 322562500, 161281250};
+
+/* the errors: not constexpr, a call fails the constant evaluation */
+inline Spirit1RegisterImage spirit1ImageXtalNotSupported() { return Spirit1RegisterImage(); }
+inline Spirit1RegisterImage spirit1ImageFrequencyOutOfBand() { return Spirit1RegisterImage(); }
+inline Spirit1RegisterImage spirit1ImageModulationUnknown() { return Spirit1RegisterImage(); }
+inline Spirit1RegisterImage spirit1ImageDatarateOutOfRange() { return Spirit1RegisterImage(); }
+inline Spirit1RegisterImage spirit1ImageOffsetOutOfRange() { return Spirit1RegisterImage(); }
+inline Spirit1RegisterImage spirit1ImageChannelSpaceOutOfRange() { return Spirit1RegisterImage(); }
+inline Spirit1RegisterImage spirit1ImageFrequencyDeviationOutOfRange() { return Spirit1RegisterImage(); }
+inline Spirit1RegisterImage spirit1ImageBandwidthOutOfRange() { return Spirit1RegisterImage(); }
+inline Spirit1RegisterImage spirit1ImageCenterFrequencyOutOfBand() { return Spirit1RegisterImage(); }
+inline Spirit1RegisterImage spirit1ImagePreambleLengthInvalid() { return Spirit1RegisterImage(); }
+inline Spirit1RegisterImage spirit1ImageSyncLengthInvalid() { return Spirit1RegisterImage(); }
+inline Spirit1RegisterImage spirit1ImageCrcModeInvalid() { return Spirit1RegisterImage(); }
+inline Spirit1RegisterImage spirit1ImageLengthWidthOutOfRange() { return Spirit1RegisterImage(); }
+inline Spirit1RegisterImage spirit1ImageControlLengthInvalid() { return Spirit1RegisterImage(); }
+inline Spirit1RegisterImage spirit1ImagePacketFlagInvalid() { return Spirit1RegisterImage(); }
+
+/* SpiritRadioGetDigDiv() after SpiritRadioInit() */
+constexpr uint8_t spirit1ImageDigDiv(uint32_t xtal) { return xtal < DOUBLE_XTAL_THR ? 0 : 1; }
+
+/* the band SpiritRadioSetFrequencyBase() selects, HIGH_BAND outside of all of them */
+constexpr uint8_t spirit1ImageBand(uint32_t frequency) {
+    return IS_FREQUENCY_BAND_MIDDLE(frequency) ? MIDDLE_BAND : IS_FREQUENCY_BAND_LOW(frequency) ? LOW_BAND
+           : IS_FREQUENCY_BAND_VERY_LOW(frequency) ? VERY_LOW_BAND : HIGH_BAND;
+}
+
+/* SpiritRadioSearchWCP() */
+constexpr uint8_t spirit1ImageBandFactor(uint32_t fc) {
+    return IS_FREQUENCY_BAND_HIGH(fc) ? HIGH_BAND_FACTOR : IS_FREQUENCY_BAND_MIDDLE(fc) ? MIDDLE_BAND_FACTOR
+           : IS_FREQUENCY_BAND_LOW(fc) ? LOW_BAND_FACTOR : IS_FREQUENCY_BAND_VERY_LOW(fc) ? VERY_LOW_BAND_FACTOR : 0;
+}
+
+constexpr uint8_t spirit1ImageWcpSearch(uint32_t vco, uint8_t i) {
+    return i < 15 && vco > (uint32_t) spirit1ImageVcoFrequency[i] * 1000 ? spirit1ImageWcpSearch(vco, i + 1) : i;
+}
+
+constexpr uint8_t spirit1ImageWcpOf(uint32_t vco) {
+    return vco >= (uint32_t) spirit1ImageVcoFrequency[15] * 1000 ? 15 % 8
+           : (spirit1ImageWcpSearch(vco, 0) ? spirit1ImageWcpSearch(vco, 0) - 1 : 0) % 8;
+}
+
+constexpr uint8_t spirit1ImageWcp(uint32_t fc) { return spirit1ImageWcpOf(fc / 1000 * spirit1ImageBandFactor(fc)); }
+
+/* FC_OFFSET as SpiritRadioInit() computes it, then as SpiritRadioGetFrequencyOffset() reads it back */
+constexpr int32_t spirit1ImageOffsetHz(const SRadioInit &radio) {
+    return (int32_t) (((float) radio.nXtalOffsetPpm * radio.lFrequencyBase) / PPM_FACTOR);
+}
+
+constexpr int16_t spirit1ImageFcOffset(uint32_t xtal, const SRadioInit &radio) {
+    return (int16_t) (((float) spirit1ImageOffsetHz(radio) * FBASE_DIVIDER) / xtal);
+}
+
+constexpr int16_t spirit1ImageSignExtend12(uint16_t value) {
+    return (int16_t) ((value & 0x0800) ? (int) (value & 0x0FFF) - 0x1000 : (int) (value & 0x0FFF));
+}
+
+constexpr int32_t spirit1ImageFcOffsetHz(uint32_t xtal, const SRadioInit &radio) {
+    return (int32_t) ((uint32_t) spirit1ImageSignExtend12((uint16_t) spirit1ImageFcOffset(xtal, radio)) * xtal) /
+           FBASE_DIVIDER;
+}
+
+/* CHSPACE, then SpiritRadioGetChannelSpace() */
+constexpr uint8_t spirit1ImageChannelSpace(uint32_t xtal, const SRadioInit &radio) {
+    return (uint8_t) (((uint32_t) radio.nChannelSpace << 9) / (xtal >> 6) + 1);
+}
+
+constexpr uint32_t spirit1ImageChannelSpaceHz(uint32_t xtal, const SRadioInit &radio) {
+    return (uint32_t) spirit1ImageChannelSpace(xtal, radio) * xtal / CHSPACE_DIVIDER;
+}
+
+/* the center frequency SpiritRadioSetFrequencyBase(base) works out from the registers */
+constexpr uint32_t spirit1ImageCenter(uint32_t xtal, const SRadioInit &radio, uint32_t base) {
+    return base + (uint32_t) spirit1ImageFcOffsetHz(xtal, radio) +
+           spirit1ImageChannelSpaceHz(xtal, radio) * radio.cChannelNumber;
+}
+
+/* the center frequency asked for, signed offset */
+constexpr int64_t spirit1ImageCenterAsked(uint32_t xtal, const SRadioInit &radio) {
+    return (int64_t) radio.lFrequencyBase + (int64_t) spirit1ImageFcOffset(xtal, radio) * xtal / FBASE_DIVIDER +
+           (int64_t) radio.nChannelSpace * radio.cChannelNumber;
+}
+
+/* synthesizer words of SpiritRadioSetFrequencyBase() and SpiritManagementSetFrequencyBase() */
+constexpr uint32_t spirit1ImageSynthWord(uint32_t xtal, uint32_t base) {
+    return (uint32_t) (base * spirit1ImageBandHalfFactor[spirit1ImageBand(base)] * (((double) (FBASE_DIVIDER * 1)) / xtal));
+}
+
+constexpr uint32_t spirit1ImageManagementSynthWord(uint32_t xtal, uint32_t base, uint8_t refDiv) {
+    return (uint32_t) (base * (((double) (FBASE_DIVIDER * refDiv * spirit1ImageBandHalfFactor[spirit1ImageBand(base)])) / xtal));
+}
+
+/* SpiritRadioGetFrequencyBase(), round() of a positive value */
+constexpr uint32_t spirit1ImageFrequencyBase(uint32_t xtal, uint32_t word, uint8_t band, uint8_t refDiv) {
+    return (uint32_t) (word * (((double) xtal) / (FBASE_DIVIDER * refDiv * spirit1ImageBandHalfFactor[band])) + 0.5);
+}
+
+/*
+ * Above DOUBLE_XTAL_THR the VCO calibration workaround reads the base
+ * frequency back, sets it again with the reference divider on (stage 0, the
+ * calibration), reads it back once more and sets it with the divider off
+ * (stage 1). Below, both stages are the setting of SpiritRadioSetFrequencyBase().
+ */
+constexpr bool spirit1ImageRefDivWorkaround(uint32_t xtal) { return xtal > DOUBLE_XTAL_THR; }
+
+constexpr uint32_t spirit1ImageCalibrationBase(uint32_t xtal, uint32_t base) {
+    return spirit1ImageFrequencyBase(xtal, spirit1ImageSynthWord(xtal, base), spirit1ImageBand(base), 1);
+}
+
+constexpr uint32_t spirit1ImageStageBase(uint32_t xtal, uint32_t base, uint8_t stage) {
+    return !spirit1ImageRefDivWorkaround(xtal) ? base : stage == 0 ? spirit1ImageCalibrationBase(xtal, base)
+           : spirit1ImageFrequencyBase(xtal, spirit1ImageManagementSynthWord(xtal, spirit1ImageCalibrationBase(xtal, base), 2),
+                                       spirit1ImageBand(spirit1ImageCalibrationBase(xtal, base)), 2);
+}
+
+constexpr uint32_t spirit1ImageStageWord(uint32_t xtal, uint32_t base, uint8_t stage) {
+    return !spirit1ImageRefDivWorkaround(xtal) ? spirit1ImageSynthWord(xtal, base)
+           : spirit1ImageManagementSynthWord(xtal, spirit1ImageStageBase(xtal, base, stage), stage == 0 ? 2 : 1);
+}
+
+/* SYNTi_BASE + i of a stage */
+constexpr uint8_t spirit1ImageSyntOf(uint32_t word, uint8_t wcp, uint8_t band, uint8_t i) {
+    return i == 0 ? (uint8_t) (((word >> 21) & 0x1F) | (wcp << 5)) : i == 1 ? (uint8_t) ((word >> 13) & 0xFF)
+           : i == 2 ? (uint8_t) ((word >> 5) & 0xFF) : (uint8_t) (((word & 0x1F) << 3) | spirit1ImageBandRegister[band]);
+}
+
+constexpr uint8_t spirit1ImageSynt(uint32_t xtal, const SRadioInit &radio, uint8_t stage, uint8_t i) {
+    return spirit1ImageSyntOf(spirit1ImageStageWord(xtal, radio.lFrequencyBase, stage),
+                              spirit1ImageWcp(spirit1ImageCenter(xtal, radio, spirit1ImageStageBase(xtal, radio.lFrequencyBase, stage))),
+                              spirit1ImageBand(spirit1ImageStageBase(xtal, radio.lFrequencyBase, stage)), i);
+}
+
+/* SpiritCalibrationSelectVco() bits of a stage, then SYNTH_CONFIG1 */
+constexpr uint8_t spirit1ImageVcoSelect(uint32_t base, uint32_t fc) {
+    return fc < spirit1ImageVcoHighFrom[spirit1ImageBand(base)] ? 0x04 : 0x02;
+}
+
+constexpr uint8_t spirit1ImageSynthConfig1(uint32_t xtal, const SRadioInit &radio, uint8_t stage) {
+    return (uint8_t) ((!spirit1ImageRefDivWorkaround(xtal) ? SPIRIT1_IMAGE_RESET_SYNTH_CONFIG1 & 0xF9
+                       : stage == 0 ? (SPIRIT1_IMAGE_RESET_SYNTH_CONFIG1 & 0xF9) | 0x80
+                       : SPIRIT1_IMAGE_RESET_SYNTH_CONFIG1 & 0x79) |
+                      spirit1ImageVcoSelect(spirit1ImageStageBase(xtal, radio.lFrequencyBase, stage),
+                                            spirit1ImageCenter(xtal, radio, spirit1ImageStageBase(xtal, radio.lFrequencyBase, stage))));
+}
+
+/* SpiritRadioSearchDatarateME(), the closest of three mantissas */
+constexpr int8_t spirit1ImageDatarateE(uint32_t datarate, uint32_t xtal, int8_t i) {
+    return i < 0 ? 0 : datarate >= (xtal >> (20 - i + spirit1ImageDigDiv(xtal))) ? i
+           : spirit1ImageDatarateE(datarate, xtal, i - 1);
+}
+
+constexpr uint8_t spirit1ImageDatarateMantissa(uint32_t datarate, uint32_t xtal, int8_t e) {
+    return (uint8_t) ((datarate * ((uint32_t) 1 << (23 - e))) / (xtal >> (5 + spirit1ImageDigDiv(xtal))) - 256);
+}
+
+constexpr int spirit1ImageDatarateError(uint32_t datarate, uint32_t xtal, int8_t e, int m) {
+    return m ? S_ABS((int16_t) (datarate - (((uint32_t) (256 + m) * (xtal >> (5 + spirit1ImageDigDiv(xtal)))) >> (23 - e))))
+             : 0x7FFF;
+}
+
+/* 0, 1 or 2: the first of the smallest errors */
+constexpr uint8_t spirit1ImageClosest(int e0, int e1, int e2) {
+    return e1 < e0 ? (e2 < e1 ? 2 : 1) : (e2 < e0 ? 2 : 0);
+}
+
+constexpr uint8_t spirit1ImageMod1Of(uint32_t datarate, uint32_t xtal, int8_t e, uint8_t m) {
+    return (uint8_t) (m - 1 + spirit1ImageClosest(spirit1ImageDatarateError(datarate, xtal, e, m - 1),
+                                                  spirit1ImageDatarateError(datarate, xtal, e, m),
+                                                  spirit1ImageDatarateError(datarate, xtal, e, m + 1)));
+}
+
+constexpr uint8_t spirit1ImageMod1(uint32_t xtal, const SRadioInit &radio) {
+    return spirit1ImageMod1Of(radio.lDatarate, xtal, spirit1ImageDatarateE(radio.lDatarate, xtal, 15),
+                              spirit1ImageDatarateMantissa(radio.lDatarate, xtal,
+                                                           spirit1ImageDatarateE(radio.lDatarate, xtal, 15)));
+}
+
+constexpr uint8_t spirit1ImageMod0(uint32_t xtal, const SRadioInit &radio) {
+    return (uint8_t) (0x00 | radio.xModulationSelect | spirit1ImageDatarateE(radio.lDatarate, xtal, 15));
+}
+
+/* SpiritRadioSearchFreqDevME() */
+constexpr float spirit1ImageXtalDiv(uint32_t xtal) { return (float) xtal / (((uint32_t) 1) << 18); }
+
+constexpr uint8_t spirit1ImageFdevE(uint32_t fdev, uint32_t xtal, uint8_t i) {
+    return i < 10 && !(fdev < (uint32_t) (spirit1ImageXtalDiv(xtal) * (uint32_t) (7.5 * (1 << i))))
+           ? spirit1ImageFdevE(fdev, xtal, i + 1) : i;
+}
+
+constexpr uint32_t spirit1ImageFdevAt(uint32_t xtal, uint8_t e, uint8_t m) {
+    return (uint32_t) (spirit1ImageXtalDiv(xtal) * (uint32_t) ((8.0 + m) / 2 * (1 << e)));
+}
+
+constexpr uint8_t spirit1ImageFdevSearch(uint32_t fdev, uint32_t xtal, uint8_t e, uint8_t i) {
+    return i < 8 && !(fdev < spirit1ImageFdevAt(xtal, e, i)) ? spirit1ImageFdevSearch(fdev, xtal, e, i + 1) : i;
+}
+
+/* m the first mantissa above fdev (8: none), b its deviation, bp that of the one below */
+constexpr uint8_t spirit1ImageFdevMOf(uint32_t fdev, uint8_t m, uint32_t b, uint32_t bp) {
+    return (fdev - bp) < (b - fdev) ? (uint8_t) (m - 1) : m;
+}
+
+constexpr uint8_t spirit1ImageFdevM(uint32_t fdev, uint32_t xtal, uint8_t e, uint8_t m) {
+    return spirit1ImageFdevMOf(fdev, m, spirit1ImageFdevAt(xtal, e, m < 8 ? m : 7),
+                               m == 0 ? 0 : spirit1ImageFdevAt(xtal, e, m < 8 ? m - 1 : 6));
+}
+
+constexpr uint8_t spirit1ImageFdev0Of(uint32_t fdev, uint32_t xtal, uint8_t e) {
+    return (uint8_t) ((e << 4) | (SPIRIT1_IMAGE_RESET_FDEV0 & 0x08) |
+                      spirit1ImageFdevM(fdev, xtal, e, spirit1ImageFdevSearch(fdev, xtal, e, 0)));
+}
+
+constexpr uint8_t spirit1ImageFdev0(uint32_t xtal, const SRadioInit &radio) {
+    return spirit1ImageFdev0Of(radio.lFreqDev, xtal, spirit1ImageFdevE(radio.lFreqDev, xtal, 0));
+}
+
+/* SpiritRadioSearchChannelBwME() */
+constexpr uint32_t spirit1ImageChfltFactor(uint32_t xtal) { return (xtal / (spirit1ImageDigDiv(xtal) ? 2 : 1)) / 100; }
+
+constexpr uint32_t spirit1ImageBandwidthAt(uint32_t xtal, int i) {
+    return (uint32_t) (((uint32_t) spirit1ImageBandwidth26M[i] * spirit1ImageChfltFactor(xtal)) / 2600);
+}
+
+constexpr int spirit1ImageBandwidthSearch(uint32_t bandwidth, uint32_t xtal, int i) {
+    return i < 90 && bandwidth < spirit1ImageBandwidthAt(xtal, i) ? spirit1ImageBandwidthSearch(bandwidth, xtal, i + 1) : i;
+}
+
+constexpr int spirit1ImageBandwidthError(uint32_t bandwidth, uint32_t xtal, int i) {
+    return i >= 0 && i <= 89 ? S_ABS((int16_t) (bandwidth - spirit1ImageBandwidthAt(xtal, i))) : 0x7FFF;
+}
+
+constexpr uint8_t spirit1ImageChfltOf(int i) { return (uint8_t) (((i % 9) << 4) | (i / 9)); }
+
+constexpr uint8_t spirit1ImageChfltNear(uint32_t bandwidth, uint32_t xtal, int i) {
+    return spirit1ImageChfltOf(i == 0 ? 0 : i - 1 + spirit1ImageClosest(spirit1ImageBandwidthError(bandwidth, xtal, i - 1),
+                                                                        spirit1ImageBandwidthError(bandwidth, xtal, i),
+                                                                        spirit1ImageBandwidthError(bandwidth, xtal, i + 1)));
+}
+
+constexpr uint8_t spirit1ImageChflt(uint32_t xtal, const SRadioInit &radio) {
+    return spirit1ImageChfltNear(radio.lBandwidth, xtal, spirit1ImageBandwidthSearch(radio.lBandwidth, xtal, 0));
+}
+
+/* IF_OFFSET_ANA (shift 12) and IF_OFFSET_DIG, ROUND() of SPIRIT_Radio.c */
+constexpr uint8_t spirit1ImageRound(float a) {
+    return (uint8_t) ((a - (uint32_t) a) > 0.5 ? (uint32_t) a + 1 : (uint32_t) a);
+}
+
+constexpr uint8_t spirit1ImageIfOffset(uint32_t xtal, uint8_t shift) {
+    return spirit1ImageRound((float) ((3.0 * 480140) / (xtal >> shift) - 64));
+}
+
+/* PCKTCTRL4_BASE + i of SpiritPktBasicInit() */
+constexpr uint8_t spirit1ImageSync(const PktBasicInit &packet, int i) {
+    return i < 3 - (packet.xSyncLength >> 1) ? 0 : (uint8_t) (packet.lSyncWords >> (8 * i));
+}
+
+constexpr bool spirit1ImageFlag(SpiritFunctionalState state) { return state == S_ENABLE || state == S_DISABLE; }
+
+constexpr Spirit1RegisterImage spirit1ImageBuild(uint32_t xtal, const SRadioInit &radio, const PktBasicInit &packet) {
+    return Spirit1RegisterImage{
+        xtal, radio.lFrequencyBase,
+        (uint8_t) ((xtal > DOUBLE_XTAL_THR ? xtal / 2 : xtal) >= 25e6 ? SPIRIT1_IMAGE_RESET_ANA_FUNC_CONF0 | SELECT_24_26_MHZ_MASK
+                                                                       : SPIRIT1_IMAGE_RESET_ANA_FUNC_CONF0 & ~SELECT_24_26_MHZ_MASK),
+        (uint8_t) (xtal < DOUBLE_XTAL_THR ? SPIRIT1_IMAGE_RESET_XO_RCO_TEST | 0x08 : SPIRIT1_IMAGE_RESET_XO_RCO_TEST & 0xF7),
+        {spirit1ImageIfOffset(xtal, 12),
+         spirit1ImageSynt(xtal, radio, 0, 0), spirit1ImageSynt(xtal, radio, 0, 1),
+         spirit1ImageSynt(xtal, radio, 0, 2), spirit1ImageSynt(xtal, radio, 0, 3),
+         spirit1ImageChannelSpace(xtal, radio),
+         xtal < DOUBLE_XTAL_THR ? spirit1ImageIfOffset(xtal, 12) : spirit1ImageIfOffset(xtal, 13),
+         (uint8_t) ((((uint16_t) spirit1ImageFcOffset(xtal, radio)) >> 8) & 0x0F),
+         (uint8_t) spirit1ImageFcOffset(xtal, radio)},
+        {spirit1ImageMod1(xtal, radio), spirit1ImageMod0(xtal, radio), spirit1ImageFdev0(xtal, radio),
+         spirit1ImageChflt(xtal, radio), (uint8_t) (SPIRIT1_IMAGE_RESET_AFC2 | AFC2_AFC_FREEZE_ON_SYNC_MASK)},
+        {(uint8_t) ((packet.xAddressField == S_ENABLE ? 0x08 : 0x00) | packet.xControlLength),
+         (uint8_t) (PCKTCTRL3_PCKT_FRMT_BASIC | ((packet.cPktLengthWidth ? packet.cPktLengthWidth : 1) - 1)),
+         (uint8_t) (packet.xPreambleLength | packet.xSyncLength | packet.xFixVarLength),
+         (uint8_t) (packet.xCrcMode | (packet.xDataWhitening == S_ENABLE ? PCKTCTRL1_WHIT_MASK : 0) |
+                    (packet.xFec == S_ENABLE ? PCKTCTRL1_FEC_MASK : 0)),
+         SPIRIT1_IMAGE_RESET_PCKTLEN1, SPIRIT1_IMAGE_RESET_PCKTLEN0,
+         spirit1ImageSync(packet, 0), spirit1ImageSync(packet, 1), spirit1ImageSync(packet, 2), spirit1ImageSync(packet, 3)},
+        {(uint8_t) ((SPIRIT1_IMAGE_RESET_PCKT_FLT_OPTIONS &
+                     ~(PCKT_FLT_OPTIONS_SOURCE_FILTERING_MASK | PCKT_FLT_OPTIONS_CONTROL_FILTERING_MASK | PCKT_FLT_OPTIONS_CRC_CHECK_MASK)) |
+                    (packet.xCrcMode != PKT_NO_CRC ? PCKT_FLT_OPTIONS_CRC_CHECK_MASK : 0)),
+         (uint8_t) (SPIRIT1_IMAGE_RESET_PROTOCOL2 & ~PROTOCOL2_VCO_CALIBRATION_MASK),
+         (uint8_t) ((SPIRIT1_IMAGE_RESET_PROTOCOL1 & ~0x20) | PROTOCOL1_AUTO_PCKT_FLT_MASK)},
+        radio.cChannelNumber,
+        {0x80, 0xE3},
+        {spirit1ImageSynthConfig1(xtal, radio, 0), 0xA0},
+        0x25,
+        (uint8_t) (SPIRIT1_IMAGE_RESET_DEM_CONFIG & ~0x02),
+        0x22,
+        {spirit1ImageSynt(xtal, radio, 1, 0), spirit1ImageSynt(xtal, radio, 1, 1),
+         spirit1ImageSynt(xtal, radio, 1, 2), spirit1ImageSynt(xtal, radio, 1, 3)},
+        spirit1ImageSynthConfig1(xtal, radio, 1)};
+}
+
+/**
+ * The registers SpiritRadioSetXtalFrequency(xtal), SpiritRadioInit(radio)
+ * and SpiritPktBasicInit(packet) write after SRES, the calibration words
+ * aside; a constant if the parameters are, an invalid parameter does not
+ * compile then. xtal: 24 to 26 MHz or 48 to 52 MHz.
+ */
+constexpr Spirit1RegisterImage spirit1RegisterImage(uint32_t xtal, const SRadioInit &radio, const PktBasicInit &packet) {
+    return !(xtal >= 24000000 && xtal <= 26000000) && !(xtal >= 48000000 && xtal <= 52000000) ? spirit1ImageXtalNotSupported()
+           : !IS_FREQUENCY_BAND(radio.lFrequencyBase) ? spirit1ImageFrequencyOutOfBand()
+           : !IS_MODULATION_SELECTED(radio.xModulationSelect) ? spirit1ImageModulationUnknown()
+           : !IS_DATARATE(radio.lDatarate) ? spirit1ImageDatarateOutOfRange()
+           : !IS_FREQUENCY_OFFSET(spirit1ImageOffsetHz(radio), xtal) ? spirit1ImageOffsetOutOfRange()
+           : !IS_CHANNEL_SPACE(radio.nChannelSpace, xtal) ? spirit1ImageChannelSpaceOutOfRange()
+           : !IS_F_DEV(radio.lFreqDev, xtal) ? spirit1ImageFrequencyDeviationOutOfRange()
+           : !(xtal < DOUBLE_XTAL_THR ? IS_CH_BW(radio.lBandwidth, xtal) : IS_CH_BW(radio.lBandwidth, (xtal >> 1)))
+             ? spirit1ImageBandwidthOutOfRange()
+           : !IS_FREQUENCY_BAND(spirit1ImageCenterAsked(xtal, radio)) ? spirit1ImageCenterFrequencyOutOfBand()
+           : !IS_PKT_PREAMBLE_LENGTH(packet.xPreambleLength) ? spirit1ImagePreambleLengthInvalid()
+           : !IS_PKT_SYNC_LENGTH(packet.xSyncLength) ? spirit1ImageSyncLengthInvalid()
+           : !IS_PKT_CRC_MODE(packet.xCrcMode) ? spirit1ImageCrcModeInvalid()
+           : !IS_PKT_LENGTH_WIDTH_BITS(packet.cPktLengthWidth) ? spirit1ImageLengthWidthOutOfRange()
+           : !IS_PKT_CONTROL_LENGTH(packet.xControlLength) ? spirit1ImageControlLengthInvalid()
+           : !IS_PKT_FIX_VAR_LENGTH(packet.xFixVarLength) || !spirit1ImageFlag(packet.xAddressField) ||
+             !spirit1ImageFlag(packet.xFec) || !spirit1ImageFlag(packet.xDataWhitening) ? spirit1ImagePacketFlagInvalid()
+           : spirit1ImageBuild(xtal, radio, packet);
+}
+
+/**
+ * Loads image into a radio fresh out of SRES and calibrates the VCO, the
+ * radio ends in READY like after SpiritRadioInit(). Returns 0, 1 for an
+ * invalid image or a state not reached (see @ref SpiritWaitState()).
+ */
+inline uint8_t spirit1ImageLoad(const Spirit1RegisterImage &image) {
+    /* the library takes non-const buffers */
+    Spirit1RegisterImage registers = image;
+    uint8_t calibration[2];
+
+    if (!image.xtal) return 1;
+    SpiritRadioSetXtalFrequency(image.xtal);
+
+    /* the clock divider is set in STANDBY, as SpiritRadioInit() does */
+    SpiritCmdStrobeStandby();
+    if (SpiritWaitState(MC_STATE_STANDBY, SPIRIT_WAIT_STATE_TIMEOUT_US) != SPIRIT_WAIT_OK) return 1;
+    SpiritSpiWriteRegisters(XO_RCO_TEST_BASE, 1, &registers.xoRcoTest);
+    SpiritCmdStrobeReady();
+    if (SpiritWaitState(MC_STATE_READY, SPIRIT_WAIT_XO_TIMEOUT_US) != SPIRIT_WAIT_OK) return 1;
+    SpiritManagementWaTRxFcMem(image.frequencyBase);
+
+    /* everything, with the synthesizer as the VCO calibration wants it and the calibration on */
+    registers.protocol[1] |= PROTOCOL2_VCO_CALIBRATION_MASK;
+    SpiritSpiWriteRegisters(ANA_FUNC_CONF0_BASE, 1, &registers.anaFuncConf0);
+    SpiritSpiWriteRegisters(IF_OFFSET_ANA_BASE, sizeof(registers.radio), registers.radio);
+    SpiritSpiWriteRegisters(MOD1_BASE, sizeof(registers.modem), registers.modem);
+    SpiritSpiWriteRegisters(PCKTCTRL4_BASE, sizeof(registers.packet), registers.packet);
+    SpiritSpiWriteRegisters(PCKT_FLT_OPTIONS_BASE, sizeof(registers.protocol), registers.protocol);
+    SpiritSpiWriteRegisters(CHNUM_BASE, 1, &registers.channel);
+    SpiritSpiWriteRegisters(0x99, sizeof(registers.iqc), registers.iqc);
+    SpiritSpiWriteRegisters(SYNTH_CONFIG1_BASE, sizeof(registers.synthConfig), registers.synthConfig);
+    SpiritSpiWriteRegisters(VCO_CONFIG_BASE, 1, &registers.vcoConfig);
+    SpiritSpiWriteRegisters(0xA3, 1, &registers.demConfig);
+    SpiritSpiWriteRegisters(0xBC, 1, &registers.vcoWorkaround);
+
+    /* SpiritManagementWaVcoCalibration() from READY */
+    SpiritCmdStrobeLockTx();
+    if (SpiritWaitState(MC_STATE_LOCK, SPIRIT_WAIT_LOCK_TIMEOUT_US) != SPIRIT_WAIT_OK) return 1;
+    calibration[0] = SpiritCalibrationGetVcoCalData();
+    SpiritCmdStrobeReady();
+    if (SpiritWaitState(MC_STATE_READY, SPIRIT_WAIT_STATE_TIMEOUT_US) != SPIRIT_WAIT_OK) return 1;
+    SpiritCmdStrobeLockRx();
+    if (SpiritWaitState(MC_STATE_LOCK, SPIRIT_WAIT_LOCK_TIMEOUT_US) != SPIRIT_WAIT_OK) return 1;
+    calibration[1] = SpiritCalibrationGetVcoCalData();
+    SpiritCmdStrobeReady();
+    if (SpiritWaitState(MC_STATE_READY, SPIRIT_WAIT_STATE_TIMEOUT_US) != SPIRIT_WAIT_OK) return 1;
+
+    registers.protocol[1] = image.protocol[1];
+    SpiritSpiWriteRegisters(PROTOCOL2_BASE, 1, &registers.protocol[1]);
+    if (memcmp(image.synth, image.radio + 1, sizeof(image.synth)) || image.synthConfig1 != image.synthConfig[0]) {
+        SpiritSpiWriteRegisters(SYNTH_CONFIG1_BASE, 1, &registers.synthConfig1);
+        SpiritSpiWriteRegisters(SYNT3_BASE, sizeof(registers.synth), registers.synth);
+    }
+    /* RCO_VCO_CALIBR_IN1..0: the RCO bits are 0 after reset */
+    SpiritSpiWriteRegisters(RCO_VCO_CALIBR_IN1_BASE, sizeof(calibration), calibration);
+    return 0;
+}
+
+#endif // SPIRIT1_REGISTER_IMAGE_H
@@ -0,0 +1,168 @@
+/**
+ * Queue of received SPIRIT1 packets between the radio thread and the
+ * application.
+ *
+ * A lock-free single producer, single consumer ring of fixed size packet
+ * descriptors: the radio bottom half claims a free slot, fills it straight
+ * from the RX FIFO and commits it; an application thread takes the packets
+ * in order. Neither side ever waits for the other, a packet that finds the
+ * ring full is dropped and counted.
+ *
+ * Each descriptor carries the payload and the RX information of the packet
+ * (RSSI, LQI, SQI, PQI, addresses, sequence number), read with one burst of
+ * the RX_PCKT_INFO..RX_ADDR_FIELD0 status registers, and the time of the
+ * nIRQ edge passed in by the caller (us_ticker_read() on the target). Usage:
+ *
+ *   Spirit1RxRing<16> rxRing;
+ *
+ *   // radio thread, on RX_DATA_READY
+ *   spirit1RxReceive(rxRing, irqEdgeUs);
+ *
+ *   // application thread
+ *   Spirit1RxPacket packet;
+ *   while (rxRing.pop(packet)) handle(packet);
+ */
+#ifndef SPIRIT1_RX_RING_H
+#define SPIRIT1_RX_RING_H
+
+#include <stdint.h>
+#include <string.h>
+#include "SPIRIT_Config.h"
+
+/* the linear FIFO */
+#define SPIRIT1_RX_PAYLOAD_MAX 96
+
+/** RX information of a packet */
+struct Spirit1RxInfo {
+    uint8_t rssi;             /*!< RSSI_LEVEL, dBm = rssi / 2 - 130 */
+    uint8_t lqi;
+    uint8_t sqi;
+    uint8_t pqi;
+    uint8_t source;           /*!< RX_ADDR_FIELD1, STack */
+    uint8_t destination;      /*!< RX_ADDR_FIELD0 */
+    uint8_t seq;              /*!< STack sequence number */
+    uint32_t timestampUs;     /*!< nIRQ edge of RX_DATA_READY */
+};
+
+struct Spirit1RxPacket : Spirit1RxInfo {
+    uint8_t payload[SPIRIT1_RX_PAYLOAD_MAX];
+    uint8_t length;
+};
+
+typedef struct {
+    uint32_t produced;        /*!< packets committed by the radio thread */
+    uint32_t consumed;
+    uint32_t overflows;       /*!< packets dropped, ring full */
+    uint32_t highWater;       /*!< most packets queued at once */
+} Spirit1RxRingStats;
+
+/** Size must be a power of two; T is the descriptor, e.g. a pointer to a pool buffer (spirit1BufferPool.h) */
+template<uint32_t Size, typename T = Spirit1RxPacket>
+class Spirit1RxRing {
+public:
+    Spirit1RxRing() : _head(0), _tail(0) {
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    /* producer */
+
+    /** the slot to fill for the next packet, NULL if the ring is full (counted as an overflow) */
+    T *claim() {
+        uint32_t head = _head;
+        if (head - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE) == Size) {
+            _stats.overflows++;
+            return NULL;
+        }
+        return &_slots[head & (Size - 1)];
+    }
+
+    /** hands the claimed slot over to the consumer */
+    void commit() {
+        uint32_t head = _head + 1;
+        __atomic_store_n(&_head, head, __ATOMIC_RELEASE);
+        _stats.produced++;
+        uint32_t queued = head - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+        if (queued > _stats.highWater) _stats.highWater = queued;
+    }
+
+    /* consumer */
+
+    /** the oldest packet, NULL if there is none; valid until release() */
+    const T *front() const {
+        uint32_t tail = _tail;
+        if (__atomic_load_n(&_head, __ATOMIC_ACQUIRE) == tail) return NULL;
+        return &_slots[tail & (Size - 1)];
+    }
+
+    /** frees the packet returned by front() */
+    void release() {
+        __atomic_store_n(&_tail, _tail + 1, __ATOMIC_RELEASE);
+        _stats.consumed++;
+    }
+
+    /** copies out the oldest packet, false if there is none */
+    bool pop(T &packet) {
+        const T *slot = front();
+        if (!slot) return false;
+        packet = *slot;
+        release();
+        return true;
+    }
+
+    /* either side */
+
+    uint32_t count() const {
+        return __atomic_load_n(&_head, __ATOMIC_ACQUIRE) - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+    }
+
+    /** produced, overflows and highWater are written by the producer, consumed by the consumer */
+    const Spirit1RxRingStats &stats() const { return _stats; }
+
+    void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+
+private:
+    T _slots[Size];
+    uint32_t _head;           /*!< written by the producer only */
+    uint32_t _tail;           /*!< written by the consumer only */
+    Spirit1RxRingStats _stats;
+
+    typedef char sizeIsAPowerOfTwo[(Size & (Size - 1)) == 0 && Size ? 1 : -1];
+};
+
+/** reads the RX information of the last packet, one burst of RX_PCKT_INFO..RX_ADDR_FIELD0 */
+inline void spirit1RxReadInfo(Spirit1RxInfo *rx, uint32_t timestampUs) {
+    uint8_t info[RX_ADDR_FIELD0_BASE - RX_PCKT_INFO_BASE + 1];
+
+    SpiritSpiReadRegisters(RX_PCKT_INFO_BASE, sizeof(info), info);
+    rx->seq = info[0] & 0x03;
+    rx->pqi = info[LINK_QUALIF2_BASE - RX_PCKT_INFO_BASE];
+    rx->sqi = info[LINK_QUALIF1_BASE - RX_PCKT_INFO_BASE] & 0x7F;
+    rx->lqi = (uint8_t) ((info[LINK_QUALIF0_BASE - RX_PCKT_INFO_BASE] & 0xF0) >> 4);
+    rx->rssi = info[RSSI_LEVEL_BASE - RX_PCKT_INFO_BASE];
+    rx->source = info[RX_ADDR_FIELD1_BASE - RX_PCKT_INFO_BASE];
+    rx->destination = info[RX_ADDR_FIELD0_BASE - RX_PCKT_INFO_BASE];
+    rx->timestampUs = timestampUs;
+}
+
+/**
+ * bottom half of RX_DATA_READY: reads the packet and its RX information into
+ * the next slot of ring. Returns false if the ring is full, the packet is then
+ * left in the RX FIFO.
+ */
+template<uint32_t Size>
+bool spirit1RxReceive(Spirit1RxRing<Size> &ring, uint32_t timestampUs) {
+    Spirit1RxPacket *packet = ring.claim();
+    if (!packet) return false;
+
+    spirit1RxReadInfo(packet, timestampUs);
+
+    uint8_t length = SpiritLinearFifoReadNumElementsRxFifo();
+    if (length > SPIRIT1_RX_PAYLOAD_MAX) length = SPIRIT1_RX_PAYLOAD_MAX;
+    SpiritSpiReadLinearFifo(length, packet->payload);
+    packet->length = length;
+
+    ring.commit();
+    return true;
+}
+
+#endif // SPIRIT1_RX_RING_H
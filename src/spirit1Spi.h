@@ -0,0 +1,217 @@
+/**
+ * SPIRIT1 SPI protocol engine.
+ *
+ * Frames the SPIRIT1 SPI transactions (header, address/command, payload) on top
+ * of a bus adapter and offers two ways to clock the payload:
+ *
+ *  - a blocking byte path, used for short register accesses and whenever the
+ *    caller cannot block (interrupt context)
+ *  - an asynchronous burst path, where the payload is handed to the bus as one
+ *    transfer (DMA on the target) and completion is signalled from the bus
+ *    interrupt, used for FIFO drain/fill and large register reads
+ *
+ * The bus adapter is a template parameter, so the engine compiles to direct
+ * calls on the target and can be driven by a stand-in bus on the host.
+ * A bus adapter provides:
+ *
+ *   void     lock();                 // take exclusive ownership of the bus
+ *   void     unlock();
+ *   void     select();               // chip select low
+ *   void     deselect();             // chip select high
+ *   uint8_t  write(uint8_t value);   // blocking single byte exchange
+ *   bool     canBlock();             // false in interrupt context
+ *   uint32_t nowUs();                // free running microsecond counter
+ *   bool     startTransfer(const uint8_t *tx, uint8_t *rx, uint16_t n,
+ *                          void (*done)(void *), void *context);
+ *   void     waitTransfer();         // block until done() has been called
+ *
+ * startTransfer() must call done(context) exactly once after the last byte,
+ * typically from interrupt context. tx or rx may be NULL.
+ */
+#ifndef SPIRIT1_SPI_H
+#define SPIRIT1_SPI_H
+
+#include <stdint.h>
+#include <string.h>
+#include "MCU_Interface.h"
+
+#define HEADER_WRITE_MASK     0x00 /*!< Write mask for header byte*/
+#define HEADER_READ_MASK      0x01 /*!< Read mask for header byte*/
+#define HEADER_ADDRESS_MASK   0x00 /*!< Address mask for header byte*/
+#define HEADER_COMMAND_MASK   0x80 /*!< Command mask for header byte*/
+
+#define LINEAR_FIFO_ADDRESS 0xFF  /*!< Linear FIFO address*/
+
+#define BUILT_HEADER(add_comm, w_r) (add_comm | w_r)  /*!< macro to build the header byte*/
+#define WRITE_HEADER    BUILT_HEADER(HEADER_ADDRESS_MASK, HEADER_WRITE_MASK) /*!< macro to build the write header byte*/
+#define READ_HEADER     BUILT_HEADER(HEADER_ADDRESS_MASK, HEADER_READ_MASK)  /*!< macro to build the read header byte*/
+#define COMMAND_HEADER  BUILT_HEADER(HEADER_COMMAND_MASK, HEADER_WRITE_MASK) /*!< macro to build the command header byte*/
+
+/* payloads of at least this many bytes go through the burst path */
+#ifndef SPIRIT1_SPI_BURST_MIN
+#define SPIRIT1_SPI_BURST_MIN 16
+#endif
+
+/** completion event of an asynchronous transaction, called from the bus interrupt */
+typedef void (*Spirit1SpiDone)(void *context, StatusBytes status);
+
+typedef struct {
+    uint32_t transactions;  /*!< all transactions, including strobes */
+    uint32_t bursts;        /*!< transactions that went through the burst path */
+    uint32_t bytes;         /*!< bytes on the wire, including the two header bytes */
+    uint32_t busyUs;        /*!< time the CPU spent clocking bytes or servicing the bus */
+} Spirit1SpiStats;
+
+template<typename Bus>
+class Spirit1Spi {
+public:
+    explicit Spirit1Spi(Bus &bus)
+            : _bus(bus), _burstMin(SPIRIT1_SPI_BURST_MIN), _pending(false), _done(NULL), _context(NULL), _bytes(0) {
+        memset(&_status, 0, sizeof(_status));
+        resetStats();
+    }
+
+    StatusBytes writeRegisters(uint8_t address, uint8_t n, uint8_t *buffer) {
+        return transfer(WRITE_HEADER, address, n, buffer, NULL);
+    }
+
+    StatusBytes readRegisters(uint8_t address, uint8_t n, uint8_t *buffer) {
+        return transfer(READ_HEADER, address, n, NULL, buffer);
+    }
+
+    StatusBytes commandStrobe(uint8_t command) {
+        return transfer(COMMAND_HEADER, command, 0, NULL, NULL);
+    }
+
+    StatusBytes writeFifo(uint8_t n, uint8_t *buffer) {
+        return transfer(WRITE_HEADER, LINEAR_FIFO_ADDRESS, n, buffer, NULL);
+    }
+
+    StatusBytes readFifo(uint8_t n, uint8_t *buffer) {
+        return transfer(READ_HEADER, LINEAR_FIFO_ADDRESS, n, NULL, buffer);
+    }
+
+    /**
+     * Full duplex transaction. Payloads of at least the burst threshold are
+     * sent as one burst when the caller is allowed to block, everything else
+     * is clocked byte by byte.
+     */
+    StatusBytes transfer(uint8_t header, uint8_t address, uint8_t n, const uint8_t *tx, uint8_t *rx) {
+        if (n && n >= _burstMin && _bus.canBlock()) {
+            if (start(header, address, n, tx, rx, NULL, NULL)) return wait();
+        }
+
+        uint32_t begin = _bus.nowUs();
+        _bus.lock();
+        _bus.select();
+        StatusBytes status = header2(header, address);
+        for (int i = 0; i < n; i++) {
+            uint8_t value = _bus.write(tx ? tx[i] : 0);
+            if (rx) rx[i] = value;
+        }
+        _bus.deselect();
+        _bus.unlock();
+        account(n, _bus.nowUs() - begin);
+        return status;
+    }
+
+    /**
+     * Start an asynchronous FIFO drain. Returns false if another asynchronous
+     * transaction is still pending. done is called from the bus interrupt once
+     * the data is in buffer; wait() must be called afterwards from thread
+     * context to release the bus.
+     */
+    bool readFifoAsync(uint8_t n, uint8_t *buffer, Spirit1SpiDone done, void *context) {
+        return start(READ_HEADER, LINEAR_FIFO_ADDRESS, n, NULL, buffer, done, context);
+    }
+
+    /** Start an asynchronous FIFO fill, see readFifoAsync(). */
+    bool writeFifoAsync(uint8_t n, const uint8_t *buffer, Spirit1SpiDone done, void *context) {
+        return start(WRITE_HEADER, LINEAR_FIFO_ADDRESS, n, buffer, NULL, done, context);
+    }
+
+    /** Start an asynchronous register read, see readFifoAsync(). */
+    bool readRegistersAsync(uint8_t address, uint8_t n, uint8_t *buffer, Spirit1SpiDone done, void *context) {
+        return start(READ_HEADER, address, n, NULL, buffer, done, context);
+    }
+
+    /** Block until the pending asynchronous transaction is complete and release the bus. */
+    StatusBytes wait() {
+        if (_pending) {
+            _bus.waitTransfer();
+            _bus.unlock();
+            _pending = false;
+        }
+        return _status;
+    }
+
+    bool busy() const { return _pending; }
+
+    /** Smallest payload sent as a burst, 256 disables the burst path for blocking calls. */
+    void setBurstThreshold(uint16_t bytes) { _burstMin = bytes; }
+
+    const Spirit1SpiStats &stats() const { return _stats; }
+
+    void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+
+private:
+    StatusBytes header2(uint8_t header, uint8_t address) {
+        uint8_t first = _bus.write(header);
+        uint8_t second = _bus.write(address);
+        uint16_t word = (uint16_t) (first << 8 | second);
+        StatusBytes status;
+        memset(&status, 0, sizeof(status));
+        memcpy(&status, &word, sizeof(word));
+        return status;
+    }
+
+    bool start(uint8_t header, uint8_t address, uint8_t n, const uint8_t *tx, uint8_t *rx,
+               Spirit1SpiDone done, void *context) {
+        if (_pending) return false;
+
+        uint32_t begin = _bus.nowUs();
+        _bus.lock();
+        _bus.select();
+        _status = header2(header, address);
+        _pending = true;
+        _done = done;
+        _context = context;
+        _bytes = n;
+        _stats.bursts++;
+        _stats.busyUs += _bus.nowUs() - begin;
+
+        if (!_bus.startTransfer(tx, rx, n, &Spirit1Spi::onTransferDone, this)) {
+            _bus.deselect();
+            _bus.unlock();
+            _pending = false;
+            _stats.bursts--;
+            return false;
+        }
+        return true;
+    }
+
+    static void onTransferDone(void *self) {
+        Spirit1Spi *spi = static_cast<Spirit1Spi *>(self);
+        uint32_t begin = spi->_bus.nowUs();
+        spi->_bus.deselect();
+        if (spi->_done) spi->_done(spi->_context, spi->_status);
+        spi->account(spi->_bytes, spi->_bus.nowUs() - begin);
+    }
+
+    void account(uint8_t n, uint32_t us) {
+        _stats.transactions++;
+        _stats.bytes += 2 + n;
+        _stats.busyUs += us;
+    }
+
+    Bus &_bus;
+    uint16_t _burstMin;
+    volatile bool _pending;
+    Spirit1SpiDone _done;
+    void *_context;
+    uint8_t _bytes;
+    StatusBytes _status;
+    Spirit1SpiStats _stats;
+};
+
+#endif // SPIRIT1_SPI_H
@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include "spirit1Trace.h"
+
+#ifdef __MBED__
+#include "mbed.h"
+#else
+#include <chrono>
+#endif
+
+/* where the dump and ring output goes, printf() on the console by default */
+#ifndef SPIRIT1_TRACE_PRINTF
+#define SPIRIT1_TRACE_PRINTF printf
+#else
+int SPIRIT1_TRACE_PRINTF(const char *format, ...);
+#endif
+
+Spirit1TraceCounters spirit1TraceCounters;
+Spirit1TraceRecord spirit1TraceRing[SPIRIT1_TRACE_RING_SIZE];
+uint32_t spirit1TraceRingIndex;
+
+static const char *const kindNames[SPIRIT1_TRACE_KINDS] = {"WRTE", "READ", "CMD ", "WFIF", "RFIF"};
+
+uint32_t spirit1TraceNowUs() {
+#ifdef __MBED__
+    return us_ticker_read();
+#else
+    return (uint32_t) std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void spirit1TraceHexDump(const char *prefix, const uint8_t *b, size_t size) {
+    for (size_t i = 0; i < size; i += 16) {
+        if (prefix && strlen(prefix) > 0) SPIRIT1_TRACE_PRINTF("%s %06x: ", prefix, (unsigned) i);
+        for (size_t j = 0; j < 16; j++) {
+            if ((i + j) < size) SPIRIT1_TRACE_PRINTF("%02x", b[i + j]); else SPIRIT1_TRACE_PRINTF("  ");
+            if ((j + 1) % 2 == 0) SPIRIT1_TRACE_PRINTF(" ");
+        }
+        SPIRIT1_TRACE_PRINTF(" ");
+        for (size_t j = 0; j < 16 && (i + j) < size; j++) {
+            SPIRIT1_TRACE_PRINTF("%c", b[i + j] >= 0x20 && b[i + j] <= 0x7E ? b[i + j] : '.');
+        }
+        SPIRIT1_TRACE_PRINTF("\r\n");
+    }
+}
+
+void spirit1TraceDump(uint8_t kind, uint8_t address, uint8_t n, const uint8_t *data, StatusBytes status) {
+    uint16_t word;
+    memcpy(&word, &status, sizeof(word));
+    SPIRIT1_TRACE_PRINTF("%s %02x=%04x (%d)\r\n", kindNames[kind], address, word, n);
+    if (n && data) spirit1TraceHexDump(kindNames[kind], data, n);
+}
+
+void spirit1TraceDumpRing() {
+    uint32_t end = spirit1TraceRingIndex;
+    uint32_t begin = end > SPIRIT1_TRACE_RING_SIZE ? end - SPIRIT1_TRACE_RING_SIZE : 0;
+    for (uint32_t i = begin; i < end; i++) {
+        const Spirit1TraceRecord &record = spirit1TraceRing[i & (SPIRIT1_TRACE_RING_SIZE - 1)];
+        SPIRIT1_TRACE_PRINTF("%10lu %s %02x=%04x (%d) %02x\r\n", (unsigned long) record.timeUs,
+                             kindNames[record.kind], record.address, record.status, record.n, record.data);
+    }
+}
+
+void spirit1TraceReset() {
+    memset(&spirit1TraceCounters, 0, sizeof(spirit1TraceCounters));
+    memset(spirit1TraceRing, 0, sizeof(spirit1TraceRing));
+    spirit1TraceRingIndex = 0;
+}
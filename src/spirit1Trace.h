@@ -0,0 +1,108 @@
+/**
+ * SPIRIT1 transport trace.
+ *
+ * The level is chosen at compile time with SPIRIT1_TRACE_LEVEL:
+ *
+ *  - SPIRIT1_TRACE_OFF       nothing, SPIRIT1_TRACE() expands to nothing
+ *  - SPIRIT1_TRACE_COUNTERS  calls and payload bytes per kind of transaction
+ *  - SPIRIT1_TRACE_RING      counters, plus a binary record of the last
+ *                            SPIRIT1_TRACE_RING_SIZE transactions, formatted
+ *                            only when spirit1TraceDumpRing() is called
+ *  - SPIRIT1_TRACE_DUMP      counters, plus a hex dump of every transaction
+ *                            as it happens (slow: formats and prints from the
+ *                            calling context, including interrupts)
+ *
+ * Only the dump level formats anything on the transaction path.
+ */
+#ifndef SPIRIT1_TRACE_H
+#define SPIRIT1_TRACE_H
+
+#include <stdint.h>
+#include <string.h>
+#include "MCU_Interface.h"
+
+#define SPIRIT1_TRACE_OFF      0
+#define SPIRIT1_TRACE_COUNTERS 1
+#define SPIRIT1_TRACE_RING     2
+#define SPIRIT1_TRACE_DUMP     3
+
+#ifndef SPIRIT1_TRACE_LEVEL
+#define SPIRIT1_TRACE_LEVEL SPIRIT1_TRACE_OFF
+#endif
+
+/* number of records kept by the ring level, a power of two */
+#ifndef SPIRIT1_TRACE_RING_SIZE
+#define SPIRIT1_TRACE_RING_SIZE 64
+#endif
+
+/* kind of transaction */
+enum {
+    SPIRIT1_TRACE_WRITE = 0,
+    SPIRIT1_TRACE_READ,
+    SPIRIT1_TRACE_COMMAND,
+    SPIRIT1_TRACE_WRITE_FIFO,
+    SPIRIT1_TRACE_READ_FIFO,
+    SPIRIT1_TRACE_KINDS
+};
+
+typedef struct {
+    uint32_t calls[SPIRIT1_TRACE_KINDS];
+    uint32_t bytes[SPIRIT1_TRACE_KINDS];  /*!< payload bytes, without the header */
+} Spirit1TraceCounters;
+
+typedef struct {
+    uint32_t timeUs;
+    uint8_t kind;
+    uint8_t address;     /*!< register address or command code */
+    uint8_t n;
+    uint8_t data;        /*!< first payload byte */
+    uint16_t status;     /*!< the two status bytes, first one in the high byte */
+} Spirit1TraceRecord;
+
+extern Spirit1TraceCounters spirit1TraceCounters;
+extern Spirit1TraceRecord spirit1TraceRing[SPIRIT1_TRACE_RING_SIZE];
+extern uint32_t spirit1TraceRingIndex;
+
+/** free running microsecond clock used to stamp the ring records */
+uint32_t spirit1TraceNowUs();
+
+/** print one transaction, used by the dump level */
+void spirit1TraceDump(uint8_t kind, uint8_t address, uint8_t n, const uint8_t *data, StatusBytes status);
+
+/** print the ring, oldest record first; call from thread context */
+void spirit1TraceDumpRing();
+
+/** clear counters and ring */
+void spirit1TraceReset();
+
+/** hex and ASCII dump of a buffer, 16 bytes per line */
+void spirit1TraceHexDump(const char *prefix, const uint8_t *buffer, size_t size);
+
+static inline void spirit1TraceRecord(uint8_t kind, uint8_t address, uint8_t n, const uint8_t *data,
+                                      StatusBytes status) {
+    spirit1TraceCounters.calls[kind]++;
+    spirit1TraceCounters.bytes[kind] += n;
+#if SPIRIT1_TRACE_LEVEL == SPIRIT1_TRACE_RING
+    Spirit1TraceRecord *record = &spirit1TraceRing[spirit1TraceRingIndex++ & (SPIRIT1_TRACE_RING_SIZE - 1)];
+    record->timeUs = spirit1TraceNowUs();
+    record->kind = kind;
+    record->address = address;
+    record->n = n;
+    record->data = n && data ? data[0] : 0;
+    memcpy(&record->status, &status, sizeof(record->status));
+#elif SPIRIT1_TRACE_LEVEL == SPIRIT1_TRACE_DUMP
+    spirit1TraceDump(kind, address, n, data, status);
+#else
+    (void) address;
+    (void) data;
+    (void) status;
+#endif
+}
+
+#if SPIRIT1_TRACE_LEVEL == SPIRIT1_TRACE_OFF
+#define SPIRIT1_TRACE(kind, address, n, data, status) ((void) 0)
+#else
+#define SPIRIT1_TRACE(kind, address, n, data, status) spirit1TraceRecord(kind, address, n, data, status)
+#endif
+
+#endif // SPIRIT1_TRACE_H
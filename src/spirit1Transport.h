@@ -0,0 +1,131 @@
+/**
+ * SPIRIT1 transport: the driver functions the library expects (see
+ * MCU_Interface.h) on top of a backend chosen at compile time.
+ *
+ * A backend is a bus adapter for the SPI engine (see spirit1Spi.h) that also
+ * drives the SDN pin and the SPI clock:
+ *
+ *   void enterShutdown();
+ *   void exitShutdown();              // returns once SPIRIT1 is out of reset
+ *   bool isShutdown();
+ *   void setFrequency(uint32_t hz);
+ *   bool waitGpioHigh(uint32_t timeoutUs);  // state waits on a GPIO edge (SPIRIT_Wait.h),
+ *                                           // false at once if no SPIRIT GPIO is wired
+ *
+ * Backends:
+ *
+ *   Spirit1MbedBus  src/spirit1MbedBus.h   mbed SPI, DMA bursts (target)
+ *   SpidevBus       host/spidevBus.h       Linux spidev (host with a SPIRIT1 attached)
+ *   SpiStandInBus   host/spiStandIn.h      in-process simulated chip (host)
+ *
+ * Exactly one translation unit binds the library to a transport instance:
+ *
+ *   Spirit1Transport<Spirit1MbedBus> spirit1Spi(spirit1Bus);
+ *   SPIRIT1_TRANSPORT(spirit1Spi)
+ *
+ * Several radios, each on its own bus: one transport per bus in an array, the
+ * library addresses the bus of the bound context (SPIRIT_Context.h):
+ *
+ *   Spirit1Transport<Spirit1MbedBus> spirit1Spis[] = {...};
+ *   SPIRIT1_TRANSPORTS(spirit1Spis)
+ *
+ * Everything is resolved at compile time, there are no virtual calls or
+ * function pointers between the library and the bus.
+ */
+#ifndef SPIRIT1_TRANSPORT_H
+#define SPIRIT1_TRANSPORT_H
+
+#include "spirit1Spi.h"
+#include "spirit1Trace.h"
+#include "spirit1Profile.h"
+
+template<typename Backend>
+class Spirit1Transport : public Spirit1Spi<Backend> {
+public:
+    explicit Spirit1Transport(Backend &backend) : Spirit1Spi<Backend>(backend), _backend(backend) {}
+
+    void enterShutdown() { _backend.enterShutdown(); }
+
+    void exitShutdown() { _backend.exitShutdown(); }
+
+    bool isShutdown() { return _backend.isShutdown(); }
+
+    /** RadioSpiSetBaudrate(): with these backends the argument is the SPI clock in Hz */
+    void setBaudrate(uint32_t hz) { _backend.setFrequency(hz); }
+
+    /** RadioWaitGpioHigh(): blocks until the wired SPIRIT GPIO is high, returns its level */
+    bool waitGpioHigh(uint32_t timeoutUs) { return _backend.waitGpioHigh(timeoutUs); }
+
+    Backend &backend() { return _backend; }
+
+private:
+    Backend &_backend;
+};
+
+/** defines the MCU_Interface.h driver functions on the given transport instance */
+#define SPIRIT1_TRANSPORT(transport)                                                            \
+extern "C" {                                                                                    \
+void RadioSpiInit(void) {}                                                                      \
+                                                                                                \
+void RadioSpiDeinit(void) {}                                                                    \
+                                                                                                \
+void RadioSpiSetBaudrate(uint32_t baudrate_prescaler) {                                         \
+    (transport).setBaudrate(baudrate_prescaler);                                                \
+}                                                                                               \
+                                                                                                \
+StatusBytes RadioSpiWriteRegisters(uint8_t address, uint8_t n_regs, uint8_t *buffer) {          \
+    StatusBytes status = (transport).writeRegisters(address, n_regs, buffer);                   \
+    SPIRIT1_TRACE(SPIRIT1_TRACE_WRITE, address, n_regs, buffer, status);                        \
+    SPIRIT1_PROFILE_TRANSACTION(n_regs);                                                        \
+    return status;                                                                              \
+}                                                                                               \
+                                                                                                \
+StatusBytes RadioSpiReadRegisters(uint8_t address, uint8_t n_regs, uint8_t *buffer) {           \
+    StatusBytes status = (transport).readRegisters(address, n_regs, buffer);                    \
+    SPIRIT1_TRACE(SPIRIT1_TRACE_READ, address, n_regs, buffer, status);                         \
+    SPIRIT1_PROFILE_TRANSACTION(n_regs);                                                        \
+    return status;                                                                              \
+}                                                                                               \
+                                                                                                \
+StatusBytes RadioSpiCommandStrobes(uint8_t cmd_code) {                                          \
+    StatusBytes status = (transport).commandStrobe(cmd_code);                                   \
+    SPIRIT1_TRACE(SPIRIT1_TRACE_COMMAND, cmd_code, 0, NULL, status);                            \
+    SPIRIT1_PROFILE_TRANSACTION(0);                                                             \
+    return status;                                                                              \
+}                                                                                               \
+                                                                                                \
+StatusBytes RadioSpiWriteFifo(uint8_t n_regs, uint8_t *buffer) {                                \
+    StatusBytes status = (transport).writeFifo(n_regs, buffer);                                 \
+    SPIRIT1_TRACE(SPIRIT1_TRACE_WRITE_FIFO, LINEAR_FIFO_ADDRESS, n_regs, buffer, status);       \
+    SPIRIT1_PROFILE_TRANSACTION(n_regs);                                                        \
+    return status;                                                                              \
+}                                                                                               \
+                                                                                                \
+StatusBytes RadioSpiReadFifo(uint8_t n_regs, uint8_t *buffer) {                                 \
+    StatusBytes status = (transport).readFifo(n_regs, buffer);                                  \
+    SPIRIT1_TRACE(SPIRIT1_TRACE_READ_FIFO, LINEAR_FIFO_ADDRESS, n_regs, buffer, status);        \
+    SPIRIT1_PROFILE_TRANSACTION(n_regs);                                                        \
+    return status;                                                                              \
+}                                                                                               \
+                                                                                                \
+void RadioEnterShutdown(void) {                                                                 \
+    (transport).enterShutdown();                                                                \
+}                                                                                               \
+                                                                                                \
+void RadioExitShutdown(void) {                                                                  \
+    (transport).exitShutdown();                                                                 \
+}                                                                                               \
+                                                                                                \
+SpiritFlagStatus RadioCheckShutdown(void) {                                                     \
+    return (transport).isShutdown() ? S_SET : S_RESET;                                          \
+}                                                                                               \
+                                                                                                \
+SpiritFlagStatus RadioWaitGpioHigh(uint32_t lTimeoutUs) {                                       \
+    return (transport).waitGpioHigh(lTimeoutUs) ? S_SET : S_RESET;                              \
+}                                                                                               \
+}
+
+/** the same on an array of transport instances, indexed by the bus of the bound context */
+#define SPIRIT1_TRANSPORTS(transports) SPIRIT1_TRANSPORT((transports)[SpiritContextGetBus()])
+
+#endif // SPIRIT1_TRANSPORT_H
@@ -0,0 +1,240 @@
+/**
+ * Pipelined SPIRIT1 transmissions from a bounded queue of frames.
+ *
+ * The application queues frames of up to one FIFO (96 bytes) from its own
+ * thread; the radio thread sends them back to back. While a frame is on the
+ * air the next one is preloaded behind it in the TX FIFO, at once if both
+ * fit, otherwise as soon as the FIFO has drained enough (TX_FIFO_ALMOST_EMPTY
+ * with the threshold set to the room the next frame needs). On TX_DATA_SENT
+ * the radio thread only writes the packet length (skipped by the register
+ * shadow when it does not change) and sends the TX command: the gap between
+ * two frames is the turnaround of the radio. Then the completion callback of
+ * the frame runs on the radio thread.
+ *
+ * A frame is either copied into the queue or, without copy, handed over in a
+ * buffer of spirit1BufferPool.h: the queue writes the FIFO straight from the
+ * buffer and releases it after the completion callback.
+ *
+ * The queue is a lock-free single producer, single consumer ring like
+ * spirit1RxRing.h: push() on the application side, start() and handleIrqs()
+ * on the radio thread. The radio thread needs waking up only when a push()
+ * finds the queue empty (startNeeded()): while frames are queued,
+ * handleIrqs() starts the next one itself. The packet length is set with
+ * SpiritPktBasicSetPayloadLength(); Usage:
+ *
+ *   Spirit1TxQueue<8> txQueue;
+ *
+ *   // radio thread, once
+ *   txQueue.init();
+ *
+ *   // application thread
+ *   if (txQueue.push(frame, length, sent, context) && txQueue.startNeeded()) wakeRadioThread();
+ *
+ *   // radio thread, woken up
+ *   txQueue.start();
+ *
+ *   // radio thread, in the IRQ bottom half
+ *   SpiritIrqGetStatus(&irqs);
+ *   txQueue.handleIrqs(irqs);
+ */
+#ifndef SPIRIT1_TX_QUEUE_H
+#define SPIRIT1_TX_QUEUE_H
+
+#include <stdint.h>
+#include <string.h>
+#include "SPIRIT_Config.h"
+#include "spirit1BufferPool.h"
+
+/* the linear FIFO */
+#define SPIRIT1_TX_PAYLOAD_MAX 96
+
+/** completion of a frame, sent is false if CSMA gave up on it (MAX_BO_CCA_REACH) */
+typedef void (*Spirit1TxDone)(void *context, bool sent);
+
+typedef struct {
+    uint32_t queued;          /*!< frames accepted by push() */
+    uint32_t rejected;        /*!< push() on a full queue */
+    uint32_t sent;            /*!< TX_DATA_SENT */
+    uint32_t dropped;         /*!< MAX_BO_CCA_REACH */
+    uint32_t preloaded;       /*!< frames written to the FIFO while the previous one was on the air */
+    uint32_t highWater;       /*!< most frames queued at once, the one on the air included */
+} Spirit1TxQueueStats;
+
+/** Size must be a power of two */
+template<uint32_t Size>
+class Spirit1TxQueue {
+public:
+    Spirit1TxQueue() : _head(0), _tail(0), _onAir(false), _loaded(0) {
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    /* application thread */
+
+    /** copies a frame into the queue, false if the queue is full or the frame larger than the FIFO */
+    bool push(const uint8_t *payload, uint8_t length, Spirit1TxDone done = NULL, void *context = NULL) {
+        uint32_t head = _head;
+        if (length > SPIRIT1_TX_PAYLOAD_MAX || head - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE) == Size) {
+            _stats.rejected++;
+            return false;
+        }
+        Slot &slot = _slots[head & (Size - 1)];
+        memcpy(slot.payload, payload, length);
+        slot.buffer = NULL;
+        slot.length = length;
+        slot.done = done;
+        slot.context = context;
+        __atomic_store_n(&_head, head + 1, __ATOMIC_RELEASE);
+        _stats.queued++;
+        return true;
+    }
+
+    /**
+     * queues a pool buffer without copy, the queue owns it from then on and
+     * releases it after done. False if the queue is full or the frame larger
+     * than the FIFO, the buffer then stays with the caller.
+     */
+    bool push(Spirit1Buffer *buffer, Spirit1TxDone done = NULL, void *context = NULL) {
+        uint32_t head = _head;
+        if (buffer->length > SPIRIT1_TX_PAYLOAD_MAX || head - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE) == Size) {
+            _stats.rejected++;
+            return false;
+        }
+        Slot &slot = _slots[head & (Size - 1)];
+        slot.buffer = buffer;
+        slot.length = (uint8_t) buffer->length;
+        slot.done = done;
+        slot.context = context;
+        __atomic_store_n(&_head, head + 1, __ATOMIC_RELEASE);
+        _stats.queued++;
+        return true;
+    }
+
+    /**
+     * after a push() that succeeded: true if the queue was empty, the radio
+     * thread then has to call start(). Otherwise the frame on the air is
+     * ahead and handleIrqs() starts this one after it.
+     */
+    bool startNeeded() const {
+        /* against handleIrqs() retiring the last frame meanwhile, see there */
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        return count() == 1;
+    }
+
+    /* either side */
+
+    /** frames queued or on the air */
+    uint32_t count() const {
+        return __atomic_load_n(&_head, __ATOMIC_ACQUIRE) - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+    }
+
+    /** rejected is written by the producer, the rest by the radio thread */
+    const Spirit1TxQueueStats &stats() const { return _stats; }
+
+    void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+
+    /* radio thread */
+
+    /** enables the IRQs of the queue and empties the TX FIFO, the radio must be in READY */
+    void init() {
+        SpiritIrq(TX_DATA_SENT, S_ENABLE);
+        SpiritIrq(MAX_BO_CCA_REACH, S_ENABLE);
+        SpiritIrq(TX_FIFO_ALMOST_EMPTY, S_ENABLE);
+        SpiritCmdStrobeFlushTxFifo();
+        _onAir = false;
+        _loaded = 0;
+    }
+
+    /** sends the oldest frame if the radio is idle, call when startNeeded() */
+    void start() {
+        uint32_t queued = count();
+        if (_onAir || queued == 0) return;
+        if (queued > _stats.highWater) _stats.highWater = queued;
+        if (_loaded == 0) load(_tail);
+        send();
+        preload();
+    }
+
+    /** serves TX_DATA_SENT, MAX_BO_CCA_REACH and TX_FIFO_ALMOST_EMPTY, returns true if one of them was set */
+    bool handleIrqs(const SpiritIrqs &irqs) {
+        if (!_onAir) return false;
+        if (irqs.IRQ_TX_DATA_SENT || irqs.IRQ_MAX_BO_CCA_REACH) {
+            Slot &slot = _slots[_tail & (Size - 1)];
+            Spirit1TxDone done = slot.done;
+            void *context = slot.context;
+            Spirit1Buffer *buffer = slot.buffer;
+            bool sent = irqs.IRQ_TX_DATA_SENT;
+
+            _onAir = false;
+            if (sent) {
+                _loaded--;
+                _stats.sent++;
+            } else {
+                /* CSMA gave up: the frame and the preloaded one are still in the FIFO */
+                SpiritCmdStrobeFlushTxFifo();
+                _loaded = 0;
+                _stats.dropped++;
+            }
+            __atomic_store_n(&_tail, _tail + 1, __ATOMIC_RELEASE);
+            /*
+             * the next frame first, the callback runs while it is on the air.
+             * A push() now either sees this tail in startNeeded() or is seen
+             * by start(): the fences order each store before the other load.
+             */
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            start();
+            if (done) done(context, sent);
+            if (buffer) buffer->release();
+            return true;
+        }
+        if (irqs.IRQ_TX_FIFO_ALMOST_EMPTY) {
+            preload();
+            return true;
+        }
+        return false;
+    }
+
+private:
+    typedef struct {
+        uint8_t payload[SPIRIT1_TX_PAYLOAD_MAX];
+        Spirit1Buffer *buffer;    /*!< the frame instead of payload, NULL if copied */
+        uint8_t length;
+        Spirit1TxDone done;
+        void *context;
+    } Slot;
+
+    void load(uint32_t index) {
+        Slot &slot = _slots[index & (Size - 1)];
+        SpiritSpiWriteLinearFifo(slot.length, slot.buffer ? slot.buffer->data() : slot.payload);
+        _loaded++;
+    }
+
+    void send() {
+        SpiritPktBasicSetPayloadLength(_slots[_tail & (Size - 1)].length);
+        SpiritCmdStrobeTx();
+        _onAir = true;
+    }
+
+    /* writes the next frame behind the one on the air if there is room, otherwise waits for the room */
+    void preload() {
+        if (!_onAir || _loaded > 1 || count() < 2) return;
+        uint8_t next = _slots[(_tail + 1) & (Size - 1)].length;
+        if (SpiritLinearFifoReadNumElementsTxFifo() + next > SPIRIT1_TX_PAYLOAD_MAX) {
+            SpiritLinearFifoSetAlmostEmptyThresholdTx((uint8_t) (SPIRIT1_TX_PAYLOAD_MAX - next));
+            /* the FIFO may have drained past the threshold meanwhile */
+            if (SpiritLinearFifoReadNumElementsTxFifo() + next > SPIRIT1_TX_PAYLOAD_MAX) return;
+        }
+        load(_tail + 1);
+        _stats.preloaded++;
+    }
+
+    Slot _slots[Size];
+    uint32_t _head;           /*!< written by the producer only */
+    uint32_t _tail;           /*!< frame on the air or next to send, written by the radio thread only */
+    bool _onAir;
+    uint8_t _loaded;          /*!< frames in the TX FIFO: 0, 1 or 2 */
+    Spirit1TxQueueStats _stats;
+
+    typedef char sizeIsAPowerOfTwo[(Size & (Size - 1)) == 0 && Size ? 1 : -1];
+};
+
+#endif // SPIRIT1_TX_QUEUE_H
@@ -0,0 +1,300 @@
+/**
+ * Warm boot of the SPIRIT1: the configuration registers and the calibration
+ * words of a cold init, saved to non-volatile storage and written back in
+ * bursts on the next boots, without the VCO calibration.
+ *
+ * A cold boot runs SRES, SpiritManagementWaExtraCurrent(), the configuration
+ * and SpiritManagementWaVcoCalibration(), with its two LOCK cycles. After it
+ * the snapshot keeps the configuration space (spirit1WarmBootRanges: the AES
+ * key and data registers and the status registers left out), XO_RCO_TEST, the
+ * VCO words (SpiritCalibrationGetVcoCalDataTx/Rx()) and the RCO words
+ * (SpiritCalibrationGetRcoCalWords()). A restore writes the calibration words
+ * into RCO_VCO_CALIBR_IN2..0 with both automatic calibrations off, the chip
+ * runs on the words of the cold boot.
+ *
+ * The snapshot is keyed by a hash of the configuration, the caller's
+ * (spirit1WarmBootKey(), over the init structures or a version number of
+ * the configuration code). It is not used for another key, when older than
+ * maxAgeS or when the temperature moved by more than maxDrift since: the
+ * calibration words are those of the temperature of the cold boot. The
+ * clock (seconds, an RTC) and the temperature (any unit, degree C from the
+ * MCU sensor for instance) are the caller's.
+ *
+ * The storage is chosen at compile time, a class with
+ *
+ *   bool read(void *data, uint16_t length);         // false: nothing stored
+ *   bool write(const void *data, uint16_t length);
+ *
+ * a flash sector, an EEPROM page or backup RAM. Usage:
+ *
+ *   uint8_t coldInit() {
+ *       SpiritCmdStrobeSres();
+ *       SpiritManagementWaExtraCurrent();
+ *       SpiritRadioSetXtalFrequency(50000000);
+ *       if (SpiritRadioInit(&radio)) return 1;
+ *       SpiritPktBasicInit(&basic);
+ *       ...
+ *       return 0;
+ *   }
+ *
+ *   Spirit1WarmBoot<FlashSector> warmBoot(flashSector, 86400, 10);
+ *   uint32_t key = spirit1WarmBootKey(&basic, sizeof(basic), spirit1WarmBootKey(&radio, sizeof(radio)));
+ *   warmBoot.boot(key, rtc_read(), temperature(), coldInit);
+ *   SpiritCmdStrobeRx();
+ *
+ * The snapshot is taken at the end of cold(): everything cold() configures
+ * is restored, a register changed later is not. After a change at run time
+ * that is to survive the boot, invalidate() the snapshot.
+ */
+#ifndef SPIRIT1_WARM_BOOT_H
+#define SPIRIT1_WARM_BOOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "SPIRIT_Config.h"
+
+/* boot() results: restored, the reasons for a cold boot, the cold init failed */
+#define SPIRIT1_WARM_BOOT_WARM 0
+#define SPIRIT1_WARM_BOOT_EMPTY 1
+#define SPIRIT1_WARM_BOOT_OTHER_KEY 2
+#define SPIRIT1_WARM_BOOT_AGED 3
+#define SPIRIT1_WARM_BOOT_DRIFTED 4
+#define SPIRIT1_WARM_BOOT_FAILED 5
+#define SPIRIT1_WARM_BOOT_ERROR 6
+
+#define SPIRIT1_WARM_BOOT_MAGIC 0x57524D31  /* "WRM1" */
+#define SPIRIT1_WARM_BOOT_KEY_SEED 2166136261u
+
+/* registers saved, the sum of the counts of spirit1WarmBootRanges */
+#define SPIRIT1_WARM_BOOT_REGISTERS 104
+
+/* {first register, count} */
+constexpr uint8_t spirit1WarmBootRanges[][2] = {
+    {ANA_FUNC_CONF1_BASE, 25},   /* 0x00..0x18: analog, GPIO, synthesizer, PA */
+    {MOD1_BASE, 14},             /* 0x1A..0x27: modem, AFC, RSSI, AGC, antenna */
+    {PCKTCTRL4_BASE, 41},        /* 0x30..0x58: packet, QI, FIFO, filtering, protocol, timers */
+    {CSMA_CONFIG3_BASE, 12},     /* 0x64..0x6F: CSMA, TX control field, channel, calibration words */
+    {IRQ_MASK3_BASE, 4},
+    {0x99, 2},                   /* IQ correction */
+    {SYNTH_CONFIG1_BASE, 2},
+    {VCO_CONFIG_BASE, 1},
+    {0xA3, 1},                   /* DEM_CONFIG */
+    {0xA5, 1},                   /* written by the GUI export */
+    {0xBC, 1},                   /* PA on after an unwanted VCO calibration */
+};
+
+constexpr int spirit1WarmBootCount(size_t r) {
+    return r < sizeof(spirit1WarmBootRanges) / sizeof(spirit1WarmBootRanges[0])
+           ? spirit1WarmBootRanges[r][1] + spirit1WarmBootCount(r + 1) : 0;
+}
+
+typedef char spirit1WarmBootRangesCounted[spirit1WarmBootCount(0) == SPIRIT1_WARM_BOOT_REGISTERS ? 1 : -1];
+
+typedef struct {
+    uint32_t magic;              /*!< SPIRIT1_WARM_BOOT_MAGIC */
+    uint32_t key;                /*!< configuration of the snapshot */
+    uint32_t xtal;               /*!< SpiritRadioGetXtalFrequency() */
+    uint32_t frequencyBase;      /*!< of SpiritManagementWaTRxFcMem() */
+    uint32_t savedAtS;           /*!< the caller's clock at the snapshot */
+    int16_t temperature;         /*!< the caller's temperature at the snapshot */
+    uint8_t vcoTx;               /*!< SpiritCalibrationGetVcoCalDataTx() */
+    uint8_t vcoRx;               /*!< SpiritCalibrationGetVcoCalDataRx() */
+    uint8_t rcoRwt;              /*!< SpiritCalibrationGetRcoCalWords() */
+    uint8_t rcoRfb;
+    uint8_t xoRcoTest;           /*!< XO_RCO_TEST, written in STANDBY */
+    uint8_t registers[SPIRIT1_WARM_BOOT_REGISTERS]; /*!< spirit1WarmBootRanges in order, as restored */
+    uint32_t check;              /*!< spirit1WarmBootKey() of the fields above */
+} Spirit1WarmBootRecord;
+
+typedef struct {
+    uint32_t warm;               /*!< boots from the snapshot */
+    uint32_t cold;               /*!< cold inits run */
+    uint32_t empty;              /*!< cold: nothing stored or a damaged snapshot */
+    uint32_t otherKey;           /*!< cold: snapshot of another configuration */
+    uint32_t aged;               /*!< cold: snapshot older than maxAgeS */
+    uint32_t drifted;            /*!< cold: temperature moved more than maxDrift */
+    uint32_t failed;             /*!< cold: the restore did not reach READY */
+    uint32_t errors;             /*!< cold inits that failed, nothing saved */
+    uint32_t storageErrors;      /*!< snapshots the storage did not take */
+} Spirit1WarmBootStats;
+
+/** FNV-1a of data, chained through key */
+inline uint32_t spirit1WarmBootKey(const void *data, size_t length, uint32_t key = SPIRIT1_WARM_BOOT_KEY_SEED) {
+    const uint8_t *bytes = (const uint8_t *) data;
+    for (size_t i = 0; i < length; i++) key = (key ^ bytes[i]) * 16777619u;
+    return key;
+}
+
+inline uint32_t spirit1WarmBootCheck(const Spirit1WarmBootRecord &record) {
+    return spirit1WarmBootKey(&record, offsetof(Spirit1WarmBootRecord, check));
+}
+
+/** offset of address in Spirit1WarmBootRecord::registers, -1 if not saved */
+inline int spirit1WarmBootIndex(uint8_t address) {
+    int offset = 0;
+    for (size_t r = 0; r < sizeof(spirit1WarmBootRanges) / sizeof(spirit1WarmBootRanges[0]); r++) {
+        uint8_t first = spirit1WarmBootRanges[r][0], count = spirit1WarmBootRanges[r][1];
+        if (address >= first && address < first + count) return offset + address - first;
+        offset += count;
+    }
+    return -1;
+}
+
+/**
+ * Snapshot of the radio after a cold init, in READY. The RCO words go into
+ * RCO_VCO_CALIBR_IN2..1 if the RCO was calibrated automatically.
+ */
+inline void spirit1WarmBootSnapshot(Spirit1WarmBootRecord *record, uint32_t key, uint32_t nowS, int16_t temperature) {
+    uint8_t *registers = record->registers;
+
+    memset(record, 0, sizeof(*record));
+    record->magic = SPIRIT1_WARM_BOOT_MAGIC;
+    record->key = key;
+    record->xtal = SpiritRadioGetXtalFrequency();
+    record->frequencyBase = g_pxSpiritContext->nDesiredFrequency;
+    record->savedAtS = nowS;
+    record->temperature = temperature;
+    SpiritSpiReadRegisters(XO_RCO_TEST_BASE, 1, &record->xoRcoTest);
+    for (size_t r = 0; r < sizeof(spirit1WarmBootRanges) / sizeof(spirit1WarmBootRanges[0]); r++) {
+        SpiritSpiReadRegisters(spirit1WarmBootRanges[r][0], spirit1WarmBootRanges[r][1], registers);
+        registers += spirit1WarmBootRanges[r][1];
+    }
+    record->vcoTx = SpiritCalibrationGetVcoCalDataTx();
+    record->vcoRx = SpiritCalibrationGetVcoCalDataRx();
+    SpiritCalibrationGetRcoCalWords(&record->rcoRwt, &record->rcoRfb);
+
+    /* the words of this boot, both calibrations off */
+    registers = record->registers;
+    uint8_t &protocol2 = registers[spirit1WarmBootIndex(PROTOCOL2_BASE)];
+    uint8_t &in2 = registers[spirit1WarmBootIndex(RCO_VCO_CALIBR_IN2_BASE)];
+    uint8_t &in1 = registers[spirit1WarmBootIndex(RCO_VCO_CALIBR_IN1_BASE)];
+    uint8_t &in0 = registers[spirit1WarmBootIndex(RCO_VCO_CALIBR_IN0_BASE)];
+    if (protocol2 & PROTOCOL2_RCO_CALIBRATION_MASK) {
+        in2 = (uint8_t) ((record->rcoRwt << 4) | (record->rcoRfb >> 1));
+        in1 = (uint8_t) ((in1 & 0x7F) | (record->rcoRfb << 7));
+    }
+    in1 = (uint8_t) ((in1 & 0x80) | record->vcoTx);
+    in0 = (uint8_t) ((in0 & 0x80) | record->vcoRx);
+    protocol2 &= (uint8_t) ~(PROTOCOL2_RCO_CALIBRATION_MASK | PROTOCOL2_VCO_CALIBRATION_MASK);
+    record->check = spirit1WarmBootCheck(*record);
+}
+
+/**
+ * SPIRIT1_WARM_BOOT_WARM if record is a snapshot of key still valid at nowS
+ * and temperature, else the reason to boot cold. maxAgeS 0: no age limit.
+ */
+inline uint8_t spirit1WarmBootValid(const Spirit1WarmBootRecord &record, uint32_t key, uint32_t nowS,
+                                    int16_t temperature, uint32_t maxAgeS, uint16_t maxDrift) {
+    if (record.magic != SPIRIT1_WARM_BOOT_MAGIC || record.check != spirit1WarmBootCheck(record)) {
+        return SPIRIT1_WARM_BOOT_EMPTY;
+    }
+    if (record.key != key) return SPIRIT1_WARM_BOOT_OTHER_KEY;
+    /* a clock behind the snapshot was reset */
+    if (maxAgeS && (nowS < record.savedAtS || nowS - record.savedAtS > maxAgeS)) return SPIRIT1_WARM_BOOT_AGED;
+    int32_t drift = (int32_t) temperature - record.temperature;
+    if (drift > maxDrift || -drift > maxDrift) return SPIRIT1_WARM_BOOT_DRIFTED;
+    return SPIRIT1_WARM_BOOT_WARM;
+}
+
+/**
+ * SRES, SpiritManagementWaExtraCurrent() and the registers of record, the
+ * radio ends in READY. Returns 0, 1 for a state not reached (see @ref
+ * SpiritWaitState()).
+ */
+inline uint8_t spirit1WarmBootRestore(const Spirit1WarmBootRecord &record) {
+    /* the library takes non-const buffers */
+    Spirit1WarmBootRecord copy = record;
+    uint8_t *registers = copy.registers;
+
+    SpiritCmdStrobeSres();
+    SpiritManagementWaExtraCurrent();
+    SpiritRadioSetXtalFrequency(record.xtal);
+
+    /* the clock divider is set in STANDBY, as SpiritRadioInit() does */
+    SpiritCmdStrobeStandby();
+    if (SpiritWaitState(MC_STATE_STANDBY, SPIRIT_WAIT_STATE_TIMEOUT_US) != SPIRIT_WAIT_OK) return 1;
+    SpiritSpiWriteRegisters(XO_RCO_TEST_BASE, 1, &copy.xoRcoTest);
+    SpiritCmdStrobeReady();
+    if (SpiritWaitState(MC_STATE_READY, SPIRIT_WAIT_XO_TIMEOUT_US) != SPIRIT_WAIT_OK) return 1;
+    SpiritManagementWaTRxFcMem(record.frequencyBase);
+
+    for (size_t r = 0; r < sizeof(spirit1WarmBootRanges) / sizeof(spirit1WarmBootRanges[0]); r++) {
+        SpiritSpiWriteRegisters(spirit1WarmBootRanges[r][0], spirit1WarmBootRanges[r][1], registers);
+        registers += spirit1WarmBootRanges[r][1];
+    }
+    return 0;
+}
+
+/** Storage: see above */
+template<typename Storage>
+class Spirit1WarmBoot {
+public:
+    /** maxAgeS: snapshots older than this are not used, 0 for no limit; maxDrift: temperature change allowed */
+    Spirit1WarmBoot(Storage &storage, uint32_t maxAgeS = 86400, uint16_t maxDrift = 10) :
+            _storage(storage), _maxAgeS(maxAgeS), _maxDrift(maxDrift) {
+        memset(&_stats, 0, sizeof(_stats));
+    }
+
+    /**
+     * brings the radio up in READY with the configuration key: restores the
+     * stored snapshot if valid, else runs cold(), the full init from SRES
+     * returning 0 on success, and stores its snapshot. Returns
+     * SPIRIT1_WARM_BOOT_WARM, the reason for the cold boot or
+     * SPIRIT1_WARM_BOOT_ERROR if cold() failed.
+     */
+    uint8_t boot(uint32_t key, uint32_t nowS, int16_t temperature, uint8_t (*cold)(void)) {
+        Spirit1WarmBootRecord record;
+        uint8_t result = SPIRIT1_WARM_BOOT_EMPTY;
+
+        if (_storage.read(&record, sizeof(record))) {
+            result = spirit1WarmBootValid(record, key, nowS, temperature, _maxAgeS, _maxDrift);
+        }
+        if (result == SPIRIT1_WARM_BOOT_WARM) {
+            if (spirit1WarmBootRestore(record) == 0) {
+                _stats.warm++;
+                return SPIRIT1_WARM_BOOT_WARM;
+            }
+            result = SPIRIT1_WARM_BOOT_FAILED;
+        }
+        count(result);
+
+        _stats.cold++;
+        if (cold()) {
+            _stats.errors++;
+            return SPIRIT1_WARM_BOOT_ERROR;
+        }
+        spirit1WarmBootSnapshot(&record, key, nowS, temperature);
+        if (!_storage.write(&record, sizeof(record))) _stats.storageErrors++;
+        return result;
+    }
+
+    /** the next boot is cold */
+    bool invalidate() {
+        Spirit1WarmBootRecord record;
+        memset(&record, 0, sizeof(record));
+        return _storage.write(&record, sizeof(record));
+    }
+
+    const Spirit1WarmBootStats &stats() const { return _stats; }
+
+    void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
+
+private:
+    void count(uint8_t result) {
+        switch (result) {
+            case SPIRIT1_WARM_BOOT_EMPTY: _stats.empty++; break;
+            case SPIRIT1_WARM_BOOT_OTHER_KEY: _stats.otherKey++; break;
+            case SPIRIT1_WARM_BOOT_AGED: _stats.aged++; break;
+            case SPIRIT1_WARM_BOOT_DRIFTED: _stats.drifted++; break;
+            default: _stats.failed++; break;
+        }
+    }
+
+    Storage &_storage;
+    uint32_t _maxAgeS;
+    uint16_t _maxDrift;
+    Spirit1WarmBootStats _stats;
+};
+
+#endif // SPIRIT1_WARM_BOOT_H